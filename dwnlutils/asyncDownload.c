@@ -0,0 +1,520 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "asyncDownload.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "downloadUtil.h"
+#include "cancelToken.h"
+#include "dnsCache.h"
+#include "transferStats.h"
+
+/* Below structure hold one submitted request */
+typedef struct asyncReq {
+    int id;
+    FileDwnl_t *pfile_dwnl;
+    struct cancelToken *token;  /* cancel of DwnlOptions_t, NULL if not given */
+    statsParam_t *statsData;    /* statsData of DwnlOptions_t, NULL if not given */
+    MemCancelData_t mem_cancel; /* write data of a memory download with a cancel token */
+    asyncDwnlCallback_t cb;
+    void *userdata;
+    CURL *curl;
+    struct curl_slist *slist;
+    DownloadData data;          /* pvOut is the download FILE when pathname is set */
+    FILE *headerfile;
+    bool cancel;
+    asyncDwnlResult_t result;
+    struct asyncReq *next;
+} AsyncReq_t;
+
+/* Everything below is protected by engineLock. The multi handle is only used by the loop thread */
+static pthread_mutex_t engineLock = PTHREAD_MUTEX_INITIALIZER;
+static AsyncReq_t *reqList = NULL;
+static int nextReqId = 0;
+static int activeCount = 0;
+static bool engineRunning = false;
+static bool engineStop = false;
+static pthread_t loopThread;
+static int wakePipe[2] = { -1, -1 };
+static CURLM *multi = NULL;
+
+/* Wake the loop thread from curl_multi_wait */
+static void wakeLoop(void) {
+    char c = 'w';
+    if (wakePipe[1] >= 0) {
+        if (write(wakePipe[1], &c, 1) < 0 && errno != EAGAIN) {
+            COMMONUTILITIES_ERROR("%s: write failed errno=%d\n", __FUNCTION__, errno);
+        }
+    }
+}
+
+static void drainWakePipe(void) {
+    char buf[64];
+    while (read(wakePipe[0], buf, sizeof(buf)) > 0) {
+    }
+}
+
+/* releaseReqResources(): Close output files and give the curl handle back to the pool */
+static void releaseReqResources(AsyncReq_t *req) {
+    if (req->data.pvOut != NULL) {
+        fflush((FILE *)req->data.pvOut);
+        fclose((FILE *)req->data.pvOut);
+        req->data.pvOut = NULL;
+    }
+    if (req->headerfile != NULL) {
+        fclose(req->headerfile);
+        req->headerfile = NULL;
+    }
+    if (req->slist != NULL) {
+        curl_slist_free_all(req->slist);
+        req->slist = NULL;
+    }
+    if (req->curl != NULL) {
+        urlHelperDestroyCurl(req->curl);
+        req->curl = NULL;
+    }
+}
+
+/* finishReq(): Set final state of a request. Must be called with engineLock held.
+ * Request with callback is moved to done list, the callback is called after unlock.
+ * */
+static void finishReq(AsyncReq_t **link, AsyncReq_t *req, asyncDwnlState_t state, AsyncReq_t **done) {
+    if (req->result.state == ASYNC_DWNL_RUNNING) {
+        curl_multi_remove_handle(multi, req->curl);
+        activeCount--;
+    }
+    req->result.state = state;
+    if (req->data.pvOut != NULL) {
+        req->result.bytes = req->data.datasize;
+    } else if (req->pfile_dwnl->pDlData != NULL) {
+        req->result.bytes = req->pfile_dwnl->pDlData->datasize;
+    }
+    releaseReqResources(req);
+    if (req->cb != NULL) {
+        *link = req->next;
+        req->next = *done;
+        *done = req;
+    }
+}
+
+/* runCallbacks(): Call completion callback and free the requests. Must be called without engineLock */
+static void runCallbacks(AsyncReq_t *done) {
+    AsyncReq_t *req;
+    while (done != NULL) {
+        req = done;
+        done = done->next;
+        COMMONUTILITIES_INFO("%s: request %d state=%d curl code=%d http code=%d bytes=%zu\n", __FUNCTION__,
+                             req->id, req->result.state, req->result.curl_code, req->result.http_code, req->result.bytes);
+        req->cb(req->id, req->pfile_dwnl, &req->result, req->userdata);
+        free(req);
+    }
+}
+
+/* reqCancelled(): Check cancel of asyncDwnlCancel and cancel token of the request */
+static bool reqCancelled(AsyncReq_t *req) {
+    return req->cancel || cancelTokenIsCancelled(req->token);
+}
+
+/* async_xferinfo(): Progress callback of requests with a cancel token, abort the transfer
+ * without waiting for the event loop */
+static int async_xferinfo(void *p, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    (void)dltotal; (void)dlnow; (void)ultotal; (void)ulnow;
+    return cancelTokenIsCancelled((CancelToken_t *)p) ? 1 : 0;
+}
+
+/* scheduleRequests(): Handle cancellation and start queued requests. Must be called with engineLock held */
+static void scheduleRequests(AsyncReq_t **done) {
+    AsyncReq_t **link = &reqList;
+    AsyncReq_t *req;
+
+    while ((req = *link) != NULL) {
+        if (reqCancelled(req) && (req->result.state == ASYNC_DWNL_QUEUED || req->result.state == ASYNC_DWNL_RUNNING)) {
+            req->result.curl_code = CURLE_ABORTED_BY_CALLBACK;
+            finishReq(link, req, ASYNC_DWNL_CANCELLED, done);
+            if (*link != req) {
+                continue;
+            }
+        } else if (req->result.state == ASYNC_DWNL_QUEUED && activeCount < ASYNC_DWNL_MAX_ACTIVE) {
+            if (curl_multi_add_handle(multi, req->curl) == CURLM_OK) {
+                req->result.state = ASYNC_DWNL_RUNNING;
+                activeCount++;
+            } else {
+                COMMONUTILITIES_ERROR("%s: curl_multi_add_handle failed for request %d\n", __FUNCTION__, req->id);
+                req->result.curl_code = CURLE_FAILED_INIT;
+                finishReq(link, req, ASYNC_DWNL_DONE, done);
+                if (*link != req) {
+                    continue;
+                }
+            }
+        }
+        link = &req->next;
+    }
+}
+
+/* collectCompleted(): Read finished transfers from the multi handle. Must be called with engineLock held */
+static void collectCompleted(AsyncReq_t **done) {
+    CURLMsg *msg;
+    AsyncReq_t **link;
+    AsyncReq_t *req;
+    long http_code = 0;
+    long connects = 0;
+    int msgs_left = 0;
+
+    while ((msg = curl_multi_info_read(multi, &msgs_left)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        for (link = &reqList; (req = *link) != NULL; link = &req->next) {
+            if (req->curl == msg->easy_handle) {
+                break;
+            }
+        }
+        if (req == NULL) {
+            continue;
+        }
+        if (dnsCacheDone(req->curl, msg->data.result)) {
+            /* Cached addresses failed before any response, start again with resolved ones */
+            curl_multi_remove_handle(multi, req->curl);
+            if (curl_multi_add_handle(multi, req->curl) == CURLM_OK) {
+                continue;
+            }
+        }
+        http_code = 0;
+        req->result.curl_code = msg->data.result;
+        transferStatsCollect(req->curl, msg->data.result);
+        curl_easy_getinfo(req->curl, CURLINFO_RESPONSE_CODE, &http_code);
+        req->result.http_code = (int)http_code;
+        connects = 0;
+        curl_easy_getinfo(req->curl, CURLINFO_NUM_CONNECTS, &connects);
+        req->result.connects = connects;
+        finishReq(link, req, (msg->data.result == CURLE_ABORTED_BY_CALLBACK && reqCancelled(req)) ? ASYNC_DWNL_CANCELLED : ASYNC_DWNL_DONE, done);
+    }
+}
+
+/* cancelAll(): Cancel every request and free the records. Called by the loop thread on shutdown */
+static void cancelAll(AsyncReq_t **done) {
+    AsyncReq_t *req;
+
+    while ((req = reqList) != NULL) {
+        if (req->result.state == ASYNC_DWNL_QUEUED || req->result.state == ASYNC_DWNL_RUNNING) {
+            req->result.curl_code = CURLE_ABORTED_BY_CALLBACK;
+            finishReq(&reqList, req, ASYNC_DWNL_CANCELLED, done);
+        }
+        if (reqList == req) {
+            reqList = req->next;
+            free(req);
+        }
+    }
+}
+
+/* Event loop thread. Drive all transfers with a single curl_multi handle */
+static void *asyncDwnlLoop(void *arg) {
+    struct curl_waitfd wake_fd;
+    AsyncReq_t *done = NULL;
+    int running = 0;
+    bool stop = false;
+
+    (void)arg;
+    COMMONUTILITIES_INFO("%s: event loop started\n", __FUNCTION__);
+    while (stop == false) {
+        done = NULL;
+        pthread_mutex_lock(&engineLock);
+        stop = engineStop;
+        if (stop) {
+            cancelAll(&done);
+        } else {
+            scheduleRequests(&done);
+        }
+        pthread_mutex_unlock(&engineLock);
+        runCallbacks(done);
+        if (stop) {
+            break;
+        }
+
+        if (curl_multi_perform(multi, &running) != CURLM_OK) {
+            COMMONUTILITIES_ERROR("%s: curl_multi_perform failed\n", __FUNCTION__);
+        }
+        done = NULL;
+        pthread_mutex_lock(&engineLock);
+        collectCompleted(&done);
+        pthread_mutex_unlock(&engineLock);
+        runCallbacks(done);
+
+        memset(&wake_fd, 0, sizeof(wake_fd));
+        wake_fd.fd = wakePipe[0];
+        wake_fd.events = CURL_WAIT_POLLIN;
+        curl_multi_wait(multi, &wake_fd, 1, 1000, NULL);
+        if (wake_fd.revents) {
+            drainWakePipe();
+        }
+    }
+    COMMONUTILITIES_INFO("%s: event loop stopped\n", __FUNCTION__);
+    return NULL;
+}
+
+/* startEngine(): Create the multi handle and the loop thread. Must be called with engineLock held
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int startEngine(void) {
+    if (engineRunning) {
+        return 0;
+    }
+    if (pipe(wakePipe) != 0) {
+        COMMONUTILITIES_ERROR("%s: pipe failed errno=%d\n", __FUNCTION__, errno);
+        wakePipe[0] = wakePipe[1] = -1;
+        return -1;
+    }
+    fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+    multi = curl_multi_init();
+    if (multi == NULL) {
+        COMMONUTILITIES_ERROR("%s: curl_multi_init failed\n", __FUNCTION__);
+    } else {
+        /* In HTTP/2 mode requests to one host run as streams of a single connection */
+        curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        engineStop = false;
+        if (pthread_create(&loopThread, NULL, asyncDwnlLoop, NULL) == 0) {
+            engineRunning = true;
+            return 0;
+        }
+        COMMONUTILITIES_ERROR("%s: pthread_create failed\n", __FUNCTION__);
+        curl_multi_cleanup(multi);
+        multi = NULL;
+    }
+    close(wakePipe[0]);
+    close(wakePipe[1]);
+    wakePipe[0] = wakePipe[1] = -1;
+    return -1;
+}
+
+/* prepareRequest(): Set all curl options of a request same as doHttpFileDownload
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int prepareRequest(AsyncReq_t *req, MtlsAuth_t *auth) {
+    FileDwnl_t *pfile_dwnl = req->pfile_dwnl;
+    CURLcode ret_code = CURLE_OK;
+    char header_dump[DWNL_PATH_FILE_LEN + 8];
+
+    ret_code = setCommonCurlOpt(req->curl, pfile_dwnl->url, pfile_dwnl->pPostFields, pfile_dwnl->sslverify);
+    if (ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("%s : CURL: setCommonCurlOpt Failed\n", __FUNCTION__);
+        return -1;
+    }
+    transferStatsBegin(req->curl, req->statsData, NULL);
+    if (req->token != NULL) {
+        curl_easy_setopt(req->curl, CURLOPT_XFERINFOFUNCTION, async_xferinfo);
+        curl_easy_setopt(req->curl, CURLOPT_XFERINFODATA, req->token);
+        curl_easy_setopt(req->curl, CURLOPT_NOPROGRESS, 0L);
+    }
+    if (auth != NULL) {
+        ret_code = setMtlsHeaders(req->curl, auth);
+        if (ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("%s : CURL: setMtlsHeaders Failed\n", __FUNCTION__);
+            return -1;
+        }
+    }
+    if (pfile_dwnl->pHeaderData != NULL && *pfile_dwnl->pHeaderData) {
+        req->slist = curl_slist_append(req->slist, pfile_dwnl->pHeaderData);
+    }
+    if (pfile_dwnl->hashData != NULL && pfile_dwnl->hashData->hashvalue != NULL && pfile_dwnl->hashData->hashtime != NULL) {
+        req->slist = curl_slist_append(req->slist, pfile_dwnl->hashData->hashvalue);
+        req->slist = curl_slist_append(req->slist, pfile_dwnl->hashData->hashtime);
+    }
+    if (req->slist != NULL) {
+        ret_code = curl_easy_setopt(req->curl, CURLOPT_HTTPHEADER, req->slist);
+        if (ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("%s : CURL: CURLOPT_HTTPHEADER failed:%s\n", __FUNCTION__, curl_easy_strerror(ret_code));
+            return -1;
+        }
+    }
+    if (*pfile_dwnl->pathname) {
+        req->data.pvOut = (void *)fopen(pfile_dwnl->pathname, "wb");
+        if (req->data.pvOut == NULL) {
+            COMMONUTILITIES_ERROR("%s: File open Fail:%s\n", __FUNCTION__, pfile_dwnl->pathname);
+            return -1;
+        }
+        snprintf(header_dump, sizeof(header_dump), "%s.header", pfile_dwnl->pathname);
+        req->headerfile = fopen(header_dump, "w");
+        if (req->headerfile == NULL) {
+            COMMONUTILITIES_ERROR("%s: path=%s file unable to open\n", __FUNCTION__, header_dump);
+            return -1;
+        }
+        ret_code = setFileWriteOpt(req->curl, &req->data, req->headerfile);
+    } else if (pfile_dwnl->pDlData != NULL && pfile_dwnl->pDlData->pvOut != NULL) {
+        *((char *)pfile_dwnl->pDlData->pvOut) = 0;
+        pfile_dwnl->pDlData->datasize = 0;
+        if (pfile_dwnl->pDlHeaderData != NULL && pfile_dwnl->pDlHeaderData->pvOut != NULL) {
+            *((char *)pfile_dwnl->pDlHeaderData->pvOut) = 0;
+            pfile_dwnl->pDlHeaderData->datasize = 0;
+        }
+        req->mem_cancel.data = pfile_dwnl->pDlData;
+        req->mem_cancel.cancel = req->token;
+        ret_code = setMemWriteOpt(req->curl, pfile_dwnl, (req->token != NULL) ? &req->mem_cancel : NULL);
+    } else {
+        COMMONUTILITIES_ERROR("%s: No download path or memory present\n", __FUNCTION__);
+        return -1;
+    }
+    return (ret_code == CURLE_OK) ? 0 : -1;
+}
+
+int asyncDwnlSubmit(FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, MtlsAuth_t *auth, asyncDwnlCallback_t cb, void *userdata) {
+    AsyncReq_t *req = NULL;
+    AsyncReq_t **link = NULL;
+    int id;
+
+    if (pfile_dwnl == NULL) {
+        COMMONUTILITIES_ERROR("%s: Parameter Check Fail\n", __FUNCTION__);
+        return DWNL_FAIL;
+    }
+    /* Waits of a retry policy would block the event loop of all requests */
+    if (opts != NULL && opts->retryData != NULL) {
+        COMMONUTILITIES_ERROR("%s: retry policy is not supported, retry from the callback\n", __FUNCTION__);
+        return DWNL_FAIL;
+    }
+    /* Only the cancel token and stats are applied by the event loop, a request must not
+     * silently run without the mode it asked for */
+    if (opts != NULL && (opts->segmentData != NULL || opts->writeBehind != NULL || opts->digestData != NULL
+        || opts->journalData != NULL || opts->memData != NULL || opts->headerData != NULL || opts->bwData != NULL
+        || opts->encodingData != NULL || opts->cacheData != NULL || opts->deltaData != NULL
+        || opts->preallocData != NULL || opts->extractData != NULL)) {
+        COMMONUTILITIES_ERROR("%s: download mode is not supported, only cancel and statsData can be set\n", __FUNCTION__);
+        return DWNL_FAIL;
+    }
+    req = (AsyncReq_t *)calloc(1, sizeof(AsyncReq_t));
+    if (req == NULL) {
+        COMMONUTILITIES_ERROR("%s: calloc failed\n", __FUNCTION__);
+        return DWNL_FAIL;
+    }
+    req->pfile_dwnl = pfile_dwnl;
+    if (opts != NULL) {
+        req->token = opts->cancel;
+        req->statsData = opts->statsData;
+    }
+    req->cb = cb;
+    req->userdata = userdata;
+    req->result.state = ASYNC_DWNL_QUEUED;
+    req->result.curl_code = CURLE_OK;
+    req->curl = urlHelperCreateCurl();
+    if (req->curl == NULL || prepareRequest(req, auth) != 0) {
+        releaseReqResources(req);
+        free(req);
+        return DWNL_FAIL;
+    }
+
+    pthread_mutex_lock(&engineLock);
+    if (startEngine() != 0) {
+        pthread_mutex_unlock(&engineLock);
+        releaseReqResources(req);
+        free(req);
+        return DWNL_FAIL;
+    }
+    if (nextReqId == INT_MAX) {
+        nextReqId = 0;
+    }
+    id = req->id = ++nextReqId;
+    for (link = &reqList; *link != NULL; link = &(*link)->next) {
+    }
+    *link = req;
+    pthread_mutex_unlock(&engineLock);
+    wakeLoop();
+    COMMONUTILITIES_INFO("%s: request %d queued url=%s\n", __FUNCTION__, id, pfile_dwnl->url);
+    return id;
+}
+
+int asyncDwnlCancel(int req_id) {
+    AsyncReq_t *req;
+    int ret = DWNL_FAIL;
+
+    pthread_mutex_lock(&engineLock);
+    for (req = reqList; req != NULL; req = req->next) {
+        if (req->id == req_id) {
+            if (req->cancel == false && (req->result.state == ASYNC_DWNL_QUEUED || req->result.state == ASYNC_DWNL_RUNNING)) {
+                req->cancel = true;
+                ret = 0;
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&engineLock);
+    if (ret == 0) {
+        COMMONUTILITIES_INFO("%s: request %d cancel requested\n", __FUNCTION__, req_id);
+        wakeLoop();
+    }
+    return ret;
+}
+
+asyncDwnlState_t asyncDwnlPoll(int req_id, asyncDwnlResult_t *result) {
+    AsyncReq_t **link;
+    AsyncReq_t *req;
+    asyncDwnlState_t state = ASYNC_DWNL_UNKNOWN;
+
+    pthread_mutex_lock(&engineLock);
+    for (link = &reqList; (req = *link) != NULL; link = &req->next) {
+        if (req->id == req_id) {
+            state = req->result.state;
+            if (result != NULL) {
+                *result = req->result;
+            }
+            /* Final result of a request without callback is given only once */
+            if (state == ASYNC_DWNL_DONE || state == ASYNC_DWNL_CANCELLED) {
+                *link = req->next;
+                free(req);
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&engineLock);
+    if (state == ASYNC_DWNL_UNKNOWN && result != NULL) {
+        memset(result, 0, sizeof(asyncDwnlResult_t));
+        result->state = ASYNC_DWNL_UNKNOWN;
+    }
+    return state;
+}
+
+void asyncDwnlShutdown(void) {
+    pthread_mutex_lock(&engineLock);
+    if (engineRunning == false) {
+        pthread_mutex_unlock(&engineLock);
+        return;
+    }
+    if (pthread_equal(pthread_self(), loopThread)) {
+        pthread_mutex_unlock(&engineLock);
+        COMMONUTILITIES_ERROR("%s: not allowed from completion callback\n", __FUNCTION__);
+        return;
+    }
+    engineStop = true;
+    pthread_mutex_unlock(&engineLock);
+    wakeLoop();
+    pthread_join(loopThread, NULL);
+
+    pthread_mutex_lock(&engineLock);
+    curl_multi_cleanup(multi);
+    multi = NULL;
+    close(wakePipe[0]);
+    close(wakePipe[1]);
+    wakePipe[0] = wakePipe[1] = -1;
+    activeCount = 0;
+    engineRunning = false;
+    pthread_mutex_unlock(&engineLock);
+    COMMONUTILITIES_INFO("%s: async download engine stopped\n", __FUNCTION__);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_ASYNCDOWNLOAD_H_
+#define  _RDK_ASYNCDOWNLOAD_H_
+
+#include "urlHelper.h"
+
+#ifndef ASYNC_DWNL_MAX_ACTIVE //This is to provide an option Define custom parallel transfer count using DFLAGS
+#define ASYNC_DWNL_MAX_ACTIVE 32
+#endif
+
+/* State of an asynchronous request returned by asyncDwnlPoll */
+typedef enum {
+    ASYNC_DWNL_UNKNOWN = -1,    /* id never submitted or already released */
+    ASYNC_DWNL_QUEUED = 0,      /* waiting for a free transfer slot */
+    ASYNC_DWNL_RUNNING,         /* transfer in progress */
+    ASYNC_DWNL_DONE,            /* transfer finished, result valid */
+    ASYNC_DWNL_CANCELLED        /* cancelled by asyncDwnlCancel or asyncDwnlShutdown */
+} asyncDwnlState_t;
+
+/* Result of an asynchronous request */
+typedef struct asyncDwnlResult {
+    asyncDwnlState_t state;
+    CURLcode curl_code;
+    int http_code;
+    size_t bytes;
+    long connects;              /* new connections opened by the request, 0 when reused */
+} asyncDwnlResult_t;
+
+/* Completion callback. Called from the event loop thread once per request,
+ * it must not block for long as all other transfers wait for it.
+ * req_id : id returned by asyncDwnlSubmit
+ * pfile_dwnl : request descriptor given to asyncDwnlSubmit
+ * result : final state and status of the request
+ * userdata : pointer given to asyncDwnlSubmit
+ * */
+typedef void (*asyncDwnlCallback_t)(int req_id, FileDwnl_t *pfile_dwnl, asyncDwnlResult_t *result, void *userdata);
+
+/* asyncDwnlSubmit(): Queue a request on the event loop thread. The thread is started on first use.
+ *                    Body is stored to pathname when set otherwise to pDlData same as doHttpFileDownload.
+ * pfile_dwnl : Request descriptor. Must stay valid till the request is completed.
+ * opts : Optional download modes, NULL for none. Only cancel and statsData are supported, the request
+ *        fails when any other mode is set. The cancel token cancels the request same as asyncDwnlCancel,
+ *        statsData must stay valid till the request is completed
+ * auth : Structure contains certificate and key, NULL if not required
+ * cb : Completion callback. When NULL the result is kept till asyncDwnlPoll read a final state
+ * userdata : Passed back to cb
+ * Return : int : request id greater than 0 on success, DWNL_FAIL on failure
+ * */
+int asyncDwnlSubmit(FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, MtlsAuth_t *auth, asyncDwnlCallback_t cb, void *userdata);
+
+/* asyncDwnlCancel(): Cancel a queued or running request. The completion callback is
+ *                    called with state ASYNC_DWNL_CANCELLED.
+ * req_id : id returned by asyncDwnlSubmit
+ * Return : int : 0 on success, DWNL_FAIL if request is not present or already finished
+ * */
+int asyncDwnlCancel(int req_id);
+
+/* asyncDwnlPoll(): Read the state of a request without blocking.
+ * req_id : id returned by asyncDwnlSubmit
+ * result : Send back state and result, can be NULL
+ * Return : asyncDwnlState_t : current state
+ * */
+asyncDwnlState_t asyncDwnlPoll(int req_id, asyncDwnlResult_t *result);
+
+/* asyncDwnlShutdown(): Cancel all pending requests and stop the event loop thread.
+ *                      Must not be called from a completion callback.
+ * */
+void asyncDwnlShutdown(void);
+
+#endif
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "bandwidthGovernor.h"
+
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <curl/curl.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+struct bwGovernor {
+    unsigned long long rate;    /* bytes per second, 0 for no limit. Read without lock */
+    unsigned long long burst;   /* 0 for default */
+    pthread_mutex_t lock;       /* protect tokens and last_us */
+    double tokens;              /* bytes that can pass now, negative when in debt */
+    unsigned long long last_us; /* time of last refill */
+};
+
+/* Binding of a curl handle to the governor of its transfer */
+typedef struct bwAttached {
+    const void *handle;
+    BwGovernor_t *gov;
+} BwAttached_t;
+
+static BwGovernor_t total_gov = { 0, 0, PTHREAD_MUTEX_INITIALIZER, 0, 0 };
+static BwAttached_t attached[BW_MAX_ATTACHED];
+static pthread_mutex_t attach_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned long long bwNowUs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)ts.tv_nsec / 1000ULL;
+}
+
+/* bwBurst(): Bucket size for rate and configured burst */
+static double bwBurst(unsigned long long rate, unsigned long long burst) {
+    unsigned long long size = (burst > 0) ? burst : rate * BW_BURST_MS / 1000;
+
+    return (double)((size > BW_MIN_BURST) ? size : BW_MIN_BURST);
+}
+
+/* bwRefill(): Add tokens earned since last refill. Called with lock held */
+static void bwRefill(BwGovernor_t *gov, unsigned long long rate, unsigned long long now) {
+    double size = bwBurst(rate, __atomic_load_n(&gov->burst, __ATOMIC_RELAXED));
+
+    if (now > gov->last_us) {
+        gov->tokens += (double)(now - gov->last_us) * (double)rate / 1000000.0;
+    }
+    if (gov->tokens > size) {
+        gov->tokens = size;
+    }
+    gov->last_us = now;
+}
+
+/* bwCharge(): Take bytes from the bucket, nothing is recorded while there is no limit */
+static void bwCharge(BwGovernor_t *gov, size_t bytes) {
+    unsigned long long rate;
+
+    pthread_mutex_lock(&gov->lock);
+    rate = __atomic_load_n(&gov->rate, __ATOMIC_ACQUIRE);
+    if (rate > 0) {
+        bwRefill(gov, rate, bwNowUs());
+        gov->tokens -= (double)bytes;
+    }
+    pthread_mutex_unlock(&gov->lock);
+}
+
+/* bwDebtUs(): Time in microseconds until the bucket is out of debt at current rate */
+static unsigned long long bwDebtUs(BwGovernor_t *gov) {
+    unsigned long long rate;
+    unsigned long long wait = 0;
+
+    pthread_mutex_lock(&gov->lock);
+    rate = __atomic_load_n(&gov->rate, __ATOMIC_ACQUIRE);
+    if (rate > 0) {
+        bwRefill(gov, rate, bwNowUs());
+        if (gov->tokens < 0) {
+            wait = (unsigned long long)(-gov->tokens * 1000000.0 / (double)rate) + 1;
+        }
+    }
+    pthread_mutex_unlock(&gov->lock);
+    return wait;
+}
+
+static void bwInit(BwGovernor_t *gov, unsigned long long rate, unsigned long long burst) {
+    gov->rate = rate;
+    gov->burst = burst;
+    gov->tokens = bwBurst(rate, burst);
+    gov->last_us = bwNowUs();
+}
+
+BwGovernor_t *bwGovernorCreate(unsigned long long rate, unsigned long long burst) {
+    BwGovernor_t *gov = malloc(sizeof(BwGovernor_t));
+
+    if (gov == NULL) {
+        COMMONUTILITIES_ERROR("%s: unable to allocate governor\n", __FUNCTION__);
+        return NULL;
+    }
+    pthread_mutex_init(&gov->lock, NULL);
+    bwInit(gov, rate, burst);
+    return gov;
+}
+
+void bwGovernorDestroy(BwGovernor_t *gov) {
+    if (gov == NULL || gov == &total_gov) {
+        return;
+    }
+    pthread_mutex_destroy(&gov->lock);
+    free(gov);
+}
+
+BwGovernor_t *bwGovernorTotal(void) {
+    return &total_gov;
+}
+
+void bwGovernorSetRate(BwGovernor_t *gov, unsigned long long rate, unsigned long long burst) {
+    unsigned long long old;
+
+    if (gov == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&gov->lock);
+    old = __atomic_load_n(&gov->rate, __ATOMIC_ACQUIRE);
+    if (old > 0) {
+        /* Time until now is paid at the old rate, the new one applies from now on */
+        bwRefill(gov, old, bwNowUs());
+        __atomic_store_n(&gov->burst, burst, __ATOMIC_RELAXED);
+        if (gov->tokens > bwBurst(rate, burst)) {
+            gov->tokens = bwBurst(rate, burst);
+        }
+    } else {
+        /* Without limit nothing was recorded, start with a full bucket */
+        __atomic_store_n(&gov->burst, burst, __ATOMIC_RELAXED);
+        gov->tokens = bwBurst(rate, burst);
+        gov->last_us = bwNowUs();
+    }
+    __atomic_store_n(&gov->rate, rate, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&gov->lock);
+    COMMONUTILITIES_INFO("%s: %s rate=%llu bytes/s burst=%llu\n", __FUNCTION__,
+                         (gov == &total_gov) ? "total" : "transfer", rate, burst);
+}
+
+unsigned long long bwGovernorGetRate(BwGovernor_t *gov) {
+    return (gov != NULL) ? __atomic_load_n(&gov->rate, __ATOMIC_ACQUIRE) : 0;
+}
+
+int bwGovernorConsume(BwGovernor_t *gov, size_t bytes, int (*stop)(void *arg), void *arg) {
+    unsigned long long wait;
+    unsigned long long total_wait;
+    struct timespec ts;
+
+    if (bwGovernorGetRate(gov) == 0 && bwGovernorGetRate(&total_gov) == 0) {
+        return 0;
+    }
+    if (gov != NULL) {
+        bwCharge(gov, bytes);
+    }
+    bwCharge(&total_gov, bytes);
+    while (1) {
+        wait = (gov != NULL) ? bwDebtUs(gov) : 0;
+        total_wait = bwDebtUs(&total_gov);
+        if (total_wait > wait) {
+            wait = total_wait;
+        }
+        if (wait == 0) {
+            return 0;
+        }
+        if (stop != NULL && stop(arg) != 0) {
+            return -1;
+        }
+        /* Sleep in slices so that rate changes and stop requests are seen quickly */
+        if (wait > BW_WAIT_SLICE_MS * 1000ULL) {
+            wait = BW_WAIT_SLICE_MS * 1000ULL;
+        }
+        ts.tv_sec = wait / 1000000ULL;
+        ts.tv_nsec = (wait % 1000000ULL) * 1000ULL;
+        nanosleep(&ts, NULL);
+    }
+}
+
+int bwGovernorAttach(const void *handle, BwGovernor_t *gov) {
+    int i;
+    int ret = -1;
+
+    if (handle == NULL || gov == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&attach_lock);
+    for (i = 0; i < BW_MAX_ATTACHED; i++) {
+        if (attached[i].handle == NULL || attached[i].handle == handle) {
+            attached[i].handle = handle;
+            attached[i].gov = gov;
+            ret = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&attach_lock);
+    if (ret != 0) {
+        COMMONUTILITIES_ERROR("%s: %d handles already governed, rate of this transfer can not be changed\n", __FUNCTION__, BW_MAX_ATTACHED);
+    }
+    return ret;
+}
+
+void bwGovernorDetach(const void *handle) {
+    int i;
+
+    pthread_mutex_lock(&attach_lock);
+    for (i = 0; i < BW_MAX_ATTACHED; i++) {
+        if (attached[i].handle == handle) {
+            attached[i].handle = NULL;
+            attached[i].gov = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&attach_lock);
+}
+
+int bwGovernorSetHandleRate(const void *handle, unsigned long long rate, unsigned long long burst) {
+    int i;
+    int ret = -1;
+
+    if (handle == NULL) {
+        return -1;
+    }
+    /* Rate is set with the binding lock held, the transfer can not detach and free the governor meanwhile */
+    pthread_mutex_lock(&attach_lock);
+    for (i = 0; i < BW_MAX_ATTACHED; i++) {
+        if (attached[i].handle == handle) {
+            bwGovernorSetRate(attached[i].gov, rate, burst);
+            ret = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&attach_lock);
+    return ret;
+}
+
+size_t bwGovernorReadCB(char *buffer, size_t size, size_t nitems, void *userp) {
+    FILE *fp = userp;
+    size_t nread = fread(buffer, size, nitems, fp);
+
+    if (nread == 0 && ferror(fp)) {
+        COMMONUTILITIES_ERROR("%s: read of upload data failed\n", __FUNCTION__);
+        return CURL_READFUNC_ABORT;
+    }
+    bwGovernorConsume(NULL, nread * size, NULL, NULL);
+    return nread;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_BANDWIDTHGOVERNOR_H_
+#define  _RDK_BANDWIDTHGOVERNOR_H_
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifndef BW_BURST_MS //This is to provide an option Define custom default burst (time at full rate) using DFLAGS
+#define BW_BURST_MS 250
+#endif
+
+#ifndef BW_MIN_BURST //This is to provide an option Define custom smallest burst using DFLAGS
+#define BW_MIN_BURST 16384
+#endif
+
+#ifndef BW_WAIT_SLICE_MS //This is to provide an option Define custom longest single sleep using DFLAGS
+#define BW_WAIT_SLICE_MS 50
+#endif
+
+#ifndef BW_MAX_ATTACHED //This is to provide an option Define custom count of governed handles using DFLAGS
+#define BW_MAX_ATTACHED 16
+#endif
+
+/* Token bucket limiting the rate of one transfer, or of all transfers for bwGovernorTotal().
+ * Tokens are bytes, refilled at rate per second up to burst. A transfer may take more than
+ * the available tokens, it then waits until the debt is paid back.
+ * Rate and burst can be changed from any thread while transfers are running */
+typedef struct bwGovernor BwGovernor_t;
+
+/* bwGovernorCreate(): Create a governor
+ * rate : bytes per second, 0 for no limit
+ * burst : bytes allowed at once after idle time, 0 for BW_BURST_MS at rate
+ * Return : BwGovernor_t * : governor, NULL if memory is not available
+ * */
+BwGovernor_t *bwGovernorCreate(unsigned long long rate, unsigned long long burst);
+
+/* bwGovernorDestroy(): Free a governor created by bwGovernorCreate */
+void bwGovernorDestroy(BwGovernor_t *gov);
+
+/* bwGovernorTotal(): Process wide governor charged by every governed download and upload.
+ * Its rate is 0 (no limit) until set with bwGovernorSetRate
+ * */
+BwGovernor_t *bwGovernorTotal(void);
+
+/* bwGovernorSetRate(): Change rate and burst. Transfers waiting on the governor use the new
+ * values within BW_WAIT_SLICE_MS, rate 0 release them at once
+ * */
+void bwGovernorSetRate(BwGovernor_t *gov, unsigned long long rate, unsigned long long burst);
+
+/* bwGovernorGetRate(): Current rate in bytes per second, 0 for no limit */
+unsigned long long bwGovernorGetRate(BwGovernor_t *gov);
+
+/* bwGovernorConsume(): Charge bytes to gov and to the total governor, then wait until
+ * both buckets are out of debt. Called from curl write and read callbacks
+ * gov : governor of the transfer, NULL to charge the total governor only
+ * stop : called with arg between sleeps, a non zero value ends the wait, NULL if not required
+ * Return : int : 0 when bytes can be passed on, -1 when stopped
+ * */
+int bwGovernorConsume(BwGovernor_t *gov, size_t bytes, int (*stop)(void *arg), void *arg);
+
+/* bwGovernorAttach(): Bind a governor to a curl handle so that its rate can be changed
+ *                     by bwGovernorSetHandleRate while the handle is transferring
+ * Return : int : 0 on success, -1 when BW_MAX_ATTACHED handles are already bound
+ * */
+int bwGovernorAttach(const void *handle, BwGovernor_t *gov);
+
+/* bwGovernorDetach(): Remove binding of handle, must be done before the governor is destroyed */
+void bwGovernorDetach(const void *handle);
+
+/* bwGovernorSetHandleRate(): Change rate of the governor bound to handle
+ * Return : int : 0 on success, -1 when no governor is bound to handle
+ * */
+int bwGovernorSetHandleRate(const void *handle, unsigned long long rate, unsigned long long burst);
+
+/* bwGovernorReadCB(): curl read callback reading from FILE * userp, charged to the total governor */
+size_t bwGovernorReadCB(char *buffer, size_t size, size_t nitems, void *userp);
+
+#endif
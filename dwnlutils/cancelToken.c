@@ -0,0 +1,66 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "cancelToken.h"
+
+#include <stdlib.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+struct cancelToken {
+    int cancelled;                  /* accessed with atomic builtins only */
+    struct cancelToken *parent;
+};
+
+CancelToken_t *cancelTokenCreate(CancelToken_t *parent) {
+    CancelToken_t *token = malloc(sizeof(CancelToken_t));
+
+    if (token == NULL) {
+        COMMONUTILITIES_ERROR("%s: unable to allocate token\n", __FUNCTION__);
+        return NULL;
+    }
+    token->cancelled = 0;
+    token->parent = parent;
+    return token;
+}
+
+void cancelTokenDestroy(CancelToken_t *token) {
+    free(token);
+}
+
+void cancelTokenCancel(CancelToken_t *token) {
+    if (token != NULL) {
+        COMMONUTILITIES_INFO("%s: cancel token %p\n", __FUNCTION__, (void *)token);
+        __atomic_store_n(&token->cancelled, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void cancelTokenReset(CancelToken_t *token) {
+    if (token != NULL) {
+        __atomic_store_n(&token->cancelled, 0, __ATOMIC_RELEASE);
+    }
+}
+
+bool cancelTokenIsCancelled(const CancelToken_t *token) {
+    for (; token != NULL; token = token->parent) {
+        if (__atomic_load_n(&token->cancelled, __ATOMIC_ACQUIRE) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_CANCELTOKEN_H_
+#define  _RDK_CANCELTOKEN_H_
+
+#include <stdbool.h>
+
+/* Cancellation context of a transfer or of a group of transfers.
+ * A token created with a parent is cancelled when the parent is cancelled, so one
+ * group token can stop all its transfers while other transfers keep running.
+ * Tokens can be cancelled from any thread, transfers check them in their write,
+ * read and progress callbacks. A parent must be destroyed after its children */
+typedef struct cancelToken CancelToken_t;
+
+/* cancelTokenCreate(): Create a token
+ * parent : group token, NULL for a token without group
+ * Return : CancelToken_t * : token, NULL if memory is not available
+ * */
+CancelToken_t *cancelTokenCreate(CancelToken_t *parent);
+
+/* cancelTokenDestroy(): Free a token created by cancelTokenCreate */
+void cancelTokenDestroy(CancelToken_t *token);
+
+/* cancelTokenCancel(): Cancel token and all tokens created with it as parent */
+void cancelTokenCancel(CancelToken_t *token);
+
+/* cancelTokenReset(): Make a token usable again for a new transfer */
+void cancelTokenReset(CancelToken_t *token);
+
+/* cancelTokenIsCancelled(): Check token and its parents
+ * Return : bool : true when token or one of its parents is cancelled, false for NULL token
+ * */
+bool cancelTokenIsCancelled(const CancelToken_t *token);
+
+#endif
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "connectivityProbe.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "retryPolicy.h"
+
+/* State of one probe round, shared by the caller and the endpoint threads.
+ * Freed by the last user, threads of losing endpoints may end after the caller returned */
+typedef struct probeRound {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int refs;
+    int pending;                /* endpoint threads not finished */
+    int decided;                /* set when an endpoint reported online, read by progress callback */
+    probeVerdict_t verdict;
+    int endpoint;
+    long timeout_ms;
+    unsigned long long start_ms;
+    unsigned long long end_ms;
+    ProbeEndpoint_t endpoints[PROBE_MAX_ENDPOINTS];
+} ProbeRound_t;
+
+/* Argument of an endpoint thread */
+typedef struct probeTask {
+    ProbeRound_t *round;
+    int index;
+} ProbeTask_t;
+
+static pthread_mutex_t probe_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t probe_cond = PTHREAD_COND_INITIALIZER;
+static ProbeEndpoint_t probe_endpoints[PROBE_MAX_ENDPOINTS] = {
+    { CONNECTIVITY_PROBE_URL, CONNECTIVITY_PROBE_CODE, CURL_IPRESOLVE_WHATEVER }
+};
+static int probe_count = 1;
+static unsigned int probe_ttl_ms = CONNECTIVITY_PROBE_TTL_MS;
+static bool probe_running = false;
+static bool probe_valid = false;        /* last verdict can be served from cache */
+static bool probe_done = false;         /* a probe was completed since start */
+static unsigned long long probe_time_ms = 0;
+static ProbeResult_t probe_last;
+
+static void roundRelease(ProbeRound_t *round) {
+    int refs;
+
+    pthread_mutex_lock(&round->lock);
+    refs = --round->refs;
+    pthread_mutex_unlock(&round->lock);
+    if (refs == 0) {
+        pthread_cond_destroy(&round->cond);
+        pthread_mutex_destroy(&round->lock);
+        free(round);
+    }
+}
+
+/* probe_xferinfo(): Abort endpoints which lost the race */
+static int probe_xferinfo(void *p, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    ProbeRound_t *round = p;
+
+    (void)dltotal; (void)dlnow; (void)ultotal; (void)ulnow;
+    return __atomic_load_n(&round->decided, __ATOMIC_ACQUIRE);
+}
+
+/* probeEndpoint(): Send probe request of one endpoint
+ * Return : probeVerdict_t : verdict of this endpoint alone
+ * */
+static probeVerdict_t probeEndpoint(ProbeRound_t *round, const ProbeEndpoint_t *ep) {
+    CURL *curl;
+    CURLcode res;
+    long http_code = 0;
+    struct curl_slist *chunk = NULL;
+    probeVerdict_t verdict = PROBE_UNKNOWN;
+
+    curl = urlHelperCreateCurl();
+    if (curl == NULL) {
+        COMMONUTILITIES_ERROR("%s: curl init failed\n", __FUNCTION__);
+        return PROBE_UNKNOWN;
+    }
+    chunk = curl_slist_append(chunk, "Cache-Control: no-cache, no-store");
+    if (curl_easy_setopt(curl, CURLOPT_URL, ep->url) != CURLE_OK
+        || curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk) != CURLE_OK
+        || curl_easy_setopt(curl, CURLOPT_USERAGENT, "RDKCaptiveCheck/1.0") != CURLE_OK
+        || curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L) != CURLE_OK
+        || curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeFunction) != CURLE_OK) {
+        COMMONUTILITIES_ERROR("%s: curl_easy_setopt failed for %s\n", __FUNCTION__, ep->url);
+        urlHelperDestroyCurl(curl);
+        curl_slist_free_all(chunk);
+        return PROBE_UNKNOWN;
+    }
+    curl_easy_setopt(curl, CURLOPT_IPRESOLVE, ep->ip_resolve);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, round->timeout_ms);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, probe_xferinfo);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, round);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+
+    res = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    urlHelperDestroyCurl(curl);
+    curl_slist_free_all(chunk);
+
+    if (res == CURLE_OK && http_code == ep->expect_code) {
+        verdict = PROBE_ONLINE;
+    } else if (res == CURLE_OK && http_code > 0) {
+        COMMONUTILITIES_INFO("%s: %s answered http=%ld, expected %ld\n", __FUNCTION__, ep->url, http_code, ep->expect_code);
+        verdict = PROBE_CAPTIVE;
+    } else if (res != CURLE_OK && res != CURLE_ABORTED_BY_CALLBACK && retryNetworkError(res)) {
+        COMMONUTILITIES_INFO("%s: %s failed: %s\n", __FUNCTION__, ep->url, curl_easy_strerror(res));
+        verdict = PROBE_OFFLINE;
+    }
+    return verdict;
+}
+
+static void *probeThread(void *arg) {
+    ProbeTask_t *task = arg;
+    ProbeRound_t *round = task->round;
+    int index = task->index;
+    probeVerdict_t verdict;
+
+    free(task);
+    verdict = probeEndpoint(round, &round->endpoints[index]);
+    pthread_mutex_lock(&round->lock);
+    if (!round->decided) {
+        /* Online decide at once, a captive answer outweigh network failures of other endpoints */
+        if (verdict == PROBE_ONLINE) {
+            __atomic_store_n(&round->decided, 1, __ATOMIC_RELEASE);
+            round->verdict = PROBE_ONLINE;
+            round->endpoint = index;
+            round->end_ms = retryNowMs();
+        } else if (verdict == PROBE_CAPTIVE || (verdict == PROBE_OFFLINE && round->verdict == PROBE_UNKNOWN)) {
+            round->verdict = verdict;
+            round->endpoint = index;
+        }
+    }
+    round->pending--;
+    if (round->pending == 0 && !round->decided) {
+        round->end_ms = retryNowMs();
+    }
+    pthread_cond_broadcast(&round->cond);
+    pthread_mutex_unlock(&round->lock);
+    roundRelease(round);
+    return NULL;
+}
+
+/* probeRun(): Start one thread per endpoint and wait for the first online answer or the end of all.
+ * Waiting is limited to the timeout with one second margin, curl timeouts normally end it before */
+static probeVerdict_t probeRun(const ProbeEndpoint_t *endpoints, int count, long timeout_ms, ProbeResult_t *result) {
+    ProbeRound_t *round;
+    ProbeTask_t *task;
+    pthread_t tid;
+    pthread_attr_t attr;
+    struct timespec deadline;
+    probeVerdict_t verdict;
+    int i;
+
+    round = calloc(1, sizeof(ProbeRound_t));
+    if (round == NULL) {
+        COMMONUTILITIES_ERROR("%s: unable to allocate probe\n", __FUNCTION__);
+        return PROBE_UNKNOWN;
+    }
+    pthread_mutex_init(&round->lock, NULL);
+    pthread_cond_init(&round->cond, NULL);
+    memcpy(round->endpoints, endpoints, sizeof(ProbeEndpoint_t) * count);
+    round->refs = 1;
+    round->endpoint = -1;
+    round->timeout_ms = timeout_ms;
+    round->start_ms = retryNowMs();
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_mutex_lock(&round->lock);
+    for (i = 0; i < count; i++) {
+        task = malloc(sizeof(ProbeTask_t));
+        if (task == NULL) {
+            break;
+        }
+        task->round = round;
+        task->index = i;
+        round->refs++;
+        round->pending++;
+        if (pthread_create(&tid, &attr, probeThread, task) != 0) {
+            COMMONUTILITIES_ERROR("%s: unable to start probe of %s\n", __FUNCTION__, endpoints[i].url);
+            round->refs--;
+            round->pending--;
+            free(task);
+        }
+    }
+    pthread_attr_destroy(&attr);
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000 + 1;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (!round->decided && round->pending > 0) {
+        if (pthread_cond_timedwait(&round->cond, &round->lock, &deadline) == ETIMEDOUT) {
+            COMMONUTILITIES_ERROR("%s: probe did not end in time\n", __FUNCTION__);
+            break;
+        }
+    }
+    /* Endpoints still running lost the race, they are aborted from their progress callback */
+    __atomic_store_n(&round->decided, 1, __ATOMIC_RELEASE);
+    verdict = round->verdict;
+    result->verdict = verdict;
+    result->endpoint = round->endpoint;
+    result->latency_ms = (unsigned int)(((round->end_ms > 0) ? round->end_ms : retryNowMs()) - round->start_ms);
+    result->age_ms = 0;
+    pthread_mutex_unlock(&round->lock);
+    roundRelease(round);
+    return verdict;
+}
+
+int connectivityProbeConfigure(const ProbeEndpoint_t *endpoints, int count, unsigned int ttl_ms) {
+    if (endpoints != NULL && (count <= 0 || count > PROBE_MAX_ENDPOINTS)) {
+        COMMONUTILITIES_ERROR("%s: invalid endpoint count %d\n", __FUNCTION__, count);
+        return -1;
+    }
+    pthread_mutex_lock(&probe_lock);
+    if (endpoints != NULL) {
+        memcpy(probe_endpoints, endpoints, sizeof(ProbeEndpoint_t) * count);
+        probe_count = count;
+    } else {
+        memset(probe_endpoints, 0, sizeof(probe_endpoints));
+        snprintf(probe_endpoints[0].url, sizeof(probe_endpoints[0].url), "%s", CONNECTIVITY_PROBE_URL);
+        probe_endpoints[0].expect_code = CONNECTIVITY_PROBE_CODE;
+        probe_endpoints[0].ip_resolve = CURL_IPRESOLVE_WHATEVER;
+        probe_count = 1;
+    }
+    probe_ttl_ms = (ttl_ms > 0) ? ttl_ms : CONNECTIVITY_PROBE_TTL_MS;
+    probe_valid = false;
+    pthread_mutex_unlock(&probe_lock);
+    return 0;
+}
+
+probeVerdict_t connectivityProbe(long timeout_ms, bool force) {
+    ProbeEndpoint_t endpoints[PROBE_MAX_ENDPOINTS];
+    ProbeResult_t result;
+    probeVerdict_t verdict;
+    int count;
+
+    if (timeout_ms <= 0) {
+        timeout_ms = CONNECTIVITY_PROBE_TIMEOUT_MS;
+    }
+    pthread_mutex_lock(&probe_lock);
+    if (!force && probe_valid && retryNowMs() - probe_time_ms < probe_ttl_ms) {
+        verdict = probe_last.verdict;
+        pthread_mutex_unlock(&probe_lock);
+        COMMONUTILITIES_DEBUG("%s: cached verdict %d\n", __FUNCTION__, verdict);
+        return verdict;
+    }
+    /* Only one probe at a time, later callers take its verdict */
+    if (probe_running) {
+        while (probe_running) {
+            pthread_cond_wait(&probe_cond, &probe_lock);
+        }
+        verdict = probe_last.verdict;
+        pthread_mutex_unlock(&probe_lock);
+        return verdict;
+    }
+    probe_running = true;
+    count = probe_count;
+    memcpy(endpoints, probe_endpoints, sizeof(ProbeEndpoint_t) * count);
+    pthread_mutex_unlock(&probe_lock);
+
+    verdict = probeRun(endpoints, count, timeout_ms, &result);
+    COMMONUTILITIES_INFO("%s: verdict=%d endpoint=%d latency=%ums\n", __FUNCTION__, verdict, result.endpoint, result.latency_ms);
+
+    pthread_mutex_lock(&probe_lock);
+    probe_last = result;
+    probe_done = true;
+    probe_time_ms = retryNowMs();
+    /* Without a usable answer next caller must probe again */
+    probe_valid = (verdict != PROBE_UNKNOWN);
+    probe_running = false;
+    pthread_cond_broadcast(&probe_cond);
+    pthread_mutex_unlock(&probe_lock);
+    return verdict;
+}
+
+int connectivityProbeLast(ProbeResult_t *result) {
+    int ret = -1;
+
+    if (result == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&probe_lock);
+    if (probe_done) {
+        *result = probe_last;
+        result->age_ms = (unsigned int)(retryNowMs() - probe_time_ms);
+        ret = 0;
+    }
+    pthread_mutex_unlock(&probe_lock);
+    return ret;
+}
+
+void connectivityProbeInvalidate(void) {
+    pthread_mutex_lock(&probe_lock);
+    probe_valid = false;
+    pthread_mutex_unlock(&probe_lock);
+}
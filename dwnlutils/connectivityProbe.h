@@ -0,0 +1,92 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_CONNECTIVITYPROBE_H_
+#define  _RDK_CONNECTIVITYPROBE_H_
+
+#include "urlHelper.h"
+
+#ifndef CONNECTIVITY_PROBE_URL //This is to provide an option Define custom default probe endpoint using DFLAGS
+#define CONNECTIVITY_PROBE_URL "http://xfinity.com"
+#endif
+
+#ifndef CONNECTIVITY_PROBE_CODE //This is to provide an option Define custom http status of a connected device using DFLAGS
+#define CONNECTIVITY_PROBE_CODE 302
+#endif
+
+#ifndef CONNECTIVITY_PROBE_TTL_MS //This is to provide an option Define custom verdict cache time using DFLAGS
+#define CONNECTIVITY_PROBE_TTL_MS 5000
+#endif
+
+#ifndef CONNECTIVITY_PROBE_TIMEOUT_MS //This is to provide an option Define custom timeout used when caller give 0 using DFLAGS
+#define CONNECTIVITY_PROBE_TIMEOUT_MS 5000
+#endif
+
+#define PROBE_MAX_ENDPOINTS 8
+
+/* Verdict of a connectivity probe */
+typedef enum {
+    PROBE_UNKNOWN = 0,  /* no endpoint gave a usable answer, verdict is not cached */
+    PROBE_ONLINE,       /* an endpoint answered with its expected status */
+    PROBE_CAPTIVE,      /* an http server answered, but not as expected (captive portal) */
+    PROBE_OFFLINE       /* all endpoints failed at network level */
+} probeVerdict_t;
+
+/* One probe endpoint. The same url can be listed with CURL_IPRESOLVE_V4 and
+ * CURL_IPRESOLVE_V6 to race both address families */
+typedef struct probeEndpoint {
+    char url[URL_MAX_LEN];
+    long expect_code;           /* http status meaning connected */
+    long ip_resolve;            /* CURL_IPRESOLVE_WHATEVER, CURL_IPRESOLVE_V4 or CURL_IPRESOLVE_V6 */
+} ProbeEndpoint_t;
+
+/* Last verdict of the prober */
+typedef struct probeResult {
+    probeVerdict_t verdict;
+    unsigned int latency_ms;    /* time from probe start to verdict */
+    unsigned int age_ms;        /* time since verdict */
+    int endpoint;               /* index of deciding endpoint, -1 if none */
+} ProbeResult_t;
+
+/* connectivityProbeConfigure(): Replace probe endpoints and verdict cache time. Cached verdict is dropped
+ * endpoints : endpoint list, NULL to use CONNECTIVITY_PROBE_URL
+ * count : No of endpoints, at most PROBE_MAX_ENDPOINTS
+ * ttl_ms : cache time of a verdict, 0 for CONNECTIVITY_PROBE_TTL_MS
+ * Return : int : 0 on success, -1 on invalid parameter
+ * */
+int connectivityProbeConfigure(const ProbeEndpoint_t *endpoints, int count, unsigned int ttl_ms);
+
+/* connectivityProbe(): Connectivity verdict. A verdict younger than the cache time is returned
+ *                      without network access. Otherwise all endpoints are probed in parallel and
+ *                      the first endpoint answering with its expected status decide. Concurrent
+ *                      callers share one probe.
+ * timeout_ms : limit for the probe, 0 for CONNECTIVITY_PROBE_TIMEOUT_MS
+ * force : probe even when a cached verdict is available
+ * Return : probeVerdict_t
+ * */
+probeVerdict_t connectivityProbe(long timeout_ms, bool force);
+
+/* connectivityProbeLast(): Copy last verdict with its probe latency
+ * Return : int : 0 on success, -1 when no verdict is available
+ * */
+int connectivityProbeLast(ProbeResult_t *result);
+
+/* connectivityProbeInvalidate(): Drop cached verdict, next connectivityProbe access the network */
+void connectivityProbeInvalidate(void);
+
+#endif
@@ -0,0 +1,563 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "contentCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "streamDigest.h"
+
+#define CACHE_HEX_LEN (DIGEST_MAX_LEN * 2 + 1)
+/* A body is stored before its index, another process may not have written the index yet */
+#define CACHE_ORPHAN_GRACE_SEC 60
+
+/* One url of the cache as seen by the eviction scan */
+typedef struct cacheUse {
+    char key[CACHE_HEX_LEN];
+    char object[CACHE_HEX_LEN];
+    long long size;
+    struct timespec used;       /* mtime of the index file */
+} CacheUse_t;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static char cache_dir[CONTENT_CACHE_PATH_LEN] = CONTENT_CACHE_DIR;
+static unsigned long long cache_max = CONTENT_CACHE_MAX_BYTES;
+static unsigned int tmp_seq = 0;
+
+void contentCacheConfigure(const char *dir, unsigned long long max_bytes) {
+    pthread_mutex_lock(&cache_lock);
+    snprintf(cache_dir, sizeof(cache_dir), "%s", (dir != NULL) ? dir : CONTENT_CACHE_DIR);
+    __atomic_store_n(&cache_max, (max_bytes > 0) ? max_bytes : CONTENT_CACHE_MAX_BYTES, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&cache_lock);
+    COMMONUTILITIES_INFO("%s: dir=%s max=%llu bytes\n", __FUNCTION__, cache_dir, cache_max);
+}
+
+/* cacheHash(): sha256 of data in lower case hex
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int cacheHash(const void *data, size_t len, char *hex) {
+    StreamDigest_t *ctx = streamDigestCreate(DIGEST_SHA256);
+    digestParam_t out;
+    int ret = -1;
+
+    if (ctx != NULL && streamDigestUpdate(ctx, data, len) == 0 && streamDigestFinal(ctx, &out) == 0) {
+        snprintf(hex, CACHE_HEX_LEN, "%s", out.digest_hex);
+        ret = 0;
+    }
+    streamDigestDestroy(ctx);
+    return ret;
+}
+
+/* cachePath(): Path of a file in the cache directory, sub is "index" or "objects" */
+static void cachePath(char *path, size_t size, const char *sub, const char *name) {
+    snprintf(path, size, "%s/%s/%s", cache_dir, sub, name);
+}
+
+/* cacheMakeDirs(): Create the cache directory tree. Called with lock held */
+static int cacheMakeDirs(void) {
+    char path[CONTENT_CACHE_PATH_LEN + 16];
+
+    if (mkdir(cache_dir, 0700) != 0 && errno != EEXIST) {
+        COMMONUTILITIES_ERROR("%s: unable to create %s errno=%d\n", __FUNCTION__, cache_dir, errno);
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/index", cache_dir);
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s/objects", cache_dir);
+    if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+}
+
+/* cacheReadLine(): Read one line of an index file without its new line
+ * Return : int : 0 on success, -1 at end of file
+ * */
+static int cacheReadLine(FILE *fp, char *buf, size_t size) {
+    size_t len;
+
+    if (fgets(buf, size, fp) == NULL) {
+        return -1;
+    }
+    len = strlen(buf);
+    if (len > 0 && buf[len - 1] == '\n') {
+        buf[len - 1] = '\0';
+    } else {
+        /* Value fills the buffer, its new line is still to be read */
+        int c;
+        while ((c = fgetc(fp)) != EOF && c != '\n') {
+        }
+    }
+    return 0;
+}
+
+/* cacheReadIndex(): Parse an index file. url is checked when not NULL
+ * Return : int : 0 on success, -1 when missing, damaged or for another url
+ * */
+static int cacheReadIndex(const char *path, const char *url, ContentCacheEntry_t *entry) {
+    FILE *fp = fopen(path, "r");
+    char line[BIG_BUF_LEN + 2];
+    char size[32];
+    int ret = -1;
+
+    if (fp == NULL) {
+        return -1;
+    }
+    if (cacheReadLine(fp, line, sizeof(line)) == 0 && (url == NULL || strcmp(line, url) == 0)
+        && cacheReadLine(fp, entry->etag, sizeof(entry->etag)) == 0
+        && cacheReadLine(fp, entry->last_modified, sizeof(entry->last_modified)) == 0
+        && cacheReadLine(fp, entry->object, sizeof(entry->object)) == 0
+        && cacheReadLine(fp, size, sizeof(size)) == 0) {
+        entry->size = strtoll(size, NULL, 10);
+        ret = (strlen(entry->object) == CACHE_HEX_LEN - 1 && entry->size >= 0) ? 0 : -1;
+    }
+    fclose(fp);
+    return ret;
+}
+
+/* cacheWriteAll(): Write len bytes to fd
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int cacheWriteAll(int fd, const char *buf, size_t len) {
+    ssize_t ret;
+
+    while (len > 0) {
+        ret = write(fd, buf, len);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return -1;
+        }
+        buf += ret;
+        len -= (size_t)ret;
+    }
+    return 0;
+}
+
+/* cacheTempFile(): Create a temporary file in sub directory. Its name starts with '.',
+ * the eviction scan skips such files. Called with lock held
+ * Return : int : open file descriptor, -1 on failure
+ * */
+static int cacheTempFile(const char *sub, char *path, size_t size) {
+    char name[64];
+    int fd;
+
+    snprintf(name, sizeof(name), ".tmp-%d-%u", (int)getpid(), tmp_seq++);
+    cachePath(path, size, sub, name);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        COMMONUTILITIES_ERROR("%s: unable to create %s errno=%d\n", __FUNCTION__, path, errno);
+    }
+    return fd;
+}
+
+/* cacheCommit(): Move a complete temporary file to its final name */
+static int cacheCommit(int fd, const char *tmp, const char *sub, const char *name) {
+    char path[CONTENT_CACHE_PATH_LEN + 96];
+
+    cachePath(path, sizeof(path), sub, name);
+    if (fsync(fd) != 0 || close(fd) != 0 || rename(tmp, path) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to store %s errno=%d\n", __FUNCTION__, path, errno);
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* cacheWriteIndex(): Store index of url. Called with lock held */
+static int cacheWriteIndex(const char *url, const char *etag, const char *last_modified, const char *object, long long size) {
+    char key[CACHE_HEX_LEN];
+    char tmp[CONTENT_CACHE_PATH_LEN + 96];
+    char *text = NULL;
+    int len;
+    int fd;
+
+    if (cacheHash(url, strlen(url), key) != 0) {
+        return -1;
+    }
+    len = snprintf(NULL, 0, "%s\n%s\n%s\n%s\n%lld\n", url, etag, last_modified, object, size);
+    text = (len > 0) ? malloc((size_t)len + 1) : NULL;
+    if (text == NULL) {
+        return -1;
+    }
+    snprintf(text, (size_t)len + 1, "%s\n%s\n%s\n%s\n%lld\n", url, etag, last_modified, object, size);
+    fd = cacheTempFile("index", tmp, sizeof(tmp));
+    if (fd < 0 || cacheWriteAll(fd, text, (size_t)len) != 0) {
+        if (fd >= 0) {
+            close(fd);
+            unlink(tmp);
+        }
+        free(text);
+        return -1;
+    }
+    free(text);
+    return cacheCommit(fd, tmp, "index", key);
+}
+
+/* cacheScan(): Collect all urls of the cache
+ * Return : int : number of urls in *uses, to be freed by caller
+ * */
+static int cacheScan(CacheUse_t **uses) {
+    char path[CONTENT_CACHE_PATH_LEN + 96];
+    DIR *dir;
+    struct dirent *de;
+    struct stat st;
+    ContentCacheEntry_t entry;
+    CacheUse_t *list = NULL;
+    CacheUse_t *grown;
+    int count = 0;
+    int room = 0;
+
+    snprintf(path, sizeof(path), "%s/index", cache_dir);
+    dir = opendir(path);
+    if (dir == NULL) {
+        *uses = NULL;
+        return 0;
+    }
+    while ((de = readdir(dir)) != NULL) {
+        /* Index names are url hashes, temporary files start with '.' */
+        if (strlen(de->d_name) != CACHE_HEX_LEN - 1) {
+            continue;
+        }
+        cachePath(path, sizeof(path), "index", de->d_name);
+        if (stat(path, &st) != 0 || cacheReadIndex(path, NULL, &entry) != 0) {
+            continue;
+        }
+        if (count == room) {
+            room = (room > 0) ? room * 2 : 16;
+            grown = realloc(list, room * sizeof(CacheUse_t));
+            if (grown == NULL) {
+                break;
+            }
+            list = grown;
+        }
+        memcpy(list[count].key, de->d_name, CACHE_HEX_LEN);
+        snprintf(list[count].object, sizeof(list[count].object), "%s", entry.object);
+        list[count].size = entry.size;
+        list[count].used = st.st_mtim;
+        count++;
+    }
+    closedir(dir);
+    *uses = list;
+    return count;
+}
+
+static int cacheUseCompare(const void *a, const void *b) {
+    const CacheUse_t *ua = a;
+    const CacheUse_t *ub = b;
+
+    if (ua->used.tv_sec != ub->used.tv_sec) {
+        return (ua->used.tv_sec < ub->used.tv_sec) ? -1 : 1;
+    }
+    if (ua->used.tv_nsec != ub->used.tv_nsec) {
+        return (ua->used.tv_nsec < ub->used.tv_nsec) ? -1 : 1;
+    }
+    return 0;
+}
+
+/* cacheReferenced(): Check if a url in uses[from..count) refers to object */
+static bool cacheReferenced(const CacheUse_t *uses, int from, int count, const char *object) {
+    int i;
+
+    for (i = from; i < count; i++) {
+        if (strcmp(uses[i].object, object) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* cacheSweep(): Remove bodies no url refers to, then drop least recently used urls until
+ * the bodies fit in limit. Called with lock held
+ * Return : unsigned long long : size of the bodies left
+ * */
+static unsigned long long cacheSweep(unsigned long long limit) {
+    char path[CONTENT_CACHE_PATH_LEN + 96];
+    DIR *dir;
+    struct dirent *de;
+    struct stat st;
+    CacheUse_t *uses = NULL;
+    int count = cacheScan(&uses);
+    unsigned long long total = 0;
+    int i;
+
+    snprintf(path, sizeof(path), "%s/objects", cache_dir);
+    dir = opendir(path);
+    if (dir != NULL) {
+        while ((de = readdir(dir)) != NULL) {
+            cachePath(path, sizeof(path), "objects", de->d_name);
+            if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+                continue;
+            }
+            /* Temporary files of a writer which died, and bodies whose urls are gone */
+            if (de->d_name[0] == '.' || !cacheReferenced(uses, 0, count, de->d_name)) {
+                if (st.st_mtime + CACHE_ORPHAN_GRACE_SEC < time(NULL)) {
+                    unlink(path);
+                }
+                continue;
+            }
+            total += (unsigned long long)st.st_size;
+        }
+        closedir(dir);
+    }
+    if (total > limit && count > 0) {
+        qsort(uses, count, sizeof(CacheUse_t), cacheUseCompare);
+        for (i = 0; i < count && total > limit; i++) {
+            cachePath(path, sizeof(path), "index", uses[i].key);
+            unlink(path);
+            if (!cacheReferenced(uses, i + 1, count, uses[i].object)) {
+                cachePath(path, sizeof(path), "objects", uses[i].object);
+                if (unlink(path) == 0) {
+                    total -= ((unsigned long long)uses[i].size < total) ? (unsigned long long)uses[i].size : total;
+                }
+            }
+            COMMONUTILITIES_INFO("%s: evicted %s\n", __FUNCTION__, uses[i].key);
+        }
+    }
+    free(uses);
+    return total;
+}
+
+int contentCacheLookup(const char *url, ContentCacheEntry_t *entry) {
+    char key[CACHE_HEX_LEN];
+    char path[CONTENT_CACHE_PATH_LEN + 96];
+    struct stat st;
+
+    if (url == NULL || entry == NULL) {
+        return -1;
+    }
+    memset(entry, 0, sizeof(ContentCacheEntry_t));
+    entry->fd = -1;
+    if (cacheHash(url, strlen(url), key) != 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&cache_lock);
+    cachePath(path, sizeof(path), "index", key);
+    if (cacheReadIndex(path, url, entry) == 0) {
+        /* Index mtime is the last use for eviction */
+        utimensat(AT_FDCWD, path, NULL, 0);
+        cachePath(path, sizeof(path), "objects", entry->object);
+        entry->fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (entry->fd >= 0 && (fstat(entry->fd, &st) != 0 || st.st_size != entry->size)) {
+            COMMONUTILITIES_ERROR("%s: body of %s damaged, not used\n", __FUNCTION__, url);
+            close(entry->fd);
+            entry->fd = -1;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+    if (entry->fd < 0) {
+        return -1;
+    }
+    COMMONUTILITIES_INFO("%s: %s cached, etag=%s last-modified=%s size=%lld\n", __FUNCTION__, url,
+                         entry->etag, entry->last_modified, entry->size);
+    return 0;
+}
+
+void contentCacheRelease(ContentCacheEntry_t *entry) {
+    if (entry != NULL && entry->fd >= 0) {
+        close(entry->fd);
+        entry->fd = -1;
+    }
+}
+
+struct curl_slist *contentCacheValidators(const ContentCacheEntry_t *entry, struct curl_slist *list) {
+    char header[CONTENT_CACHE_VALIDATOR_LEN + 32];
+    struct curl_slist *added;
+
+    if (entry == NULL) {
+        return list;
+    }
+    if (entry->etag[0] != '\0') {
+        snprintf(header, sizeof(header), "If-None-Match: %s", entry->etag);
+        added = curl_slist_append(list, header);
+        list = (added != NULL) ? added : list;
+    }
+    if (entry->last_modified[0] != '\0') {
+        snprintf(header, sizeof(header), "If-Modified-Since: %s", entry->last_modified);
+        added = curl_slist_append(list, header);
+        list = (added != NULL) ? added : list;
+    }
+    return list;
+}
+
+ssize_t contentCacheRead(ContentCacheEntry_t *entry, void *buf, size_t len, long long offset) {
+    ssize_t ret;
+
+    if (entry == NULL || entry->fd < 0) {
+        return -1;
+    }
+    do {
+        ret = pread(entry->fd, buf, len, (off_t)offset);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+/* cacheStoreBody(): Store body under its hash and write index of url. Called with lock held.
+ * src_fd is the body when not -1, else data and len
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int cacheStoreBody(const char *url, const char *etag, const char *last_modified,
+                          int src_fd, const void *data, size_t len) {
+    char tmp[CONTENT_CACHE_PATH_LEN + 96];
+    char object[CACHE_HEX_LEN];
+    char *buf = NULL;
+    StreamDigest_t *ctx;
+    digestParam_t out;
+    long long size = 0;
+    ssize_t nread;
+    int fd;
+    int ret = -1;
+
+    if (cacheMakeDirs() != 0) {
+        return -1;
+    }
+    ctx = streamDigestCreate(DIGEST_SHA256);
+    fd = cacheTempFile("objects", tmp, sizeof(tmp));
+    if (ctx == NULL || fd < 0) {
+        goto done;
+    }
+    if (src_fd >= 0) {
+        buf = malloc(CONTENT_CACHE_READ_SIZE);
+        if (buf == NULL) {
+            goto done;
+        }
+        while ((nread = read(src_fd, buf, CONTENT_CACHE_READ_SIZE)) != 0) {
+            if (nread < 0 && errno == EINTR) {
+                continue;
+            }
+            if (nread < 0 || cacheWriteAll(fd, buf, (size_t)nread) != 0) {
+                goto done;
+            }
+            streamDigestUpdate(ctx, buf, (size_t)nread);
+            size += nread;
+        }
+    } else {
+        if (cacheWriteAll(fd, data, len) != 0) {
+            goto done;
+        }
+        streamDigestUpdate(ctx, data, len);
+        size = (long long)len;
+    }
+    if (streamDigestFinal(ctx, &out) != 0) {
+        goto done;
+    }
+    snprintf(object, sizeof(object), "%s", out.digest_hex);
+    /* Same body under the same name, an existing copy is simply replaced */
+    ret = cacheCommit(fd, tmp, "objects", object);
+    fd = -1;
+    if (ret == 0) {
+        ret = cacheWriteIndex(url, (etag != NULL) ? etag : "", (last_modified != NULL) ? last_modified : "", object, size);
+    }
+    if (ret == 0) {
+        COMMONUTILITIES_INFO("%s: stored %s as %s size=%lld\n", __FUNCTION__, url, object, size);
+        cacheSweep(cache_max);
+    }
+done:
+    if (fd >= 0) {
+        close(fd);
+        unlink(tmp);
+    }
+    free(buf);
+    streamDigestDestroy(ctx);
+    return ret;
+}
+
+/* cacheStorable(): Check that a response can be stored */
+static bool cacheStorable(const char *url, const char *etag, const char *last_modified, unsigned long long size) {
+    if (url == NULL || strlen(url) >= BIG_BUF_LEN || strchr(url, '\n') != NULL) {
+        return false;
+    }
+    if ((etag == NULL || etag[0] == '\0') && (last_modified == NULL || last_modified[0] == '\0')) {
+        return false;
+    }
+    if ((etag != NULL && strlen(etag) >= CONTENT_CACHE_VALIDATOR_LEN)
+        || (last_modified != NULL && strlen(last_modified) >= CONTENT_CACHE_VALIDATOR_LEN)) {
+        return false;
+    }
+    return (size <= __atomic_load_n(&cache_max, __ATOMIC_RELAXED));
+}
+
+int contentCacheStoreFile(const char *url, const char *etag, const char *last_modified, const char *file) {
+    struct stat st;
+    int src_fd;
+    int ret = -1;
+
+    if (file == NULL) {
+        return -1;
+    }
+    src_fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (src_fd < 0) {
+        return -1;
+    }
+    if (fstat(src_fd, &st) == 0 && cacheStorable(url, etag, last_modified, (unsigned long long)st.st_size)) {
+        pthread_mutex_lock(&cache_lock);
+        ret = cacheStoreBody(url, etag, last_modified, src_fd, NULL, 0);
+        pthread_mutex_unlock(&cache_lock);
+    }
+    close(src_fd);
+    return ret;
+}
+
+int contentCacheStoreMem(const char *url, const char *etag, const char *last_modified, const void *data, size_t len) {
+    int ret;
+
+    if ((data == NULL && len > 0) || !cacheStorable(url, etag, last_modified, (unsigned long long)len)) {
+        return -1;
+    }
+    pthread_mutex_lock(&cache_lock);
+    ret = cacheStoreBody(url, etag, last_modified, -1, data, len);
+    pthread_mutex_unlock(&cache_lock);
+    return ret;
+}
+
+void contentCacheRemove(const char *url) {
+    char key[CACHE_HEX_LEN];
+    char path[CONTENT_CACHE_PATH_LEN + 96];
+
+    if (url == NULL || cacheHash(url, strlen(url), key) != 0) {
+        return;
+    }
+    pthread_mutex_lock(&cache_lock);
+    cachePath(path, sizeof(path), "index", key);
+    if (unlink(path) == 0) {
+        cacheSweep(cache_max);
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+unsigned long long contentCacheSize(void) {
+    unsigned long long total;
+
+    pthread_mutex_lock(&cache_lock);
+    total = cacheSweep((unsigned long long)-1);
+    pthread_mutex_unlock(&cache_lock);
+    return total;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_CONTENTCACHE_H_
+#define  _RDK_CONTENTCACHE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <curl/curl.h>
+
+#include "urlHelper.h"
+
+#ifndef CONTENT_CACHE_DIR //This is to provide an option Define custom content cache directory using DFLAGS
+#define CONTENT_CACHE_DIR "/opt/.dwnlutil_content_cache"
+#endif
+
+#ifndef CONTENT_CACHE_MAX_BYTES //This is to provide an option Define custom size limit of cached bodies using DFLAGS
+#define CONTENT_CACHE_MAX_BYTES (64ULL * 1024 * 1024)
+#endif
+
+#define CONTENT_CACHE_PATH_LEN 256
+#define CONTENT_CACHE_VALIDATOR_LEN 256
+#define CONTENT_CACHE_READ_SIZE (64 * 1024)
+
+/* Cache of response bodies with their validators, used for conditional GET.
+ * Bodies are stored once under <dir>/objects/<sha256 of body>, each url has an index file
+ * <dir>/index/<sha256 of url> naming its ETag, Last-Modified and body. Index files are
+ * touched on every use, when the bodies are over the size limit the least recently used
+ * urls are dropped together with bodies no other url refers to */
+
+/* Cached response of one url, filled by contentCacheLookup */
+typedef struct contentCacheEntry {
+    char etag[CONTENT_CACHE_VALIDATOR_LEN];             /* ETag of the response, empty if not sent */
+    char last_modified[CONTENT_CACHE_VALIDATOR_LEN];    /* Last-Modified of the response, empty if not sent */
+    char object[DIGEST_MAX_LEN * 2 + 1];                /* sha256 of body in hex, name of the body file */
+    long long size;                                     /* body size */
+    int fd;                                             /* open body, it stays readable when evicted meanwhile */
+} ContentCacheEntry_t;
+
+/* contentCacheConfigure(): Set cache directory and size limit of the stored bodies
+ * dir : cache directory, created when needed. NULL for CONTENT_CACHE_DIR
+ * max_bytes : size limit of all bodies, 0 for CONTENT_CACHE_MAX_BYTES
+ * */
+void contentCacheConfigure(const char *dir, unsigned long long max_bytes);
+
+/* contentCacheLookup(): Find the cached response of url and open its body
+ * Return : int : 0 when found, entry must then be given to contentCacheRelease. -1 when not cached
+ * */
+int contentCacheLookup(const char *url, ContentCacheEntry_t *entry);
+
+/* contentCacheRelease(): Close the body opened by contentCacheLookup */
+void contentCacheRelease(ContentCacheEntry_t *entry);
+
+/* contentCacheValidators(): Append If-None-Match and If-Modified-Since of entry to a request header list
+ * Return : struct curl_slist * : new list head, same as curl_slist_append
+ * */
+struct curl_slist *contentCacheValidators(const ContentCacheEntry_t *entry, struct curl_slist *list);
+
+/* contentCacheRead(): Read body of entry at offset, same as pread
+ * Return : ssize_t : bytes read, 0 at end of body, -1 on error
+ * */
+ssize_t contentCacheRead(ContentCacheEntry_t *entry, void *buf, size_t len, long long offset);
+
+/* contentCacheStoreFile(): Store file as body of url. Nothing is stored without validator
+ *                          or when the body is over the size limit
+ * etag, last_modified : validators of the response, NULL or empty if not sent
+ * Return : int : 0 on success, -1 when not stored
+ * */
+int contentCacheStoreFile(const char *url, const char *etag, const char *last_modified, const char *file);
+
+/* contentCacheStoreMem(): Same as contentCacheStoreFile with the body in memory */
+int contentCacheStoreMem(const char *url, const char *etag, const char *last_modified, const void *data, size_t len);
+
+/* contentCacheRemove(): Drop the cached response of url, the body stays while other urls refer to it */
+void contentCacheRemove(const char *url);
+
+/* contentCacheSize(): Total size of the stored bodies */
+unsigned long long contentCacheSize(void);
+
+#endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "curlPool.h"
+
+#include <pthread.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+static pthread_once_t poolInitOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+/* One lock per curl_lock_data so DNS and TLS session cache do not serialize each other */
+static pthread_mutex_t shareLocks[CURL_LOCK_DATA_LAST];
+
+static CURLSH *share = NULL;
+static CURL *idleHandles[CURL_POOL_MAX_IDLE];
+static int idleCount = 0;
+static bool http2Mode = CURL_POOL_HTTP2;
+
+/**
+ * Auto initializer: called by pthread_once
+ */
+static void curlPoolInit(void) {
+    int i;
+    curl_global_init(CURL_GLOBAL_ALL);
+    for (i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&shareLocks[i], NULL);
+    }
+}
+
+static void shareLockCB(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    (void)handle;
+    (void)access;
+    (void)userptr;
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST) {
+        pthread_mutex_lock(&shareLocks[data]);
+    }
+}
+
+static void shareUnlockCB(CURL *handle, curl_lock_data data, void *userptr) {
+    (void)handle;
+    (void)userptr;
+    if (data >= 0 && data < CURL_LOCK_DATA_LAST) {
+        pthread_mutex_unlock(&shareLocks[data]);
+    }
+}
+
+/* createShare(): Create the share handle. Must be called with poolLock held.
+ * Return : CURLSH * : share handle, NULL on failure
+ * */
+static CURLSH *createShare(void) {
+    CURLSH *sh = NULL;
+    CURLSHcode sh_code = CURLSHE_OK;
+
+    sh = curl_share_init();
+    if (sh == NULL) {
+        COMMONUTILITIES_ERROR("%s: curl_share_init failed\n", __FUNCTION__);
+        return NULL;
+    }
+    curl_share_setopt(sh, CURLSHOPT_LOCKFUNC, shareLockCB);
+    curl_share_setopt(sh, CURLSHOPT_UNLOCKFUNC, shareUnlockCB);
+    sh_code = curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    if (sh_code != CURLSHE_OK) {
+        COMMONUTILITIES_ERROR("%s: DNS share failed:%s\n", __FUNCTION__, curl_share_strerror(sh_code));
+    }
+    sh_code = curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    if (sh_code != CURLSHE_OK) {
+        COMMONUTILITIES_ERROR("%s: SSL session share failed:%s\n", __FUNCTION__, curl_share_strerror(sh_code));
+    }
+    /* Connection cache is not shared, libcurl does not support it between concurrent threads.
+     * Each pooled handle keeps its own live connections across curlPoolRelease */
+    COMMONUTILITIES_INFO("%s: curl share handle created\n", __FUNCTION__);
+    return sh;
+}
+
+CURLSH *curlPoolGetShare(void) {
+    CURLSH *sh;
+    pthread_once(&poolInitOnce, curlPoolInit);
+    pthread_mutex_lock(&poolLock);
+    if (share == NULL) {
+        share = createShare();
+    }
+    sh = share;
+    pthread_mutex_unlock(&poolLock);
+    return sh;
+}
+
+CURL *curlPoolAcquire(void) {
+    CURL *curl = NULL;
+    CURLSH *sh = NULL;
+    CURLcode ret_code = CURLE_OK;
+
+    sh = curlPoolGetShare();
+    pthread_mutex_lock(&poolLock);
+    if (idleCount > 0) {
+        curl = idleHandles[--idleCount];
+        idleHandles[idleCount] = NULL;
+    }
+    pthread_mutex_unlock(&poolLock);
+
+    if (curl == NULL) {
+        curl = curl_easy_init();
+        if (curl == NULL) {
+            COMMONUTILITIES_ERROR("%s: curl_easy_init failed\n", __FUNCTION__);
+            return NULL;
+        }
+    }
+    if (sh != NULL) {
+        ret_code = curl_easy_setopt(curl, CURLOPT_SHARE, sh);
+        if (ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("%s: CURLOPT_SHARE failed:%s\n", __FUNCTION__, curl_easy_strerror(ret_code));
+        }
+    }
+    return curl;
+}
+
+void curlPoolRelease(CURL *curl) {
+    if (curl == NULL) {
+        return;
+    }
+    /* Drop every option of the previous request, the share and live connections are kept */
+    curl_easy_reset(curl);
+    pthread_mutex_lock(&poolLock);
+    if (idleCount < CURL_POOL_MAX_IDLE) {
+        idleHandles[idleCount++] = curl;
+        curl = NULL;
+    }
+    pthread_mutex_unlock(&poolLock);
+    if (curl != NULL) {
+        curl_easy_cleanup(curl);
+    }
+}
+
+void curlPoolSetHttp2(bool enable) {
+    __atomic_store_n(&http2Mode, enable, __ATOMIC_RELEASE);
+    COMMONUTILITIES_INFO("%s: HTTP/2 mode %s\n", __FUNCTION__, enable ? "enabled" : "disabled");
+}
+
+bool curlPoolHttp2(void) {
+    return __atomic_load_n(&http2Mode, __ATOMIC_ACQUIRE);
+}
+
+CURLcode curlPoolSetHttpVersion(CURL *curl) {
+    CURLcode ret_code = CURLE_OK;
+
+    if (curl == NULL) {
+        return CURLE_BAD_FUNCTION_ARGUMENT;
+    }
+    if (!curlPoolHttp2()) {
+        return CURLE_OK;
+    }
+    ret_code = curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    if (ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("%s: CURLOPT_HTTP_VERSION failed:%s\n", __FUNCTION__, curl_easy_strerror(ret_code));
+        return ret_code;
+    }
+    /* Wait for a connection able to multiplex rather than opening a new one */
+    ret_code = curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    if (ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("%s: CURLOPT_PIPEWAIT failed:%s\n", __FUNCTION__, curl_easy_strerror(ret_code));
+    }
+    return ret_code;
+}
+
+void curlPoolCleanup(void) {
+    CURLSHcode sh_code = CURLSHE_OK;
+
+    pthread_mutex_lock(&poolLock);
+    while (idleCount > 0) {
+        idleCount--;
+        curl_easy_cleanup(idleHandles[idleCount]);
+        idleHandles[idleCount] = NULL;
+    }
+    if (share != NULL) {
+        sh_code = curl_share_cleanup(share);
+        if (sh_code == CURLSHE_OK) {
+            share = NULL;
+        } else {
+            COMMONUTILITIES_ERROR("%s: curl_share_cleanup failed:%s\n", __FUNCTION__, curl_share_strerror(sh_code));
+        }
+    }
+    pthread_mutex_unlock(&poolLock);
+}
+
+#ifdef GTEST_ENABLE
+static int curlPoolIdleCount(void) {
+    int count;
+    pthread_mutex_lock(&poolLock);
+    count = idleCount;
+    pthread_mutex_unlock(&poolLock);
+    return count;
+}
+
+int (*getcurlPoolIdleCount(void)) (void) {
+    return &curlPoolIdleCount;
+}
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_CURLPOOL_H_
+#define  _RDK_CURLPOOL_H_
+
+#include <stdbool.h>
+#include <curl/curl.h>
+
+#ifndef CURL_POOL_MAX_IDLE //This is to provide an option Define custom pool depth using DFLAGS
+#define CURL_POOL_MAX_IDLE 4
+#endif
+
+#ifndef CURL_POOL_HTTP2 //This is to provide an option Define custom default of HTTP/2 mode using DFLAGS
+#define CURL_POOL_HTTP2 false
+#endif
+
+/* curlPoolAcquire(): Get an easy handle attached to the process wide share
+ *                    (DNS cache and TLS session cache).
+ *                    An idle handle is recycled when available with its live connections,
+ *                    otherwise a new one is created.
+ * Return : CURL * : curl handle, NULL on failure
+ * */
+CURL *curlPoolAcquire(void);
+
+/* curlPoolRelease(): Give a handle back to the pool. All options are reset with
+ *                    curl_easy_reset; live connections stay in the connection cache of the handle.
+ *                    Handles beyond CURL_POOL_MAX_IDLE are cleaned up.
+ * curl : handle returned by curlPoolAcquire
+ * */
+void curlPoolRelease(CURL *curl);
+
+/* curlPoolGetShare(): Return the process wide share handle, NULL if sharing is not available */
+CURLSH *curlPoolGetShare(void);
+
+/* curlPoolSetHttp2(): Enable or disable HTTP/2 for handles configured after this call.
+ *                     HTTPS transfers negotiate HTTP/2 with ALPN and fall back to HTTP/1.1,
+ *                     plain HTTP stays on HTTP/1.1. Concurrent transfers of one multi handle
+ *                     (asyncDwnlSubmit, segmented download) to the same host then share one
+ *                     multiplexed connection. Blocking requests such as doHttpFileDownload,
+ *                     metadata POSTs and uploadUtil S3 PUTs run on their own easy handle and the
+ *                     share holds no connections, so they only reuse the live connection of a
+ *                     recycled handle and are never multiplexed with other transfers.
+ * */
+void curlPoolSetHttp2(bool enable);
+
+/* curlPoolHttp2(): Check if HTTP/2 mode is enabled */
+bool curlPoolHttp2(void);
+
+/* curlPoolSetHttpVersion(): Set HTTP version options of HTTP/2 mode on a handle, nothing is set
+ *                           when the mode is disabled
+ * Return : CURLcode : CURLE_OK on success
+ * */
+CURLcode curlPoolSetHttpVersion(CURL *curl);
+
+/* curlPoolCleanup(): Free idle handles and the share handle. Should be called only when
+ *                    no transfer is in progress, typically before process exit.
+ * */
+void curlPoolCleanup(void);
+
+#endif
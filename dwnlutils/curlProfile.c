@@ -0,0 +1,288 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "curlProfile.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "downloadUtil.h"
+#include "curlPool.h"
+#include "bandwidthGovernor.h"
+#include "dnsCache.h"
+#include "tlsSessionCache.h"
+
+/* Template handle of a profile. Handles copied from it point to its header list,
+ * so a replaced profile is kept until the last of them is destroyed */
+typedef struct curlProfile {
+    CURL *tmpl;
+    struct curl_slist *headers;
+    int users;                  /* handles created from the profile */
+    struct curlProfile *next;   /* next replaced profile still in use */
+} CurlProfile_t;
+
+/* Profile a handle was created from */
+typedef struct profileBound {
+    CURL *handle;
+    CurlProfile_t *profile;
+} ProfileBound_t;
+
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+static CurlProfile_t *profiles[CURL_PROFILE_MAX];
+static CurlProfile_t *retired = NULL;
+static ProfileBound_t bound[CURL_PROFILE_MAX_BOUND];
+static int bound_count = 0;
+
+static const char *profile_names[CURL_PROFILE_MAX] = { "xconf-mtls", "ssr-download", "jsonrpc-local", "s3-put" };
+
+/* profileFree(): Free template handle and header list */
+static void profileFree(CurlProfile_t *profile) {
+    if (profile != NULL) {
+        curl_easy_cleanup(profile->tmpl);
+        curl_slist_free_all(profile->headers);
+        free(profile);
+    }
+}
+
+/* profileHeader(): Add a header line to the list of profile
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int profileHeader(CurlProfile_t *profile, const char *line) {
+    struct curl_slist *list;
+
+    if (line == NULL || *line == '\0') {
+        return 0;
+    }
+    list = curl_slist_append(profile->headers, line);
+    if (list == NULL) {
+        return -1;
+    }
+    profile->headers = list;
+    return 0;
+}
+
+/* profileSetopt(): Set all options of profile id on its template handle
+ * Return : CURLcode : CURLE_OK on success
+ * */
+static CURLcode profileSetopt(CurlProfile_t *profile, curlProfileId_t id, const curlProfileOpt_t *opt) {
+    CURLcode ret_code;
+
+    ret_code = setCommonCurlBaseOpt(profile->tmpl, opt->sslverify);
+    if (ret_code != CURLE_OK) {
+        return ret_code;
+    }
+    curlPoolSetHttpVersion(profile->tmpl);
+    if (opt->auth != NULL) {
+        ret_code = setMtlsHeaders(profile->tmpl, opt->auth);
+        if (ret_code != CURLE_OK) {
+            return ret_code;
+        }
+    }
+    if (profileHeader(profile, opt->header) != 0 || profileHeader(profile, opt->auth_token) != 0) {
+        return CURLE_OUT_OF_MEMORY;
+    }
+    if (profile->headers != NULL) {
+        ret_code = curl_easy_setopt(profile->tmpl, CURLOPT_HTTPHEADER, profile->headers);
+        if (ret_code != CURLE_OK) {
+            return ret_code;
+        }
+    }
+    if (id == CURL_PROFILE_S3_PUT) {
+        ret_code = curl_easy_setopt(profile->tmpl, CURLOPT_UPLOAD, 1L);
+        if (ret_code != CURLE_OK) {
+            return ret_code;
+        }
+        /* Upload data is read through the bandwidth governor so the total cap of the process applies */
+        ret_code = curl_easy_setopt(profile->tmpl, CURLOPT_READFUNCTION, bwGovernorReadCB);
+    }
+    return ret_code;
+}
+
+int curlProfileBuild(curlProfileId_t id, const curlProfileOpt_t *opt) {
+    CurlProfile_t *profile;
+    CurlProfile_t *old;
+
+    if ((int)id < 0 || id >= CURL_PROFILE_MAX || opt == NULL) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return -1;
+    }
+    if (id == CURL_PROFILE_XCONF_MTLS && opt->auth == NULL) {
+        COMMONUTILITIES_ERROR("%s: %s needs a client certificate\n", __FUNCTION__, profile_names[id]);
+        return -1;
+    }
+    profile = (CurlProfile_t *)calloc(1, sizeof(CurlProfile_t));
+    if (profile == NULL) {
+        COMMONUTILITIES_ERROR("%s: memory allocation failed\n", __FUNCTION__);
+        return -1;
+    }
+    profile->tmpl = curl_easy_init();
+    if (profile->tmpl == NULL || profileSetopt(profile, id, opt) != CURLE_OK) {
+        COMMONUTILITIES_ERROR("%s: unable to build %s\n", __FUNCTION__, profile_names[id]);
+        profileFree(profile);
+        return -1;
+    }
+    pthread_mutex_lock(&profile_lock);
+    old = profiles[id];
+    profiles[id] = profile;
+    if (old != NULL && old->users > 0) {
+        old->next = retired;
+        retired = old;
+        old = NULL;
+    }
+    pthread_mutex_unlock(&profile_lock);
+    profileFree(old);
+    COMMONUTILITIES_INFO("%s: %s built\n", __FUNCTION__, profile_names[id]);
+    return 0;
+}
+
+bool curlProfileReady(curlProfileId_t id) {
+    bool ready;
+
+    if ((int)id < 0 || id >= CURL_PROFILE_MAX) {
+        return false;
+    }
+    pthread_mutex_lock(&profile_lock);
+    ready = (profiles[id] != NULL);
+    pthread_mutex_unlock(&profile_lock);
+    return ready;
+}
+
+CURL *curlProfileCreate(curlProfileId_t id, const char *url, char *pPostFields) {
+    CURL *curl = NULL;
+    int i;
+
+    if ((int)id < 0 || id >= CURL_PROFILE_MAX || url == NULL) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return NULL;
+    }
+    pthread_mutex_lock(&profile_lock);
+    if (profiles[id] != NULL) {
+        for (i = 0; i < CURL_PROFILE_MAX_BOUND; i++) {
+            if (bound[i].handle == NULL) {
+                break;
+            }
+        }
+        if (i == CURL_PROFILE_MAX_BOUND) {
+            COMMONUTILITIES_ERROR("%s: more than %d handles of profiles\n", __FUNCTION__, CURL_PROFILE_MAX_BOUND);
+        } else {
+            /* The template is only read, the lock keeps it from being used by two threads at once */
+            curl = curl_easy_duphandle(profiles[id]->tmpl);
+            if (curl != NULL) {
+                bound[i].handle = curl;
+                bound[i].profile = profiles[id];
+                profiles[id]->users++;
+                __atomic_add_fetch(&bound_count, 1, __ATOMIC_RELEASE);
+            }
+        }
+    }
+    pthread_mutex_unlock(&profile_lock);
+    if (curl == NULL) {
+        return NULL;
+    }
+    curl_easy_setopt(curl, CURLOPT_SHARE, curlPoolGetShare());
+    if (curl_easy_setopt(curl, CURLOPT_URL, url) != CURLE_OK
+        || (pPostFields != NULL && SetPostFields(curl, pPostFields) != CURLE_OK)) {
+        COMMONUTILITIES_ERROR("%s: unable to set request of %s\n", __FUNCTION__, profile_names[id]);
+        urlHelperDestroyCurl(curl);
+        return NULL;
+    }
+    /* Options depending on the host are not part of the template */
+    dnsCacheApply(curl, url);
+    if (tlsSessionCacheEnabled()) {
+        tlsSessionCacheSetopt(curl, url);
+    }
+    return curl;
+}
+
+void curlProfileRelease(CURL *curl) {
+    CurlProfile_t *profile = NULL;
+    CurlProfile_t *unused = NULL;
+    CurlProfile_t **link;
+    int i;
+
+    if (curl == NULL || __atomic_load_n(&bound_count, __ATOMIC_ACQUIRE) == 0) {
+        return;
+    }
+    pthread_mutex_lock(&profile_lock);
+    for (i = 0; i < CURL_PROFILE_MAX_BOUND; i++) {
+        if (bound[i].handle == curl) {
+            profile = bound[i].profile;
+            memset(&bound[i], 0, sizeof(ProfileBound_t));
+            __atomic_sub_fetch(&bound_count, 1, __ATOMIC_RELEASE);
+            profile->users--;
+            break;
+        }
+    }
+    /* Last handle of a replaced profile frees it */
+    if (profile != NULL && profile->users == 0) {
+        for (link = &retired; *link != NULL; link = &(*link)->next) {
+            if (*link == profile) {
+                *link = profile->next;
+                unused = profile;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&profile_lock);
+    profileFree(unused);
+}
+
+int curlProfileRequest(curlProfileId_t id, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *out_httpCode) {
+    CURL *curl;
+    CURLcode curl_status = -1;
+    size_t byte_dwnled = 0;
+
+    if (pfile_dwnl == NULL || out_httpCode == NULL || id == CURL_PROFILE_S3_PUT) {
+        COMMONUTILITIES_ERROR("%s: Parameter Check Fail\n", __FUNCTION__);
+        return DWNL_FAIL;
+    }
+    curl = curlProfileCreate(id, pfile_dwnl->url, pfile_dwnl->pPostFields);
+    if (curl == NULL) {
+        COMMONUTILITIES_ERROR("%s: profile %d not available\n", __FUNCTION__, id);
+        return DWNL_FAIL;
+    }
+    if (*pfile_dwnl->pathname) {
+        byte_dwnled = urlHelperDownloadFileEx(curl, pfile_dwnl, opts, NULL, out_httpCode, &curl_status);
+    } else {
+        byte_dwnled = urlHelperDownloadToMemEx(curl, pfile_dwnl, opts, out_httpCode, &curl_status);
+    }
+    COMMONUTILITIES_INFO("%s : %s Bytes Downloaded=%zu and curl ret status=%d and http code=%d\n", __FUNCTION__,
+                         profile_names[id], byte_dwnled, curl_status, *out_httpCode);
+    urlHelperDestroyCurl(curl);
+    return (int)curl_status;
+}
+
+void curlProfileCleanup(void) {
+    CurlProfile_t *profile;
+    int i;
+
+    pthread_mutex_lock(&profile_lock);
+    for (i = 0; i < CURL_PROFILE_MAX; i++) {
+        profileFree(profiles[i]);
+        profiles[i] = NULL;
+    }
+    while ((profile = retired) != NULL) {
+        retired = profile->next;
+        profileFree(profile);
+    }
+    memset(bound, 0, sizeof(bound));
+    __atomic_store_n(&bound_count, 0, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&profile_lock);
+}
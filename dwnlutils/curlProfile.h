@@ -0,0 +1,83 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_CURLPROFILE_H_
+#define  _RDK_CURLPROFILE_H_
+
+#include <stdbool.h>
+#include <curl/curl.h>
+
+#include "urlHelper.h"
+
+#ifndef CURL_PROFILE_MAX_BOUND //This is to provide an option Define custom count of handles created from profiles at once using DFLAGS
+#define CURL_PROFILE_MAX_BOUND 32
+#endif
+
+/* Request profiles. Each one is a curl handle holding the options of a kind of request, built once
+ * and copied with curl_easy_duphandle for every request so that only url and body are set per request */
+typedef enum {
+    CURL_PROFILE_XCONF_MTLS = 0,    /* xconf query with client certificate */
+    CURL_PROFILE_SSR_DOWNLOAD,      /* image download from the SSR */
+    CURL_PROFILE_JSONRPC_LOCAL,     /* JSON-RPC call to the local service */
+    CURL_PROFILE_S3_PUT,            /* upload of a file to a presigned S3 url */
+    CURL_PROFILE_MAX
+} curlProfileId_t;
+
+/* Options of a profile, strings are copied by curlProfileBuild */
+typedef struct curlProfileOpt {
+    MtlsAuth_t *auth;               /* client certificate, NULL for none. Required by CURL_PROFILE_XCONF_MTLS */
+    bool sslverify;                 /* check OCSP status of the server certificate */
+    const char *header;             /* request header line, NULL for none */
+    const char *auth_token;         /* second header line e.g. JSON-RPC Authorization, NULL for none */
+} curlProfileOpt_t;
+
+/* curlProfileBuild(): Build profile id or replace it, e.g. when the JSON-RPC token changed.
+ *                     Handles created from the previous options keep them until they are destroyed
+ * Return : int : 0 on success, -1 on failure
+ * */
+int curlProfileBuild(curlProfileId_t id, const curlProfileOpt_t *opt);
+
+/* curlProfileReady(): Check if profile id is built */
+bool curlProfileReady(curlProfileId_t id);
+
+/* curlProfileCreate(): Get a handle with the options of profile id, free it with urlHelperDestroyCurl
+ * url : request url
+ * pPostFields : request body, NULL for none
+ * Return : CURL * : curl handle, NULL when the profile is not built or on failure
+ * */
+CURL *curlProfileCreate(curlProfileId_t id, const char *url, char *pPostFields);
+
+/* curlProfileRelease(): Drop profile of handle, called by urlHelperDestroyCurl before the handle is reset */
+void curlProfileRelease(CURL *curl);
+
+/* curlProfileRequest(): Request pfile_dwnl->url with pfile_dwnl->pPostFields on a handle of profile id.
+ *                       Body is stored to pathname when set otherwise to pDlData same as doHttpFileDownload.
+ *                       Not for CURL_PROFILE_S3_PUT, see performS3PutUpload
+ * pfile_dwnl : request descriptor
+ * opts : Optional download modes, NULL for none
+ * out_httpCode : Send back http status.
+ * Return : int : curl status, -1 when the profile can not be used
+ * */
+int curlProfileRequest(curlProfileId_t id, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *out_httpCode);
+
+/* curlProfileCleanup(): Free all profiles. Should be called only when no handle of a profile
+ *                       is in use, typically before process exit
+ * */
+void curlProfileCleanup(void);
+
+#endif
@@ -0,0 +1,986 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "deltaDownload.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "curlPool.h"
+#include "streamDigest.h"
+#include "bandwidthGovernor.h"
+#include "cancelToken.h"
+#include "transferStats.h"
+
+/* States of a multipart/byteranges body */
+#define DELTA_PART_SEEK     0   /* before a delimiter line */
+#define DELTA_PART_HEADERS  1   /* part header lines */
+#define DELTA_PART_BODY     2   /* range data */
+#define DELTA_PART_END      3   /* after the close delimiter */
+
+/* Memory buffer of the manifest request */
+typedef struct deltaText {
+    char *data;
+    size_t len;
+    size_t size;
+} DeltaText_t;
+
+uint32_t deltaWeakSum(const unsigned char *data, size_t len) {
+    uint32_t a = 0;
+    uint32_t b = 0;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        a += data[i];
+        b += (uint32_t)(len - i) * data[i];
+    }
+    return (a & 0xffff) | (b << 16);
+}
+
+/* deltaStrongSum(): sha256 of a block
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int deltaStrongSum(const void *data, size_t len, unsigned char *out) {
+    StreamDigest_t *ctx = streamDigestCreate(DIGEST_SHA256);
+    digestParam_t dp;
+    int ret = -1;
+
+    if (ctx != NULL && streamDigestUpdate(ctx, data, len) == 0 && streamDigestFinal(ctx, &dp) == 0) {
+        memcpy(out, dp.digest, DIGEST_MAX_LEN);
+        ret = 0;
+    }
+    streamDigestDestroy(ctx);
+    return ret;
+}
+
+static void deltaHex(const unsigned char *bin, size_t len, char *hex) {
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        sprintf(hex + i * 2, "%02x", bin[i]);
+    }
+    hex[len * 2] = '\0';
+}
+
+static int deltaUnhex(const char *hex, unsigned char *bin, size_t len) {
+    unsigned int byte;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (sscanf(hex + i * 2, "%2x", &byte) != 1) {
+            return -1;
+        }
+        bin[i] = (unsigned char)byte;
+    }
+    return 0;
+}
+
+int deltaManifestWrite(const char *file, size_t block_size, const char *manifest) {
+    unsigned char strong[DIGEST_MAX_LEN];
+    char hex[DIGEST_MAX_LEN * 2 + 1];
+    digestParam_t whole;
+    unsigned char *buf = NULL;
+    FILE *in = NULL;
+    FILE *out = NULL;
+    struct stat st;
+    size_t nread;
+    int ret = -1;
+
+    if (file == NULL || manifest == NULL) {
+        return -1;
+    }
+    if (block_size == 0) {
+        block_size = DELTA_BLOCK_SIZE;
+    }
+    memset(&whole, 0, sizeof(whole));
+    whole.type = DIGEST_SHA256;
+    if (stat(file, &st) != 0 || streamDigestFile(file, &whole) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to read %s\n", __FUNCTION__, file);
+        return -1;
+    }
+    buf = malloc(block_size);
+    in = fopen(file, "rb");
+    out = fopen(manifest, "w");
+    if (buf == NULL || in == NULL || out == NULL) {
+        goto done;
+    }
+    fprintf(out, "%s\nLength: %lld\nBlocksize: %zu\nSHA-256: %s\n\n", DELTA_MANIFEST_MAGIC,
+            (long long)st.st_size, block_size, whole.digest_hex);
+    while ((nread = fread(buf, 1, block_size, in)) > 0) {
+        if (deltaStrongSum(buf, nread, strong) != 0) {
+            goto done;
+        }
+        deltaHex(strong, DIGEST_MAX_LEN, hex);
+        fprintf(out, "%08x %s\n", deltaWeakSum(buf, nread), hex);
+    }
+    ret = ferror(in) ? -1 : 0;
+done:
+    if (out != NULL && fclose(out) != 0) {
+        ret = -1;
+    }
+    if (in != NULL) {
+        fclose(in);
+    }
+    free(buf);
+    return ret;
+}
+
+/* deltaNextLine(): Return next line of text and advance pos, NULL at end */
+static const char *deltaNextLine(const char *text, size_t len, size_t *pos, size_t *line_len) {
+    const char *line;
+    const char *nl;
+
+    if (*pos >= len) {
+        return NULL;
+    }
+    line = text + *pos;
+    nl = memchr(line, '\n', len - *pos);
+    *line_len = (nl != NULL) ? (size_t)(nl - line) : len - *pos;
+    *pos += *line_len + 1;
+    if (*line_len > 0 && line[*line_len - 1] == '\r') {
+        (*line_len)--;
+    }
+    return line;
+}
+
+/* deltaLineCount(): Lines of text from pos to the end */
+static size_t deltaLineCount(const char *text, size_t len, size_t pos) {
+    const char *nl;
+    size_t lines = 0;
+
+    while (pos < len) {
+        nl = memchr(text + pos, '\n', len - pos);
+        lines++;
+        if (nl == NULL) {
+            break;
+        }
+        pos = (size_t)(nl - text) + 1;
+    }
+    return lines;
+}
+
+int deltaManifestParse(const char *text, size_t len, DeltaManifest_t *manifest) {
+    const char *line;
+    size_t line_len = 0;
+    size_t pos = 0;
+    size_t i;
+    char field[DELTA_LINE_LEN];
+    char strong[DIGEST_MAX_LEN * 2 + 2];
+    unsigned int weak;
+
+    if (text == NULL || manifest == NULL) {
+        return -1;
+    }
+    memset(manifest, 0, sizeof(DeltaManifest_t));
+    manifest->length = -1;
+    line = deltaNextLine(text, len, &pos, &line_len);
+    if (line == NULL || line_len != strlen(DELTA_MANIFEST_MAGIC) || strncmp(line, DELTA_MANIFEST_MAGIC, line_len) != 0) {
+        COMMONUTILITIES_ERROR("%s: not a delta manifest\n", __FUNCTION__);
+        return -1;
+    }
+    while ((line = deltaNextLine(text, len, &pos, &line_len)) != NULL && line_len > 0) {
+        if (line_len >= sizeof(field)) {
+            continue;
+        }
+        memcpy(field, line, line_len);
+        field[line_len] = '\0';
+        if (strncasecmp(field, "Length:", 7) == 0) {
+            manifest->length = strtoll(field + 7, NULL, 10);
+        } else if (strncasecmp(field, "Blocksize:", 10) == 0) {
+            manifest->block_size = (size_t)strtoul(field + 10, NULL, 10);
+        } else if (strncasecmp(field, "SHA-256:", 8) == 0) {
+            sscanf(field + 8, " %64s", manifest->sha256);
+        }
+    }
+    if (manifest->length < 0 || manifest->block_size == 0 || strlen(manifest->sha256) != DIGEST_MAX_LEN * 2) {
+        COMMONUTILITIES_ERROR("%s: manifest header incomplete\n", __FUNCTION__);
+        return -1;
+    }
+    /* Length and block size are not trusted, the body must hold a line for every block */
+    manifest->count = (size_t)(manifest->length / (long long)manifest->block_size
+                               + ((manifest->length % (long long)manifest->block_size) != 0));
+    if (manifest->count > DELTA_MAX_BLOCKS || manifest->count > deltaLineCount(text, len, pos)) {
+        COMMONUTILITIES_ERROR("%s: %zu blocks not in the manifest\n", __FUNCTION__, manifest->count);
+        manifest->count = 0;
+        return -1;
+    }
+    if (manifest->count > 0) {
+        manifest->blocks = calloc(manifest->count, sizeof(DeltaBlock_t));
+        if (manifest->blocks == NULL) {
+            return -1;
+        }
+    }
+    for (i = 0; i < manifest->count; i++) {
+        line = deltaNextLine(text, len, &pos, &line_len);
+        if (line == NULL || line_len >= sizeof(field)) {
+            break;
+        }
+        memcpy(field, line, line_len);
+        field[line_len] = '\0';
+        if (sscanf(field, "%8x %65s", &weak, strong) != 2 || strlen(strong) != DIGEST_MAX_LEN * 2
+            || deltaUnhex(strong, manifest->blocks[i].strong, DIGEST_MAX_LEN) != 0) {
+            break;
+        }
+        manifest->blocks[i].weak = weak;
+        manifest->blocks[i].seed_offset = -1;
+    }
+    if (i != manifest->count) {
+        COMMONUTILITIES_ERROR("%s: %zu of %zu block checksums valid\n", __FUNCTION__, i, manifest->count);
+        deltaManifestFree(manifest);
+        return -1;
+    }
+    return 0;
+}
+
+void deltaManifestFree(DeltaManifest_t *manifest) {
+    if (manifest != NULL) {
+        free(manifest->blocks);
+        manifest->blocks = NULL;
+        manifest->count = 0;
+    }
+}
+
+/* deltaBlockLen(): Size of block i, only the last block can be short */
+static size_t deltaBlockLen(const DeltaManifest_t *manifest, size_t i) {
+    long long start = (long long)i * (long long)manifest->block_size;
+    long long left = manifest->length - start;
+
+    return (left < (long long)manifest->block_size) ? (size_t)left : manifest->block_size;
+}
+
+/* Full block of the seed scan, sorted by weak checksum. The key is kept in the entry so
+ * concurrent scans of different manifests share no state */
+typedef struct deltaWeak {
+    uint32_t weak;
+    size_t index;                           /* block in the manifest */
+} DeltaWeak_t;
+
+static int deltaWeakCompare(const void *a, const void *b) {
+    uint32_t wa = ((const DeltaWeak_t *)a)->weak;
+    uint32_t wb = ((const DeltaWeak_t *)b)->weak;
+
+    return (wa < wb) ? -1 : (wa > wb) ? 1 : 0;
+}
+
+/* deltaFirstWeak(): Index in sorted of the first block with checksum weak, count when none */
+static size_t deltaFirstWeak(const DeltaWeak_t *sorted, size_t count, uint32_t weak) {
+    size_t lo = 0;
+    size_t hi = count;
+    size_t mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (sorted[mid].weak < weak) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < count && sorted[lo].weak == weak) ? lo : count;
+}
+
+/* deltaMatchAt(): Check blocks with checksum weak against the seed window at pos
+ * Return : bool : true when at least one block was found
+ * */
+static bool deltaMatchAt(DeltaManifest_t *manifest, const DeltaWeak_t *sorted, size_t count,
+                         const unsigned char *seed, long long pos, uint32_t weak) {
+    unsigned char strong[DIGEST_MAX_LEN];
+    bool have_strong = false;
+    bool found = false;
+    size_t i = deltaFirstWeak(sorted, count, weak);
+
+    for (; i < count && sorted[i].weak == weak; i++) {
+        DeltaBlock_t *block = &manifest->blocks[sorted[i].index];
+        if (block->seed_offset >= 0) {
+            continue;
+        }
+        if (!have_strong) {
+            if (deltaStrongSum(seed + pos, manifest->block_size, strong) != 0) {
+                return false;
+            }
+            have_strong = true;
+        }
+        /* Equal blocks, e.g. padding, are all taken from the same place */
+        if (memcmp(strong, block->strong, DIGEST_MAX_LEN) == 0) {
+            block->seed_offset = pos;
+            found = true;
+        }
+    }
+    return found;
+}
+
+/* deltaMatchLast(): A short last block can only be at the end of the seed or at its own offset */
+static void deltaMatchLast(DeltaManifest_t *manifest, const unsigned char *seed, long long seed_len) {
+    DeltaBlock_t *last = &manifest->blocks[manifest->count - 1];
+    size_t len = deltaBlockLen(manifest, manifest->count - 1);
+    long long where[2];
+    unsigned char strong[DIGEST_MAX_LEN];
+    int i;
+
+    where[0] = seed_len - (long long)len;
+    where[1] = (long long)(manifest->count - 1) * (long long)manifest->block_size;
+    for (i = 0; i < 2 && last->seed_offset < 0; i++) {
+        if (where[i] >= 0 && where[i] + (long long)len <= seed_len
+            && deltaStrongSum(seed + where[i], len, strong) == 0 && memcmp(strong, last->strong, DIGEST_MAX_LEN) == 0) {
+            last->seed_offset = where[i];
+        }
+    }
+}
+
+long long deltaMatchSeed(DeltaManifest_t *manifest, const char *seed) {
+    const unsigned char *map = NULL;
+    DeltaWeak_t *sorted = NULL;
+    size_t count = 0;
+    size_t bs;
+    size_t i;
+    long long seed_len;
+    long long pos = 0;
+    long long reused = 0;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    struct stat st;
+    int fd;
+
+    if (manifest == NULL || seed == NULL) {
+        return -1;
+    }
+    fd = open(seed, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        COMMONUTILITIES_ERROR("%s: seed %s not readable\n", __FUNCTION__, seed);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    seed_len = (long long)st.st_size;
+    if (seed_len == 0 || manifest->count == 0) {
+        close(fd);
+        return 0;
+    }
+    map = mmap(NULL, (size_t)seed_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        COMMONUTILITIES_ERROR("%s: mmap of seed failed errno=%d\n", __FUNCTION__, errno);
+        return -1;
+    }
+    madvise((void *)map, (size_t)seed_len, MADV_SEQUENTIAL);
+    bs = manifest->block_size;
+    sorted = malloc(manifest->count * sizeof(DeltaWeak_t));
+    if (sorted == NULL) {
+        munmap((void *)map, (size_t)seed_len);
+        return -1;
+    }
+    for (i = 0; i < manifest->count; i++) {
+        if (deltaBlockLen(manifest, i) == bs) {
+            sorted[count].weak = manifest->blocks[i].weak;
+            sorted[count].index = i;
+            count++;
+        }
+    }
+    qsort(sorted, count, sizeof(DeltaWeak_t), deltaWeakCompare);
+
+    /* Rolling checksum of the window [pos, pos + bs), rsync style:
+     * a is the sum of the bytes, b the sum weighted by distance to the window end */
+    while (count > 0 && pos + (long long)bs <= seed_len) {
+        if (pos == 0 || a == 0xffffffffU) {
+            uint32_t w = deltaWeakSum(map + pos, bs);
+            a = w & 0xffff;
+            b = w >> 16;
+        }
+        if (deltaMatchAt(manifest, sorted, count, map, pos, (a & 0xffff) | (b << 16))) {
+            pos += (long long)bs;
+            a = 0xffffffffU;    /* start again after the matched block */
+            continue;
+        }
+        if (pos + (long long)bs >= seed_len) {
+            break;
+        }
+        a = (a - map[pos] + map[pos + bs]) & 0xffff;
+        b = (b - (uint32_t)bs * map[pos] + a) & 0xffff;
+        pos++;
+    }
+    if (deltaBlockLen(manifest, manifest->count - 1) != bs) {
+        deltaMatchLast(manifest, map, seed_len);
+    }
+    for (i = 0; i < manifest->count; i++) {
+        if (manifest->blocks[i].seed_offset >= 0) {
+            reused += (long long)deltaBlockLen(manifest, i);
+        }
+    }
+    free(sorted);
+    munmap((void *)map, (size_t)seed_len);
+    COMMONUTILITIES_INFO("%s: %lld of %lld bytes found in %s\n", __FUNCTION__, reused, manifest->length, seed);
+    return reused;
+}
+
+/* deltaCopySeed(): Write blocks found in the seed at their offset in the file
+ * Return : int : 0 on success, -1 on read or write failure
+ * */
+static int deltaCopySeed(const DeltaManifest_t *manifest, const char *seed, int fd) {
+    char *buf = malloc(manifest->block_size);
+    int seed_fd = open(seed, O_RDONLY | O_CLOEXEC);
+    size_t len;
+    size_t i;
+    int ret = 0;
+
+    if (buf == NULL || seed_fd < 0) {
+        free(buf);
+        if (seed_fd >= 0) {
+            close(seed_fd);
+        }
+        return -1;
+    }
+    for (i = 0; i < manifest->count && ret == 0; i++) {
+        if (manifest->blocks[i].seed_offset < 0) {
+            continue;
+        }
+        len = deltaBlockLen(manifest, i);
+        if (pread(seed_fd, buf, len, (off_t)manifest->blocks[i].seed_offset) != (ssize_t)len
+            || pwrite(fd, buf, len, (off_t)i * (off_t)manifest->block_size) != (ssize_t)len) {
+            COMMONUTILITIES_ERROR("%s: copy of block %zu failed errno=%d\n", __FUNCTION__, i, errno);
+            ret = -1;
+        }
+    }
+    close(seed_fd);
+    free(buf);
+    return ret;
+}
+
+static size_t delta_manifest_cb(void *ptr, size_t size, size_t nmemb, void *userdata) {
+    DeltaText_t *text = userdata;
+    size_t len = size * nmemb;
+    size_t want;
+    char *grown;
+
+    if (text->len + len + 1 > text->size) {
+        if (text->len + len + 1 > DELTA_MANIFEST_MAX) {
+            COMMONUTILITIES_ERROR("delta_manifest_cb: manifest larger than %d bytes\n", DELTA_MANIFEST_MAX);
+            return 0;
+        }
+        want = (text->size > 0) ? text->size * 2 : 64 * 1024;
+        while (want < text->len + len + 1) {
+            want *= 2;
+        }
+        grown = realloc(text->data, want);
+        if (grown == NULL) {
+            return 0;
+        }
+        text->data = grown;
+        text->size = want;
+    }
+    memcpy(text->data + text->len, ptr, len);
+    text->len += len;
+    text->data[text->len] = '\0';
+    return len;
+}
+
+/* deltaFetchManifest(): Download and parse the manifest with the options of curl
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int deltaFetchManifest(CURL *curl, const char *url, DeltaManifest_t *manifest) {
+    CURL *req = curl_easy_duphandle(curl);
+    DeltaText_t text;
+    CURLcode curl_code;
+    long http_code = 0;
+    int ret = -1;
+
+    if (req == NULL) {
+        COMMONUTILITIES_ERROR("%s: curl_easy_duphandle failed\n", __FUNCTION__);
+        return -1;
+    }
+    transferStatsInherit(req, curl);
+    memset(&text, 0, sizeof(text));
+    curl_easy_setopt(req, CURLOPT_SHARE, curlPoolGetShare());
+    curl_easy_setopt(req, CURLOPT_URL, url);
+    curl_easy_setopt(req, CURLOPT_HEADERFUNCTION, NULL);
+    curl_easy_setopt(req, CURLOPT_HEADERDATA, NULL);
+    curl_easy_setopt(req, CURLOPT_NOPROGRESS, 1L);
+    curl_easy_setopt(req, CURLOPT_RANGE, NULL);
+    curl_easy_setopt(req, CURLOPT_WRITEFUNCTION, delta_manifest_cb);
+    curl_easy_setopt(req, CURLOPT_WRITEDATA, &text);
+    curl_code = curl_easy_perform(req);
+    transferStatsCollect(req, curl_code);
+    curl_easy_getinfo(req, CURLINFO_RESPONSE_CODE, &http_code);
+    if (curl_code == CURLE_OK && http_code == 200 && text.data != NULL) {
+        ret = deltaManifestParse(text.data, text.len, manifest);
+    } else {
+        COMMONUTILITIES_ERROR("%s: %s not available curl=%d http=%ld\n", __FUNCTION__, url, curl_code, http_code);
+    }
+    free(text.data);
+    transferStatsEnd(req);
+    curlPoolRelease(req);
+    return ret;
+}
+
+/* deltaContentRange(): Parse "Content-Range: bytes first-last/total"
+ * Return : int : 0 on success, -1 when line is not a valid Content-Range
+ * */
+static int deltaContentRange(const char *line, size_t len, long long *first, long long *last) {
+    char value[DELTA_LINE_LEN];
+
+    if (len < 14 || len >= sizeof(value) || strncasecmp(line, "Content-Range:", 14) != 0) {
+        return -1;
+    }
+    memcpy(value, line + 14, len - 14);
+    value[len - 14] = '\0';
+    if (sscanf(value, " bytes %lld-%lld", first, last) != 2 || *first < 0 || *last < *first) {
+        return -1;
+    }
+    return 0;
+}
+
+/* deltaStop(): Stop check of the download, its token or setForceStop */
+static int deltaStop(void *arg) {
+    DeltaFetch_t *fetch = (DeltaFetch_t *)arg;
+
+    return (getForceStop() == 1 || cancelTokenIsCancelled(fetch->cancel));
+}
+
+/*
+ * This is Call back function for range responses. It keeps the boundary of a multipart
+ * response and the range of a single range response, and dumps the header like urlHelperDownloadFile.
+ * */
+static size_t delta_header_cb(char *buffer, size_t size, size_t nitems, void *userdata) {
+    DeltaFetch_t *fetch = (DeltaFetch_t *)userdata;
+    size_t len = size * nitems;
+    long long first;
+    long long last;
+    const char *param;
+    size_t n;
+
+    if (fetch->headerfile != NULL) {
+        fwrite(buffer, size, nitems, fetch->headerfile);
+    }
+    /* New status line means redirect was followed, only the final response is used */
+    if (len > 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+        fetch->boundary[0] = '\0';
+        fetch->offset = -1;
+        fetch->remaining = 0;
+    } else if (deltaContentRange(buffer, len, &first, &last) == 0) {
+        fetch->offset = first;
+        fetch->remaining = last - first + 1;
+    } else if (len > 13 && strncasecmp(buffer, "Content-Type:", 13) == 0) {
+        param = strstr(buffer, "boundary=");
+        if (param != NULL && (size_t)(param - buffer) < len) {
+            param += 9;
+            if (*param == '"') {
+                param++;
+            }
+            n = strcspn(param, "\"\r\n;");
+            if (n > 0 && n + 3 <= sizeof(fetch->boundary)) {
+                snprintf(fetch->boundary, sizeof(fetch->boundary), "--%.*s", (int)n, param);
+            }
+        }
+    }
+    return len;
+}
+
+/* deltaStore(): Write range data at the current offset
+ * Return : size_t : bytes stored, less than len on failure
+ * */
+static size_t deltaStore(DeltaFetch_t *fetch, const char *data, size_t len) {
+    size_t done = 0;
+    ssize_t ret;
+
+    if (fetch->offset < 0 || fetch->offset + (long long)len > fetch->length) {
+        COMMONUTILITIES_ERROR("delta_write: range data outside of file\n");
+        return 0;
+    }
+    while (done < len) {
+        ret = pwrite(fetch->fd, data + done, len - done, (off_t)(fetch->offset + (long long)done));
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            COMMONUTILITIES_ERROR("delta_write: pwrite failed errno=%d\n", errno);
+            break;
+        }
+        done += (size_t)ret;
+    }
+    fetch->offset += (long long)done;
+    fetch->remaining -= (long long)done;
+    fetch->received += (long long)done;
+    return done;
+}
+
+/* deltaPartLine(): Handle a delimiter or part header line of a multipart body
+ * Return : int : 0 to continue, -1 on invalid body
+ * */
+static int deltaPartLine(DeltaFetch_t *fetch) {
+    size_t len = fetch->line_len;
+    size_t blen = strlen(fetch->boundary);
+    long long first;
+    long long last;
+
+    if (len > 0 && fetch->line[len - 1] == '\r') {
+        len--;
+    }
+    if (fetch->state == DELTA_PART_SEEK) {
+        if (len >= blen && strncmp(fetch->line, fetch->boundary, blen) == 0) {
+            if (len >= blen + 2 && strncmp(fetch->line + blen, "--", 2) == 0) {
+                fetch->state = DELTA_PART_END;
+            } else {
+                fetch->state = DELTA_PART_HEADERS;
+                fetch->offset = -1;
+                fetch->remaining = 0;
+            }
+        }
+        return 0;
+    }
+    /* DELTA_PART_HEADERS */
+    if (len == 0) {
+        if (fetch->offset < 0 || fetch->remaining <= 0) {
+            COMMONUTILITIES_ERROR("delta_write: part without Content-Range\n");
+            return -1;
+        }
+        fetch->state = DELTA_PART_BODY;
+    } else if (deltaContentRange(fetch->line, len, &first, &last) == 0) {
+        fetch->offset = first;
+        fetch->remaining = last - first + 1;
+    }
+    return 0;
+}
+
+/*
+ * This is Call back function for range responses. Data of each range is written
+ * at its own offset, multipart delimiters and part headers are parsed on the way.
+ * */
+static size_t delta_write(void *ptr, size_t size, size_t nmemb, void *userdata) {
+    DeltaFetch_t *fetch = (DeltaFetch_t *)userdata;
+    const char *data = ptr;
+    size_t len = size * nmemb;
+    size_t pos = 0;
+    size_t take;
+
+    if (deltaStop(fetch)) {
+        COMMONUTILITIES_INFO("delta_write Stopping Download\n");
+        return 0;
+    }
+    /* A server ignoring the ranges send the whole file with 200 */
+    if (fetch->checked == false) {
+        if (fetch->curl != NULL) {
+            curl_easy_getinfo(fetch->curl, CURLINFO_RESPONSE_CODE, &fetch->http_code);
+        }
+        if (fetch->http_code != 206) {
+            COMMONUTILITIES_ERROR("delta_write: range request answered with http=%ld\n", fetch->http_code);
+            fetch->range_ignored = true;
+            return 0;
+        }
+        fetch->checked = true;
+        fetch->state = (fetch->boundary[0] != '\0') ? DELTA_PART_SEEK : DELTA_PART_BODY;
+        fetch->line_len = 0;
+    }
+    if (bwGovernorConsume(NULL, len, deltaStop, fetch) != 0) {
+        return 0;
+    }
+    while (pos < len) {
+        if (fetch->state == DELTA_PART_BODY) {
+            if (fetch->remaining <= 0) {
+                if (fetch->boundary[0] == '\0') {
+                    COMMONUTILITIES_ERROR("delta_write: received more data than requested range\n");
+                    return 0;
+                }
+                fetch->state = DELTA_PART_SEEK;
+                continue;
+            }
+            take = len - pos;
+            if ((long long)take > fetch->remaining) {
+                take = (size_t)fetch->remaining;
+            }
+            if (deltaStore(fetch, data + pos, take) != take) {
+                return 0;
+            }
+            pos += take;
+            continue;
+        }
+        if (fetch->state == DELTA_PART_END) {
+            /* Epilogue is ignored */
+            return len;
+        }
+        if (data[pos] == '\n') {
+            if (deltaPartLine(fetch) != 0) {
+                return 0;
+            }
+            fetch->line_len = 0;
+        } else if (fetch->line_len < sizeof(fetch->line) - 1) {
+            fetch->line[fetch->line_len++] = data[pos];
+        }
+        pos++;
+    }
+    return len;
+}
+
+/* deltaFetchRanges(): Request blocks from first to last not found in the seed, DELTA_MAX_RANGES
+ *                     ranges at most. Adjacent missing blocks form one range
+ * next : Send back first block after the requested ranges
+ * expected : Send back bytes requested
+ * Return : CURLcode : CURLE_OK when the request was set
+ * */
+static CURLcode deltaFetchRanges(DeltaFetch_t *fetch, const DeltaManifest_t *manifest, size_t first, size_t *next, long long *expected) {
+    char *range = NULL;
+    size_t range_len = 0;
+    size_t range_size = 0;
+    size_t i = first;
+    int ranges = 0;
+    long long start;
+    long long end;
+    char item[64];
+    char *grown;
+    CURLcode ret_code;
+
+    *expected = 0;
+    while (i < manifest->count && ranges < DELTA_MAX_RANGES) {
+        if (manifest->blocks[i].seed_offset >= 0) {
+            i++;
+            continue;
+        }
+        start = (long long)i * (long long)manifest->block_size;
+        while (i < manifest->count && manifest->blocks[i].seed_offset < 0) {
+            i++;
+        }
+        end = (long long)i * (long long)manifest->block_size;
+        if (end > manifest->length) {
+            end = manifest->length;
+        }
+        snprintf(item, sizeof(item), "%s%lld-%lld", (ranges > 0) ? "," : "", start, end - 1);
+        if (range_len + strlen(item) + 1 > range_size) {
+            range_size = (range_size > 0) ? range_size * 2 : 512;
+            grown = realloc(range, range_size);
+            if (grown == NULL) {
+                free(range);
+                return CURLE_OUT_OF_MEMORY;
+            }
+            range = grown;
+        }
+        memcpy(range + range_len, item, strlen(item) + 1);
+        range_len += strlen(item);
+        *expected += end - start;
+        ranges++;
+    }
+    *next = i;
+    if (ranges == 0) {
+        free(range);
+        return CURLE_OK;
+    }
+    fetch->checked = false;
+    fetch->range_ignored = false;
+    fetch->received = 0;
+    fetch->boundary[0] = '\0';
+    fetch->offset = -1;
+    fetch->remaining = 0;
+    ret_code = curl_easy_setopt(fetch->curl, CURLOPT_RANGE, range);
+    if (ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("%s: CURLOPT_RANGE failed msg:%s\n", __FUNCTION__, curl_easy_strerror(ret_code));
+    } else {
+        COMMONUTILITIES_INFO("%s: %d ranges, %lld bytes\n", __FUNCTION__, ranges, *expected);
+    }
+    free(range);
+    return ret_code;
+}
+
+/* deltaVerify(): Check the built file against the digest of the manifest. The file is read once,
+ *                the digest requested by the caller is taken from the same pass
+ * fd : built file
+ * digest : digest requested for the file, NULL if not requested. Not set when the file does not verify
+ * */
+static bool deltaVerify(int fd, const DeltaManifest_t *manifest, digestParam_t *digest) {
+    StreamDigest_t *sha = streamDigestCreate(DIGEST_SHA256);
+    StreamDigest_t *other = NULL;
+    digestParam_t dp;
+    unsigned char *buf;
+    ssize_t got;
+    off_t pos = 0;
+    bool ok = false;
+
+    memset(&dp, 0, sizeof(dp));
+    dp.type = DIGEST_SHA256;
+    if (digest != NULL && digest->type != DIGEST_SHA256) {
+        other = streamDigestCreate(digest->type);
+    }
+    buf = malloc(DIGEST_READ_BUF_SIZE);
+    if (sha == NULL || buf == NULL || (digest != NULL && digest->type != DIGEST_SHA256 && other == NULL)) {
+        goto done;
+    }
+    while ((got = pread(fd, buf, DIGEST_READ_BUF_SIZE, pos)) > 0) {
+        if (streamDigestUpdate(sha, buf, (size_t)got) != 0 || (other != NULL && streamDigestUpdate(other, buf, (size_t)got) != 0)) {
+            goto done;
+        }
+        pos += got;
+    }
+    if (got < 0 || streamDigestFinal(sha, &dp) != 0 || strcasecmp(dp.digest_hex, manifest->sha256) != 0) {
+        goto done;
+    }
+    if (other != NULL) {
+        ok = (streamDigestFinal(other, digest) == 0);
+    }else {
+        if (digest != NULL) {
+            memcpy(digest, &dp, sizeof(digestParam_t));
+        }
+        ok = true;
+    }
+done:
+    free(buf);
+    streamDigestDestroy(other);
+    streamDigestDestroy(sha);
+    return ok;
+}
+
+int deltaDownloadFile(CURL *curl, const char *file, deltaParam_t *delta, digestParam_t *digest, struct cancelToken *cancel,
+                      size_t *bytes, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+    DeltaManifest_t manifest;
+    DeltaFetch_t fetch;
+    struct stat seed_st;
+    struct stat file_st;
+    char header_dump[128];
+    size_t next = 0;
+    long long expected = 0;
+    long long reused;
+    int ret = DELTA_DWNL_NOT_POSSIBLE;
+
+    if (curl == NULL || file == NULL || delta == NULL || delta->manifest_url == NULL || delta->seed == NULL
+        || bytes == NULL || httpCode_ret_status == NULL || curl_ret_status == NULL) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return DELTA_DWNL_NOT_POSSIBLE;
+    }
+    *bytes = 0;
+    delta->reused_bytes = 0;
+    delta->fetched_bytes = 0;
+    if (digest != NULL) {
+        digest->digest_len = 0;
+        digest->digest_hex[0] = '\0';
+    }
+    /* Blocks are written over the file while the seed is still read */
+    if (stat(delta->seed, &seed_st) != 0 || (stat(file, &file_st) == 0 && seed_st.st_dev == file_st.st_dev && seed_st.st_ino == file_st.st_ino)) {
+        COMMONUTILITIES_ERROR("%s: seed %s missing or same as download file\n", __FUNCTION__, delta->seed);
+        return DELTA_DWNL_NOT_POSSIBLE;
+    }
+    if (deltaFetchManifest(curl, delta->manifest_url, &manifest) != 0) {
+        return DELTA_DWNL_NOT_POSSIBLE;
+    }
+    reused = deltaMatchSeed(&manifest, delta->seed);
+    if (reused <= 0) {
+        COMMONUTILITIES_INFO("%s: nothing to reuse from seed, full download\n", __FUNCTION__);
+        deltaManifestFree(&manifest);
+        return DELTA_DWNL_NOT_POSSIBLE;
+    }
+    memset(&fetch, 0, sizeof(fetch));
+    fetch.length = manifest.length;
+    fetch.cancel = cancel;
+    fetch.fd = open(file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fetch.fd < 0) {
+        COMMONUTILITIES_ERROR("%s: File open Fail:%s\n", __FUNCTION__, file);
+        deltaManifestFree(&manifest);
+        return DELTA_DWNL_NOT_POSSIBLE;
+    }
+    /* File has its final size at once, seed and fetched blocks fill it in place */
+    if (ftruncate(fetch.fd, (off_t)manifest.length) != 0 || deltaCopySeed(&manifest, delta->seed, fetch.fd) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to build %s from seed\n", __FUNCTION__, file);
+        goto done;
+    }
+    delta->reused_bytes = reused;
+    fetch.curl = curl_easy_duphandle(curl);
+    if (fetch.curl == NULL) {
+        COMMONUTILITIES_ERROR("%s: curl_easy_duphandle failed\n", __FUNCTION__);
+        goto done;
+    }
+    transferStatsInherit(fetch.curl, curl);
+    curl_easy_setopt(fetch.curl, CURLOPT_SHARE, curlPoolGetShare());
+    curl_easy_setopt(fetch.curl, CURLOPT_HEADERFUNCTION, delta_header_cb);
+    curl_easy_setopt(fetch.curl, CURLOPT_HEADERDATA, &fetch);
+    curl_easy_setopt(fetch.curl, CURLOPT_NOPROGRESS, 1L);
+    curl_easy_setopt(fetch.curl, CURLOPT_WRITEFUNCTION, delta_write);
+    curl_easy_setopt(fetch.curl, CURLOPT_WRITEDATA, &fetch);
+    snprintf(header_dump, sizeof(header_dump), "%s.header", file);
+    fetch.headerfile = fopen(header_dump, "w");
+
+    *curl_ret_status = CURLE_OK;
+    *httpCode_ret_status = 200;
+    while (next < manifest.count) {
+        if (deltaFetchRanges(&fetch, &manifest, next, &next, &expected) != CURLE_OK) {
+            *curl_ret_status = CURLE_FAILED_INIT;
+            break;
+        }
+        if (expected == 0) {
+            break;
+        }
+        *curl_ret_status = curl_easy_perform(fetch.curl);
+        transferStatsCollect(fetch.curl, *curl_ret_status);
+        curl_easy_getinfo(fetch.curl, CURLINFO_RESPONSE_CODE, &fetch.http_code);
+        delta->fetched_bytes += fetch.received;
+        if (fetch.headerfile != NULL) {
+            fclose(fetch.headerfile);
+            fetch.headerfile = NULL;
+        }
+        if (fetch.range_ignored) {
+            goto done;
+        }
+        if (*curl_ret_status == CURLE_OK && fetch.received < expected) {
+            *curl_ret_status = CURLE_PARTIAL_FILE;
+        }
+        if (*curl_ret_status != CURLE_OK) {
+            *httpCode_ret_status = (int)fetch.http_code;
+            if (deltaStop(&fetch)) {
+                *curl_ret_status = CURLE_ABORTED_BY_CALLBACK;
+            }
+            COMMONUTILITIES_ERROR("%s: range request failed curl=%d http=%ld\n", __FUNCTION__, *curl_ret_status, fetch.http_code);
+            ret = DELTA_DWNL_DONE;
+            goto done;
+        }
+    }
+    if (*curl_ret_status == CURLE_OK) {
+        fsync(fetch.fd);
+        if (!deltaVerify(fetch.fd, &manifest, digest)) {
+            COMMONUTILITIES_ERROR("%s: %s does not match SHA-256 of manifest\n", __FUNCTION__, file);
+            goto done;
+        }
+        *bytes = (size_t)manifest.length;
+    }
+    ret = DELTA_DWNL_DONE;
+    COMMONUTILITIES_INFO("%s: Download Operation Done. reused:%lld fetched:%lld curl code=%d http code=%d\n", __FUNCTION__,
+                         delta->reused_bytes, delta->fetched_bytes, *curl_ret_status, *httpCode_ret_status);
+done:
+    if (fetch.headerfile != NULL) {
+        fclose(fetch.headerfile);
+    }
+    if (fetch.curl != NULL) {
+        transferStatsEnd(fetch.curl);
+        curlPoolRelease(fetch.curl);
+    }
+    close(fetch.fd);
+    deltaManifestFree(&manifest);
+    return ret;
+}
+
+#ifdef GTEST_ENABLE
+size_t (*getdelta_write(void)) (void *ptr, size_t size, size_t nmemb, void *userdata) {
+    return &delta_write;
+}
+
+size_t (*getdelta_header_cb(void)) (char *buffer, size_t size, size_t nitems, void *userdata) {
+    return &delta_header_cb;
+}
+#endif
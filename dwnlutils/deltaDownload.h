@@ -0,0 +1,136 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_DELTADOWNLOAD_H_
+#define  _RDK_DELTADOWNLOAD_H_
+
+#include <stdint.h>
+
+#include "urlHelper.h"
+
+#define DELTA_DWNL_DONE             0   /* delta download ran, result is in the out parameters */
+#define DELTA_DWNL_NOT_POSSIBLE     1   /* file not built, caller should download it in full */
+
+#ifndef DELTA_BLOCK_SIZE //This is to provide an option Define custom block size of written manifests using DFLAGS
+#define DELTA_BLOCK_SIZE 65536
+#endif
+
+#ifndef DELTA_MAX_RANGES //This is to provide an option Define custom count of ranges in one request using DFLAGS
+#define DELTA_MAX_RANGES 32
+#endif
+
+#ifndef DELTA_MANIFEST_MAX //This is to provide an option Define custom largest accepted manifest using DFLAGS
+#define DELTA_MANIFEST_MAX (16 * 1024 * 1024)
+#endif
+
+#ifndef DELTA_MAX_BLOCKS //This is to provide an option Define custom largest block count of an accepted manifest using DFLAGS
+#define DELTA_MAX_BLOCKS (256 * 1024)
+#endif
+
+#define DELTA_MANIFEST_MAGIC "dwnl-delta: 1"
+#define DELTA_BOUNDARY_LEN 80
+#define DELTA_LINE_LEN 256
+
+/* Block checksum manifest published next to a file, text with one line per block:
+ *   dwnl-delta: 1
+ *   Length: <file size>
+ *   Blocksize: <block size>
+ *   SHA-256: <digest of the whole file>
+ *   <empty line>
+ *   <weak rolling checksum, 8 hex> <sha256 of the block, 64 hex>
+ * The last block covers the remaining bytes and may be shorter than the block size */
+
+/* Below structure describe one block of the file */
+typedef struct deltaBlock {
+    uint32_t weak;                          /* rsync style rolling checksum */
+    unsigned char strong[DIGEST_MAX_LEN];   /* sha256 of the block */
+    long long seed_offset;                  /* position of the same data in the seed, -1 when it must be fetched */
+} DeltaBlock_t;
+
+typedef struct deltaManifest {
+    long long length;                       /* file size */
+    size_t block_size;
+    char sha256[DIGEST_MAX_LEN * 2 + 1];    /* digest of the whole file in hex */
+    size_t count;                           /* number of blocks */
+    DeltaBlock_t *blocks;
+} DeltaManifest_t;
+
+/* Below structure describe the state of one range request, the response is a single range or
+ * a multipart/byteranges body whose parts are written at their own offset */
+typedef struct deltaFetch {
+    CURL *curl;
+    int fd;
+    long long length;                       /* file size, every part must be inside */
+    char boundary[DELTA_BOUNDARY_LEN];      /* "--" and boundary of a multipart response, empty for a single range */
+    int state;                              /* position in the multipart body */
+    char line[DELTA_LINE_LEN];              /* part delimiter or header line being received */
+    size_t line_len;
+    long long offset;                       /* file offset of next body byte, -1 when not known */
+    long long remaining;                    /* body bytes left in current range */
+    long long received;                     /* body bytes stored by this request */
+    bool checked;                           /* http status checked for current response */
+    bool range_ignored;                     /* server answered without 206 */
+    long http_code;
+    FILE *headerfile;                       /* header dump, NULL if not required */
+    struct cancelToken *cancel;             /* cancellation of the download, NULL if not requested */
+} DeltaFetch_t;
+
+/* deltaWeakSum(): Rolling checksum of a block, same as in the manifest */
+uint32_t deltaWeakSum(const unsigned char *data, size_t len);
+
+/* deltaManifestWrite(): Write the manifest of a file, used where files are published
+ * block_size : 0 for DELTA_BLOCK_SIZE
+ * Return : int : 0 on success, -1 on failure
+ * */
+int deltaManifestWrite(const char *file, size_t block_size, const char *manifest);
+
+/* deltaManifestParse(): Read a manifest from memory. Every block starts as not found in the seed
+ * Return : int : 0 on success, -1 when the manifest is not valid. On success free with deltaManifestFree
+ * */
+int deltaManifestParse(const char *text, size_t len, DeltaManifest_t *manifest);
+
+/* deltaManifestFree(): Free blocks of a parsed manifest */
+void deltaManifestFree(DeltaManifest_t *manifest);
+
+/* deltaMatchSeed(): Find blocks of the manifest in the seed file and set their seed_offset.
+ *                   Every position of the seed is checked with the rolling checksum, sha256
+ *                   is computed only when the rolling checksum matches a block
+ * Return : long long : bytes of the file found in the seed, -1 when the seed can not be read
+ * */
+long long deltaMatchSeed(DeltaManifest_t *manifest, const char *seed);
+
+/* deltaDownloadFile(): Build file from the blocks found in the seed and fetch only the other
+ *                      blocks with multi-range requests. The file is created at its final size
+ *                      and every block is written at its own offset, then checked against the
+ *                      SHA-256 of the manifest. Headers of the first range response are dumped
+ *                      to <file>.header same as urlHelperDownloadFile.
+ * curl : Curl object with url and security options already set. It is duplicated for the requests
+ * file : path with file name to download, must not be the seed
+ * delta : manifest url and seed file, reused and fetched bytes are sent back in it
+ * digest : digest of the file, NULL if not requested. Blocks are not written in order so it is
+ *          computed by the pass that checks the manifest digest, digest_len is 0 unless the file verified
+ * cancel : cancellation token of the download, NULL for setForceStop only
+ * bytes : Send back file size
+ * httpCode_ret_status : Send back http status.
+ * curl_ret_status : Send back curl status
+ * Return : DELTA_DWNL_DONE or DELTA_DWNL_NOT_POSSIBLE
+ * */
+int deltaDownloadFile(CURL *curl, const char *file, deltaParam_t *delta, digestParam_t *digest, struct cancelToken *cancel,
+                      size_t *bytes, int *httpCode_ret_status, CURLcode *curl_ret_status);
+
+#endif
@@ -0,0 +1,502 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "dnsCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+#define DNS_MAX_BOUND 32
+
+/* '+' lets curl expire the addresses like resolved ones, the form exists since curl 7.75.0.
+ * Older versions keep them until dnsCacheDone drops them */
+#if LIBCURL_VERSION_NUM >= 0x074b00
+#define DNS_RESOLVE_FORMAT "+%s:%ld:%s"
+#else
+#define DNS_RESOLVE_FORMAT "%s:%ld:%s"
+#endif
+
+/* Cached addresses of one host and port */
+typedef struct dnsEntry {
+    char host[DNS_HOST_MAX_LEN];
+    long port;
+    char addrs[DNS_ADDRS_MAX_LEN];  /* curl resolve format, IPv6 in brackets. Empty when dropped */
+    time_t expiry;                  /* wall clock, the file is used across restarts */
+    bool refreshing;
+    bool purge;                     /* pinned addresses must be removed from curl DNS cache */
+} DnsEntry_t;
+
+/* Resolve list set on a handle, must live until the transfer started */
+typedef struct dnsBound {
+    CURL *handle;
+    struct curl_slist *list;
+    char host[DNS_HOST_MAX_LEN];
+    long port;
+} DnsBound_t;
+
+typedef struct dnsRefreshTask {
+    char host[DNS_HOST_MAX_LEN];
+    long port;
+} DnsRefreshTask_t;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static char cache_file[DNS_HOST_MAX_LEN] = DNS_CACHE_FILE;
+static unsigned int cache_ttl = DNS_CACHE_TTL_SEC;
+static bool cache_loaded = false;
+static DnsEntry_t entries[DNS_CACHE_MAX_HOSTS];
+static int entry_count = 0;
+static DnsBound_t bound[DNS_MAX_BOUND];
+
+/* dnsFind(): Index of host and port in cache, -1 if not present. Called with lock held */
+static int dnsFind(const char *host, long port) {
+    int i;
+
+    for (i = 0; i < entry_count; i++) {
+        if (entries[i].port == port && strcmp(entries[i].host, host) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* dnsSlot(): Entry for host and port, the one expiring first is replaced when cache is full.
+ * Called with lock held */
+static DnsEntry_t *dnsSlot(const char *host, long port) {
+    int i = dnsFind(host, port);
+    int oldest = 0;
+
+    if (i >= 0) {
+        return &entries[i];
+    }
+    if (entry_count < DNS_CACHE_MAX_HOSTS) {
+        i = entry_count++;
+    } else {
+        for (i = 1; i < entry_count; i++) {
+            if (!entries[i].refreshing && entries[i].expiry < entries[oldest].expiry) {
+                oldest = i;
+            }
+        }
+        i = oldest;
+    }
+    memset(&entries[i], 0, sizeof(DnsEntry_t));
+    snprintf(entries[i].host, sizeof(entries[i].host), "%s", host);
+    entries[i].port = port;
+    return &entries[i];
+}
+
+/* dnsLoad(): Read cache file once. Called with lock held */
+static void dnsLoad(void) {
+    FILE *fp;
+    char line[DNS_HOST_MAX_LEN + DNS_ADDRS_MAX_LEN + 64];
+    char host[DNS_HOST_MAX_LEN];
+    char addrs[DNS_ADDRS_MAX_LEN];
+    long port;
+    long long expiry;
+    DnsEntry_t *entry;
+
+    if (cache_loaded) {
+        return;
+    }
+    cache_loaded = true;
+    entry_count = 0;
+    fp = fopen(cache_file, "r");
+    if (fp == NULL) {
+        return;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        /* host port expiry addresses */
+        if (sscanf(line, "%255s %ld %lld %255s", host, &port, &expiry, addrs) != 4) {
+            continue;
+        }
+        entry = dnsSlot(host, port);
+        snprintf(entry->addrs, sizeof(entry->addrs), "%s", addrs);
+        entry->expiry = (time_t)expiry;
+    }
+    fclose(fp);
+    COMMONUTILITIES_INFO("%s: %d hosts loaded from %s\n", __FUNCTION__, entry_count, cache_file);
+}
+
+/* dnsSave(): Write cache file, replaced at once so a reader never sees a partial file.
+ * Called with lock held */
+static void dnsSave(void) {
+    FILE *fp;
+    char tmp[DNS_HOST_MAX_LEN + 8];
+    int i;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", cache_file);
+    fp = fopen(tmp, "w");
+    if (fp == NULL) {
+        COMMONUTILITIES_ERROR("%s: unable to write %s\n", __FUNCTION__, tmp);
+        return;
+    }
+    for (i = 0; i < entry_count; i++) {
+        if (entries[i].addrs[0] != '\0') {
+            fprintf(fp, "%s %ld %lld %s\n", entries[i].host, entries[i].port,
+                    (long long)entries[i].expiry, entries[i].addrs);
+        }
+    }
+    if (fclose(fp) != 0 || rename(tmp, cache_file) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to replace %s\n", __FUNCTION__, cache_file);
+        remove(tmp);
+    }
+}
+
+/* dnsResolve(): Resolve host into curl resolve format
+ * Return : int : No of addresses, 0 on failure
+ * */
+static int dnsResolve(const char *host, char *addrs, size_t len) {
+    struct addrinfo hints;
+    struct addrinfo *res = NULL;
+    struct addrinfo *ai;
+    char ip[INET6_ADDRSTRLEN];
+    char item[INET6_ADDRSTRLEN + 3];
+    const void *sa;
+    int count = 0;
+    size_t used = 0;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, NULL, &hints, &res) != 0) {
+        return 0;
+    }
+    addrs[0] = '\0';
+    for (ai = res; ai != NULL && count < DNS_CACHE_MAX_ADDRS; ai = ai->ai_next) {
+        if (ai->ai_family == AF_INET) {
+            sa = &((struct sockaddr_in *)ai->ai_addr)->sin_addr;
+        } else if (ai->ai_family == AF_INET6) {
+            sa = &((struct sockaddr_in6 *)ai->ai_addr)->sin6_addr;
+        } else {
+            continue;
+        }
+        if (inet_ntop(ai->ai_family, sa, ip, sizeof(ip)) == NULL) {
+            continue;
+        }
+        snprintf(item, sizeof(item), (ai->ai_family == AF_INET6) ? "[%s]" : "%s", ip);
+        if (strstr(addrs, item) != NULL || used + strlen(item) + 2 > len) {
+            continue;
+        }
+        used += snprintf(addrs + used, len - used, "%s%s", (count > 0) ? "," : "", item);
+        count++;
+    }
+    freeaddrinfo(res);
+    return count;
+}
+
+static void *dnsRefreshThread(void *arg) {
+    DnsRefreshTask_t *task = arg;
+
+    dnsCacheRefresh(task->host, task->port);
+    free(task);
+    return NULL;
+}
+
+/* dnsRefreshLater(): Start background resolution of entry unless one is running. Called with lock held */
+static void dnsRefreshLater(DnsEntry_t *entry) {
+    DnsRefreshTask_t *task;
+    pthread_t tid;
+    pthread_attr_t attr;
+
+    if (entry->refreshing) {
+        return;
+    }
+    task = malloc(sizeof(DnsRefreshTask_t));
+    if (task == NULL) {
+        return;
+    }
+    snprintf(task->host, sizeof(task->host), "%s", entry->host);
+    task->port = entry->port;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&tid, &attr, dnsRefreshThread, task) == 0) {
+        entry->refreshing = true;
+    } else {
+        free(task);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+/* dnsUrlHost(): Get host and port of url, IP address hosts are not cached
+ * Return : int : 0 on success, -1 when url has no cacheable host
+ * */
+#if LIBCURL_VERSION_NUM >= 0x073e00
+static int dnsUrlHost(const char *url, char *host, size_t len, long *port) {
+    CURLU *h;
+    char *part = NULL;
+    struct in_addr addr4;
+    int ret = -1;
+
+    h = curl_url();
+    if (h == NULL) {
+        return -1;
+    }
+    if (curl_url_set(h, CURLUPART_URL, url, 0) == CURLUE_OK
+        && curl_url_get(h, CURLUPART_HOST, &part, 0) == CURLUE_OK) {
+        if (part[0] != '[' && inet_pton(AF_INET, part, &addr4) != 1 && strlen(part) < len) {
+            snprintf(host, len, "%s", part);
+            ret = 0;
+        }
+        curl_free(part);
+        part = NULL;
+    }
+    if (ret == 0 && curl_url_get(h, CURLUPART_PORT, &part, CURLU_DEFAULT_PORT) == CURLUE_OK) {
+        *port = strtol(part, NULL, 10);
+        curl_free(part);
+    } else {
+        ret = -1;
+    }
+    curl_url_cleanup(h);
+    return ret;
+}
+#else
+/* URL API exists since curl 7.62.0, older versions resolve every transfer */
+static int dnsUrlHost(const char *url, char *host, size_t len, long *port) {
+    (void)url;
+    (void)host;
+    (void)len;
+    (void)port;
+    return -1;
+}
+#endif
+
+/* dnsBind(): Keep resolve list of handle, the previous list of the handle is freed.
+ * Called with lock held
+ * Return : int : 0 on success, -1 when DNS_MAX_BOUND handles already hold a list
+ * */
+static int dnsBind(CURL *curl, struct curl_slist *list, const char *host, long port) {
+    int i;
+    int slot = -1;
+
+    for (i = 0; i < DNS_MAX_BOUND; i++) {
+        if (bound[i].handle == curl) {
+            curl_slist_free_all(bound[i].list);
+            slot = i;
+            break;
+        }
+        if (bound[i].handle == NULL && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        return -1;
+    }
+    bound[slot].handle = curl;
+    bound[slot].list = list;
+    snprintf(bound[slot].host, sizeof(bound[slot].host), "%s", host);
+    bound[slot].port = port;
+    return 0;
+}
+
+int dnsCacheConfigure(const char *path, unsigned int ttl_sec) {
+    if (path != NULL && (path[0] == '\0' || strlen(path) >= sizeof(cache_file))) {
+        COMMONUTILITIES_ERROR("%s: invalid cache file\n", __FUNCTION__);
+        return -1;
+    }
+    pthread_mutex_lock(&cache_lock);
+    snprintf(cache_file, sizeof(cache_file), "%s", (path != NULL) ? path : "");
+    cache_ttl = (ttl_sec > 0) ? ttl_sec : DNS_CACHE_TTL_SEC;
+    cache_loaded = false;
+    entry_count = 0;
+    pthread_mutex_unlock(&cache_lock);
+    return 0;
+}
+
+int dnsCacheApply(CURL *curl, const char *url) {
+    char host[DNS_HOST_MAX_LEN];
+    char item[DNS_HOST_MAX_LEN + DNS_ADDRS_MAX_LEN + 32];
+    long port = 0;
+    DnsEntry_t *entry;
+    struct curl_slist *list = NULL;
+    time_t now;
+    int ret = 0;
+
+    if (curl == NULL || url == NULL || dnsUrlHost(url, host, sizeof(host), &port) != 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&cache_lock);
+    if (cache_file[0] == '\0') {
+        pthread_mutex_unlock(&cache_lock);
+        return 0;
+    }
+    dnsLoad();
+    now = time(NULL);
+    entry = dnsSlot(host, port);
+    if (entry->purge) {
+        /* Remove pinned addresses from the shared curl DNS cache */
+        snprintf(item, sizeof(item), "-%s:%ld", host, port);
+        list = curl_slist_append(NULL, item);
+    } else if (entry->addrs[0] != '\0' && entry->expiry > now) {
+        snprintf(item, sizeof(item), DNS_RESOLVE_FORMAT, host, port, entry->addrs);
+        list = curl_slist_append(NULL, item);
+        ret = 1;
+    }
+    if (entry->addrs[0] == '\0' || entry->expiry - now < DNS_CACHE_REFRESH_SEC) {
+        dnsRefreshLater(entry);
+    }
+    if (list != NULL && dnsBind(curl, list, host, port) != 0) {
+        COMMONUTILITIES_ERROR("%s: %d handles hold cached addresses, %s is resolved by curl\n", __FUNCTION__, DNS_MAX_BOUND, host);
+        curl_slist_free_all(list);
+        list = NULL;
+        ret = 0;
+    }
+    if (list != NULL) {
+        if (curl_easy_setopt(curl, CURLOPT_RESOLVE, list) == CURLE_OK) {
+            entry->purge = false;
+            COMMONUTILITIES_DEBUG("%s: %s\n", __FUNCTION__, item);
+        } else {
+            ret = 0;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return ret;
+}
+
+/* dnsPinFailure(): Check if a curl code can be caused by a wrong cached address */
+static bool dnsPinFailure(CURLcode curl_code) {
+    switch (curl_code) {
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_PEER_FAILED_VERIFICATION:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int dnsCacheDone(CURL *curl, CURLcode curl_code) {
+    char item[DNS_HOST_MAX_LEN + 32];
+    struct curl_slist *list;
+    long http_code = 0;
+    int i;
+    int index;
+    int ret = 0;
+
+    if (curl == NULL || !dnsPinFailure(curl_code)) {
+        return 0;
+    }
+    pthread_mutex_lock(&cache_lock);
+    for (i = 0; i < DNS_MAX_BOUND; i++) {
+        if (bound[i].handle == curl) {
+            index = dnsFind(bound[i].host, bound[i].port);
+            if (index < 0 || entries[index].addrs[0] == '\0') {
+                break;
+            }
+            COMMONUTILITIES_INFO("%s: cached addresses of %s failed, dropped\n", __FUNCTION__, bound[i].host);
+            entries[index].addrs[0] = '\0';
+            entries[index].expiry = 0;
+            entries[index].purge = true;
+            dnsSave();
+            /* Without a response nothing reached the caller, the same handle can try again */
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+            if (http_code != 0) {
+                break;
+            }
+            snprintf(item, sizeof(item), "-%s:%ld", bound[i].host, bound[i].port);
+            list = curl_slist_append(NULL, item);
+            if (list != NULL && curl_easy_setopt(curl, CURLOPT_RESOLVE, list) == CURLE_OK) {
+                curl_slist_free_all(bound[i].list);
+                bound[i].list = list;
+                entries[index].purge = false;
+                ret = 1;
+            } else {
+                curl_slist_free_all(list);
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return ret;
+}
+
+void dnsCacheRelease(CURL *curl) {
+    int i;
+
+    if (curl == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&cache_lock);
+    for (i = 0; i < DNS_MAX_BOUND; i++) {
+        if (bound[i].handle == curl) {
+            curl_slist_free_all(bound[i].list);
+            memset(&bound[i], 0, sizeof(DnsBound_t));
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+int dnsCacheRefresh(const char *host, long port) {
+    char addrs[DNS_ADDRS_MAX_LEN];
+    DnsEntry_t *entry;
+    int count = 0;
+
+    if (host == NULL || host[0] == '\0' || strlen(host) >= DNS_HOST_MAX_LEN) {
+        return -1;
+    }
+    /* Resolution is done without lock, it can take seconds */
+    count = dnsResolve(host, addrs, sizeof(addrs));
+    pthread_mutex_lock(&cache_lock);
+    if (cache_file[0] != '\0') {
+        dnsLoad();
+        entry = dnsSlot(host, port);
+        entry->refreshing = false;
+        if (count > 0) {
+            /* Addresses pinned before the failure are replaced by the new ones, no purge needed */
+            snprintf(entry->addrs, sizeof(entry->addrs), "%s", addrs);
+            entry->expiry = time(NULL) + cache_ttl;
+            entry->purge = false;
+            dnsSave();
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+    if (count == 0) {
+        COMMONUTILITIES_INFO("%s: unable to resolve %s\n", __FUNCTION__, host);
+        return -1;
+    }
+    COMMONUTILITIES_DEBUG("%s: %s:%ld=%s\n", __FUNCTION__, host, port, addrs);
+    return 0;
+}
+
+int dnsCacheLookup(const char *host, long port, char *addrs, size_t len) {
+    int index;
+    int ret = -1;
+
+    if (host == NULL || addrs == NULL || len == 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&cache_lock);
+    if (cache_file[0] != '\0') {
+        dnsLoad();
+        index = dnsFind(host, port);
+        if (index >= 0 && entries[index].addrs[0] != '\0' && entries[index].expiry > time(NULL)) {
+            snprintf(addrs, len, "%s", entries[index].addrs);
+            ret = 0;
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return ret;
+}
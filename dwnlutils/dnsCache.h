@@ -0,0 +1,86 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_DNSCACHE_H_
+#define  _RDK_DNSCACHE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <curl/curl.h>
+
+#ifndef DNS_CACHE_FILE //This is to provide an option Define custom persistent DNS cache file using DFLAGS
+#define DNS_CACHE_FILE "/opt/.dwnlutil_dns_cache"
+#endif
+
+#ifndef DNS_CACHE_TTL_SEC //This is to provide an option Define custom lifetime of a resolved address using DFLAGS
+#define DNS_CACHE_TTL_SEC 3600
+#endif
+
+#ifndef DNS_CACHE_REFRESH_SEC //This is to provide an option Define custom remaining lifetime starting a background refresh using DFLAGS
+#define DNS_CACHE_REFRESH_SEC 300
+#endif
+
+#ifndef DNS_CACHE_MAX_HOSTS //This is to provide an option Define custom count of cached hosts using DFLAGS
+#define DNS_CACHE_MAX_HOSTS 32
+#endif
+
+#define DNS_CACHE_MAX_ADDRS 4
+#define DNS_HOST_MAX_LEN 256
+#define DNS_ADDRS_MAX_LEN 256
+
+/* Persistent cache of resolved addresses of hosts the device talked to.
+ * Fresh addresses are given to curl with CURLOPT_RESOLVE so the transfer does not wait for DNS,
+ * they are refreshed in the background before they expire. Expired and failed addresses are
+ * not used, curl then resolves the host itself */
+
+/* dnsCacheConfigure(): Set cache file and address lifetime, the file is loaded at next use
+ * path : cache file, NULL to disable the cache
+ * ttl_sec : lifetime of a resolved address, 0 for DNS_CACHE_TTL_SEC
+ * Return : int : 0 on success, -1 on invalid parameter
+ * */
+int dnsCacheConfigure(const char *path, unsigned int ttl_sec);
+
+/* dnsCacheApply(): Set CURLOPT_RESOLVE for host of url when fresh addresses are cached.
+ *                  Hosts missing or about to expire are resolved in the background for next time
+ * curl : curl handle, the resolve list is kept until dnsCacheRelease
+ * url : request url
+ * Return : int : 1 when cached addresses are used, 0 when curl resolves itself
+ * */
+int dnsCacheApply(CURL *curl, const char *url);
+
+/* dnsCacheDone(): Report transfer result of handle. Addresses which failed with a connect, timeout
+ *                 or TLS handshake error are dropped so the next transfer falls back to normal resolution.
+ *                 When the transfer got no response the handle is set to resolve the host itself
+ * Return : int : 1 when the transfer should be performed once more on the same handle, 0 otherwise
+ * */
+int dnsCacheDone(CURL *curl, CURLcode curl_code);
+
+/* dnsCacheRelease(): Free resolve list of handle, called before the handle is reset or freed */
+void dnsCacheRelease(CURL *curl);
+
+/* dnsCacheRefresh(): Resolve host now and store its addresses
+ * Return : int : 0 on success, -1 when host could not be resolved
+ * */
+int dnsCacheRefresh(const char *host, long port);
+
+/* dnsCacheLookup(): Copy fresh cached addresses of host, comma separated
+ * Return : int : 0 when found, -1 when not cached or expired
+ * */
+int dnsCacheLookup(const char *host, long port, char *addrs, size_t len);
+
+#endif
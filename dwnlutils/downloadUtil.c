@@ -17,6 +17,10 @@
  */
 
 #include "downloadUtil.h"
+#include "retryPolicy.h"
+#include "bandwidthGovernor.h"
+#include "cancelToken.h"
+#include "transferStats.h"
 #include "rdkv_cdl_log_wrapper.h"
 
 /* doCurlInit(): ininitialize curl resources
@@ -47,7 +51,9 @@ void doStopDownload(void *curl)
         urlHelperDestroyCurl(curl_dest);
     }
 }
-/* doInteruptDwnl(): Stop the download and start again
+/* doInteruptDwnl(): Change speed of a running download.
+ *                   A download started with bwData has its governor rate changed at once, without pause.
+ *                   Other downloads are paused, CURLOPT_MAX_RECV_SPEED_LARGE is set and download is continued.
  * param : in_curl: curl instance
  * param :max_dwnl_speed : Speed value. 0 means full speed
  * return :int
@@ -59,6 +65,10 @@ int doInteruptDwnl(void *in_curl, unsigned int max_dwnl_speed)
 
     if (in_curl != NULL) {
         curl = (CURL *)in_curl;
+        if (bwGovernorSetHandleRate(curl, max_dwnl_speed, 0) == 0) {
+            COMMONUTILITIES_INFO("%s : governor rate set:%u\n", __FUNCTION__, max_dwnl_speed);
+            return ret_code;
+        }
         if (max_dwnl_speed > 0) {
             ret_code = curl_easy_pause(curl, CURLPAUSE_ALL);
     	    if(ret_code != CURLE_OK) {
@@ -236,6 +246,24 @@ int getJsonRpcData(void *in_curl, FileDwnl_t *pfile_dwnl, char *jsonrpc_auth_tok
     }
     return (int)curl_status;
 }
+/* downloadStop(): Retry wait stop on the cancel token given as arg and on setForceStop */
+static int downloadStop(void *arg)
+{
+    return (getForceStop() == 1 || cancelTokenIsCancelled((CancelToken_t *)arg));
+}
+
+/* hasDownloadModes(): Check if any optional file download mode of opts is requested
+ * Return : bool : true when urlHelperDownloadFileEx is needed
+ * */
+static bool hasDownloadModes(DwnlOptions_t *opts)
+{
+    return (opts != NULL && (opts->segmentData != NULL || opts->writeBehind != NULL || opts->digestData != NULL
+            || opts->journalData != NULL || opts->headerData != NULL || opts->retryData != NULL
+            || opts->bwData != NULL || opts->cancel != NULL
+            || opts->cacheData != NULL || opts->deltaData != NULL
+            || opts->preallocData != NULL || opts->extractData != NULL));
+}
+
 /* doHttpFileDownload(): Use for http download with out mtls
  * in_curl : curl pointer which is return type from curl_init call.
  * pfile_dwnl : Structure pointer contains post fields, url, download path, chunkdownload retry, sslverify status 
@@ -246,11 +274,29 @@ int getJsonRpcData(void *in_curl, FileDwnl_t *pfile_dwnl, char *jsonrpc_auth_tok
  * Return :curl_ret_status : Send back curl status
  * */
 int doHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, MtlsAuth_t *auth, unsigned int max_dwnl_speed, char *dnl_start_pos, int *out_httpCode )
+{
+    return doHttpFileDownloadEx(in_curl, pfile_dwnl, NULL, auth, max_dwnl_speed, dnl_start_pos, out_httpCode);
+}
+
+/* doHttpFileDownloadEx(): Same as doHttpFileDownload with the optional download modes of opts
+ * opts : Optional download modes, NULL for none. It is only read, the modes are applied on a copy
+ * Other parameters are same as doHttpFileDownload
+ * Return :curl_ret_status : Send back curl status
+ * */
+int doHttpFileDownloadEx(void *in_curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, MtlsAuth_t *auth, unsigned int max_dwnl_speed,
+                         char *dnl_start_pos, int *out_httpCode )
 {
     CURL *curl;
     CURLcode ret_code = CURLE_OK;
     size_t byte_dwnled = 0;
     CURLcode curl_status = -1;
+    bool retry_owner;
+    bool stats_owner;
+    int attempts;
+    int retry_delay;
+    unsigned long long attempt_start;
+    DwnlOptions_t dwnl_opts;
+    bwParam_t bw_speed;
 #ifdef CURL_DEBUG
     DbgData_t verbosinfo;
     memset(&verbosinfo, '\0', sizeof(DbgData_t));
@@ -269,6 +315,10 @@ int doHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, MtlsAuth_t *auth,
         }
     }
     curl = (CURL *)in_curl;
+    memset(&dwnl_opts, 0, sizeof(dwnl_opts));
+    if (opts != NULL) {
+        dwnl_opts = *opts;
+    }
 
     ret_code = setCommonCurlOpt(curl, pfile_dwnl->url, pfile_dwnl->pPostFields, pfile_dwnl->sslverify);
     if(ret_code != CURLE_OK) {
@@ -307,7 +357,13 @@ int doHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, MtlsAuth_t *auth,
         }
     }
 
-    if (max_dwnl_speed > 0) {
+    if (max_dwnl_speed > 0 && dwnl_opts.bwData != NULL) {
+        /* Governor enforce the speed in the write path, doInteruptDwnl can change it later.
+         * The rate is set on a copy, bwData of the caller is not changed */
+        bw_speed = *dwnl_opts.bwData;
+        bw_speed.rate = max_dwnl_speed;
+        dwnl_opts.bwData = &bw_speed;
+    } else if (max_dwnl_speed > 0) {
     	ret_code = setThrottleMode(curl, (curl_off_t) max_dwnl_speed);
     	if(ret_code != CURLE_OK) {
             COMMONUTILITIES_ERROR("%s : CURL: setThrottleMode Failed\n", __FUNCTION__);
@@ -324,13 +380,49 @@ int doHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, MtlsAuth_t *auth,
         COMMONUTILITIES_INFO("%s : CURL: Set Verbos Success\n", __FUNCTION__);
     }
 #endif
-    if( *pfile_dwnl->pathname )
-    {
-        byte_dwnled = urlHelperDownloadFile(curl, pfile_dwnl->pathname, dnl_start_pos, pfile_dwnl->chunk_dwnl_retry_time, out_httpCode, &curl_status);
+    /* Throttled download is not split, the speed limit is per connection */
+    if (max_dwnl_speed > 0) {
+        dwnl_opts.segmentData = NULL;
+    }
+    retry_owner = retryBegin(dwnl_opts.retryData);
+    stats_owner = transferStatsBegin(curl, dwnl_opts.statsData, dwnl_opts.retryData);
+    while (1) {
+        attempts = (dwnl_opts.retryData != NULL) ? dwnl_opts.retryData->attempts : 0;
+        attempt_start = retryNowMs();
+        if( *pfile_dwnl->pathname )
+        {
+            if (hasDownloadModes(&dwnl_opts)) {
+                byte_dwnled = urlHelperDownloadFileEx(curl, pfile_dwnl, &dwnl_opts, dnl_start_pos, out_httpCode, &curl_status);
+            } else {
+                byte_dwnled = urlHelperDownloadFile(curl, pfile_dwnl->pathname, dnl_start_pos, pfile_dwnl->chunk_dwnl_retry_time, out_httpCode, &curl_status);
+            }
+        }
+        else
+        {
+            if (opts != NULL) {
+                byte_dwnled = urlHelperDownloadToMemEx(curl, pfile_dwnl, &dwnl_opts, out_httpCode, &curl_status);
+            } else {
+                byte_dwnled = urlHelperDownloadToMem(curl, pfile_dwnl, out_httpCode, &curl_status);
+            }
+        }
+        /* Chunk download apply the policy itself, attempts are already recorded */
+        if (dwnl_opts.retryData == NULL || dwnl_opts.retryData->attempts != attempts) {
+            break;
+        }
+        if (cancelTokenIsCancelled(dwnl_opts.cancel)) {
+            COMMONUTILITIES_INFO("%s : download cancelled, no retry\n", __FUNCTION__);
+            break;
+        }
+        retry_delay = retryNext(dwnl_opts.retryData, curl_status, *out_httpCode, (unsigned int)(retryNowMs() - attempt_start));
+        if (retry_delay < 0 || retryWait((unsigned int)retry_delay, downloadStop, dwnl_opts.cancel) != 0) {
+            break;
+        }
     }
-    else
-    {
-        byte_dwnled = urlHelperDownloadToMem(curl, pfile_dwnl, out_httpCode, &curl_status);
+    if (retry_owner) {
+        retryEnd(dwnl_opts.retryData);
+    }
+    if (stats_owner) {
+        transferStatsEnd(curl);
     }
     COMMONUTILITIES_INFO("%s : After curl operation no of bytes Downloaded=%zu and curl ret status=%d and http code=%d\n", __FUNCTION__, byte_dwnled, curl_status, *out_httpCode);
 
@@ -350,6 +442,15 @@ int doHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, MtlsAuth_t *auth,
  * Return :curl_ret_status : Send back curl status
  * */
 int doAuthHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, int *out_httpCode ){
+    return doAuthHttpFileDownloadEx(in_curl, pfile_dwnl, NULL, out_httpCode);
+}
+
+/* doAuthHttpFileDownloadEx(): Same as doAuthHttpFileDownload with the optional download modes of opts
+ * opts : Optional download modes, NULL for none
+ * Other parameters are same as doAuthHttpFileDownload
+ * Return :curl_ret_status : Send back curl status
+ * */
+int doAuthHttpFileDownloadEx(void *in_curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *out_httpCode ){
     CURL *curl;
     CURLcode ret_code = CURLE_OK;
     struct curl_slist *slist = NULL;
@@ -393,11 +494,19 @@ int doAuthHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, int *out_httpC
 #endif
     if( *pfile_dwnl->pathname )
     {
-        byte_dwnled = urlHelperDownloadFile(curl, pfile_dwnl->pathname, NULL, 0, out_httpCode, &curl_status);
+        if (hasDownloadModes(opts)) {
+            byte_dwnled = urlHelperDownloadFileEx(curl, pfile_dwnl, opts, NULL, out_httpCode, &curl_status);
+        } else {
+            byte_dwnled = urlHelperDownloadFile(curl, pfile_dwnl->pathname, NULL, 0, out_httpCode, &curl_status);
+        }
     }
     else
     {
-        byte_dwnled = urlHelperDownloadToMem(curl, pfile_dwnl, out_httpCode, &curl_status);
+        if (opts != NULL) {
+            byte_dwnled = urlHelperDownloadToMemEx(curl, pfile_dwnl, opts, out_httpCode, &curl_status);
+        } else {
+            byte_dwnled = urlHelperDownloadToMem(curl, pfile_dwnl, out_httpCode, &curl_status);
+        }
     }
     COMMONUTILITIES_INFO("%s : After curl operation no of bytes Downloaded=%zu and curl ret status=%d and http code=%d\n", __FUNCTION__, byte_dwnled, curl_status, *out_httpCode);
     if( slist != NULL ) {
@@ -33,6 +33,20 @@
 
 int doHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, MtlsAuth_t *auth, unsigned int max_dwnl_speed, char *dnl_start_pos, int *out_httpCode );
 int doAuthHttpFileDownload(void *in_curl, FileDwnl_t *pfile_dwnl, int *out_httpCode);
+
+/* doHttpFileDownloadEx(): Same as doHttpFileDownload with the optional download modes of opts
+ * opts : Optional download modes (see DwnlOptions_t), NULL for none. With max_dwnl_speed bwData
+ *        takes the speed and segmentData is not used
+ * Return :curl_ret_status : Send back curl status
+ * */
+int doHttpFileDownloadEx(void *in_curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, MtlsAuth_t *auth, unsigned int max_dwnl_speed,
+                         char *dnl_start_pos, int *out_httpCode );
+
+/* doAuthHttpFileDownloadEx(): Same as doAuthHttpFileDownload with the optional download modes of opts
+ * opts : Optional download modes (see DwnlOptions_t), NULL for none
+ * Return :curl_ret_status : Send back curl status
+ * */
+int doAuthHttpFileDownloadEx(void *in_curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *out_httpCode);
 void *doCurlInit(void);
 void doStopDownload(void *curl);
 int doInteruptDwnl(void *in_curl, unsigned int max_dwnl_speed);
@@ -0,0 +1,371 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define _GNU_SOURCE  // Required for FTW_PHYS
+#include "extractDownload.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "curlPool.h"
+#include "cancelToken.h"
+#include "transferStats.h"
+
+/* extractStop(): Stop check of the download, its token or setForceStop */
+static int extractStop(ExtractFetch_t *fetch) {
+    return (getForceStop() == 1 || cancelTokenIsCancelled(fetch->cancel));
+}
+
+static int extractRemoveEntry(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+static int extractRemoveChild(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    return (ftw->level == 0) ? 0 : extractRemoveEntry(path, st, flag, ftw);
+}
+
+/* extractRemoveTree(): Remove a staging directory and what it holds, links are not followed
+ * keep_top : true to only empty the directory
+ * */
+static int extractRemoveTree(const char *path, bool keep_top) {
+    if (nftw(path, keep_top ? extractRemoveChild : extractRemoveEntry, 16, FTW_DEPTH | FTW_PHYS) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to remove %s errno=%d\n", __FUNCTION__, path, errno);
+        return -1;
+    }
+    return 0;
+}
+
+/* extractMove(): Move the members of staging directory src into dst. Directories present in both
+ * are merged, any other member replaces the one at dst by rename so a link there is never followed
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int extractMove(const char *src, const char *dst) {
+    char from[PATH_MAX];
+    char to[PATH_MAX];
+    struct stat sst;
+    struct stat dst_st;
+    struct dirent *entry;
+    DIR *dir;
+    int ret = 0;
+
+    dir = opendir(src);
+    if (dir == NULL) {
+        COMMONUTILITIES_ERROR("%s: unable to open %s errno=%d\n", __FUNCTION__, src, errno);
+        return -1;
+    }
+    while (ret == 0 && (entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        if ((size_t)snprintf(from, sizeof(from), "%s/%s", src, entry->d_name) >= sizeof(from)
+            || (size_t)snprintf(to, sizeof(to), "%s/%s", dst, entry->d_name) >= sizeof(to)
+            || lstat(from, &sst) != 0) {
+            ret = -1;
+        } else if (S_ISDIR(sst.st_mode) && lstat(to, &dst_st) == 0 && S_ISDIR(dst_st.st_mode)) {
+            ret = extractMove(from, to);
+        } else if (rename(from, to) != 0) {
+            COMMONUTILITIES_ERROR("%s: unable to move %s to %s errno=%d\n", __FUNCTION__, from, to, errno);
+            ret = -1;
+        }
+    }
+    closedir(dir);
+    return ret;
+}
+
+/* extractVerify(): Check the archive digest against the expected one
+ * Return : int : 0 when it matches or no check is requested, -1 otherwise
+ * */
+static int extractVerify(const extractParam_t *extract, const digestParam_t *digest) {
+    if (extract->expected_digest == NULL) {
+        return 0;
+    }
+    if (digest == NULL || digest->digest_len == 0 || strcasecmp(extract->expected_digest, digest->digest_hex) != 0) {
+        COMMONUTILITIES_ERROR("%s: archive digest %s does not match %s\n", __FUNCTION__,
+                              (digest != NULL && digest->digest_len > 0) ? digest->digest_hex : "none", extract->expected_digest);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * This is Call back function for archive responses. It keeps the first byte of a range
+ * response and dumps the header like urlHelperDownloadFile.
+ * */
+static size_t extract_header_cb(char *buffer, size_t size, size_t nitems, void *userdata) {
+    ExtractFetch_t *fetch = (ExtractFetch_t *)userdata;
+    size_t len = size * nitems;
+    char value[64];
+    long long first;
+
+    if (fetch->headerfile != NULL) {
+        fwrite(buffer, size, nitems, fetch->headerfile);
+    }
+    /* New status line means redirect was followed, only the final response is used */
+    if (len > 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+        fetch->range_start = -1;
+    } else if (len > 14 && len - 14 < sizeof(value) && strncasecmp(buffer, "Content-Range:", 14) == 0) {
+        memcpy(value, buffer + 14, len - 14);
+        value[len - 14] = '\0';
+        if (sscanf(value, " bytes %lld-", &first) == 1 && first >= 0) {
+            fetch->range_start = first;
+        }
+    }
+    return len;
+}
+
+/* extractResponse(): Check the response on its first body data. A 206 must continue at the
+ * received length, a 200 answer to a range request restarts the extraction from the start.
+ * The body of other responses is not an archive and is dropped
+ * Return : int : 0 on success, -1 when the response can not be used
+ * */
+static int extractResponse(ExtractFetch_t *fetch) {
+    long http_code = 0;
+
+    fetch->checked = true;
+    curl_easy_getinfo(fetch->curl, CURLINFO_RESPONSE_CODE, &http_code);
+    if (http_code == 206) {
+        if (fetch->range_start != fetch->received) {
+            COMMONUTILITIES_ERROR("%s: range starts at %lld, expected %lld\n", __FUNCTION__, fetch->range_start, fetch->received);
+            return -1;
+        }
+        fetch->feeding = true;
+        return 0;
+    }
+    if (http_code != 200) {
+        COMMONUTILITIES_INFO("%s: http code %ld, body is not the archive\n", __FUNCTION__, http_code);
+        return 0;
+    }
+    if (fetch->received > 0) {
+        COMMONUTILITIES_INFO("%s: range ignored, extract %s again from start\n", __FUNCTION__, fetch->out_path);
+        tarStreamDestroy(fetch->ts);
+        /* Members of the first response may not be in the new one */
+        extractRemoveTree(fetch->out_path, true);
+        fetch->ts = tarStreamCreate(fetch->out_path);
+        fetch->received = 0;
+        if (fetch->digest != NULL) {
+            streamDigestDestroy(fetch->digest);
+            fetch->digest = streamDigestCreate(fetch->digest_type);
+        }
+        if (fetch->ts == NULL) {
+            return -1;
+        }
+    }
+    fetch->feeding = true;
+    return 0;
+}
+
+/*
+ * This is Call back function for archive data. Data goes through the inflater and tar parser
+ * straight to the extracted files, nothing is stored for the archive itself.
+ * */
+static size_t extract_write(void *ptr, size_t size, size_t nmemb, void *userdata) {
+    ExtractFetch_t *fetch = (ExtractFetch_t *)userdata;
+    size_t len = size * nmemb;
+
+    if (extractStop(fetch)) {
+        COMMONUTILITIES_INFO("%s: Download cancelled\n", __FUNCTION__);
+        return 0;
+    }
+    if (!fetch->checked && extractResponse(fetch) != 0) {
+        fetch->failed = true;
+        return 0;
+    }
+    if (!fetch->feeding) {
+        return len;
+    }
+    if (tarStreamWrite(fetch->ts, ptr, len) != TAR_STREAM_OK) {
+        COMMONUTILITIES_ERROR("%s: archive not valid after %lld bytes\n", __FUNCTION__, fetch->received);
+        fetch->failed = true;
+        return 0;
+    }
+    if (fetch->digest != NULL) {
+        streamDigestUpdate(fetch->digest, ptr, len);
+    }
+    fetch->received += (long long)len;
+    return len;
+}
+
+int extractDownloadFile(CURL *curl, const char *file, extractParam_t *extract, digestParam_t *digest,
+                        struct cancelToken *cancel, size_t *bytes, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+    ExtractFetch_t fetch;
+    digestParam_t own_digest;
+    char staging[PATH_MAX];
+    char header_dump[128];
+    char range[32];
+    struct stat st;
+    size_t len;
+    long http_code = 0;
+    int retry = 0;
+
+    if (curl == NULL || file == NULL || extract == NULL || extract->out_path == NULL
+        || bytes == NULL || httpCode_ret_status == NULL || curl_ret_status == NULL) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return EXTRACT_DWNL_NOT_POSSIBLE;
+    }
+    *bytes = 0;
+    extract->entries = 0;
+    extract->extracted_bytes = 0;
+    extract->complete = false;
+    if (stat(extract->out_path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        COMMONUTILITIES_ERROR("%s: output directory %s not present\n", __FUNCTION__, extract->out_path);
+        return EXTRACT_DWNL_NOT_POSSIBLE;
+    }
+    /* Expected digest without a digest request is checked with the algorithm of its length */
+    if (digest == NULL && extract->expected_digest != NULL) {
+        memset(&own_digest, 0, sizeof(own_digest));
+        own_digest.type = (strlen(extract->expected_digest) == 32) ? DIGEST_MD5 : DIGEST_SHA256;
+        digest = &own_digest;
+    }
+    /* Staging directory next to out_path, on the same file system so members are renamed into place */
+    len = strlen(extract->out_path);
+    while (len > 1 && extract->out_path[len - 1] == '/') {
+        len--;
+    }
+    if ((size_t)snprintf(staging, sizeof(staging), "%.*s.XXXXXX", (int)len, extract->out_path) >= sizeof(staging)
+        || mkdtemp(staging) == NULL) {
+        COMMONUTILITIES_ERROR("%s: unable to create staging directory of %s errno=%d\n", __FUNCTION__, extract->out_path, errno);
+        return EXTRACT_DWNL_NOT_POSSIBLE;
+    }
+    memset(&fetch, 0, sizeof(fetch));
+    fetch.out_path = staging;
+    fetch.cancel = cancel;
+    fetch.range_start = -1;
+    fetch.ts = tarStreamCreate(staging);
+    if (fetch.ts == NULL) {
+        extractRemoveTree(staging, false);
+        return EXTRACT_DWNL_NOT_POSSIBLE;
+    }
+    fetch.curl = curl_easy_duphandle(curl);
+    if (fetch.curl == NULL) {
+        COMMONUTILITIES_ERROR("%s: curl_easy_duphandle failed\n", __FUNCTION__);
+        tarStreamDestroy(fetch.ts);
+        extractRemoveTree(staging, false);
+        return EXTRACT_DWNL_NOT_POSSIBLE;
+    }
+    transferStatsInherit(fetch.curl, curl);
+    if (digest != NULL) {
+        fetch.digest_type = digest->type;
+        fetch.digest = streamDigestCreate(digest->type);
+    }
+    curl_easy_setopt(fetch.curl, CURLOPT_SHARE, curlPoolGetShare());
+    curl_easy_setopt(fetch.curl, CURLOPT_HEADERFUNCTION, extract_header_cb);
+    curl_easy_setopt(fetch.curl, CURLOPT_HEADERDATA, &fetch);
+    curl_easy_setopt(fetch.curl, CURLOPT_NOPROGRESS, 1L);
+    curl_easy_setopt(fetch.curl, CURLOPT_WRITEFUNCTION, extract_write);
+    curl_easy_setopt(fetch.curl, CURLOPT_WRITEDATA, &fetch);
+    snprintf(header_dump, sizeof(header_dump), "%s.header", file);
+    fetch.headerfile = fopen(header_dump, "w");
+
+    COMMONUTILITIES_INFO("%s: Download and extract in %s\n", __FUNCTION__, staging);
+    while (1) {
+        fetch.checked = false;
+        fetch.feeding = false;
+        *curl_ret_status = curl_easy_perform(fetch.curl);
+        transferStatsCollect(fetch.curl, *curl_ret_status);
+        curl_easy_getinfo(fetch.curl, CURLINFO_RESPONSE_CODE, &http_code);
+        *httpCode_ret_status = (int)http_code;
+        if (fetch.headerfile != NULL) {
+            fclose(fetch.headerfile);
+            fetch.headerfile = NULL;
+        }
+        if (fetch.failed) {
+            *curl_ret_status = CURLE_WRITE_ERROR;
+            break;
+        }
+        if (*curl_ret_status != CURLE_OK && extractStop(&fetch)) {
+            *curl_ret_status = CURLE_ABORTED_BY_CALLBACK;
+            break;
+        }
+        /* Same errors as the chunk download, the stream continues from the received length */
+        if ((*curl_ret_status == CURLE_PARTIAL_FILE || *curl_ret_status == CURLE_OPERATION_TIMEDOUT
+             || *curl_ret_status == CURLE_RECV_ERROR) && retry < EXTRACT_DWNL_RETRY) {
+            retry++;
+            snprintf(range, sizeof(range), "%lld-", fetch.received);
+            COMMONUTILITIES_INFO("%s: curl error=%d, continue from %s\n", __FUNCTION__, *curl_ret_status, range);
+            curl_easy_setopt(fetch.curl, CURLOPT_RANGE, range);
+            continue;
+        }
+        break;
+    }
+    if (fetch.received > 0 || fetch.feeding) {
+        if (tarStreamFinish(fetch.ts, &extract->entries, &extract->extracted_bytes) == TAR_STREAM_OK) {
+            extract->complete = true;
+        } else if (*curl_ret_status == CURLE_OK) {
+            /* Transfer ended while the archive did not */
+            *curl_ret_status = CURLE_WRITE_ERROR;
+        }
+    }
+    if (digest != NULL) {
+        if (!extract->complete || *curl_ret_status != CURLE_OK || fetch.digest == NULL || streamDigestFinal(fetch.digest, digest) != 0) {
+            digest->digest_len = 0;
+            digest->digest_hex[0] = '\0';
+        }
+    }
+    /* Only a complete and verified archive reaches out_path */
+    if (extract->complete && *curl_ret_status == CURLE_OK) {
+        if (extractVerify(extract, digest) != 0 || extractMove(staging, extract->out_path) != 0) {
+            extract->complete = false;
+            *curl_ret_status = CURLE_WRITE_ERROR;
+        }
+    } else {
+        extract->complete = false;
+    }
+    extractRemoveTree(staging, false);
+    *bytes = (size_t)fetch.received;
+    COMMONUTILITIES_INFO("%s: Download Operation Done. received:%lld entries:%lld extracted:%lld curl code=%d http code=%d\n", __FUNCTION__,
+                         fetch.received, extract->entries, extract->extracted_bytes, *curl_ret_status, *httpCode_ret_status);
+    streamDigestDestroy(fetch.digest);
+    transferStatsEnd(fetch.curl);
+    curlPoolRelease(fetch.curl);
+    tarStreamDestroy(fetch.ts);
+    return EXTRACT_DWNL_DONE;
+}
+
+#ifdef GTEST_ENABLE
+size_t (*getextract_write(void)) (void *ptr, size_t size, size_t nmemb, void *userdata) {
+    return &extract_write;
+}
+
+size_t (*getextract_header_cb(void)) (char *buffer, size_t size, size_t nitems, void *userdata) {
+    return &extract_header_cb;
+}
+
+int (*getextractMove(void)) (const char *src, const char *dst) {
+    return &extractMove;
+}
+
+int (*getextractRemoveTree(void)) (const char *path, bool keep_top) {
+    return &extractRemoveTree;
+}
+
+int (*getextractVerify(void)) (const extractParam_t *extract, const digestParam_t *digest) {
+    return &extractVerify;
+}
+#endif
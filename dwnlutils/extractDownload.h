@@ -0,0 +1,71 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_EXTRACTDOWNLOAD_H_
+#define  _RDK_EXTRACTDOWNLOAD_H_
+
+#include "urlHelper.h"
+#include "streamDigest.h"
+#include "tarStream.h"
+
+#define EXTRACT_DWNL_DONE           0   /* extraction ran, result is in the out parameters */
+#define EXTRACT_DWNL_NOT_POSSIBLE   1   /* output directory not usable, nothing was requested */
+
+#ifndef EXTRACT_DWNL_RETRY //This is to provide an option Define custom count of resumed requests using DFLAGS
+#define EXTRACT_DWNL_RETRY 2
+#endif
+
+/* Below structure describe the state of a streamed archive download. A retry continues with a
+ * range request from the received length, the inflater and tar parser keep their state across it */
+typedef struct extractFetch {
+    CURL *curl;
+    TarStream_t *ts;
+    const char *out_path;
+    StreamDigest_t *digest;         /* digest of the archive bytes, NULL if not requested */
+    digestType_t digest_type;
+    long long received;             /* archive bytes given to the tar stream */
+    long long range_start;          /* first byte of a 206 response, -1 when not given */
+    bool checked;                   /* http status checked for current response */
+    bool feeding;                   /* current response is the archive */
+    bool failed;                    /* archive refused by the tar stream */
+    FILE *headerfile;               /* header dump, NULL if not required */
+    struct cancelToken *cancel;     /* cancellation of the download, NULL if not requested */
+} ExtractFetch_t;
+
+/* extractDownloadFile(): Download a tar or tar.gz archive and extract it while it is received into
+ *                        a staging directory <out_path>.XXXXXX. The archive is not stored, file is
+ *                        only used for the <file>.header dump same as urlHelperDownloadFile. An
+ *                        interrupted transfer is continued with a range request from the received
+ *                        length. Members are moved into extract->out_path only when the archive is
+ *                        complete and matches extract->expected_digest, the staging directory is
+ *                        removed in every case so a failed download leaves out_path as it was.
+ * curl : Curl object with url and security options already set. It is duplicated for the requests
+ * file : path the archive would be stored at
+ * extract : output directory, totals are sent back in it
+ * digest : digest of the archive bytes, NULL if not requested
+ * cancel : cancellation token of the download, NULL for setForceStop only
+ * bytes : Send back archive bytes received
+ * httpCode_ret_status : Send back http status.
+ * curl_ret_status : Send back curl status, CURLE_WRITE_ERROR when the archive is not valid,
+ *                   does not match the expected digest or can not be moved to out_path
+ * Return : EXTRACT_DWNL_DONE or EXTRACT_DWNL_NOT_POSSIBLE
+ * */
+int extractDownloadFile(CURL *curl, const char *file, extractParam_t *extract, digestParam_t *digest,
+                        struct cancelToken *cancel, size_t *bytes, int *httpCode_ret_status, CURLcode *curl_ret_status);
+
+#endif
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "headerMap.h"
+
+#include <strings.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+/* One header, name and value are NULL terminated strings inside buf */
+typedef struct headerEntry {
+    uint32_t hash;
+    uint32_t name_off;
+    uint32_t name_len;          /* 0 for empty slot */
+    uint32_t value_off;
+} HeaderEntry_t;
+
+struct headerMap {
+    int status;
+    unsigned int count;
+    unsigned int slots;         /* power of two */
+    HeaderEntry_t *entry;
+    char *buf;
+    size_t buf_used;
+    size_t buf_size;
+};
+
+/* headerHash(): FNV-1a of the lower case name */
+static uint32_t headerHash(const char *name, size_t len) {
+    uint32_t hash = 2166136261U;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= (uint32_t)tolower((unsigned char)name[i]);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/* headerFind(): Get slot of name, or the empty slot where it belongs */
+static HeaderEntry_t *headerFind(const HeaderMap_t *map, const char *name, size_t len, uint32_t hash) {
+    unsigned int mask = map->slots - 1;
+    unsigned int i = hash & mask;
+    HeaderEntry_t *e;
+
+    for (;;) {
+        e = &map->entry[i];
+        if (e->name_len == 0) {
+            return e;
+        }
+        if (e->hash == hash && e->name_len == len && strncasecmp(map->buf + e->name_off, name, len) == 0) {
+            return e;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+static int headerGrow(HeaderMap_t *map) {
+    HeaderEntry_t *old = map->entry;
+    unsigned int old_slots = map->slots;
+    HeaderEntry_t *e;
+    unsigned int i;
+
+    map->entry = (HeaderEntry_t *)calloc(old_slots * 2, sizeof(HeaderEntry_t));
+    if (map->entry == NULL) {
+        map->entry = old;
+        return -1;
+    }
+    map->slots = old_slots * 2;
+    for (i = 0; i < old_slots; i++) {
+        if (old[i].name_len != 0) {
+            e = headerFind(map, map->buf + old[i].name_off, old[i].name_len, old[i].hash);
+            *e = old[i];
+        }
+    }
+    free(old);
+    return 0;
+}
+
+/* headerReserve(): Make room for extra bytes in buf
+ * Return : int : 0 on success, -1 if no memory
+ * */
+static int headerReserve(HeaderMap_t *map, size_t extra) {
+    size_t need = map->buf_used + extra;
+    size_t newsize = map->buf_size;
+    char *ptr;
+
+    if (need > UINT32_MAX) {
+        return -1;
+    }
+    if (need > map->buf_size) {
+        while (newsize < need) {
+            newsize *= 2;
+        }
+        ptr = (char *)realloc(map->buf, newsize);
+        if (ptr == NULL) {
+            return -1;
+        }
+        map->buf = ptr;
+        map->buf_size = newsize;
+    }
+    return 0;
+}
+
+/* headerAppend(): Copy to buf, room must be reserved
+ * Return : uint32_t : offset of the copy
+ * */
+static uint32_t headerAppend(HeaderMap_t *map, const char *s, size_t len, bool terminate) {
+    uint32_t off = (uint32_t)map->buf_used;
+
+    memcpy(map->buf + map->buf_used, s, len);
+    map->buf_used += len;
+    if (terminate) {
+        map->buf[map->buf_used++] = '\0';
+    }
+    return off;
+}
+
+HeaderMap_t *headerMapCreate(void) {
+    HeaderMap_t *map = (HeaderMap_t *)calloc(1, sizeof(HeaderMap_t));
+
+    if (map == NULL) {
+        COMMONUTILITIES_ERROR("%s: calloc failed\n", __FUNCTION__);
+        return NULL;
+    }
+    map->slots = HEADER_MAP_SLOTS;
+    map->entry = (HeaderEntry_t *)calloc(map->slots, sizeof(HeaderEntry_t));
+    map->buf_size = HEADER_MAP_BUF_SIZE;
+    map->buf = (char *)malloc(map->buf_size);
+    if (map->entry == NULL || map->buf == NULL) {
+        COMMONUTILITIES_ERROR("%s: malloc failed\n", __FUNCTION__);
+        headerMapDestroy(map);
+        return NULL;
+    }
+    return map;
+}
+
+void headerMapDestroy(HeaderMap_t *map) {
+    if (map != NULL) {
+        free(map->entry);
+        free(map->buf);
+        free(map);
+    }
+}
+
+void headerMapClear(HeaderMap_t *map) {
+    if (map != NULL) {
+        memset(map->entry, 0, map->slots * sizeof(HeaderEntry_t));
+        map->count = 0;
+        map->buf_used = 0;
+        map->status = 0;
+    }
+}
+
+int headerMapAddLine(HeaderMap_t *map, const char *line, size_t len) {
+    const char *colon;
+    const char *value;
+    HeaderEntry_t *e;
+    size_t name_len;
+    size_t value_len;
+    size_t old_len;
+    uint32_t hash;
+    uint32_t value_off;
+
+    if (map == NULL || line == NULL) {
+        return -1;
+    }
+    while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == '\n')) {
+        len--;
+    }
+    if (len > 5 && strncmp(line, "HTTP/", 5) == 0) {
+        headerMapClear(map);
+        value = memchr(line, ' ', len);
+        map->status = (value != NULL) ? atoi(value + 1) : 0;
+        return 0;
+    }
+    colon = memchr(line, ':', len);
+    if (colon == NULL || colon == line) {
+        return (len == 0) ? 0 : -1;
+    }
+    name_len = colon - line;
+    value = colon + 1;
+    value_len = len - name_len - 1;
+    while (value_len > 0 && (*value == ' ' || *value == '\t')) {
+        value++;
+        value_len--;
+    }
+    while (value_len > 0 && (value[value_len - 1] == ' ' || value[value_len - 1] == '\t')) {
+        value_len--;
+    }
+    hash = headerHash(line, name_len);
+    e = headerFind(map, line, name_len, hash);
+    if (e->name_len != 0) {
+        /* Repeated header, combine the values */
+        old_len = strlen(map->buf + e->value_off);
+        if (headerReserve(map, old_len + 2 + value_len + 1) != 0) {
+            COMMONUTILITIES_ERROR("%s: no memory for header\n", __FUNCTION__);
+            return -1;
+        }
+        value_off = headerAppend(map, map->buf + e->value_off, old_len, false);
+        headerAppend(map, ", ", 2, false);
+        headerAppend(map, value, value_len, true);
+        e->value_off = value_off;
+        return 0;
+    }
+    if ((map->count + 1) * 2 > map->slots) {
+        if (headerGrow(map) != 0) {
+            return -1;
+        }
+        e = headerFind(map, line, name_len, hash);
+    }
+    if (headerReserve(map, name_len + 1 + value_len + 1) != 0) {
+        COMMONUTILITIES_ERROR("%s: no memory for header\n", __FUNCTION__);
+        return -1;
+    }
+    e->hash = hash;
+    e->name_len = (uint32_t)name_len;
+    e->name_off = headerAppend(map, line, name_len, true);
+    e->value_off = headerAppend(map, value, value_len, true);
+    map->count++;
+    return 0;
+}
+
+const char *headerMapGet(const HeaderMap_t *map, const char *name) {
+    const HeaderEntry_t *e;
+    size_t len;
+
+    if (map == NULL || name == NULL) {
+        return NULL;
+    }
+    len = strlen(name);
+    e = headerFind(map, name, len, headerHash(name, len));
+    return (e->name_len != 0) ? map->buf + e->value_off : NULL;
+}
+
+int headerMapStatus(const HeaderMap_t *map) {
+    return (map != NULL) ? map->status : 0;
+}
+
+curl_off_t headerMapContentLength(const HeaderMap_t *map) {
+    const char *value = headerMapGet(map, "Content-Length");
+    char *end = NULL;
+    long long length;
+
+    if (value == NULL || !isdigit((unsigned char)*value)) {
+        return -1;
+    }
+    length = strtoll(value, &end, 10);
+    return (end != NULL && *end == '\0') ? (curl_off_t)length : -1;
+}
+
+size_t headerMapCurlCB(char *buffer, size_t size, size_t nitems, void *userdata) {
+    if (buffer != NULL) {
+        headerMapAddLine((HeaderMap_t *)userdata, buffer, size * nitems);
+    }
+    return size * nitems;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_HEADERMAP_H_
+#define  _RDK_HEADERMAP_H_
+
+#include "urlHelper.h"
+
+#define HEADER_MAP_SLOTS 32
+#define HEADER_MAP_BUF_SIZE 1024
+
+/* Response headers of a transfer kept in memory. Names are case insensitive.
+ * A new status line (redirect, 100 Continue) clear the map so it hold the final response only */
+typedef struct headerMap HeaderMap_t;
+
+/* headerMapCreate(): Create an empty header map
+ * Return : HeaderMap_t * : map, NULL on failure
+ * */
+HeaderMap_t *headerMapCreate(void);
+
+/* headerMapDestroy(): Free the map. NULL is allowed */
+void headerMapDestroy(HeaderMap_t *map);
+
+/* headerMapClear(): Remove all headers and status of the map */
+void headerMapClear(HeaderMap_t *map);
+
+/* headerMapAddLine(): Add one header line as received from server
+ * line : "Name: value\r\n" or status line "HTTP/1.1 200 OK\r\n", not NULL terminated
+ * Repeated names are combined as "value1, value2"
+ * Return : int : 0 on success, -1 on invalid line or no memory
+ * */
+int headerMapAddLine(HeaderMap_t *map, const char *line, size_t len);
+
+/* headerMapGet(): Get the value of a header
+ * name : header name, any case
+ * Return : const char * : value, NULL if not present. Valid till next headerMapAddLine or headerMapClear
+ * */
+const char *headerMapGet(const HeaderMap_t *map, const char *name);
+
+/* headerMapStatus(): Get http status of the response, 0 if no status line seen */
+int headerMapStatus(const HeaderMap_t *map);
+
+/* headerMapContentLength(): Get Content-Length of the response
+ * Return : curl_off_t : length, -1 if not present or invalid
+ * */
+curl_off_t headerMapContentLength(const HeaderMap_t *map);
+
+/* headerMapCurlCB(): CURLOPT_HEADERFUNCTION callback, CURLOPT_HEADERDATA is the HeaderMap_t */
+size_t headerMapCurlCB(char *buffer, size_t size, size_t nitems, void *userdata);
+
+#endif
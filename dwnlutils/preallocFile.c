@@ -0,0 +1,97 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define _GNU_SOURCE  // Required for fallocate
+#include "preallocFile.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "system_utils.h"
+
+#define PREALLOC_MB (1024LL * 1024)
+
+/* preallocDir(): Directory of file for getFreeSpace, which only accepts absolute paths
+ * Return : int : 0 on success, -1 when file is not an absolute path
+ * */
+static int preallocDir(const char *file, char *dir, size_t len) {
+    const char *slash = strrchr(file, '/');
+
+    if (file[0] != '/' || slash == NULL || (size_t)(slash - file) + 2 > len) {
+        return -1;
+    }
+    if (slash == file) {
+        snprintf(dir, len, "/");
+    } else {
+        snprintf(dir, len, "%.*s", (int)(slash - file), file);
+    }
+    return 0;
+}
+
+int preallocFile(int fd, const char *file, long long offset, long long length, preallocParam_t *prealloc) {
+    char dir[PREALLOC_PATH_LEN];
+    unsigned int free_mb;
+    long long need_mb;
+
+    if (fd < 0 || file == NULL || prealloc == NULL || offset < 0) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return PREALLOC_NOT_DONE;
+    }
+    prealloc->reserved = 0;
+    prealloc->no_space = false;
+    if (length <= 0) {
+        COMMONUTILITIES_INFO("%s: Content-Length not known, %s not preallocated\n", __FUNCTION__, file);
+        return PREALLOC_NOT_DONE;
+    }
+    need_mb = (length + PREALLOC_MB - 1) / PREALLOC_MB;
+    if (preallocDir(file, dir, sizeof(dir)) == 0) {
+        free_mb = getFreeSpace(dir);
+        if ((long long)free_mb < need_mb) {
+            COMMONUTILITIES_ERROR("%s: %s needs %lld MB, %u MB free\n", __FUNCTION__, file, need_mb, free_mb);
+            prealloc->no_space = true;
+            return PREALLOC_NO_SPACE;
+        }
+    }
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)length) != 0) {
+        if (errno == ENOSPC) {
+            COMMONUTILITIES_ERROR("%s: no space for %lld bytes of %s\n", __FUNCTION__, length, file);
+            prealloc->no_space = true;
+            return PREALLOC_NO_SPACE;
+        }
+        /* e.g. EOPNOTSUPP on file systems without fallocate, the free space check above still applies */
+        COMMONUTILITIES_INFO("%s: fallocate not possible for %s errno=%d\n", __FUNCTION__, file, errno);
+        return PREALLOC_NOT_DONE;
+    }
+    prealloc->reserved = length;
+    COMMONUTILITIES_INFO("%s: %lld bytes reserved at %lld for %s\n", __FUNCTION__, length, offset, file);
+    return PREALLOC_DONE;
+}
+
+void preallocRelease(int fd) {
+    struct stat st;
+
+    /* Truncate to the current size drops the blocks reserved past it */
+    if (fd >= 0 && fstat(fd, &st) == 0 && ftruncate(fd, st.st_size) != 0) {
+        COMMONUTILITIES_ERROR("%s: ftruncate failed errno=%d\n", __FUNCTION__, errno);
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_PREALLOCFILE_H_
+#define  _RDK_PREALLOCFILE_H_
+
+#include "urlHelper.h"
+
+#define PREALLOC_DONE           0   /* space of the file is reserved */
+#define PREALLOC_NOT_DONE       1   /* size unknown or file system can not reserve, download continues as before */
+#define PREALLOC_NO_SPACE      -1   /* not enough free space, download must not start */
+
+#define PREALLOC_PATH_LEN 256
+
+/* preallocFile(): Check that length bytes from offset fit in the free space of the file system of file
+ *                 (getFreeSpace) and reserve them for fd in one contiguous request. Blocks are reserved
+ *                 without changing the file size so an interrupted download leaves only the received data
+ * fd : open download file
+ * file : path of the download file, its directory is checked for free space
+ * offset : file offset of the first byte still to be received
+ * length : bytes still to be received, 0 or less when not known
+ * prealloc : reserved bytes and no_space are sent back in it
+ * Return : PREALLOC_DONE, PREALLOC_NOT_DONE or PREALLOC_NO_SPACE
+ * */
+int preallocFile(int fd, const char *file, long long offset, long long length, preallocParam_t *prealloc);
+
+/* preallocRelease(): Give back reserved blocks past the end of file, used when a download did not complete */
+void preallocRelease(int fd);
+
+#endif
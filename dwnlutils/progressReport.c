@@ -0,0 +1,188 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "progressReport.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sched.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+#define PROGRESS_READ_RETRY 100
+
+struct progressPublisher {
+    int fd;
+    ProgressRecord_t *rec;
+    unsigned long long start_ms;
+    unsigned long long last_ms;
+    uint64_t last_dlnow;
+};
+
+/* recordWriteBegin(): Make seq odd, readers retry till recordWriteEnd */
+static void recordWriteBegin(ProgressRecord_t *rec) {
+    __atomic_fetch_add(&rec->seq, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void recordWriteEnd(ProgressRecord_t *rec) {
+    __atomic_fetch_add(&rec->seq, 1, __ATOMIC_RELEASE);
+}
+
+ProgressPublisher_t *progressOpen(const char *path) {
+    ProgressPublisher_t *pub = NULL;
+    void *map;
+    int fd;
+
+    if (path == NULL) {
+        return NULL;
+    }
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        COMMONUTILITIES_ERROR("%s: unable to open %s\n", __FUNCTION__, path);
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(ProgressRecord_t)) != 0) {
+        COMMONUTILITIES_ERROR("%s: ftruncate failed for %s\n", __FUNCTION__, path);
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, sizeof(ProgressRecord_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        COMMONUTILITIES_ERROR("%s: mmap failed for %s\n", __FUNCTION__, path);
+        close(fd);
+        return NULL;
+    }
+    pub = (ProgressPublisher_t *)calloc(1, sizeof(ProgressPublisher_t));
+    if (pub == NULL) {
+        munmap(map, sizeof(ProgressRecord_t));
+        close(fd);
+        return NULL;
+    }
+    pub->fd = fd;
+    pub->rec = (ProgressRecord_t *)map;
+    pub->start_ms = pub->last_ms = 0;
+
+    recordWriteBegin(pub->rec);
+    pub->rec->magic = PROGRESS_MAGIC;
+    pub->rec->version = PROGRESS_VERSION;
+    pub->rec->state = PROGRESS_RUNNING;
+    pub->rec->dlnow = 0;
+    pub->rec->dltotal = 0;
+    pub->rec->rate_now = 0;
+    pub->rec->rate_avg = 0;
+    pub->rec->eta_sec = -1;
+    pub->rec->elapsed_ms = 0;
+    recordWriteEnd(pub->rec);
+    return pub;
+}
+
+void progressPublish(ProgressPublisher_t *pub, curl_off_t dlnow, curl_off_t dltotal, unsigned long long now_ms) {
+    ProgressRecord_t *rec;
+    uint64_t now_bytes = (dlnow > 0) ? (uint64_t)dlnow : 0;
+    uint64_t total = (dltotal > 0) ? (uint64_t)dltotal : 0;
+    unsigned long long elapsed;
+
+    if (pub == NULL) {
+        return;
+    }
+    rec = pub->rec;
+    if (pub->start_ms == 0) {
+        pub->start_ms = pub->last_ms = now_ms;
+    }
+    elapsed = now_ms - pub->start_ms;
+
+    recordWriteBegin(rec);
+    if (now_ms > pub->last_ms && now_bytes >= pub->last_dlnow) {
+        rec->rate_now = (now_bytes - pub->last_dlnow) * 1000ULL / (now_ms - pub->last_ms);
+    }
+    rec->rate_avg = (elapsed > 0) ? now_bytes * 1000ULL / elapsed : 0;
+    if (total > 0 && now_bytes >= total) {
+        rec->eta_sec = 0;
+    } else if (total > 0 && rec->rate_avg > 0) {
+        rec->eta_sec = (int64_t)((total - now_bytes) / rec->rate_avg);
+    } else {
+        rec->eta_sec = -1;
+    }
+    rec->dlnow = now_bytes;
+    rec->dltotal = total;
+    rec->elapsed_ms = elapsed;
+    recordWriteEnd(rec);
+
+    pub->last_ms = now_ms;
+    pub->last_dlnow = now_bytes;
+}
+
+void progressClose(ProgressPublisher_t *pub) {
+    if (pub == NULL) {
+        return;
+    }
+    recordWriteBegin(pub->rec);
+    pub->rec->state = PROGRESS_DONE;
+    pub->rec->rate_now = 0;
+    recordWriteEnd(pub->rec);
+    munmap(pub->rec, sizeof(ProgressRecord_t));
+    close(pub->fd);
+    free(pub);
+}
+
+int progressRead(const char *path, ProgressRecord_t *out) {
+    ProgressRecord_t *rec;
+    struct stat st;
+    uint32_t seq1;
+    uint32_t seq2;
+    int ret = -1;
+    int i;
+    int fd;
+
+    if (path == NULL || out == NULL) {
+        return -1;
+    }
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ProgressRecord_t)) {
+        close(fd);
+        return -1;
+    }
+    rec = (ProgressRecord_t *)mmap(NULL, sizeof(ProgressRecord_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (rec == MAP_FAILED) {
+        return -1;
+    }
+    for (i = 0; i < PROGRESS_READ_RETRY; i++) {
+        seq1 = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+        if ((seq1 & 1) == 0) {
+            memcpy(out, rec, sizeof(ProgressRecord_t));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            seq2 = __atomic_load_n(&rec->seq, __ATOMIC_RELAXED);
+            if (seq1 == seq2) {
+                ret = 0;
+                break;
+            }
+        }
+        sched_yield();
+    }
+    munmap(rec, sizeof(ProgressRecord_t));
+    if (ret == 0 && (out->magic != PROGRESS_MAGIC || out->version != PROGRESS_VERSION)) {
+        ret = -1;
+    }
+    return ret;
+}
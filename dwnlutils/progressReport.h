@@ -0,0 +1,77 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_PROGRESSREPORT_H_
+#define  _RDK_PROGRESSREPORT_H_
+
+#include "urlHelper.h"
+
+#ifndef CURL_PROGRESS_RECORD //This is to provide an option Define custom progress record path using DFLAGS
+#define CURL_PROGRESS_RECORD "/tmp/curl_progress.bin"
+#endif
+
+#ifndef CURL_PROGRESS_INTERVAL_MS //This is to provide an option Define custom progress update interval using DFLAGS
+#define CURL_PROGRESS_INTERVAL_MS 1000
+#endif
+
+#define PROGRESS_MAGIC 0x474f5250U  /* "PROG" */
+#define PROGRESS_VERSION 1
+
+typedef enum {
+    PROGRESS_IDLE = 0,
+    PROGRESS_RUNNING,
+    PROGRESS_DONE
+} progressState_t;
+
+/* Fixed layout record shared through mmap. A writer makes seq odd while it update
+ * the record, readers copy the record and retry when seq was odd or changed. */
+typedef struct progressRecord {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;
+    uint32_t state;         /* progressState_t */
+    uint64_t dlnow;         /* bytes received by the current transfer */
+    uint64_t dltotal;       /* bytes expected by the current transfer, 0 if not known */
+    uint64_t rate_now;      /* bytes per second since previous update */
+    uint64_t rate_avg;      /* bytes per second since transfer start */
+    int64_t eta_sec;        /* seconds to completion, -1 if not known */
+    uint64_t elapsed_ms;    /* time since transfer start */
+} ProgressRecord_t;
+
+typedef struct progressPublisher ProgressPublisher_t;
+
+/* progressOpen(): Create or reuse the shared progress record and mark it running
+ * path : record file, normally CURL_PROGRESS_RECORD on tmpfs
+ * Return : ProgressPublisher_t * : publisher, NULL on failure
+ * */
+ProgressPublisher_t *progressOpen(const char *path);
+
+/* progressPublish(): Update the record. Callers limit the update rate
+ * now_ms : monotonic time of the update
+ * */
+void progressPublish(ProgressPublisher_t *pub, curl_off_t dlnow, curl_off_t dltotal, unsigned long long now_ms);
+
+/* progressClose(): Mark the record done and unmap it. NULL is allowed */
+void progressClose(ProgressPublisher_t *pub);
+
+/* progressRead(): Read a consistent copy of the record, used by other processes
+ * Return : int : 0 on success, -1 if record is not present or invalid
+ * */
+int progressRead(const char *path, ProgressRecord_t *out);
+
+#endif
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "resumeJournal.h"
+
+#include <sys/stat.h>
+#include <strings.h>
+#include <errno.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+/* journalPath(): Build journal path of a download file */
+static int journalPath(const char *file, char *path, size_t len) {
+    int ret = snprintf(path, len, "%s%s", file, JOURNAL_SUFFIX);
+    return (ret > 0 && (size_t)ret < len) ? 0 : -1;
+}
+
+/* copyValue(): Copy header value without leading spaces and trailing CR LF */
+static void copyValue(char *dst, size_t dst_len, const char *src, size_t len) {
+    while (len > 0 && (*src == ' ' || *src == '\t')) {
+        src++;
+        len--;
+    }
+    while (len > 0 && (src[len - 1] == '\r' || src[len - 1] == '\n' || src[len - 1] == ' ')) {
+        len--;
+    }
+    if (len >= dst_len) {
+        /* Truncated validator would never match, keep none */
+        len = 0;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+/* parseSize(): Read a byte count of a journal field or header value
+ * Return : long long : value, -1 when it is not a number or does not fit in long long
+ * */
+static long long parseSize(const char *val) {
+    char *end = NULL;
+    long long size;
+
+    errno = 0;
+    size = strtoll(val, &end, 10);
+    if (end == val || errno == ERANGE || size < 0 || (*end != '\0' && *end != '\r' && *end != '\n' && *end != ' ')) {
+        return -1;
+    }
+    return size;
+}
+
+void journalInit(ResumeJournal_t *jr, const char *url) {
+    if (jr == NULL) {
+        return;
+    }
+    memset(jr, 0, sizeof(ResumeJournal_t));
+    if (url != NULL) {
+        snprintf(jr->url, sizeof(jr->url), "%s", url);
+    }
+    jr->total_size = -1;
+}
+
+int journalLoad(const char *file, ResumeJournal_t *jr) {
+    char path[DWNL_PATH_FILE_LEN + 16];
+    char line[BIG_BUF_LEN + 16];
+    char *val;
+    FILE *fp;
+    int fields = 0;
+
+    if (file == NULL || jr == NULL || journalPath(file, path, sizeof(path)) != 0) {
+        return -1;
+    }
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+    journalInit(jr, NULL);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        val = strchr(line, '=');
+        if (val == NULL) {
+            continue;
+        }
+        *val++ = '\0';
+        if (strcmp(line, "url") == 0) {
+            copyValue(jr->url, sizeof(jr->url), val, strlen(val));
+            fields++;
+        } else if (strcmp(line, "etag") == 0) {
+            copyValue(jr->etag, sizeof(jr->etag), val, strlen(val));
+        } else if (strcmp(line, "last_modified") == 0) {
+            copyValue(jr->last_modified, sizeof(jr->last_modified), val, strlen(val));
+        } else if (strcmp(line, "total_size") == 0) {
+            jr->total_size = parseSize(val);
+        } else if (strcmp(line, "offset") == 0) {
+            /* A damaged offset fails the field count below */
+            jr->offset = parseSize(val);
+            fields += (jr->offset >= 0) ? 1 : 0;
+        }
+    }
+    fclose(fp);
+    if (fields != 2 || jr->offset < 0) {
+        COMMONUTILITIES_ERROR("%s: invalid journal %s\n", __FUNCTION__, path);
+        return -1;
+    }
+    return 0;
+}
+
+int journalSave(const char *file, const ResumeJournal_t *jr) {
+    char path[DWNL_PATH_FILE_LEN + 16];
+    char tmp_path[DWNL_PATH_FILE_LEN + 24];
+    FILE *fp;
+    int ret = 0;
+
+    if (file == NULL || jr == NULL || journalPath(file, path, sizeof(path)) != 0) {
+        return -1;
+    }
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    fp = fopen(tmp_path, "w");
+    if (fp == NULL) {
+        COMMONUTILITIES_ERROR("%s: unable to open %s\n", __FUNCTION__, tmp_path);
+        return -1;
+    }
+    if (fprintf(fp, "url=%s\netag=%s\nlast_modified=%s\ntotal_size=%lld\noffset=%lld\n",
+                jr->url, jr->etag, jr->last_modified, jr->total_size, jr->offset) < 0) {
+        ret = -1;
+    }
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0) {
+        ret = -1;
+    }
+    fclose(fp);
+    if (ret == 0 && rename(tmp_path, path) != 0) {
+        ret = -1;
+    }
+    if (ret != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to write %s\n", __FUNCTION__, path);
+        unlink(tmp_path);
+    }
+    return ret;
+}
+
+void journalRemove(const char *file) {
+    char path[DWNL_PATH_FILE_LEN + 16];
+
+    if (file != NULL && journalPath(file, path, sizeof(path)) == 0) {
+        unlink(path);
+    }
+}
+
+void journalParseHeader(ResumeJournal_t *jr, const char *line, size_t len, int http_code) {
+    const char *slash;
+
+    if (jr == NULL || line == NULL) {
+        return;
+    }
+    if (len > 5 && strncasecmp(line, "ETag:", 5) == 0) {
+        copyValue(jr->etag, sizeof(jr->etag), line + 5, len - 5);
+    } else if (len > 14 && strncasecmp(line, "Last-Modified:", 14) == 0) {
+        copyValue(jr->last_modified, sizeof(jr->last_modified), line + 14, len - 14);
+    } else if (len > 14 && strncasecmp(line, "Content-Range:", 14) == 0) {
+        /* bytes <start>-<end>/<total> */
+        slash = memchr(line, '/', len);
+        if (slash != NULL && slash[1] != '*') {
+            jr->total_size = parseSize(slash + 1);
+        }
+    } else if (http_code == 200 && len > 15 && strncasecmp(line, "Content-Length:", 15) == 0) {
+        jr->total_size = parseSize(line + 15);
+    }
+}
+
+const char *journalIfRange(const ResumeJournal_t *jr) {
+    if (jr == NULL) {
+        return NULL;
+    }
+    if (jr->etag[0] == '"') {
+        return jr->etag;
+    }
+    if (jr->last_modified[0] != '\0') {
+        return jr->last_modified;
+    }
+    return NULL;
+}
+
+long long journalResumeOffset(const char *file, const char *url, ResumeJournal_t *jr) {
+    struct stat st;
+
+    if (file == NULL || url == NULL || jr == NULL) {
+        return 0;
+    }
+    if (journalLoad(file, jr) != 0) {
+        return 0;
+    }
+    if (strcmp(jr->url, url) != 0) {
+        COMMONUTILITIES_INFO("%s: journal is for other url, full download\n", __FUNCTION__);
+        return 0;
+    }
+    if (journalIfRange(jr) == NULL) {
+        COMMONUTILITIES_INFO("%s: no strong validator in journal, full download\n", __FUNCTION__);
+        return 0;
+    }
+    if (stat(file, &st) != 0 || (long long)st.st_size < jr->offset) {
+        COMMONUTILITIES_INFO("%s: file shorter than journal offset, full download\n", __FUNCTION__);
+        return 0;
+    }
+    if (jr->offset <= 0 || (jr->total_size >= 0 && jr->offset >= jr->total_size)) {
+        return 0;
+    }
+    COMMONUTILITIES_INFO("%s: resume %s at %lld of %lld\n", __FUNCTION__, file, jr->offset, jr->total_size);
+    return jr->offset;
+}
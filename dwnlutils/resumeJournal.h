@@ -0,0 +1,80 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_RESUMEJOURNAL_H_
+#define  _RDK_RESUMEJOURNAL_H_
+
+#include "urlHelper.h"
+
+#ifndef JOURNAL_SYNC_BYTES //This is to provide an option Define custom journal update interval using DFLAGS
+#define JOURNAL_SYNC_BYTES (1024 * 1024)
+#endif
+
+#define JOURNAL_SUFFIX ".journal"
+#define JOURNAL_VALIDATOR_LEN MAX_BUFF_SIZE1
+
+/* Content of the sidecar journal <file>.journal.
+ * offset is the length of the file prefix which was flushed to disk while
+ * the remote object had the recorded validators. */
+typedef struct resumeJournal {
+    char url[BIG_BUF_LEN];
+    char etag[JOURNAL_VALIDATOR_LEN];           /* strong ETag, empty if not sent by server */
+    char last_modified[JOURNAL_VALIDATOR_LEN];  /* Last-Modified, empty if not sent by server */
+    long long total_size;                       /* full object size, -1 if not known */
+    long long offset;                           /* verified bytes present in the file */
+} ResumeJournal_t;
+
+/* journalInit(): Start a new journal record for url
+ * */
+void journalInit(ResumeJournal_t *jr, const char *url);
+
+/* journalLoad(): Read the journal of a download file
+ * file : download file path, journal is file + JOURNAL_SUFFIX
+ * Return : int : 0 on success, -1 if journal is not present or invalid
+ * */
+int journalLoad(const char *file, ResumeJournal_t *jr);
+
+/* journalSave(): Write the journal of a download file. Temporary file and rename are used
+ *                so that a crash leaves either the old or the new journal.
+ * Return : int : 0 on success, -1 on failure
+ * */
+int journalSave(const char *file, const ResumeJournal_t *jr);
+
+/* journalRemove(): Delete the journal of a download file. Missing journal is not an error */
+void journalRemove(const char *file);
+
+/* journalParseHeader(): Store validators and size from one response header line
+ * line : header line as given to CURLOPT_HEADERFUNCTION, not NUL terminated
+ * http_code : status of the response the header belongs to
+ * */
+void journalParseHeader(ResumeJournal_t *jr, const char *line, size_t len, int http_code);
+
+/* journalIfRange(): Validator to send in If-Range header. Weak ETag can not be used with If-Range
+ * Return : const char * : validator, NULL if the download can not be resumed safely
+ * */
+const char *journalIfRange(const ResumeJournal_t *jr);
+
+/* journalResumeOffset(): Check the journal against the request and the file on disk
+ * file : download file path
+ * url : url of the new request
+ * jr : filled with the journal content when resume is possible
+ * Return : long long : offset to resume from, 0 when a full download is needed
+ * */
+long long journalResumeOffset(const char *file, const char *url, ResumeJournal_t *jr);
+
+#endif
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "retryPolicy.h"
+
+#include <time.h>
+#include <pthread.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+/* Engine state of a policy between retryBegin and retryEnd */
+typedef struct retryState {
+    retryParam_t *rp;
+    unsigned long long start_ms;
+    unsigned int prev_delay_ms;
+    unsigned int seed;
+} RetryState_t;
+
+static pthread_mutex_t retry_lock = PTHREAD_MUTEX_INITIALIZER;
+static RetryState_t active[RETRY_MAX_ACTIVE];
+
+/* retryFind(): Slot of policy, -1 if not begun. Called with lock held */
+static int retryFind(const retryParam_t *rp) {
+    int i;
+
+    for (i = 0; i < RETRY_MAX_ACTIVE; i++) {
+        if (active[i].rp == rp) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+unsigned long long retryNowMs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000ULL + (unsigned long long)ts.tv_nsec / 1000000ULL;
+}
+
+bool retryNetworkError(CURLcode curl_code) {
+    switch (curl_code) {
+        case CURLE_COULDNT_CONNECT:
+        case CURLE_COULDNT_RESOLVE_HOST:
+        case CURLE_COULDNT_RESOLVE_PROXY:
+        case CURLE_BAD_DOWNLOAD_RESUME:
+        case CURLE_INTERFACE_FAILED:
+        case CURLE_GOT_NOTHING:
+        case CURLE_NO_CONNECTION_AVAILABLE:
+        case CURLE_OPERATION_TIMEDOUT:
+        case CURLE_PARTIAL_FILE:
+        case CURLE_READ_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_SEND_ERROR:
+        case CURLE_SEND_FAIL_REWIND:
+        case CURLE_SSL_CONNECT_ERROR:
+        case CURLE_UPLOAD_FAILED:
+        case CURLE_WRITE_ERROR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int retryClassify(CURLcode curl_code, int http_code) {
+    if (curl_code == CURLE_OK) {
+        switch (http_code) {
+            case 408:   /* Request Timeout */
+            case 425:   /* Too Early */
+            case 429:   /* Too Many Requests */
+                return RETRY_AGAIN;
+            case 501:   /* Not Implemented */
+            case 505:   /* HTTP Version Not Supported */
+                return RETRY_FATAL;
+            default:
+                break;
+        }
+        if (http_code >= 500) {
+            return RETRY_AGAIN;
+        }
+        return (http_code >= 400) ? RETRY_FATAL : RETRY_DONE;
+    }
+    switch (curl_code) {
+        /* Write error is a local disk problem or a force stop. Range errors
+         * need a full download, not the same request again */
+        case CURLE_WRITE_ERROR:
+        case CURLE_ABORTED_BY_CALLBACK:
+        case CURLE_BAD_DOWNLOAD_RESUME:
+        case CURLE_RANGE_ERROR:
+            return RETRY_FATAL;
+        case CURLE_HTTP2:
+        case CURLE_HTTP2_STREAM:
+            return RETRY_AGAIN;
+        default:
+            break;
+    }
+    return retryNetworkError(curl_code) ? RETRY_AGAIN : RETRY_FATAL;
+}
+
+bool retryBegin(retryParam_t *rp) {
+    unsigned long long now;
+    int i;
+
+    if (rp == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&retry_lock);
+    if (retryFind(rp) >= 0) {
+        pthread_mutex_unlock(&retry_lock);
+        return false;
+    }
+    i = retryFind(NULL);
+    if (i < 0) {
+        pthread_mutex_unlock(&retry_lock);
+        COMMONUTILITIES_ERROR("%s: more than %d retried transfers, no retry\n", __FUNCTION__, RETRY_MAX_ACTIVE);
+        return false;
+    }
+    now = retryNowMs();
+    active[i].rp = rp;
+    active[i].start_ms = now;
+    active[i].prev_delay_ms = 0;
+    /* Different on each device and process so that waits are not in lockstep */
+    active[i].seed = (unsigned int)now ^ ((unsigned int)getpid() << 16) ^ (unsigned int)(uintptr_t)rp;
+    pthread_mutex_unlock(&retry_lock);
+    rp->attempts = 0;
+    rp->elapsed_ms = 0;
+    memset(rp->attempt, 0, sizeof(rp->attempt));
+    return true;
+}
+
+void retryEnd(retryParam_t *rp) {
+    int i;
+
+    if (rp == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&retry_lock);
+    i = retryFind(rp);
+    if (i >= 0) {
+        rp->elapsed_ms = (unsigned int)(retryNowMs() - active[i].start_ms);
+        memset(&active[i], 0, sizeof(RetryState_t));
+    }
+    pthread_mutex_unlock(&retry_lock);
+}
+
+int retryNext(retryParam_t *rp, CURLcode curl_code, int http_code, unsigned int duration_ms) {
+    RetryState_t *state;
+    int idx;
+    int slot;
+    int cls;
+    int max_attempts;
+    int ret = -1;
+    unsigned int base;
+    unsigned int cap;
+    unsigned int prev;
+    unsigned int upper;
+    unsigned int delay;
+
+    if (rp == NULL) {
+        return -1;
+    }
+    idx = rp->attempts++;
+    if (idx < RETRY_MAX_RECORDS) {
+        rp->attempt[idx].curl_code = curl_code;
+        rp->attempt[idx].http_code = http_code;
+        rp->attempt[idx].duration_ms = duration_ms;
+        rp->attempt[idx].delay_ms = 0;
+    }
+    cls = (rp->classify != NULL) ? rp->classify(curl_code, http_code) : retryClassify(curl_code, http_code);
+    pthread_mutex_lock(&retry_lock);
+    /* No retry for a policy not begun, retryBegin already logged when it ran out of slots */
+    slot = retryFind(rp);
+    if (slot < 0) {
+        goto done;
+    }
+    state = &active[slot];
+    rp->elapsed_ms = (unsigned int)(retryNowMs() - state->start_ms);
+    if (cls != RETRY_AGAIN) {
+        goto done;
+    }
+    max_attempts = (rp->max_attempts > 0) ? rp->max_attempts : RETRY_MAX_ATTEMPTS;
+    if (rp->attempts >= max_attempts) {
+        COMMONUTILITIES_INFO("%s: no retry, %d attempts done\n", __FUNCTION__, rp->attempts);
+        goto done;
+    }
+    base = (rp->base_delay_ms > 0) ? rp->base_delay_ms : RETRY_BASE_DELAY_MS;
+    cap = (rp->max_delay_ms > 0) ? rp->max_delay_ms : RETRY_MAX_DELAY_MS;
+    if (cap < base) {
+        cap = base;
+    }
+    /* First wait is drawn from [base, 3 * base] too, devices failing together must not retry together */
+    prev = (state->prev_delay_ms > 0) ? state->prev_delay_ms : base;
+    upper = (prev > cap / 3) ? cap : prev * 3;
+    delay = base + (unsigned int)(rand_r(&state->seed) % (upper - base + 1));
+    if (rp->budget_ms > 0 && rp->elapsed_ms + delay >= rp->budget_ms) {
+        COMMONUTILITIES_INFO("%s: no retry, time budget %u ms used\n", __FUNCTION__, rp->budget_ms);
+        goto done;
+    }
+    state->prev_delay_ms = delay;
+    if (idx < RETRY_MAX_RECORDS) {
+        rp->attempt[idx].delay_ms = delay;
+    }
+    COMMONUTILITIES_INFO("%s: attempt %d curl=%d http=%d, retry after %u ms\n", __FUNCTION__, rp->attempts, curl_code, http_code, delay);
+    ret = (int)delay;
+done:
+    pthread_mutex_unlock(&retry_lock);
+    return ret;
+}
+
+int retryWait(unsigned int delay_ms, int (*stop)(void *arg), void *arg) {
+    unsigned long long end = retryNowMs() + delay_ms;
+    unsigned long long now;
+    unsigned long long wait;
+    struct timespec ts;
+
+    while (1) {
+        if (stop != NULL && stop(arg) != 0) {
+            COMMONUTILITIES_INFO("%s: retry wait stopped\n", __FUNCTION__);
+            return -1;
+        }
+        now = retryNowMs();
+        if (now >= end) {
+            return 0;
+        }
+        /* Sleep in slices so that cancel and force stop end the wait quickly */
+        wait = end - now;
+        if (wait > RETRY_WAIT_SLICE_MS) {
+            wait = RETRY_WAIT_SLICE_MS;
+        }
+        ts.tv_sec = wait / 1000;
+        ts.tv_nsec = (long)(wait % 1000) * 1000000L;
+        nanosleep(&ts, NULL);
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_RETRYPOLICY_H_
+#define  _RDK_RETRYPOLICY_H_
+
+#include "urlHelper.h"
+
+#ifndef RETRY_MAX_ATTEMPTS //This is to provide an option Define custom attempt count using DFLAGS
+#define RETRY_MAX_ATTEMPTS 3
+#endif
+
+#ifndef RETRY_BASE_DELAY_MS //This is to provide an option Define custom smallest wait using DFLAGS
+#define RETRY_BASE_DELAY_MS 1000
+#endif
+
+#ifndef RETRY_MAX_DELAY_MS //This is to provide an option Define custom largest wait using DFLAGS
+#define RETRY_MAX_DELAY_MS 60000
+#endif
+
+#ifndef RETRY_MAX_ACTIVE //This is to provide an option Define custom count of transfers retried at once using DFLAGS
+#define RETRY_MAX_ACTIVE 32
+#endif
+
+#ifndef RETRY_WAIT_SLICE_MS //This is to provide an option Define custom longest single sleep of a retry wait using DFLAGS
+#define RETRY_WAIT_SLICE_MS 50
+#endif
+
+/* Class of a transfer result */
+typedef enum {
+    RETRY_DONE = 0,     /* success, no retry */
+    RETRY_FATAL,        /* error which the same request can not fix */
+    RETRY_AGAIN         /* transient network or server error */
+} retryClass_t;
+
+/* retryNetworkError(): Check if a curl code report a network connectivity problem
+ * Return : bool : true for connect, resolve, timeout, send, receive and TLS handshake errors
+ * */
+bool retryNetworkError(CURLcode curl_code);
+
+/* retryClassify(): Default classifier. Network errors, 408, 425, 429 and 5xx except
+ *                  501 and 505 are retried. Local write errors, force stop and range errors are not.
+ * Return : int : retryClass_t value
+ * */
+int retryClassify(CURLcode curl_code, int http_code);
+
+/* retryBegin(): Start a retried transfer. Nested calls on an active policy do nothing
+ *               so that inner retry loops share the attempts and budget of the caller.
+ *               At most RETRY_MAX_ACTIVE policies are active at once, retryNext does not retry others.
+ * Return : bool : true when this call started the policy and must call retryEnd
+ * */
+bool retryBegin(retryParam_t *rp);
+
+/* retryEnd(): Finish a transfer started by retryBegin */
+void retryEnd(retryParam_t *rp);
+
+/* retryNext(): Record the result of an attempt and compute the wait before the next one.
+ *              Wait use decorrelated jitter: random between base and 3 times the previous
+ *              wait (base before the first retry), limited by max_delay_ms, so that devices do not retry in lockstep.
+ * duration_ms : time spent in the attempt
+ * Return : int : wait in milliseconds, -1 when no retry must be done
+ * */
+int retryNext(retryParam_t *rp, CURLcode curl_code, int http_code, unsigned int duration_ms);
+
+/* retryWait(): Sleep for a retry wait. The sleep is done in slices of RETRY_WAIT_SLICE_MS
+ * stop : called with arg between slices, a non zero value ends the wait, NULL if not required
+ * Return : int : 0 when the whole wait is done, -1 when stopped
+ * */
+int retryWait(unsigned int delay_ms, int (*stop)(void *arg), void *arg);
+
+/* retryNowMs(): Monotonic time in milliseconds, used to time attempts */
+unsigned long long retryNowMs(void);
+
+#endif
@@ -0,0 +1,419 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "segmentDownload.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "curlPool.h"
+#include "headerMap.h"
+#include "bandwidthGovernor.h"
+#include "cancelToken.h"
+#include "preallocFile.h"
+#include "transferStats.h"
+
+/* Below structure use for the header request done before splitting the file */
+typedef struct probeData {
+    FILE *headerfile;
+    bool accept_ranges;
+    HeaderMap_t *map;       /* response headers, NULL if not required */
+} ProbeData_t;
+
+/*
+ * This is Call back function for the header request. It dumps the header
+ * to file same as urlHelperDownloadFile and check range support.
+ * */
+static size_t probe_header_cb(char *buffer, size_t size, size_t nitems, void *userdata) {
+    ProbeData_t *probe = (ProbeData_t *)userdata;
+    size_t len = size * nitems;
+
+    if (probe == NULL || buffer == NULL) {
+        return len;
+    }
+    if (probe->headerfile != NULL) {
+        fwrite(buffer, size, nitems, probe->headerfile);
+    }
+    if (probe->map != NULL) {
+        headerMapAddLine(probe->map, buffer, len);
+    }
+    /* New status line means redirect was followed, only the final response is used */
+    if (len > 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+        probe->accept_ranges = false;
+    } else if (len > 14 && strncasecmp(buffer, "Accept-Ranges:", 14) == 0) {
+        if (strstr(buffer + 14, "bytes") != NULL) {
+            probe->accept_ranges = true;
+        }
+    }
+    return len;
+}
+
+/* probeContentLength(): Send header request and get total size of the file
+ * curl : Curl object with request options already set
+ * file : path of download file. Header is dump to <file>.header
+ * hdr : header map to fill, the dump is done only if dump_file is set. NULL to always dump
+ * accept_ranges : Send back true when server allow byte range request
+ * Return : curl_off_t : Content-Length, -1 if not available
+ * */
+static curl_off_t probeContentLength(CURL *curl, const char *file, headerParam_t *hdr, bool *accept_ranges) {
+    CURL *probe_curl = NULL;
+    CURLcode ret_code = CURLE_OK;
+    ProbeData_t probe;
+    char header_dump[128];
+    curl_off_t length = -1;
+    long http_code = 0;
+
+    *accept_ranges = false;
+    probe_curl = curl_easy_duphandle(curl);
+    if (probe_curl == NULL) {
+        COMMONUTILITIES_ERROR("%s: curl_easy_duphandle failed\n", __FUNCTION__);
+        return -1;
+    }
+    transferStatsInherit(probe_curl, curl);
+    memset(&probe, 0, sizeof(probe));
+    if (hdr != NULL) {
+        probe.map = hdr->map;
+        headerMapClear(probe.map);
+    }
+    if (hdr == NULL || hdr->dump_file) {
+        snprintf(header_dump, sizeof(header_dump), "%s.header", file);
+        COMMONUTILITIES_INFO("%s: Dump header info to file:%s\n", __FUNCTION__, header_dump);
+        probe.headerfile = fopen(header_dump, "w");
+        if (probe.headerfile == NULL) {
+            COMMONUTILITIES_ERROR("%s: path=%s file unable to open\n", __FUNCTION__, header_dump);
+        }
+    }
+    curl_easy_setopt(probe_curl, CURLOPT_SHARE, curlPoolGetShare());
+    curl_easy_setopt(probe_curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(probe_curl, CURLOPT_HEADERFUNCTION, probe_header_cb);
+    curl_easy_setopt(probe_curl, CURLOPT_HEADERDATA, &probe);
+    ret_code = curl_easy_perform(probe_curl);
+    transferStatsCollect(probe_curl, ret_code);
+    if (ret_code == CURLE_OK) {
+        curl_easy_getinfo(probe_curl, CURLINFO_RESPONSE_CODE, &http_code);
+        if (http_code == 200) {
+            curl_easy_getinfo(probe_curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+        }
+    }
+    COMMONUTILITIES_INFO("%s: curl code=%d http code=%ld length=%" CURL_FORMAT_CURL_OFF_T " accept ranges=%d\n",
+                         __FUNCTION__, ret_code, http_code, length, probe.accept_ranges);
+    *accept_ranges = probe.accept_ranges;
+    if (probe.headerfile != NULL) {
+        fclose(probe.headerfile);
+    }
+    transferStatsEnd(probe_curl);
+    curlPoolRelease(probe_curl);
+    return length;
+}
+
+/* segmentPlan(): Split total length into byte ranges
+ * length : total file size
+ * seg : requested segment count and minimum segment size
+ * segs : Array of at least SEGMENT_MAX_COUNT entries filled with the ranges
+ * Return : int : No of segments, less than 2 when splitting is not worth it
+ * */
+static int segmentPlan(curl_off_t length, segmentParam_t *seg, Segment_t *segs) {
+    curl_off_t min_size = SEGMENT_MIN_SIZE_DEFAULT;
+    curl_off_t seg_len = 0;
+    int count = seg->segments;
+    int i;
+
+    if (seg->min_segment_size > 0) {
+        min_size = (curl_off_t)seg->min_segment_size;
+    }
+    if (count > SEGMENT_MAX_COUNT) {
+        count = SEGMENT_MAX_COUNT;
+    }
+    if (length / min_size < count) {
+        count = (int)(length / min_size);
+    }
+    if (count < 2) {
+        return count;
+    }
+    seg_len = length / count;
+    for (i = 0; i < count; i++) {
+        memset(&segs[i], 0, sizeof(Segment_t));
+        segs[i].fd = -1;
+        segs[i].start = i * seg_len;
+        /* Last range take the remaining bytes */
+        segs[i].end = (i == count - 1) ? (length - 1) : (segs[i].start + seg_len - 1);
+    }
+    return count;
+}
+
+/*
+ * This is Call back function which is called continuesly at the
+ * time of data tranfer. This function write range data at its own offset
+ * */
+/* segmentStop(): Stop check of a segment, its download token or setForceStop */
+static int segmentStop(void *arg) {
+    Segment_t *seg = (Segment_t *)arg;
+
+    return (getForceStop() == 1 || cancelTokenIsCancelled(seg->cancel));
+}
+
+static size_t segment_write(void *ptr, size_t size, size_t nmemb, void *userdata) {
+    Segment_t *seg = (Segment_t *)userdata;
+    size_t len = size * nmemb;
+    size_t done = 0;
+    ssize_t ret = 0;
+    curl_off_t offset;
+
+    if (segmentStop(seg)) {
+        COMMONUTILITIES_INFO("segment_write Stopping Download\n");
+        return 0;
+    }
+    /* A server ignoring the range send the whole file with 200, that must not land at our offset */
+    if (seg->checked == false) {
+        curl_easy_getinfo(seg->curl, CURLINFO_RESPONSE_CODE, &seg->http_code);
+        if (seg->http_code != 206) {
+            COMMONUTILITIES_ERROR("segment_write: range request answered with http=%ld\n", seg->http_code);
+            seg->range_ignored = true;
+            return 0;
+        }
+        seg->checked = true;
+    }
+    /* Segments share the total bandwidth cap of the process */
+    if (bwGovernorConsume(NULL, len, segmentStop, seg) != 0) {
+        return 0;
+    }
+    offset = seg->start + seg->written;
+    if (offset + (curl_off_t)len > seg->end + 1) {
+        COMMONUTILITIES_ERROR("segment_write: received more data than requested range\n");
+        return 0;
+    }
+    while (done < len) {
+        ret = pwrite(seg->fd, (char *)ptr + done, len - done, offset + done);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            COMMONUTILITIES_ERROR("segment_write: pwrite failed errno=%d\n", errno);
+            break;
+        }
+        done += ret;
+    }
+    seg->written += done;
+    return done;
+}
+
+/* segmentStart(): Set range request for remaining bytes of a segment
+ * curl : Curl object used as template for the segment
+ * seg : segment to start or restart
+ * Return : CURLcode : CURLE_OK on success
+ * */
+static CURLcode segmentStart(CURL *curl, Segment_t *seg) {
+    CURLcode ret_code = CURLE_OK;
+    char range[64];
+
+    if (seg->curl == NULL) {
+        seg->curl = curl_easy_duphandle(curl);
+        if (seg->curl == NULL) {
+            COMMONUTILITIES_ERROR("%s: curl_easy_duphandle failed\n", __FUNCTION__);
+            return CURLE_OUT_OF_MEMORY;
+        }
+        transferStatsInherit(seg->curl, curl);
+        curl_easy_setopt(seg->curl, CURLOPT_SHARE, curlPoolGetShare());
+        curl_easy_setopt(seg->curl, CURLOPT_HEADERFUNCTION, NULL);
+        curl_easy_setopt(seg->curl, CURLOPT_HEADERDATA, NULL);
+        curl_easy_setopt(seg->curl, CURLOPT_NOPROGRESS, 1L);
+        curl_easy_setopt(seg->curl, CURLOPT_WRITEFUNCTION, segment_write);
+        curl_easy_setopt(seg->curl, CURLOPT_WRITEDATA, seg);
+    }
+    seg->checked = false;
+    snprintf(range, sizeof(range), "%" CURL_FORMAT_CURL_OFF_T "-%" CURL_FORMAT_CURL_OFF_T,
+             seg->start + seg->written, seg->end);
+    ret_code = curl_easy_setopt(seg->curl, CURLOPT_RANGE, range);
+    if (ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("%s: CURLOPT_RANGE failed msg:%s\n", __FUNCTION__, curl_easy_strerror(ret_code));
+    } else {
+        COMMONUTILITIES_INFO("%s: range %s\n", __FUNCTION__, range);
+    }
+    return ret_code;
+}
+
+int segmentedDownloadFile(CURL *curl, const char *file, segmentParam_t *seg, headerParam_t *hdr, struct cancelToken *cancel,
+                          preallocParam_t *prealloc, size_t *bytes, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+    Segment_t segs[SEGMENT_MAX_COUNT];
+    CURLM *multi = NULL;
+    CURLMsg *msg = NULL;
+    curl_off_t length = -1;
+    curl_off_t total = 0;
+    bool accept_ranges = false;
+    bool fallback = false;
+    bool cancelled = false;
+    int count = 0;
+    int pending = 0;
+    int running = 0;
+    int msgs_left = 0;
+    int max_retry = SEGMENT_RETRY_DEFAULT;
+    int fd = -1;
+    int i;
+
+    if (curl == NULL || file == NULL || seg == NULL || bytes == NULL || httpCode_ret_status == NULL || curl_ret_status == NULL) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return SEGMENT_DWNL_NOT_POSSIBLE;
+    }
+    *bytes = 0;
+    if (seg->segments < 2) {
+        return SEGMENT_DWNL_NOT_POSSIBLE;
+    }
+    if (seg->segment_retry > 0) {
+        max_retry = seg->segment_retry;
+    }
+    length = probeContentLength(curl, file, hdr, &accept_ranges);
+    if (length <= 0 || accept_ranges == false) {
+        COMMONUTILITIES_INFO("%s: Content-Length or range support not available\n", __FUNCTION__);
+        return SEGMENT_DWNL_NOT_POSSIBLE;
+    }
+    count = segmentPlan(length, seg, segs);
+    if (count < 2) {
+        COMMONUTILITIES_INFO("%s: file size %" CURL_FORMAT_CURL_OFF_T " too small to split\n", __FUNCTION__, length);
+        return SEGMENT_DWNL_NOT_POSSIBLE;
+    }
+    fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        COMMONUTILITIES_ERROR("%s: File open Fail:%s\n", __FUNCTION__, file);
+        return SEGMENT_DWNL_NOT_POSSIBLE;
+    }
+    /* Ranges land in one reserved extent instead of growing the file at several places */
+    if (prealloc != NULL && preallocFile(fd, file, 0, (long long)length, prealloc) == PREALLOC_NO_SPACE) {
+        close(fd);
+        *curl_ret_status = CURLE_WRITE_ERROR;
+        *httpCode_ret_status = 0;
+        return SEGMENT_DWNL_DONE;
+    }
+    multi = curl_multi_init();
+    if (multi == NULL) {
+        COMMONUTILITIES_ERROR("%s: curl_multi_init failed\n", __FUNCTION__);
+        close(fd);
+        return SEGMENT_DWNL_NOT_POSSIBLE;
+    }
+    /* In HTTP/2 mode segments run as streams of a single connection */
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    COMMONUTILITIES_INFO("%s: Download %" CURL_FORMAT_CURL_OFF_T " bytes in %d segments\n", __FUNCTION__, length, count);
+    for (i = 0; i < count; i++) {
+        segs[i].fd = fd;
+        segs[i].cancel = cancel;
+        if (segmentStart(curl, &segs[i]) != CURLE_OK || curl_multi_add_handle(multi, segs[i].curl) != CURLM_OK) {
+            segs[i].curl_code = CURLE_FAILED_INIT;
+            continue;
+        }
+        pending++;
+    }
+
+    while (pending > 0) {
+        if (curl_multi_perform(multi, &running) != CURLM_OK) {
+            COMMONUTILITIES_ERROR("%s: curl_multi_perform failed\n", __FUNCTION__);
+            break;
+        }
+        while ((msg = curl_multi_info_read(multi, &msgs_left)) != NULL) {
+            Segment_t *done_seg = NULL;
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            for (i = 0; i < count; i++) {
+                if (segs[i].curl == msg->easy_handle) {
+                    done_seg = &segs[i];
+                    break;
+                }
+            }
+            if (done_seg == NULL) {
+                continue;
+            }
+            curl_multi_remove_handle(multi, done_seg->curl);
+            pending--;
+            done_seg->curl_code = msg->data.result;
+            curl_easy_getinfo(done_seg->curl, CURLINFO_RESPONSE_CODE, &done_seg->http_code);
+            transferStatsCollect(done_seg->curl, done_seg->curl_code);
+            if (done_seg->curl_code == CURLE_OK && done_seg->written == (done_seg->end - done_seg->start + 1)) {
+                continue;
+            }
+            if (done_seg->range_ignored) {
+                fallback = true;
+                continue;
+            }
+            /* Only this range is requested again, from the first missing byte */
+            if (done_seg->retry < max_retry && !segmentStop(done_seg)) {
+                done_seg->retry++;
+                COMMONUTILITIES_INFO("%s: segment %d failed curl=%d http=%ld, retry %d\n", __FUNCTION__,
+                                     (int)(done_seg - segs), done_seg->curl_code, done_seg->http_code, done_seg->retry);
+                if (segmentStart(curl, done_seg) == CURLE_OK && curl_multi_add_handle(multi, done_seg->curl) == CURLM_OK) {
+                    pending++;
+                }
+            }
+        }
+        if (fallback) {
+            break;
+        }
+        /* A stalled range does not reach segment_write, so the token is also checked here */
+        if (cancelTokenIsCancelled(cancel)) {
+            COMMONUTILITIES_INFO("%s: download cancelled\n", __FUNCTION__);
+            cancelled = true;
+            break;
+        }
+        if (pending > 0) {
+            curl_multi_wait(multi, NULL, 0, 1000, NULL);
+        }
+    }
+
+    /* Callers check for 200 on a complete file, the 206 of each range is not exposed */
+    *curl_ret_status = CURLE_OK;
+    *httpCode_ret_status = 200;
+    for (i = 0; i < count; i++) {
+        if (segs[i].curl != NULL) {
+            curl_multi_remove_handle(multi, segs[i].curl);
+            transferStatsEnd(segs[i].curl);
+            curlPoolRelease(segs[i].curl);
+            segs[i].curl = NULL;
+        }
+        total += segs[i].written;
+        if (*curl_ret_status == CURLE_OK && segs[i].written != (segs[i].end - segs[i].start + 1)) {
+            *curl_ret_status = cancelled ? CURLE_ABORTED_BY_CALLBACK
+                             : (segs[i].curl_code != CURLE_OK) ? segs[i].curl_code : CURLE_PARTIAL_FILE;
+            *httpCode_ret_status = (int)segs[i].http_code;
+        }
+    }
+    curl_multi_cleanup(multi);
+    if (prealloc != NULL && prealloc->reserved > 0 && *curl_ret_status != CURLE_OK) {
+        preallocRelease(fd);
+    }
+    close(fd);
+    if (fallback) {
+        COMMONUTILITIES_ERROR("%s: server ignored range request\n", __FUNCTION__);
+        return SEGMENT_DWNL_NOT_POSSIBLE;
+    }
+    *bytes = (size_t)total;
+    COMMONUTILITIES_INFO("%s: Download Operation Done. bytes:%zu curl code=%d http code=%d\n", __FUNCTION__,
+                         *bytes, *curl_ret_status, *httpCode_ret_status);
+    return SEGMENT_DWNL_DONE;
+}
+
+#ifdef GTEST_ENABLE
+size_t (*getprobe_header_cb(void)) (char *buffer, size_t size, size_t nitems, void *userdata) {
+    return &probe_header_cb;
+}
+
+int (*getsegmentPlan(void)) (curl_off_t length, segmentParam_t *seg, Segment_t *segs) {
+    return &segmentPlan;
+}
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_SEGMENTDOWNLOAD_H_
+#define  _RDK_SEGMENTDOWNLOAD_H_
+
+#include "urlHelper.h"
+
+#define SEGMENT_DWNL_DONE           0   /* segmented download ran, result is in the out parameters */
+#define SEGMENT_DWNL_NOT_POSSIBLE   1   /* nothing downloaded, caller should use single stream */
+
+#define SEGMENT_MAX_COUNT           16
+#define SEGMENT_MIN_SIZE_DEFAULT    (1024 * 1024)
+#define SEGMENT_RETRY_DEFAULT       2
+
+/* Below structure describe one byte range of a segmented download */
+typedef struct segment {
+    CURL *curl;
+    int fd;
+    curl_off_t start;       /* first byte of the range */
+    curl_off_t end;         /* last byte of the range (inclusive) */
+    curl_off_t written;     /* bytes already stored at start */
+    int retry;              /* retries used so far */
+    bool checked;           /* http status checked for current attempt */
+    bool range_ignored;     /* server answered without 206 */
+    CURLcode curl_code;
+    long http_code;
+    struct cancelToken *cancel; /* cancellation of the whole download, NULL if not requested */
+} Segment_t;
+
+/* segmentedDownloadFile(): Download a file over several parallel byte range requests.
+ *                          The Content-Length is taken from a header request which is dumped
+ *                          to <file>.header same as urlHelperDownloadFile.
+ * curl : Curl object with url and security options already set. It is duplicated for each range
+ * file : path with file name to download
+ * seg : segment count, minimum segment size and per segment retry
+ * hdr : header map filled from the header request, NULL to only dump <file>.header
+ * cancel : cancellation token of the download, NULL for setForceStop only
+ * prealloc : reserve space of the whole file before the ranges start, NULL to let the file grow
+ * bytes : Send back no of bytes downloaded
+ * httpCode_ret_status : Send back http status.
+ * curl_ret_status : Send back curl status
+ * Return : SEGMENT_DWNL_DONE or SEGMENT_DWNL_NOT_POSSIBLE
+ * */
+int segmentedDownloadFile(CURL *curl, const char *file, segmentParam_t *seg, headerParam_t *hdr, struct cancelToken *cancel,
+                          preallocParam_t *prealloc, size_t *bytes, int *httpCode_ret_status, CURLcode *curl_ret_status);
+
+#endif
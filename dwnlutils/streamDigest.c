@@ -0,0 +1,172 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "streamDigest.h"
+
+#include <openssl/evp.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+struct streamDigest {
+    EVP_MD_CTX *mdctx;
+    bool final;
+};
+
+StreamDigest_t *streamDigestCreate(digestType_t type) {
+    StreamDigest_t *ctx = NULL;
+    const EVP_MD *md = NULL;
+
+    switch (type) {
+        case DIGEST_MD5:
+            md = EVP_md5();
+            break;
+        case DIGEST_SHA256:
+            md = EVP_sha256();
+            break;
+        default:
+            COMMONUTILITIES_ERROR("%s: unknown digest type=%d\n", __FUNCTION__, type);
+            return NULL;
+    }
+    ctx = (StreamDigest_t *)calloc(1, sizeof(StreamDigest_t));
+    if (ctx == NULL) {
+        COMMONUTILITIES_ERROR("%s: calloc failed\n", __FUNCTION__);
+        return NULL;
+    }
+    ctx->mdctx = EVP_MD_CTX_new();
+    if (ctx->mdctx == NULL || EVP_DigestInit_ex(ctx->mdctx, md, NULL) != 1) {
+        COMMONUTILITIES_ERROR("%s: digest init failed\n", __FUNCTION__);
+        EVP_MD_CTX_free(ctx->mdctx);
+        free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+int streamDigestUpdate(StreamDigest_t *ctx, const void *data, size_t len) {
+    if (ctx == NULL || ctx->final || (data == NULL && len > 0)) {
+        return -1;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    return (EVP_DigestUpdate(ctx->mdctx, data, len) == 1) ? 0 : -1;
+}
+
+int streamDigestPrefix(StreamDigest_t *ctx, FILE *fp, curl_off_t len) {
+    char *buf = NULL;
+    size_t want;
+    size_t got;
+    int ret = 0;
+
+    if (ctx == NULL || fp == NULL || len < 0) {
+        return -1;
+    }
+    if (fseeko(fp, 0, SEEK_SET) != 0) {
+        COMMONUTILITIES_ERROR("%s: fseek failed\n", __FUNCTION__);
+        return -1;
+    }
+    buf = (char *)malloc(DIGEST_READ_BUF_SIZE);
+    if (buf == NULL) {
+        COMMONUTILITIES_ERROR("%s: malloc failed\n", __FUNCTION__);
+        return -1;
+    }
+    while (len > 0) {
+        want = (len > DIGEST_READ_BUF_SIZE) ? DIGEST_READ_BUF_SIZE : (size_t)len;
+        got = fread(buf, 1, want, fp);
+        if (got != want) {
+            COMMONUTILITIES_ERROR("%s: file shorter than resume position, %" CURL_FORMAT_CURL_OFF_T " bytes missing\n", __FUNCTION__, len - (curl_off_t)got);
+            ret = -1;
+            break;
+        }
+        if (streamDigestUpdate(ctx, buf, got) != 0) {
+            ret = -1;
+            break;
+        }
+        len -= got;
+    }
+    free(buf);
+    return ret;
+}
+
+int streamDigestFinal(StreamDigest_t *ctx, digestParam_t *out) {
+    unsigned int len = 0;
+    unsigned int i;
+
+    if (ctx == NULL || out == NULL || ctx->final) {
+        return -1;
+    }
+    ctx->final = true;
+    if (EVP_DigestFinal_ex(ctx->mdctx, out->digest, &len) != 1 || len > DIGEST_MAX_LEN) {
+        COMMONUTILITIES_ERROR("%s: digest final failed\n", __FUNCTION__);
+        out->digest_len = 0;
+        out->digest_hex[0] = '\0';
+        return -1;
+    }
+    out->digest_len = len;
+    for (i = 0; i < len; i++) {
+        snprintf(&out->digest_hex[i * 2], 3, "%02x", out->digest[i]);
+    }
+    out->digest_hex[len * 2] = '\0';
+    return 0;
+}
+
+void streamDigestDestroy(StreamDigest_t *ctx) {
+    if (ctx != NULL) {
+        EVP_MD_CTX_free(ctx->mdctx);
+        free(ctx);
+    }
+}
+
+int streamDigestFile(const char *file, digestParam_t *out) {
+    StreamDigest_t *ctx = NULL;
+    FILE *fp = NULL;
+    char *buf = NULL;
+    size_t got;
+    int ret = -1;
+
+    if (file == NULL || out == NULL) {
+        return -1;
+    }
+    out->digest_len = 0;
+    out->digest_hex[0] = '\0';
+    fp = fopen(file, "rb");
+    if (fp == NULL) {
+        COMMONUTILITIES_ERROR("%s: File open Fail:%s\n", __FUNCTION__, file);
+        return -1;
+    }
+    ctx = streamDigestCreate(out->type);
+    buf = (char *)malloc(DIGEST_READ_BUF_SIZE);
+    if (ctx != NULL && buf != NULL) {
+        ret = 0;
+        while ((got = fread(buf, 1, DIGEST_READ_BUF_SIZE, fp)) > 0) {
+            if (streamDigestUpdate(ctx, buf, got) != 0) {
+                ret = -1;
+                break;
+            }
+        }
+        if (ret == 0 && ferror(fp) == 0) {
+            ret = streamDigestFinal(ctx, out);
+        } else {
+            ret = -1;
+        }
+    }
+    free(buf);
+    streamDigestDestroy(ctx);
+    fclose(fp);
+    return ret;
+}
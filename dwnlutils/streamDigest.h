@@ -0,0 +1,62 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_STREAMDIGEST_H_
+#define  _RDK_STREAMDIGEST_H_
+
+#include "urlHelper.h"
+
+#define DIGEST_READ_BUF_SIZE (64 * 1024)
+
+typedef struct streamDigest StreamDigest_t;
+
+/* streamDigestCreate(): Create a digest context
+ * type : DIGEST_MD5 or DIGEST_SHA256
+ * Return : StreamDigest_t * : context, NULL on failure or unknown type
+ * */
+StreamDigest_t *streamDigestCreate(digestType_t type);
+
+/* streamDigestUpdate(): Add data to the digest
+ * Return : int : 0 on success, -1 on failure
+ * */
+int streamDigestUpdate(StreamDigest_t *ctx, const void *data, size_t len);
+
+/* streamDigestPrefix(): Add the first len bytes of an already present file to the digest.
+ *                       Used to rebuild the state before a resumed download. File position is not kept.
+ * fp : file opened for read
+ * len : prefix length
+ * Return : int : 0 on success, -1 if the file is shorter than len or read failed
+ * */
+int streamDigestPrefix(StreamDigest_t *ctx, FILE *fp, curl_off_t len);
+
+/* streamDigestFinal(): Finish the digest and store binary and hex value in out
+ * Return : int : 0 on success, -1 on failure. The context can not be updated after this call
+ * */
+int streamDigestFinal(StreamDigest_t *ctx, digestParam_t *out);
+
+/* streamDigestDestroy(): Free the context. NULL is allowed */
+void streamDigestDestroy(StreamDigest_t *ctx);
+
+/* streamDigestFile(): Compute the digest of a whole file
+ * file : path of the file
+ * out : type is input, digest is output
+ * Return : int : 0 on success, -1 on failure
+ * */
+int streamDigestFile(const char *file, digestParam_t *out);
+
+#endif
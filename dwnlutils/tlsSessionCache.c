@@ -0,0 +1,382 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "tlsSessionCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <openssl/x509.h>
+#include <openssl/evp.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+#define TLS_CERT_ID_BYTES 16
+
+/* One stored session in DER form */
+typedef struct tlsSessionEntry {
+    char key[TLS_SESSION_KEY_LEN];
+    unsigned char *der;
+    int len;
+    time_t expiry;
+} TlsSessionEntry_t;
+
+typedef int (*newSessionCB_t)(SSL *ssl, SSL_SESSION *session);
+
+static pthread_mutex_t session_lock = PTHREAD_MUTEX_INITIALIZER;
+static char session_file[256] = TLS_SESSION_FILE;
+static bool session_enabled = false;
+static bool session_loaded = false;
+static TlsSessionEntry_t sessions[TLS_SESSION_MAX];
+static int session_count = 0;
+static newSessionCB_t curl_new_cb = NULL;   /* callback curl installed to fill its own cache */
+static pthread_once_t index_once = PTHREAD_ONCE_INIT;
+static int port_index = -1;                 /* SSL_CTX ex data holding the server port */
+
+static void tlsIndexInit(void) {
+    port_index = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+}
+
+static void tlsFreeAll(void) {
+    int i;
+
+    for (i = 0; i < session_count; i++) {
+        free(sessions[i].der);
+    }
+    memset(sessions, 0, sizeof(sessions));
+    session_count = 0;
+}
+
+/* tlsFind(): Index of key, -1 if not present. Called with lock held */
+static int tlsFind(const char *key) {
+    int i;
+
+    for (i = 0; i < session_count; i++) {
+        if (strcmp(sessions[i].key, key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* tlsStore(): Keep der under key, der is owned by the cache after the call.
+ * The session expiring first is replaced when cache is full. Called with lock held */
+static void tlsStore(const char *key, unsigned char *der, int len, time_t expiry) {
+    int i = tlsFind(key);
+    int j;
+
+    if (i < 0) {
+        if (session_count < TLS_SESSION_MAX) {
+            i = session_count++;
+        } else {
+            i = 0;
+            for (j = 1; j < session_count; j++) {
+                if (sessions[j].expiry < sessions[i].expiry) {
+                    i = j;
+                }
+            }
+        }
+    }
+    free(sessions[i].der);
+    snprintf(sessions[i].key, sizeof(sessions[i].key), "%s", key);
+    sessions[i].der = der;
+    sessions[i].len = len;
+    sessions[i].expiry = expiry;
+}
+
+/* tlsLoad(): Read session file once, expired sessions are skipped. Called with lock held */
+static void tlsLoad(void) {
+    FILE *fp;
+    char *line = NULL;
+    size_t size = 0;
+    char key[TLS_SESSION_KEY_LEN];
+    long long expiry;
+    int offset = 0;
+    unsigned char *der;
+    size_t hexlen;
+    size_t i;
+    unsigned int byte;
+
+    if (session_loaded) {
+        return;
+    }
+    session_loaded = true;
+    tlsFreeAll();
+    fp = fopen(session_file, "r");
+    if (fp == NULL) {
+        return;
+    }
+    while (getline(&line, &size, fp) > 0) {
+        /* key expiry hex-der */
+        if (sscanf(line, "%383s %lld %n", key, &expiry, &offset) != 2 || expiry <= (long long)time(NULL)) {
+            continue;
+        }
+        hexlen = strcspn(line + offset, "\r\n");
+        if (hexlen == 0 || (hexlen % 2) != 0) {
+            continue;
+        }
+        der = malloc(hexlen / 2);
+        if (der == NULL) {
+            break;
+        }
+        for (i = 0; i < hexlen / 2; i++) {
+            if (sscanf(line + offset + i * 2, "%2x", &byte) != 1) {
+                break;
+            }
+            der[i] = (unsigned char)byte;
+        }
+        if (i != hexlen / 2) {
+            free(der);
+            continue;
+        }
+        tlsStore(key, der, (int)(hexlen / 2), (time_t)expiry);
+    }
+    free(line);
+    fclose(fp);
+    COMMONUTILITIES_INFO("%s: %d TLS sessions loaded from %s\n", __FUNCTION__, session_count, session_file);
+}
+
+/* tlsSave(): Write session file with owner only access, replaced at once. Called with lock held */
+static void tlsSave(void) {
+    char tmp[sizeof(session_file) + 8];
+    FILE *fp;
+    int fd;
+    int i;
+    int j;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", session_file);
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        COMMONUTILITIES_ERROR("%s: unable to write %s\n", __FUNCTION__, tmp);
+        return;
+    }
+    /* Mode of open() is only used for new files */
+    fchmod(fd, S_IRUSR | S_IWUSR);
+    fp = fdopen(fd, "w");
+    if (fp == NULL) {
+        close(fd);
+        remove(tmp);
+        return;
+    }
+    for (i = 0; i < session_count; i++) {
+        fprintf(fp, "%s %lld ", sessions[i].key, (long long)sessions[i].expiry);
+        for (j = 0; j < sessions[i].len; j++) {
+            fprintf(fp, "%02x", sessions[i].der[j]);
+        }
+        fputc('\n', fp);
+    }
+    if (fclose(fp) != 0 || rename(tmp, session_file) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to replace %s\n", __FUNCTION__, session_file);
+        remove(tmp);
+    }
+}
+
+/* tlsKey(): Cache key of connection: server name, port and client certificate digest.
+ * curl talks to OpenSSL through its own BIO, the port comes from the request url
+ * Return : int : 0 on success, -1 when connection has no server name
+ * */
+static int tlsKey(const SSL *ssl, char *key, size_t len) {
+    const char *host = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int md_len = 0;
+    char cert_id[TLS_CERT_ID_BYTES * 2 + 1] = "-";
+    X509 *cert;
+    long port;
+    int i;
+
+    if (host == NULL) {
+        return -1;
+    }
+    port = (long)(intptr_t)SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), port_index);
+    cert = SSL_get_certificate(ssl);
+    if (cert != NULL && X509_digest(cert, EVP_sha256(), md, &md_len) == 1 && md_len >= TLS_CERT_ID_BYTES) {
+        for (i = 0; i < TLS_CERT_ID_BYTES; i++) {
+            snprintf(cert_id + i * 2, 3, "%02x", md[i]);
+        }
+    }
+    snprintf(key, len, "%s:%ld:%s", host, port, cert_id);
+    return 0;
+}
+
+/* tlsNewSessionCB(): Save sessions of completed handshakes, then pass them to curl */
+static int tlsNewSessionCB(SSL *ssl, SSL_SESSION *session) {
+    newSessionCB_t cb = __atomic_load_n(&curl_new_cb, __ATOMIC_ACQUIRE);
+    char key[TLS_SESSION_KEY_LEN];
+
+    if (tlsSessionCacheEnabled() && SSL_SESSION_is_resumable(session) && tlsKey(ssl, key, sizeof(key)) == 0) {
+        tlsSessionCachePut(key, session);
+    }
+    return (cb != NULL) ? cb(ssl, session) : 0;
+}
+
+/* tlsInfoCB(): Offer the stored session when curl has none for the connection.
+ * Called before the client hello is built */
+static void tlsInfoCB(const SSL *ssl, int where, int ret) {
+    char key[TLS_SESSION_KEY_LEN];
+    SSL_SESSION *session;
+
+    (void)ret;
+    if ((where & SSL_CB_HANDSHAKE_DONE) && SSL_session_reused((SSL *)ssl)) {
+        COMMONUTILITIES_DEBUG("%s: TLS session resumed\n", __FUNCTION__);
+        return;
+    }
+    if (!(where & SSL_CB_HANDSHAKE_START) || SSL_get_session(ssl) != NULL || !tlsSessionCacheEnabled()) {
+        return;
+    }
+    if (tlsKey(ssl, key, sizeof(key)) != 0) {
+        return;
+    }
+    session = tlsSessionCacheGet(key);
+    if (session != NULL) {
+        if (SSL_set_session((SSL *)ssl, session) == 1) {
+            COMMONUTILITIES_DEBUG("%s: offering stored session for %s\n", __FUNCTION__, key);
+        }
+        SSL_SESSION_free(session);
+    }
+}
+
+/* tlsCtxCB(): curl SSL context callback, hooks session callbacks into the context of a connection
+ * parm : server port of the request
+ * */
+static CURLcode tlsCtxCB(CURL *curl, void *sslctx, void *parm) {
+    SSL_CTX *ctx = sslctx;
+    newSessionCB_t cb = SSL_CTX_sess_get_new_cb(ctx);
+
+    (void)curl;
+    SSL_CTX_set_ex_data(ctx, port_index, parm);
+    if (cb != NULL && cb != tlsNewSessionCB) {
+        __atomic_store_n(&curl_new_cb, cb, __ATOMIC_RELEASE);
+    }
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ctx, tlsNewSessionCB);
+    SSL_CTX_set_info_callback(ctx, tlsInfoCB);
+    return CURLE_OK;
+}
+
+int tlsSessionCacheEnable(const char *path) {
+    if (path != NULL && (path[0] == '\0' || strlen(path) >= sizeof(session_file))) {
+        COMMONUTILITIES_ERROR("%s: invalid session file\n", __FUNCTION__);
+        return -1;
+    }
+    pthread_mutex_lock(&session_lock);
+    snprintf(session_file, sizeof(session_file), "%s", (path != NULL) ? path : TLS_SESSION_FILE);
+    session_loaded = false;
+    __atomic_store_n(&session_enabled, true, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&session_lock);
+    COMMONUTILITIES_INFO("%s: TLS sessions stored in %s\n", __FUNCTION__, session_file);
+    return 0;
+}
+
+void tlsSessionCacheDisable(void) {
+    pthread_mutex_lock(&session_lock);
+    __atomic_store_n(&session_enabled, false, __ATOMIC_RELEASE);
+    tlsFreeAll();
+    session_loaded = false;
+    pthread_mutex_unlock(&session_lock);
+}
+
+bool tlsSessionCacheEnabled(void) {
+    return __atomic_load_n(&session_enabled, __ATOMIC_ACQUIRE);
+}
+
+CURLcode tlsSessionCacheSetopt(CURL *curl, const char *url) {
+    CURLU *h;
+    char *part = NULL;
+    long port = 0;
+    CURLcode code;
+
+    if (curl == NULL || url == NULL) {
+        return CURLE_BAD_FUNCTION_ARGUMENT;
+    }
+    pthread_once(&index_once, tlsIndexInit);
+    h = curl_url();
+    if (h != NULL) {
+        if (curl_url_set(h, CURLUPART_URL, url, 0) == CURLUE_OK
+            && curl_url_get(h, CURLUPART_PORT, &part, CURLU_DEFAULT_PORT) == CURLUE_OK) {
+            port = strtol(part, NULL, 10);
+            curl_free(part);
+        }
+        curl_url_cleanup(h);
+    }
+    code = curl_easy_setopt(curl, CURLOPT_SSL_CTX_FUNCTION, tlsCtxCB);
+    if (code == CURLE_OK) {
+        code = curl_easy_setopt(curl, CURLOPT_SSL_CTX_DATA, (void *)(intptr_t)port);
+    }
+    if (code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("%s: TLS sessions can not be stored: %s\n", __FUNCTION__, curl_easy_strerror(code));
+    }
+    return code;
+}
+
+int tlsSessionCachePut(const char *key, SSL_SESSION *session) {
+    unsigned char *der;
+    unsigned char *p;
+    int len;
+
+    if (key == NULL || session == NULL || strlen(key) >= TLS_SESSION_KEY_LEN || strchr(key, ' ') != NULL) {
+        return -1;
+    }
+    len = i2d_SSL_SESSION(session, NULL);
+    if (len <= 0) {
+        return -1;
+    }
+    der = malloc(len);
+    if (der == NULL) {
+        return -1;
+    }
+    p = der;
+    i2d_SSL_SESSION(session, &p);
+    pthread_mutex_lock(&session_lock);
+    if (!__atomic_load_n(&session_enabled, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_unlock(&session_lock);
+        free(der);
+        return -1;
+    }
+    tlsLoad();
+    tlsStore(key, der, len, (time_t)(SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session)));
+    tlsSave();
+    pthread_mutex_unlock(&session_lock);
+    return 0;
+}
+
+SSL_SESSION *tlsSessionCacheGet(const char *key) {
+    SSL_SESSION *session = NULL;
+    const unsigned char *p;
+    int i;
+
+    if (key == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&session_lock);
+    if (__atomic_load_n(&session_enabled, __ATOMIC_ACQUIRE)) {
+        tlsLoad();
+        i = tlsFind(key);
+        if (i >= 0 && sessions[i].expiry > time(NULL)) {
+            p = sessions[i].der;
+            session = d2i_SSL_SESSION(NULL, &p, sessions[i].len);
+        }
+    }
+    pthread_mutex_unlock(&session_lock);
+    return session;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_TLSSESSIONCACHE_H_
+#define  _RDK_TLSSESSIONCACHE_H_
+
+#include <stdbool.h>
+#include <curl/curl.h>
+#include <openssl/ssl.h>
+
+#ifndef TLS_SESSION_FILE //This is to provide an option Define custom persistent TLS session file using DFLAGS
+#define TLS_SESSION_FILE "/opt/.dwnlutil_tls_sessions"
+#endif
+
+#ifndef TLS_SESSION_MAX //This is to provide an option Define custom count of stored TLS sessions using DFLAGS
+#define TLS_SESSION_MAX 16
+#endif
+
+#define TLS_SESSION_KEY_LEN 384
+
+/* Persistent TLS session cache. Sessions are keyed by server host, port and client certificate,
+ * stored in a file readable by the owner only and offered again by later processes so the
+ * handshake, including the client certificate exchange of mTLS, is resumed instead of done in full.
+ * Works with the OpenSSL backend of curl, other backends keep full handshakes */
+
+/* tlsSessionCacheEnable(): Enable the cache for transfers configured after this call
+ * path : session file, NULL for TLS_SESSION_FILE
+ * Return : int : 0 on success, -1 on invalid path
+ * */
+int tlsSessionCacheEnable(const char *path);
+
+/* tlsSessionCacheDisable(): Stop offering and saving sessions, stored sessions are kept in the file */
+void tlsSessionCacheDisable(void);
+
+/* tlsSessionCacheEnabled(): Check if the cache is enabled */
+bool tlsSessionCacheEnabled(void);
+
+/* tlsSessionCacheSetopt(): Install the session hooks on a curl handle
+ * url : request url, its port is part of the session key
+ * Return : CURLcode : CURLE_OK on success, CURLE_NOT_BUILT_IN when curl does not use OpenSSL
+ * */
+CURLcode tlsSessionCacheSetopt(CURL *curl, const char *url);
+
+/* tlsSessionCachePut(): Store a session under key, replacing the previous one
+ * Return : int : 0 on success, -1 on failure
+ * */
+int tlsSessionCachePut(const char *key, SSL_SESSION *session);
+
+/* tlsSessionCacheGet(): Stored unexpired session of key
+ * Return : SSL_SESSION * : session to be freed with SSL_SESSION_free, NULL if not found
+ * */
+SSL_SESSION *tlsSessionCacheGet(const char *key);
+
+#endif
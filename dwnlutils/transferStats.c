@@ -0,0 +1,355 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "transferStats.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+/* Stats a handle reports to, duplicates bound with transferStatsInherit share the fields of the first handle */
+typedef struct statsBound {
+    CURL *handle;
+    statsParam_t *stats;
+    const retryParam_t *retry;  /* policy the retries are read from, NULL for none */
+    unsigned long long start_us;
+} StatsBound_t;
+
+/* Timings of one request in microseconds */
+typedef struct statsSample {
+    long long namelookup;
+    long long connect;
+    long long appconnect;
+    long long pretransfer;
+    long long starttransfer;
+    long long total;
+    long long bytes_down;
+    long long bytes_up;
+    long long speed_down;
+    long redirects;
+    long http_code;
+} StatsSample_t;
+
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static StatsBound_t bound[TRANSFER_STATS_MAX_BOUND];
+static TransferHistogram_t histogram;
+static int histogram_enabled = 0;
+
+static const char *phase_names[TRANSFER_PHASE_MAX] = { "dns", "connect", "tls", "ttfb", "body", "total" };
+
+/* statsNowUs(): Monotonic time in microseconds */
+static unsigned long long statsNowUs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)ts.tv_nsec / 1000ULL;
+}
+
+/* statsFind(): Slot of handle, -1 if not bound. Called with lock held */
+static int statsFind(CURL *curl) {
+    int i;
+
+    for (i = 0; i < TRANSFER_STATS_MAX_BOUND; i++) {
+        if (bound[i].handle == curl) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* statsBind(): Bind handle to stats. Called with lock held
+ * Return : bool : true on success, false when every slot is used
+ * */
+static bool statsBind(CURL *curl, statsParam_t *stats, const retryParam_t *retry, unsigned long long start_us) {
+    int i = statsFind(NULL);
+
+    if (i < 0) {
+        COMMONUTILITIES_ERROR("%s: more than %d transfers, stats not collected\n", __FUNCTION__, TRANSFER_STATS_MAX_BOUND);
+        return false;
+    }
+    bound[i].handle = curl;
+    bound[i].stats = stats;
+    bound[i].retry = retry;
+    bound[i].start_us = start_us;
+    return true;
+}
+
+/* statsTime(): Time info of curl in microseconds, the _T variants exist since curl 7.61.0 */
+#if LIBCURL_VERSION_NUM >= 0x073d00
+#define STATS_TIME(curl, info) statsTime(curl, CURLINFO_##info##_TIME_T)
+static long long statsTime(CURL *curl, CURLINFO info) {
+    curl_off_t value = 0;
+
+    curl_easy_getinfo(curl, info, &value);
+    return (long long)value;
+}
+#else
+#define STATS_TIME(curl, info) statsTime(curl, CURLINFO_##info##_TIME)
+static long long statsTime(CURL *curl, CURLINFO info) {
+    double value = 0;
+
+    curl_easy_getinfo(curl, info, &value);
+    return (long long)(value * 1000000.0);
+}
+#endif
+
+/* statsCount(): Byte or speed info of curl */
+static long long statsCount(CURL *curl, CURLINFO info) {
+    curl_off_t value = 0;
+
+    curl_easy_getinfo(curl, info, &value);
+    return (long long)value;
+}
+
+/* statsPhase(): Time spent between two points of a request, 0 when the later one was not reached */
+static long long statsPhase(long long from, long long to) {
+    return (to > from) ? to - from : 0;
+}
+
+/* statsBucket(): Histogram bucket of value */
+static int statsBucket(unsigned long long value) {
+    int bucket = 0;
+
+    while (value > 0 && bucket < TRANSFER_STATS_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/* statsFailed(): Request ended with a curl error or an http error status */
+static bool statsFailed(CURLcode curl_code, long http_code) {
+    return (curl_code != CURLE_OK || http_code >= 400);
+}
+
+/* statsAdd(): Add request to the stats of a handle. Called with lock held */
+static void statsAdd(const StatsBound_t *slot, const StatsSample_t *sample, CURLcode curl_code) {
+    statsParam_t *stats = slot->stats;
+    unsigned long long now = statsNowUs();
+
+    stats->namelookup_us = sample->namelookup;
+    stats->connect_us = sample->connect;
+    stats->appconnect_us = sample->appconnect;
+    stats->pretransfer_us = sample->pretransfer;
+    stats->starttransfer_us = sample->starttransfer;
+    stats->total_us = sample->total;
+    stats->bytes_down += sample->bytes_down;
+    stats->bytes_up += sample->bytes_up;
+    stats->redirects += (int)sample->redirects;
+    stats->requests++;
+    /* Attempts are recorded by retryNext after the request, so they count the ones made before it */
+    if (slot->retry != NULL) {
+        stats->retries = slot->retry->attempts;
+    }
+    if (statsFailed(curl_code, sample->http_code)) {
+        stats->failures++;
+    }
+    stats->curl_code = curl_code;
+    stats->http_code = sample->http_code;
+    stats->elapsed_us = (long long)(now - slot->start_us);
+    if (stats->elapsed_us > 0) {
+        stats->speed_down = stats->bytes_down * 1000000LL / stats->elapsed_us;
+        stats->speed_up = stats->bytes_up * 1000000LL / stats->elapsed_us;
+    }
+}
+
+/* statsHistogramAdd(): Add request to the histograms. Called with lock held */
+static void statsHistogramAdd(const StatsSample_t *sample, CURLcode curl_code) {
+    histogram.requests++;
+    if (statsFailed(curl_code, sample->http_code)) {
+        histogram.failures++;
+    }
+    histogram.bytes_down += (unsigned long long)sample->bytes_down;
+    histogram.bytes_up += (unsigned long long)sample->bytes_up;
+    /* Connect time is 0 when curl took a connection of the pool */
+    if (sample->connect == 0) {
+        histogram.reused++;
+    } else {
+        histogram.phase_ms[TRANSFER_PHASE_DNS][statsBucket(sample->namelookup / 1000)]++;
+        histogram.phase_ms[TRANSFER_PHASE_CONNECT][statsBucket(statsPhase(sample->namelookup, sample->connect) / 1000)]++;
+        if (sample->appconnect > 0) {
+            histogram.phase_ms[TRANSFER_PHASE_TLS][statsBucket(statsPhase(sample->connect, sample->appconnect) / 1000)]++;
+        }
+    }
+    if (sample->starttransfer > 0) {
+        histogram.phase_ms[TRANSFER_PHASE_TTFB][statsBucket(statsPhase(sample->pretransfer, sample->starttransfer) / 1000)]++;
+        histogram.phase_ms[TRANSFER_PHASE_BODY][statsBucket(statsPhase(sample->starttransfer, sample->total) / 1000)]++;
+    }
+    histogram.phase_ms[TRANSFER_PHASE_TOTAL][statsBucket(sample->total / 1000)]++;
+    if (sample->bytes_down > 0) {
+        histogram.speed_kbps[statsBucket(sample->speed_down / 1024)]++;
+    }
+}
+
+bool transferStatsBegin(CURL *curl, statsParam_t *stats, const retryParam_t *retry) {
+    bool ret = false;
+
+    if (curl == NULL || stats == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&stats_lock);
+    if (statsFind(curl) < 0) {
+        memset(stats, 0, sizeof(statsParam_t));
+        ret = statsBind(curl, stats, retry, statsNowUs());
+    }
+    pthread_mutex_unlock(&stats_lock);
+    return ret;
+}
+
+bool transferStatsInherit(CURL *dup, CURL *curl) {
+    bool ret = false;
+    int i;
+
+    if (dup == NULL || curl == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&stats_lock);
+    i = statsFind(curl);
+    if (i >= 0 && statsFind(dup) < 0) {
+        ret = statsBind(dup, bound[i].stats, bound[i].retry, bound[i].start_us);
+    }
+    pthread_mutex_unlock(&stats_lock);
+    return ret;
+}
+
+void transferStatsEnd(CURL *curl) {
+    int i;
+
+    if (curl == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&stats_lock);
+    i = statsFind(curl);
+    if (i >= 0) {
+        memset(&bound[i], 0, sizeof(StatsBound_t));
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void transferStatsCollect(CURL *curl, CURLcode curl_code) {
+    StatsSample_t sample;
+    int i;
+
+    if (curl == NULL) {
+        return;
+    }
+    /* Nothing is read from curl for requests no one asked stats of */
+    pthread_mutex_lock(&stats_lock);
+    i = (histogram_enabled) ? 0 : statsFind(curl);
+    pthread_mutex_unlock(&stats_lock);
+    if (i < 0) {
+        return;
+    }
+    memset(&sample, 0, sizeof(sample));
+    sample.namelookup = STATS_TIME(curl, NAMELOOKUP);
+    sample.connect = STATS_TIME(curl, CONNECT);
+    sample.appconnect = STATS_TIME(curl, APPCONNECT);
+    sample.pretransfer = STATS_TIME(curl, PRETRANSFER);
+    sample.starttransfer = STATS_TIME(curl, STARTTRANSFER);
+    sample.total = STATS_TIME(curl, TOTAL);
+    sample.bytes_down = statsCount(curl, CURLINFO_SIZE_DOWNLOAD_T);
+    sample.bytes_up = statsCount(curl, CURLINFO_SIZE_UPLOAD_T);
+    sample.speed_down = statsCount(curl, CURLINFO_SPEED_DOWNLOAD_T);
+    curl_easy_getinfo(curl, CURLINFO_REDIRECT_COUNT, &sample.redirects);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &sample.http_code);
+
+    COMMONUTILITIES_INFO("Curl timing dns=%lldus connect=%lldus tls=%lldus ttfb=%lldus total=%lldus down=%lld up=%lld redirects=%ld\n",
+                         sample.namelookup, statsPhase(sample.namelookup, sample.connect),
+                         statsPhase(sample.connect, sample.appconnect), statsPhase(sample.pretransfer, sample.starttransfer),
+                         sample.total, sample.bytes_down, sample.bytes_up, sample.redirects);
+
+    pthread_mutex_lock(&stats_lock);
+    i = statsFind(curl);
+    if (i >= 0) {
+        statsAdd(&bound[i], &sample, curl_code);
+    }
+    if (histogram_enabled) {
+        statsHistogramAdd(&sample, curl_code);
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void transferStatsHistogramEnable(bool enable) {
+    pthread_mutex_lock(&stats_lock);
+    histogram_enabled = enable ? 1 : 0;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void transferStatsHistogramGet(TransferHistogram_t *hist) {
+    if (hist == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&stats_lock);
+    memcpy(hist, &histogram, sizeof(TransferHistogram_t));
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void transferStatsHistogramReset(void) {
+    pthread_mutex_lock(&stats_lock);
+    memset(&histogram, 0, sizeof(TransferHistogram_t));
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/* statsWriteBuckets(): Write one histogram as a JSON array */
+static void statsWriteBuckets(FILE *fp, const char *name, const unsigned long long *buckets) {
+    int i;
+
+    fprintf(fp, ",\"%s\":[", name);
+    for (i = 0; i < TRANSFER_STATS_BUCKETS; i++) {
+        fprintf(fp, "%s%llu", (i > 0) ? "," : "", buckets[i]);
+    }
+    fprintf(fp, "]");
+}
+
+int transferStatsHistogramDump(const char *file) {
+    TransferHistogram_t hist;
+    char tmp[256];
+    FILE *fp;
+    int i;
+
+    if (file == NULL || snprintf(tmp, sizeof(tmp), "%s.tmp", file) >= (int)sizeof(tmp)) {
+        COMMONUTILITIES_ERROR("%s: invalid file\n", __FUNCTION__);
+        return -1;
+    }
+    transferStatsHistogramGet(&hist);
+    fp = fopen(tmp, "w");
+    if (fp == NULL) {
+        COMMONUTILITIES_ERROR("%s: unable to open %s\n", __FUNCTION__, tmp);
+        return -1;
+    }
+    fprintf(fp, "{\"requests\":%llu,\"failures\":%llu,\"reused\":%llu,\"bytes_down\":%llu,\"bytes_up\":%llu,\"buckets\":[0",
+            hist.requests, hist.failures, hist.reused, hist.bytes_down, hist.bytes_up);
+    for (i = 1; i < TRANSFER_STATS_BUCKETS; i++) {
+        fprintf(fp, ",%llu", 1ULL << (i - 1));
+    }
+    fprintf(fp, "]");
+    for (i = 0; i < TRANSFER_PHASE_MAX; i++) {
+        statsWriteBuckets(fp, phase_names[i], hist.phase_ms[i]);
+    }
+    statsWriteBuckets(fp, "speed_kbps", hist.speed_kbps);
+    fprintf(fp, "}\n");
+    if (fclose(fp) != 0 || rename(tmp, file) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to write %s\n", __FUNCTION__, file);
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
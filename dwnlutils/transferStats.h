@@ -0,0 +1,100 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_TRANSFERSTATS_H_
+#define  _RDK_TRANSFERSTATS_H_
+
+#include <stdbool.h>
+#include <curl/curl.h>
+
+#include "urlHelper.h"
+
+#ifndef TRANSFER_STATS_MAX_BOUND //This is to provide an option Define custom count of handles reporting to a statsParam_t using DFLAGS
+#define TRANSFER_STATS_MAX_BOUND 32
+#endif
+
+/* Bucket 0 counts values below 1, bucket i values from 2^(i-1) up to 2^i, last bucket everything above */
+#define TRANSFER_STATS_BUCKETS 20
+
+/* Phases of a request, each one is the time spent in it and not the time since start */
+typedef enum {
+    TRANSFER_PHASE_DNS = 0,     /* name resolution */
+    TRANSFER_PHASE_CONNECT,     /* TCP connect */
+    TRANSFER_PHASE_TLS,         /* TLS handshake */
+    TRANSFER_PHASE_TTFB,        /* request sent until first response byte */
+    TRANSFER_PHASE_BODY,        /* first until last response byte */
+    TRANSFER_PHASE_TOTAL,       /* whole request */
+    TRANSFER_PHASE_MAX
+} transferPhase_t;
+
+/* Process wide histograms of every request made while enabled. Phase times are in milliseconds,
+ * download speeds in KiB per second. Connection phases are only counted for new connections */
+typedef struct transferHistogram {
+    unsigned long long requests;
+    unsigned long long failures;        /* curl error or http status >= 400 */
+    unsigned long long reused;          /* requests sent on a kept alive connection */
+    unsigned long long bytes_down;
+    unsigned long long bytes_up;
+    unsigned long long phase_ms[TRANSFER_PHASE_MAX][TRANSFER_STATS_BUCKETS];
+    unsigned long long speed_kbps[TRANSFER_STATS_BUCKETS];
+} TransferHistogram_t;
+
+/* Timing breakdown of transfers. A request done by the library reads its timings with
+ * curl_easy_getinfo once it ended, when its handle is bound to a statsParam_t or the histograms
+ * are enabled. doHttpFileDownloadEx, urlHelperDownloadFileEx, urlHelperDownloadToMemEx and
+ * asyncDwnlSubmit bind DwnlOptions_t.statsData, other requests can be bound with transferStatsBegin */
+
+/* transferStatsBegin(): Bind stats to handle and reset it. Nested calls for a handle already bound
+ *                       do nothing so that outer retry loops count the attempts of inner ones
+ * curl : handle of the transfer
+ * stats : filled by every request made with curl until transferStatsEnd, NULL for none
+ * retry : retry policy of the transfer, retries are its attempts, NULL for none
+ * Return : bool : true when this call bound the handle and must call transferStatsEnd
+ * */
+bool transferStatsBegin(CURL *curl, statsParam_t *stats, const retryParam_t *retry);
+
+/* transferStatsInherit(): Report requests of dup, a duplicate of curl, to the stats of curl
+ * Return : bool : true when dup was bound and must call transferStatsEnd
+ * */
+bool transferStatsInherit(CURL *dup, CURL *curl);
+
+/* transferStatsEnd(): Unbind handle, called before the handle is reset or freed */
+void transferStatsEnd(CURL *curl);
+
+/* transferStatsCollect(): Read timings of the request just done by curl and add them to the
+ *                         stats bound to the handle and to the histograms
+ * curl : handle after curl_easy_perform or CURLMSG_DONE
+ * curl_code : result of the request
+ * */
+void transferStatsCollect(CURL *curl, CURLcode curl_code);
+
+/* transferStatsHistogramEnable(): Start or stop adding requests to the histograms, off by default */
+void transferStatsHistogramEnable(bool enable);
+
+/* transferStatsHistogramGet(): Copy the histograms */
+void transferStatsHistogramGet(TransferHistogram_t *hist);
+
+/* transferStatsHistogramReset(): Clear the histograms, e.g. after they were uploaded */
+void transferStatsHistogramReset(void);
+
+/* transferStatsHistogramDump(): Write the histograms to file as JSON, replaced atomically
+ * Return : int : 0 on success, -1 on failure
+ * */
+int transferStatsHistogramDump(const char *file);
+
+#endif
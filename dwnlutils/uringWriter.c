@@ -0,0 +1,270 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "uringWriter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define URING_WRITER_SUPPORTED
+#endif
+#endif
+
+#ifdef URING_WRITER_SUPPORTED
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+/* Below structure is the ring shared with the kernel */
+struct uringWriter {
+    int ring_fd;
+    int fd;                     /* file written */
+    unsigned int entries;
+    unsigned int queued;        /* queue entries not yet sent to the kernel */
+    void *sq_ptr;
+    size_t sq_size;
+    void *cq_ptr;
+    size_t cq_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_array;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+    char **bufs;
+    bool registered;
+};
+
+static int uringSetup(unsigned int entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uringEnter(int ring_fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uringRegister(int ring_fd, unsigned int opcode, void *arg, unsigned int nr_args) {
+    return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+UringWriter_t *uringWriterCreate(int fd, char **bufs, int count, size_t buf_size) {
+    UringWriter_t *uw = NULL;
+    struct io_uring_params p;
+    struct iovec *iov = NULL;
+    int i;
+
+    if (fd < 0 || bufs == NULL || count <= 0) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return NULL;
+    }
+    uw = (UringWriter_t *)calloc(1, sizeof(UringWriter_t));
+    if (uw == NULL) {
+        COMMONUTILITIES_ERROR("%s: calloc failed\n", __FUNCTION__);
+        return NULL;
+    }
+    uw->fd = fd;
+    uw->bufs = bufs;
+    uw->sq_ptr = MAP_FAILED;
+    uw->cq_ptr = MAP_FAILED;
+    uw->sqes = MAP_FAILED;
+    memset(&p, 0, sizeof(p));
+    uw->ring_fd = uringSetup((unsigned int)count, &p);
+    if (uw->ring_fd < 0) {
+        /* ENOSYS on old kernels, EPERM when disabled by sysctl or seccomp */
+        COMMONUTILITIES_INFO("%s: io_uring not available errno=%d\n", __FUNCTION__, errno);
+        free(uw);
+        return NULL;
+    }
+    uw->entries = p.sq_entries;
+    uw->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    uw->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (uw->cq_size > uw->sq_size) {
+            uw->sq_size = uw->cq_size;
+        }
+        uw->cq_size = uw->sq_size;
+    }
+    uw->sq_ptr = mmap(NULL, uw->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uw->ring_fd, IORING_OFF_SQ_RING);
+    if (uw->sq_ptr == MAP_FAILED) {
+        goto fail;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        uw->cq_ptr = uw->sq_ptr;
+    } else {
+        uw->cq_ptr = mmap(NULL, uw->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uw->ring_fd, IORING_OFF_CQ_RING);
+        if (uw->cq_ptr == MAP_FAILED) {
+            goto fail;
+        }
+    }
+    uw->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    uw->sqes = mmap(NULL, uw->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uw->ring_fd, IORING_OFF_SQES);
+    if (uw->sqes == MAP_FAILED) {
+        goto fail;
+    }
+    uw->sq_tail = (unsigned int *)((char *)uw->sq_ptr + p.sq_off.tail);
+    uw->sq_mask = (unsigned int *)((char *)uw->sq_ptr + p.sq_off.ring_mask);
+    uw->sq_array = (unsigned int *)((char *)uw->sq_ptr + p.sq_off.array);
+    uw->cq_head = (unsigned int *)((char *)uw->cq_ptr + p.cq_off.head);
+    uw->cq_tail = (unsigned int *)((char *)uw->cq_ptr + p.cq_off.tail);
+    uw->cq_mask = (unsigned int *)((char *)uw->cq_ptr + p.cq_off.ring_mask);
+    uw->cqes = (struct io_uring_cqe *)((char *)uw->cq_ptr + p.cq_off.cqes);
+
+    /* Registered buffers are pinned once instead of being mapped for every write */
+    iov = (struct iovec *)calloc(count, sizeof(struct iovec));
+    if (iov == NULL) {
+        goto fail;
+    }
+    for (i = 0; i < count; i++) {
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len = buf_size;
+    }
+    if (uringRegister(uw->ring_fd, IORING_REGISTER_BUFFERS, iov, (unsigned int)count) != 0) {
+        /* Usually RLIMIT_MEMLOCK on kernels charging registered buffers to it */
+        COMMONUTILITIES_INFO("%s: buffer registration failed errno=%d\n", __FUNCTION__, errno);
+        free(iov);
+        goto fail;
+    }
+    free(iov);
+    uw->registered = true;
+    COMMONUTILITIES_INFO("%s: ring of %u entries with %d registered buffers\n", __FUNCTION__, uw->entries, count);
+    return uw;
+fail:
+    uringWriterDestroy(uw);
+    return NULL;
+}
+
+int uringWriterQueue(UringWriter_t *uw, int index, size_t len, long long offset) {
+    struct io_uring_sqe *sqe;
+    unsigned int tail;
+    unsigned int slot;
+
+    if (uw == NULL || uw->queued >= uw->entries) {
+        return -1;
+    }
+    /* Only this thread moves the tail, the kernel moves the head */
+    tail = *uw->sq_tail;
+    slot = tail & *uw->sq_mask;
+    sqe = &uw->sqes[slot];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = uw->fd;
+    sqe->addr = (unsigned long long)(uintptr_t)uw->bufs[index];
+    sqe->len = (unsigned int)len;
+    sqe->off = (unsigned long long)offset;
+    sqe->buf_index = (unsigned short)index;
+    sqe->user_data = (unsigned long long)index;
+    uw->sq_array[slot] = slot;
+    __atomic_store_n(uw->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    uw->queued++;
+    return 0;
+}
+
+int uringWriterSubmit(UringWriter_t *uw, bool wait) {
+    int ret;
+
+    if (uw == NULL) {
+        return -1;
+    }
+    if (uw->queued == 0 && !wait) {
+        return 0;
+    }
+    do {
+        ret = uringEnter(uw->ring_fd, uw->queued, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        COMMONUTILITIES_ERROR("%s: io_uring_enter failed errno=%d\n", __FUNCTION__, errno);
+        return -1;
+    }
+    uw->queued -= ((unsigned int)ret < uw->queued) ? (unsigned int)ret : uw->queued;
+    return 0;
+}
+
+int uringWriterReap(UringWriter_t *uw, int *index, long long *result) {
+    struct io_uring_cqe *cqe;
+    unsigned int head;
+
+    if (uw == NULL || index == NULL || result == NULL) {
+        return 0;
+    }
+    head = *uw->cq_head;
+    if (head == __atomic_load_n(uw->cq_tail, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    cqe = &uw->cqes[head & *uw->cq_mask];
+    *index = (int)cqe->user_data;
+    *result = cqe->res;
+    __atomic_store_n(uw->cq_head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void uringWriterDestroy(UringWriter_t *uw) {
+    if (uw == NULL) {
+        return;
+    }
+    if (uw->registered) {
+        uringRegister(uw->ring_fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+    }
+    if (uw->sqes != MAP_FAILED) {
+        munmap(uw->sqes, uw->sqes_size);
+    }
+    if (uw->cq_ptr != MAP_FAILED && uw->cq_ptr != uw->sq_ptr) {
+        munmap(uw->cq_ptr, uw->cq_size);
+    }
+    if (uw->sq_ptr != MAP_FAILED) {
+        munmap(uw->sq_ptr, uw->sq_size);
+    }
+    close(uw->ring_fd);
+    free(uw);
+}
+
+#else
+
+UringWriter_t *uringWriterCreate(int fd, char **bufs, int count, size_t buf_size) {
+    COMMONUTILITIES_INFO("%s: io_uring not supported by this build\n", __FUNCTION__);
+    return NULL;
+}
+
+int uringWriterQueue(UringWriter_t *uw, int index, size_t len, long long offset) {
+    return -1;
+}
+
+int uringWriterSubmit(UringWriter_t *uw, bool wait) {
+    return -1;
+}
+
+int uringWriterReap(UringWriter_t *uw, int *index, long long *result) {
+    return 0;
+}
+
+void uringWriterDestroy(UringWriter_t *uw) {
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_URINGWRITER_H_
+#define  _RDK_URINGWRITER_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Minimal io_uring submission of file writes, made with the raw system calls so that
+ * no liburing is needed. Buffers are registered once and written with IORING_OP_WRITE_FIXED,
+ * queued writes are sent to the kernel together by uringWriterSubmit. Built only where
+ * <linux/io_uring.h> is present, uringWriterCreate returns NULL everywhere else and on
+ * kernels without io_uring so the caller keeps its stdio path */
+
+typedef struct uringWriter UringWriter_t;
+
+/* uringWriterCreate(): Set up a ring for fd with the given buffers registered
+ * bufs : count buffers of buf_size bytes, they must stay allocated till uringWriterDestroy
+ * Return : UringWriter_t * : ring, NULL when io_uring is not usable
+ * */
+UringWriter_t *uringWriterCreate(int fd, char **bufs, int count, size_t buf_size);
+
+/* uringWriterQueue(): Queue write of len bytes of buffer index at file offset. Nothing is sent
+ *                     to the kernel till uringWriterSubmit
+ * Return : int : 0 on success, -1 when the submission queue is full
+ * */
+int uringWriterQueue(UringWriter_t *uw, int index, size_t len, long long offset);
+
+/* uringWriterSubmit(): Send queued writes to the kernel with one system call
+ * wait : also wait till at least one write completed
+ * Return : int : 0 on success, -1 on failure
+ * */
+int uringWriterSubmit(UringWriter_t *uw, bool wait);
+
+/* uringWriterReap(): Take one completed write without system call
+ * index : Send back buffer index of the write
+ * result : Send back bytes written, negative errno on failure
+ * Return : int : 1 when a completion was taken, 0 when none is ready
+ * */
+int uringWriterReap(UringWriter_t *uw, int *index, long long *result);
+
+/* uringWriterDestroy(): Unregister the buffers and close the ring. Writes must be completed. NULL is allowed */
+void uringWriterDestroy(UringWriter_t *uw);
+
+#endif
@@ -21,16 +21,52 @@
 #include <sys/stat.h>
 #include <pthread.h>
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
 
 #include "rdkv_cdl_log_wrapper.h"
+#include "curlPool.h"
+#include "segmentDownload.h"
+#include "deltaDownload.h"
+#include "preallocFile.h"
+#include "extractDownload.h"
+#include "writeBehind.h"
+#include "streamDigest.h"
+#include "resumeJournal.h"
+#include "retryPolicy.h"
+#include "progressReport.h"
+#include "headerMap.h"
+#include "bandwidthGovernor.h"
+#include "cancelToken.h"
+#include "connectivityProbe.h"
+#include "dnsCache.h"
+#include "tlsSessionCache.h"
+#include "contentCache.h"
+#include "transferStats.h"
+#include "curlProfile.h"
 
 #define DEFAULT_CONN_IDLE_SECS  118
 #define TLSVERSION     CURL_SSLVERSION_TLSv1_2
 
+#ifndef MEM_PRESIZE_MAX //This is to provide an option Define custom largest presize of in-memory download using DFLAGS
+#define MEM_PRESIZE_MAX (64 * 1024 * 1024)
+#endif
+#ifndef MEM_SPILL_DIR //This is to provide an option Define custom directory for spill file of in-memory download using DFLAGS
+#define MEM_SPILL_DIR "/tmp"
+#endif
+#define MEM_MIN_ALLOC 1024
+#define MEM_ARENA_ALIGN 8
+
 pthread_once_t initOnce = PTHREAD_ONCE_INIT;
 
 static long performRequest(CURL *curl, CURLcode *curl_code);
-/*Use for forcefully stop download */
+static size_t downloadFileCommon(CURL *curl, const char *file, char *dnl_start_pos, int chunk_dwnl_retry_time,
+    FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status);
+static int retryAgain(DwnlOptions_t *opts, int attempts, unsigned long long attempt_start,
+    CURLcode curl_code, int http_code);
+static size_t downloadToMemOnce(CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status);
+/*Use for forcefully stop download, accessed with atomic builtins only */
 static int force_stop = 0;
 
 /**
@@ -40,17 +76,20 @@ static void urlHelperInit(void) {
     curl_global_init(CURL_GLOBAL_ALL);
 }
 
-/* Creat or initialize curl request */
+/* Creat or initialize curl request.
+ * Handles come from the curl pool so DNS, TLS sessions and connections are reused */
 CURL *urlHelperCreateCurl(void) {
     pthread_once(&initOnce, urlHelperInit);
-    return curl_easy_init();
+    return curlPoolAcquire();
 }
 
-/* Destroy curl */
+/* Destroy curl. The handle is reset and returned to the curl pool */
 void urlHelperDestroyCurl(CURL *ctx) {
     if(ctx != NULL) {
-        curl_easy_cleanup(ctx);
-        curl_global_cleanup();
+        dnsCacheRelease(ctx);
+        transferStatsEnd(ctx);
+        curlProfileRelease(ctx);
+        curlPoolRelease(ctx);
     }
 }
 /*Description: Use for setting the force_stop variable. This function should call
@@ -61,10 +100,24 @@ void urlHelperDestroyCurl(CURL *ctx) {
 int setForceStop(int value)
 {
     COMMONUTILITIES_INFO("setForceStop(): rcv value=%d\n", value);
-    force_stop = value;
-    COMMONUTILITIES_INFO("setForceStop(): set force_stop=%d\n", force_stop);
+    __atomic_store_n(&force_stop, value, __ATOMIC_RELEASE);
+    COMMONUTILITIES_INFO("setForceStop(): set force_stop=%d\n", value);
     return 0;
 }
+/*Description: Use for reading the force_stop variable inside download callbacks.
+ * @return: int: current force_stop value
+ * */
+int getForceStop(void)
+{
+    return __atomic_load_n(&force_stop, __ATOMIC_ACQUIRE);
+}
+
+/* forceStopCB(): Stop check of bandwidth governor waits for transfers without cancellation token */
+static int forceStopCB(void *arg)
+{
+    (void)arg;
+    return (getForceStop() == 1);
+}
 /* performRequest(): Use for sending curl request and receive data
  * curl : server url
  * curl_ret_status: parameter used for returning curl status
@@ -80,6 +133,11 @@ static long performRequest(CURL *curl, CURLcode *curl_ret_status) {
     }
 
     CURLcode curlcode = curl_easy_perform(curl);
+    if(dnsCacheDone(curl, curlcode)) {
+        COMMONUTILITIES_INFO("Cached addresses failed, retry with resolved addresses\n");
+        curlcode = curl_easy_perform(curl);
+        dnsCacheDone(curl, curlcode);
+    }
 
     /* This code is only emitted when mTLS is enabled and the client cert is invalid */
     if(curlcode == CURLE_SSL_CERTPROBLEM) {
@@ -92,31 +150,13 @@ static long performRequest(CURL *curl, CURLcode *curl_ret_status) {
     curl_easy_getinfo(curl, CURLINFO_PRIMARY_PORT, &port);
 
     COMMONUTILITIES_INFO("Curl Connected to %s (%s) port %ld\n", serverurl, ip_addr, port);
+    transferStatsCollect(curl, curlcode);
     COMMONUTILITIES_INFO("Curl return code =%d, http code=%ld\n", curlcode, httpCode);
 
     if(curlcode != CURLE_OK) {
         COMMONUTILITIES_INFO("Error performing HTTP request. HTTP status: [%ld]; Error code: [%d][%s]\n", httpCode, curlcode, curl_easy_strerror(curlcode));
-        switch(curlcode) {
-            case CURLE_COULDNT_CONNECT:
-            case CURLE_COULDNT_RESOLVE_HOST:
-            case CURLE_COULDNT_RESOLVE_PROXY:
-            case CURLE_BAD_DOWNLOAD_RESUME:
-            case CURLE_INTERFACE_FAILED:
-            case CURLE_GOT_NOTHING:
-            case CURLE_NO_CONNECTION_AVAILABLE:
-            case CURLE_OPERATION_TIMEDOUT:
-            case CURLE_PARTIAL_FILE:
-            case CURLE_READ_ERROR:
-            case CURLE_RECV_ERROR:
-            case CURLE_SEND_ERROR:
-            case CURLE_SEND_FAIL_REWIND:
-            case CURLE_SSL_CONNECT_ERROR:
-            case CURLE_UPLOAD_FAILED:
-            case CURLE_WRITE_ERROR:
-                COMMONUTILITIES_ERROR("Reporting network connectivity concerns.\n");
-                break;
-            default:
-                break;
+        if(retryNetworkError(curlcode)) {
+            COMMONUTILITIES_ERROR("Reporting network connectivity concerns.\n");
         }
 
     }
@@ -250,40 +290,46 @@ CURLcode setMtlsHeaders(CURL *curl, MtlsAuth_t *sec) {
 
 /*
  * This is Call back function which is called continuesly at the
- * time of data tranfer. This function will write curl progress data inside file
+ * time of data tranfer. Progress is published at most once per CURL_PROGRESS_INTERVAL_MS
+ * and on completion, into the binary record or the text file.
  * */
 static int xferinfo(void *p, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
     struct curlprogress *myp = (struct curlprogress *) p;
-    //CURL *curl = myp->curl;
-    //curl_off_t curtime = 0;
-    if(myp->prog_store == NULL) {
-        myp->prog_store = stdout;
-    }
-
-    /*curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &curtime);
+    curl_off_t now = (curl_off_t)retryNowMs();
 
-     myp->lastruntime = curtime;
-     fprintf(myp->prog_store, "TOTAL TIME: %lu.%06lu\n",
-     (unsigned long)(curtime / 1000000),
-     (unsigned long)(curtime % 1000000));*/
+    /* Non zero return abort the transfer even when no data is received */
+    if(cancelTokenIsCancelled(myp->cancel)) {
+        COMMONUTILITIES_INFO("xferinfo(): transfer cancelled\n");
+        return 1;
+    }
 
+    if((now - myp->lastruntime) < CURL_PROGRESS_INTERVAL_MS && (dltotal == 0 || dlnow < dltotal)) {
+        return 0;
+    }
+    myp->lastruntime = now;
+    if(myp->publisher != NULL) {
+        progressPublish(myp->publisher, dlnow, dltotal, (unsigned long long)now);
+        if(myp->prog_store == NULL) {
+            return 0;
+        }
+    }
+    /* Record could not be opened, only the cancel check is done */
+    if(myp->prog_store == NULL) {
+        return 0;
+    }
     fprintf(myp->prog_store, "UP: %lu of %lu  DOWN: %lu of %lu\n", (unsigned long) ulnow, (unsigned long) ultotal, (unsigned long) dlnow,
             (unsigned long) dltotal);
     fseek(myp->prog_store, 0, SEEK_SET);
     return 0;
 }
 
-/*
- * This is Call back function which is called continuesly at the
- * time of data tranfer. This function will write requested file data inside file
- * */
-static size_t download_func(void* ptr, size_t size, size_t nmemb, void* stream) {
-    DownloadData* data = stream;
+/* fileWrite(): Write received data to the download file */
+static size_t fileWrite(void* ptr, size_t size, size_t nmemb, DownloadData* data) {
     size_t written;
     /*This logic is use for forcefully stop downlaod when Throttle mode is set to
      * background and throttle speed rfc is set to zero. Here if we return zero curl
      * lib will return 23 error code */
-    if (force_stop == 1) {
+    if (getForceStop() == 1) {
         COMMONUTILITIES_INFO("download_func Stopping Download\n");
         return 0;
     }
@@ -298,20 +344,73 @@ static size_t download_func(void* ptr, size_t size, size_t nmemb, void* stream)
     return written;
 }
 
+/*
+ * This is Call back function which is called continuesly at the
+ * time of data tranfer. This function will write requested file data inside file
+ * */
+static size_t download_func(void* ptr, size_t size, size_t nmemb, void* stream) {
+    /* Total bandwidth cap of the process, returns at once when it is not set */
+    if (bwGovernorConsume(NULL, size * nmemb, forceStopCB, NULL) != 0) {
+        return 0;
+    }
+    return fileWrite(ptr, size, nmemb, stream);
+}
+
+/* memReserve(): Make room for need bytes, NULL terminator included, in a memory download buffer.
+ * Buffer grows geometrically so a large body is copied only O(log n) times.
+ * A buffer taken from an arena already spans the rest of the arena, it is moved to heap when that is not enough.
+ * mem : memory download parameters, NULL if buffer is not from an arena
+ * Return : int : 0 on success, -1 if memory is not available
+ * */
+static int memReserve(DownloadData *pdata, size_t need, memParam_t *mem)
+{
+    size_t newsize;
+    char *ptr;
+
+    if( pdata->pvOut != NULL && need <= pdata->memsize )
+    {
+        return 0;
+    }
+    newsize = (pdata->memsize > MEM_MIN_ALLOC / 2) ? pdata->memsize : MEM_MIN_ALLOC / 2;
+    newsize = (newsize > ((size_t)-1) / 2) ? need : newsize * 2;
+    if( newsize < need )
+    {
+        newsize = need;
+    }
+    COMMONUTILITIES_DEBUG( "memReserve: growing %zu to %zu bytes, pdata->pvOut = 0x%p\n", pdata->memsize, newsize, pdata->pvOut );
+    if( mem != NULL && mem->in_arena )
+    {
+        ptr = malloc( newsize );
+        if( ptr != NULL )
+        {
+            memcpy( ptr, pdata->pvOut, pdata->datasize );
+            mem->in_arena = false;
+        }
+    }
+    else
+    {
+        ptr = realloc( pdata->pvOut, newsize );
+    }
+    if( ptr == NULL )
+    {
+        return -1;
+    }
+    pdata->pvOut = ptr;
+    pdata->memsize = newsize;
+    return 0;
+}
+
 static size_t WriteMemoryCB( void *pvContents, size_t szOneContent, size_t numContentItems, void *userp )
 {
   size_t numBytes = numContentItems * szOneContent;         // num bytes is how big this data block is
   DownloadData* pdata = (DownloadData*)userp;
-  char *ptr;
+  char *ptr = NULL;
 
   if( (pdata->datasize + numBytes) >= pdata->memsize )     // if new data plus what we currently have stored >= current mem alloc
   {
-      COMMONUTILITIES_INFO( "WriteMemoryCB: reallocating %zu bytes, pdata->pvOut = 0x%p\n", pdata->datasize + numBytes + 1, pdata->pvOut );
-      ptr = realloc( pdata->pvOut, pdata->datasize + numBytes + 1 );     // current data size plus new data size plus 1 byte for NULL
-      if( ptr != NULL )
+      if( memReserve( pdata, pdata->datasize + numBytes + 1, NULL ) == 0 )   // current data size plus new data size plus 1 byte for NULL
       {
-          pdata->memsize = pdata->datasize + numBytes + 1;              // memsize now reflects the new allocation
-          pdata->pvOut = ptr;                                           // pvOut is points to reallocation region
+          ptr = (char*)pdata->pvOut;
       }
       else
       {
@@ -334,6 +433,619 @@ static size_t WriteMemoryCB( void *pvContents, size_t szOneContent, size_t numCo
   return numBytes;
 }
 
+/* WriteMemoryCancelCB(): WriteMemoryCB of a request with a cancel token, userp is the MemCancelData_t.
+ * Write fails once the token is cancelled so curl stops with CURLE_WRITE_ERROR */
+static size_t WriteMemoryCancelCB( void *pvContents, size_t szOneContent, size_t numContentItems, void *userp )
+{
+    MemCancelData_t *cancel_data = (MemCancelData_t *)userp;
+
+    if( cancelTokenIsCancelled(cancel_data->cancel) )
+    {
+        return 0;
+    }
+    return WriteMemoryCB(pvContents, szOneContent, numContentItems, cancel_data->data);
+}
+
+/* Below structure use when optional write modes are requested for a download */
+typedef struct dwnlSink {
+    DownloadData *data;
+    WriteBehind_t *wb;          /* write-behind ring, NULL for direct write */
+    StreamDigest_t *digest;     /* digest updated with stored data, NULL if not requested */
+    digestType_t digest_type;
+    ResumeJournal_t *journal;   /* resume journal, NULL if not requested */
+    const char *file;           /* download file the journal belongs to */
+    FILE *headerfile;           /* header dump, NULL if not required */
+    size_t sync_bytes;          /* journal update interval */
+    size_t unsynced;            /* bytes received since last journal update */
+    int http_code;              /* status of the response being received */
+    bool resumed;               /* request sent with If-Range from the journal */
+    bool started;               /* body data received for current response */
+    bool received;              /* body data received by any response */
+    CURL *curl;
+    char *pHeaderData;          /* request header of the caller to keep when If-Range is set */
+    hashParam_t *hashData;      /* request headers to keep when If-Range is set */
+    struct curl_slist *headers; /* If-Range request headers */
+    retryParam_t *retry;        /* retry policy started by this download, ended by closeSink */
+    memParam_t *mem;            /* memory download sizing, NULL for defaults */
+    bool sized;                 /* memory download buffer presized for the response */
+    bool spilling;              /* memory download over budget, body goes to spill_fd */
+    int spill_fd;
+    HeaderMap_t *headerMap;     /* response headers, NULL if not required */
+    HeaderMap_t *own_map;       /* header map created by the sink, freed by closeSink */
+    DownloadData *header_mem;   /* header dump of memory download, NULL if not required */
+    BwGovernor_t *gov;          /* bandwidth governor of the download, NULL if not requested */
+    CancelToken_t *cancel;      /* cancellation of the download, NULL if not requested */
+    bool local;                 /* body served from the content cache, not charged to governors */
+    preallocParam_t *prealloc;  /* reserve space from Content-Length, NULL if not requested */
+    bool prealloc_checked;      /* space checked on first data */
+} DwnlSink_t;
+
+/* fileSinkStop(): File download stop on its token and on setForceStop */
+static int fileSinkStop(void *arg) {
+    DwnlSink_t *sink = arg;
+
+    return (getForceStop() == 1 || cancelTokenIsCancelled(sink->cancel));
+}
+
+/* retryStop(): Retry wait stop on the cancel token given as arg and on setForceStop */
+static int retryStop(void *arg) {
+    return (getForceStop() == 1 || cancelTokenIsCancelled((CancelToken_t *)arg));
+}
+
+/* memSinkStop(): Memory download stop only on its token, setForceStop is for file downloads */
+static int memSinkStop(void *arg) {
+    DwnlSink_t *sink = arg;
+
+    return cancelTokenIsCancelled(sink->cancel);
+}
+
+static StreamDigest_t *rebuildDigest(StreamDigest_t *digest, digestType_t type, FILE *fp, curl_off_t len);
+
+/* journalSync(): Put received data on disk and record its length in the journal */
+static void journalSync(DwnlSink_t *sink) {
+    FILE *fp = (FILE *)sink->data->pvOut;
+    off_t pos;
+
+    sink->unsynced = 0;
+    if (sink->wb != NULL) {
+        writeBehindFlush(sink->wb);
+    }
+    if (fflush(fp) != 0 || fdatasync(fileno(fp)) != 0) {
+        COMMONUTILITIES_ERROR("journalSync(): unable to sync %s, journal not updated\n", sink->file);
+        return;
+    }
+    pos = ftello(fp);
+    if (pos >= 0) {
+        sink->journal->offset = (long long)pos;
+        journalSave(sink->file, sink->journal);
+    }
+}
+
+/* journalStart(): Called on first body data of each response. A 200 answer to a range request
+ * means If-Range did not match, so the old prefix is dropped and the download restart from 0 */
+static void journalStart(DwnlSink_t *sink) {
+    FILE *fp = (FILE *)sink->data->pvOut;
+
+    sink->started = true;
+    sink->received = true;
+    if (sink->http_code == 200 && ftello(fp) > 0) {
+        COMMONUTILITIES_INFO("journalStart(): remote object changed, download %s from start\n", sink->file);
+        fflush(fp);
+        if (fseek(fp, 0, SEEK_SET) != 0 || ftruncate(fileno(fp), 0) != 0) {
+            COMMONUTILITIES_ERROR("journalStart(): unable to truncate %s\n", sink->file);
+        }
+        if (sink->digest != NULL) {
+            sink->digest = rebuildDigest(sink->digest, sink->digest_type, fp, 0);
+        }
+        sink->resumed = false;
+    }
+    /* Validators of this response must be on disk before any data is trusted */
+    journalSync(sink);
+}
+
+/* sinkPreallocate(): Reserve the space of the response on its first data. Without enough free
+ * space no_space is set and the download stops before anything is written */
+static void sinkPreallocate(DwnlSink_t *sink) {
+    FILE *fp = (FILE *)sink->data->pvOut;
+    curl_off_t length = -1;
+    off_t pos;
+
+    sink->prealloc_checked = true;
+    fflush(fp);
+    pos = ftello(fp);
+    if (pos < 0 || curl_easy_getinfo(sink->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) != CURLE_OK) {
+        return;
+    }
+    preallocFile(fileno(fp), sink->file, (long long)pos, (long long)length, sink->prealloc);
+}
+
+/*
+ * This is Call back function used instead of download_func or WriteMemoryCB when a
+ * write-behind or digest is requested. Digest is updated only with the data really stored.
+ * */
+static size_t download_sink_func(void* ptr, size_t size, size_t nmemb, void* stream) {
+    DwnlSink_t *sink = stream;
+    size_t written;
+
+    if (cancelTokenIsCancelled(sink->cancel)) {
+        COMMONUTILITIES_INFO("download_sink_func Download cancelled\n");
+        return 0;
+    }
+    if (!sink->local && bwGovernorConsume(sink->gov, size * nmemb, fileSinkStop, sink) != 0) {
+        return 0;
+    }
+    if (sink->journal != NULL && !sink->started) {
+        journalStart(sink);
+    }
+    if (sink->prealloc != NULL && !sink->prealloc_checked && !sink->local) {
+        sinkPreallocate(sink);
+    }
+    /* Also a retry of the request must not write */
+    if (sink->prealloc != NULL && sink->prealloc->no_space) {
+        return 0;
+    }
+    if (sink->wb != NULL) {
+        written = writeBehindCurlCB(ptr, size, nmemb, sink->wb);
+    } else {
+        written = fileWrite(ptr, size, nmemb, sink->data);
+    }
+    if (sink->digest != NULL && written > 0) {
+        streamDigestUpdate(sink->digest, ptr, written * size);
+    }
+    if (sink->journal != NULL) {
+        sink->unsynced += written * size;
+        if (sink->unsynced >= sink->sync_bytes) {
+            journalSync(sink);
+        }
+    }
+    return written;
+}
+
+/* memArenaTake(): Point a memory download buffer at the free part of the arena */
+static void memArenaTake(memParam_t *mem, DownloadData *pdata) {
+    memArena_t *arena = mem->arena;
+
+    mem->in_arena = false;
+    if (arena->base == NULL || arena->used >= arena->size) {
+        COMMONUTILITIES_INFO("%s: arena is full, using heap\n", __FUNCTION__);
+        pdata->memsize = 0;
+        return;
+    }
+    pdata->pvOut = arena->base + arena->used;
+    pdata->memsize = arena->size - arena->used;
+    mem->in_arena = true;
+}
+
+/* memArenaCommit(): Account the data of a download left in the arena */
+static void memArenaCommit(memParam_t *mem, DownloadData *pdata) {
+    size_t end;
+
+    if (mem == NULL || !mem->in_arena) {
+        return;
+    }
+    end = ((char *)pdata->pvOut - mem->arena->base) + pdata->datasize + 1;
+    end = (end + MEM_ARENA_ALIGN - 1) & ~((size_t)MEM_ARENA_ALIGN - 1);
+    mem->arena->used = (end < mem->arena->size) ? end : mem->arena->size;
+}
+
+/* memPresize(): Reserve the expected body size on first data of a memory download.
+ * size_hint is used when given, else Content-Length of the response, limited to MEM_PRESIZE_MAX
+ * */
+static void memPresize(DwnlSink_t *sink) {
+    curl_off_t content_len = -1;
+    size_t want = 0;
+
+    sink->sized = true;
+    if (sink->mem != NULL && sink->mem->size_hint > 0) {
+        want = sink->mem->size_hint;
+    } else if (sink->curl != NULL && curl_easy_getinfo(sink->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_len) == CURLE_OK && content_len > 0) {
+        want = (size_t)content_len;
+    }
+    if (want > MEM_PRESIZE_MAX) {
+        want = MEM_PRESIZE_MAX;
+    }
+    /* Body over budget is spilled, no memory is reserved for it */
+    if (sink->mem != NULL && sink->mem->budget > 0 && want > sink->mem->budget) {
+        want = 0;
+    }
+    if (want > 0 && memReserve(sink->data, want + 1, sink->mem) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to reserve %zu bytes\n", __FUNCTION__, want);
+    }
+}
+
+static int memWriteAll(int fd, const char *buf, size_t len) {
+    ssize_t ret;
+
+    while (len > 0) {
+        ret = write(fd, buf, len);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            return -1;
+        }
+        buf += ret;
+        len -= (size_t)ret;
+    }
+    return 0;
+}
+
+/* memSpill(): Move buffered body of a memory download to an unlinked file in MEM_SPILL_DIR,
+ * rest of the body is appended to the file
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int memSpill(DwnlSink_t *sink) {
+    char path[] = MEM_SPILL_DIR "/dwnl_spill_XXXXXX";
+    DownloadData *pdata = sink->data;
+    int fd;
+
+    fd = mkstemp(path);
+    if (fd < 0) {
+        COMMONUTILITIES_ERROR("%s: unable to create spill file in %s\n", __FUNCTION__, MEM_SPILL_DIR);
+        return -1;
+    }
+    unlink(path);
+    if (pdata->datasize > 0 && memWriteAll(fd, pdata->pvOut, pdata->datasize) != 0) {
+        COMMONUTILITIES_ERROR("%s: spill file write failed\n", __FUNCTION__);
+        close(fd);
+        return -1;
+    }
+    COMMONUTILITIES_INFO("%s: body over budget %zu bytes, spilling to file\n", __FUNCTION__, sink->mem->budget);
+    if (sink->mem->in_arena) {
+        sink->mem->in_arena = false;
+    } else {
+        free(pdata->pvOut);
+    }
+    pdata->pvOut = NULL;
+    pdata->memsize = 0;
+    sink->spill_fd = fd;
+    sink->spilling = true;
+    return 0;
+}
+
+/* memSpillMap(): Close spill file and give its read only mapping to caller as pDlData->pvOut.
+ * Mapping has a NULL terminator after datasize bytes as the memory buffer has
+ * Return : int : 0 on success, -1 when body is not available
+ * */
+static int memSpillMap(DwnlSink_t *sink) {
+    DownloadData *pdata = sink->data;
+    void *map = MAP_FAILED;
+    char nul = 0;
+
+    if (memWriteAll(sink->spill_fd, &nul, 1) == 0) {
+        map = mmap(NULL, pdata->datasize + 1, PROT_READ, MAP_PRIVATE, sink->spill_fd, 0);
+    }
+    close(sink->spill_fd);
+    sink->spill_fd = -1;
+    sink->spilling = false;
+    if (map == MAP_FAILED) {
+        COMMONUTILITIES_ERROR("%s: unable to map spill file\n", __FUNCTION__);
+        pdata->datasize = 0;
+        if (memReserve(pdata, 1, NULL) == 0) {
+            *((char *)pdata->pvOut) = 0;
+        }
+        return -1;
+    }
+    pdata->pvOut = map;
+    pdata->memsize = pdata->datasize + 1;
+    sink->mem->spilled = true;
+    return 0;
+}
+
+static size_t mem_sink_func(void *pvContents, size_t szOneContent, size_t numContentItems, void *userp) {
+    DwnlSink_t *sink = userp;
+    size_t numBytes = szOneContent * numContentItems;
+
+    if (cancelTokenIsCancelled(sink->cancel)) {
+        COMMONUTILITIES_INFO("mem_sink_func Download cancelled\n");
+        return 0;
+    }
+    if (!sink->local && bwGovernorConsume(sink->gov, numBytes, memSinkStop, sink) != 0) {
+        return 0;
+    }
+    if (!sink->sized) {
+        memPresize(sink);
+    }
+    if (!sink->spilling && sink->mem != NULL && sink->mem->budget > 0
+        && sink->data->datasize + numBytes > sink->mem->budget && memSpill(sink) != 0) {
+        return 0;
+    }
+    if (sink->spilling) {
+        if (memWriteAll(sink->spill_fd, pvContents, numBytes) != 0) {
+            COMMONUTILITIES_ERROR("%s: spill file write failed\n", __FUNCTION__);
+            return 0;
+        }
+        sink->data->datasize += numBytes;
+        if (sink->digest != NULL && numBytes > 0) {
+            streamDigestUpdate(sink->digest, pvContents, numBytes);
+        }
+        return numBytes;
+    }
+    /* Moving out of an arena needs the arena state, WriteMemoryCB would realloc the arena pointer */
+    if (sink->mem != NULL && sink->mem->in_arena && sink->data->datasize + numBytes >= sink->data->memsize
+        && memReserve(sink->data, sink->data->datasize + numBytes + 1, sink->mem) != 0) {
+        COMMONUTILITIES_ERROR("%s: unable to move download out of arena\n", __FUNCTION__);
+        return 0;
+    }
+    numBytes = WriteMemoryCB(pvContents, szOneContent, numContentItems, sink->data);
+    if (sink->digest != NULL && numBytes > 0) {
+        streamDigestUpdate(sink->digest, pvContents, numBytes);
+    }
+    return numBytes;
+}
+
+/* sinkGovernorStart(): Create the bandwidth governor of a download and bind it to the curl handle
+ * so that doInteruptDwnl can change its rate. Without governor the download is not limited */
+static void sinkGovernorStart(DwnlSink_t *sink, CURL *curl, bwParam_t *bw) {
+    if (bw == NULL) {
+        return;
+    }
+    sink->curl = curl;
+    sink->gov = bwGovernorCreate(bw->rate, bw->burst);
+    if (sink->gov != NULL) {
+        bwGovernorAttach(curl, sink->gov);
+    }
+}
+
+/* sinkGovernorEnd(): Unbind and free the bandwidth governor of a download */
+static void sinkGovernorEnd(DwnlSink_t *sink) {
+    if (sink->gov != NULL) {
+        bwGovernorDetach(sink->curl);
+        bwGovernorDestroy(sink->gov);
+        sink->gov = NULL;
+    }
+}
+
+/* cancel_xferinfo(): Progress callback of memory downloads, only used to abort a cancelled transfer */
+static int cancel_xferinfo(void *p, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) {
+    (void)dltotal; (void)dlnow; (void)ultotal; (void)ulnow;
+    return cancelTokenIsCancelled((CancelToken_t *)p) ? 1 : 0;
+}
+
+/* setCancelProgress(): Abort a memory download from the progress callback when token is cancelled,
+ * so that a stalled transfer also ends. NULL token removes the callback, the handle must not keep it */
+static void setCancelProgress(CURL *curl, CancelToken_t *token) {
+    if (token != NULL) {
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, cancel_xferinfo);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, token);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    } else {
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 1L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, NULL);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, NULL);
+    }
+}
+
+/* closeSink(): Stop write-behind, free digest, request headers and own header map and end retry policy of a download */
+static void closeSink(DwnlSink_t *sink) {
+    sinkGovernorEnd(sink);
+    writeBehindClose(sink->wb);
+    sink->wb = NULL;
+    streamDigestDestroy(sink->digest);
+    sink->digest = NULL;
+    if (sink->headers != NULL) {
+        curl_easy_setopt(sink->curl, CURLOPT_HTTPHEADER, NULL);
+        curl_slist_free_all(sink->headers);
+        sink->headers = NULL;
+    }
+    if (sink->retry != NULL) {
+        retryEnd(sink->retry);
+        sink->retry = NULL;
+    }
+    if (sink->own_map != NULL) {
+        if (sink->curl != NULL) {
+            curl_easy_setopt(sink->curl, CURLOPT_HEADERFUNCTION, NULL);
+            curl_easy_setopt(sink->curl, CURLOPT_HEADERDATA, NULL);
+        }
+        headerMapDestroy(sink->own_map);
+        sink->headerMap = NULL;
+        sink->own_map = NULL;
+    }
+}
+
+/* sinkOwnHeaderMap(): Parse response headers in the sink when the content cache or encoding report
+ *                     need them and curl can not give them, curl_easy_header exists since curl 7.83.0
+ * */
+static void sinkOwnHeaderMap(DwnlSink_t *sink, DwnlOptions_t *opts) {
+#if LIBCURL_VERSION_NUM < 0x075300
+    if (sink->headerMap == NULL && (opts->cacheData != NULL || opts->encodingData != NULL)) {
+        sink->own_map = headerMapCreate();
+        sink->headerMap = sink->own_map;
+    }
+#else
+    (void)sink;
+    (void)opts;
+#endif
+}
+
+/* responseHeader(): Copy value of a header of the last response, empty when not present */
+static void responseHeader(CURL *curl, DwnlSink_t *sink, const char *name, char *value, size_t size) {
+#if LIBCURL_VERSION_NUM >= 0x075300
+    struct curl_header *hdr = NULL;
+
+    (void)sink;
+    value[0] = '\0';
+    if (curl_easy_header(curl, name, 0, CURLH_HEADER, -1, &hdr) == CURLHE_OK && hdr != NULL) {
+        snprintf(value, size, "%s", hdr->value);
+    }
+#else
+    const char *hdr = (sink->headerMap != NULL) ? headerMapGet(sink->headerMap, name) : NULL;
+
+    (void)curl;
+    snprintf(value, size, "%s", (hdr != NULL) ? hdr : "");
+#endif
+}
+
+/* finishJournal(): Drop the journal of a complete or unusable download, else record the final offset */
+static void finishJournal(DwnlSink_t *sink, CURLcode curl_code, int http_code) {
+    if (sink->journal == NULL) {
+        return;
+    }
+    if (curl_code == CURLE_OK && (http_code == 200 || http_code == 206)) {
+        journalRemove(sink->file);
+    } else if (curl_code == CURLE_RANGE_ERROR || curl_code == CURLE_BAD_DOWNLOAD_RESUME || http_code == 416) {
+        COMMONUTILITIES_INFO("finishJournal(): resume rejected for %s, journal removed\n", sink->file);
+        journalRemove(sink->file);
+    } else if (sink->received && journalIfRange(sink->journal) != NULL) {
+        journalSync(sink);
+        COMMONUTILITIES_INFO("finishJournal(): %s can resume at %lld\n", sink->file, sink->journal->offset);
+    } else if (!sink->received && !sink->resumed) {
+        /* Nothing received, no validators to keep */
+        journalRemove(sink->file);
+    }
+}
+
+/* rebuildDigest(): Restart the digest with the first len bytes of the file. Only used on resume
+ * Return : StreamDigest_t * : new digest, NULL if the file prefix can not be read
+ * */
+static StreamDigest_t *rebuildDigest(StreamDigest_t *digest, digestType_t type, FILE *fp, curl_off_t len) {
+    streamDigestDestroy(digest);
+    digest = streamDigestCreate(type);
+    if (digest != NULL && streamDigestPrefix(digest, fp, len) != 0) {
+        COMMONUTILITIES_ERROR("rebuildDigest(): unable to read %" CURL_FORMAT_CURL_OFF_T " bytes of file prefix, digest disabled\n", len);
+        streamDigestDestroy(digest);
+        digest = NULL;
+    }
+    return digest;
+}
+
+/* finishDigest(): Store the final digest when the transfer completed, else report no digest */
+static void finishDigest(StreamDigest_t *digest, digestParam_t *out, CURLcode curl_code) {
+    if (out == NULL) {
+        return;
+    }
+    if (digest == NULL || curl_code != CURLE_OK || streamDigestFinal(digest, out) != 0) {
+        out->digest_len = 0;
+        out->digest_hex[0] = '\0';
+    } else {
+        COMMONUTILITIES_INFO("finishDigest(): digest=%s\n", out->digest_hex);
+    }
+}
+
+/* setEncodingOpt(): Request compressed body, curl decodes it before the write callback
+ * Return : CURLcode : CURLE_OK on success
+ * */
+static CURLcode setEncodingOpt(CURL *curl, encodingParam_t *enc) {
+    CURLcode ret_code;
+
+    enc->wire_bytes = 0;
+    enc->decoded_bytes = 0;
+    enc->encoding[0] = '\0';
+    /* Empty string make curl offer all encodings it supports (gzip, deflate, br, zstd) */
+    ret_code = curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, (enc->accept != NULL) ? enc->accept : "");
+    if (ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("setEncodingOpt(): CURLOPT_ACCEPT_ENCODING failed:%s\n", curl_easy_strerror(ret_code));
+    }
+    return ret_code;
+}
+
+/* finishEncoding(): Report wire and decoded size of the body, encoding is switched off again
+ * for the next request on the same handle */
+static void finishEncoding(CURL *curl, DwnlSink_t *sink, encodingParam_t *enc, size_t decoded) {
+    curl_off_t wire = 0;
+
+    if (curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &wire) == CURLE_OK) {
+        enc->wire_bytes = wire;
+    }
+    enc->decoded_bytes = (curl_off_t)decoded;
+    responseHeader(curl, sink, "Content-Encoding", enc->encoding, sizeof(enc->encoding));
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, NULL);
+    COMMONUTILITIES_INFO("finishEncoding(): encoding=%s wire=%" CURL_FORMAT_CURL_OFF_T " decoded=%" CURL_FORMAT_CURL_OFF_T "\n",
+                         (enc->encoding[0] != '\0') ? enc->encoding : "identity", enc->wire_bytes, enc->decoded_bytes);
+}
+
+/* setCacheOpt(): Look up url of a GET download in the content cache and send the validators
+ * of the cached response with the request headers of the download
+ * cache : cacheData of the download
+ * entry : filled with the cached response, to be released with contentCacheRelease when true is returned
+ * Return : bool : true when the request is conditional
+ * */
+static bool setCacheOpt(CURL *curl, DwnlSink_t *sink, FileDwnl_t *pfile_dwnl, cacheParam_t *cache, ContentCacheEntry_t *entry) {
+    struct curl_slist *list = NULL;
+    CURLcode ret_code;
+
+    cache->hit = false;
+    cache->stored = false;
+    if (pfile_dwnl->pPostFields != NULL || contentCacheLookup(pfile_dwnl->url, entry) != 0) {
+        return false;
+    }
+    /* Request headers of the caller are replaced by the list, they are sent again with the validators */
+    if (pfile_dwnl->pHeaderData != NULL && *pfile_dwnl->pHeaderData) {
+        list = curl_slist_append(list, pfile_dwnl->pHeaderData);
+    }
+    if (pfile_dwnl->hashData != NULL && pfile_dwnl->hashData->hashvalue != NULL && pfile_dwnl->hashData->hashtime != NULL) {
+        list = curl_slist_append(list, pfile_dwnl->hashData->hashvalue);
+        list = curl_slist_append(list, pfile_dwnl->hashData->hashtime);
+    }
+    list = contentCacheValidators(entry, list);
+    ret_code = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, list);
+    if (ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("setCacheOpt(): CURLOPT_HTTPHEADER failed:%s\n", curl_easy_strerror(ret_code));
+        curl_slist_free_all(list);
+        contentCacheRelease(entry);
+        return false;
+    }
+    sink->curl = curl;
+    sink->headers = list;
+    return true;
+}
+
+/* serveCached(): Pass the cached body of a 304 response to the write callback of the download as if
+ * the server sent it, so that write-behind, digest and memory budget handle it the same way
+ * write_cb : write callback of the download, userp : its data
+ * Return : int : 0 when the whole body was delivered, -1 otherwise
+ * */
+static int serveCached(ContentCacheEntry_t *entry, DwnlSink_t *sink,
+                       size_t (*write_cb)(void *, size_t, size_t, void *), void *userp) {
+    char *buf = malloc(CONTENT_CACHE_READ_SIZE);
+    long long offset = 0;
+    ssize_t nread = 0;
+
+    if (buf == NULL) {
+        return -1;
+    }
+    sink->local = true;
+    while (offset < entry->size) {
+        nread = contentCacheRead(entry, buf, CONTENT_CACHE_READ_SIZE, offset);
+        if (nread <= 0 || write_cb(buf, 1, (size_t)nread, userp) != (size_t)nread) {
+            break;
+        }
+        offset += nread;
+    }
+    sink->local = false;
+    free(buf);
+    if (offset != entry->size) {
+        COMMONUTILITIES_ERROR("serveCached(): cached body delivered %lld of %lld bytes\n", offset, entry->size);
+        return -1;
+    }
+    COMMONUTILITIES_INFO("serveCached(): not modified, %lld bytes served from cache\n", offset);
+    return 0;
+}
+
+/* storeCached(): Store a complete 200 response in the content cache with its validators
+ * cache : cacheData of the download, stored is set
+ * file : downloaded file, NULL when the body is data and len
+ * */
+static void storeCached(CURL *curl, DwnlSink_t *sink, FileDwnl_t *pfile_dwnl, cacheParam_t *cache, const char *file, const void *data, size_t len) {
+    char etag[CONTENT_CACHE_VALIDATOR_LEN];
+    char last_modified[CONTENT_CACHE_VALIDATOR_LEN];
+    char cache_control[CONTENT_CACHE_VALIDATOR_LEN];
+    int ret;
+
+    responseHeader(curl, sink, "Cache-Control", cache_control, sizeof(cache_control));
+    if (strstr(cache_control, "no-store") != NULL) {
+        return;
+    }
+    responseHeader(curl, sink, "ETag", etag, sizeof(etag));
+    responseHeader(curl, sink, "Last-Modified", last_modified, sizeof(last_modified));
+    if (file != NULL) {
+        ret = contentCacheStoreFile(pfile_dwnl->url, etag, last_modified, file);
+    } else {
+        ret = contentCacheStoreMem(pfile_dwnl->url, etag, last_modified, data, len);
+    }
+    cache->stored = (ret == 0);
+}
+
 /*
  * This is Call back function which is called before data transfer start.
  * Which is stores curl request header data.
@@ -341,13 +1053,234 @@ static size_t WriteMemoryCB( void *pvContents, size_t szOneContent, size_t numCo
 static size_t header_callback(char *buffer, size_t size, size_t nitems, void *userdata) {
     FILE *fp = userdata;
     if(fp != NULL && buffer != NULL) {
-        COMMONUTILITIES_INFO("header_callback():=%s",buffer); // No need to end with new line \n as buffer already has \r\n
+        COMMONUTILITIES_DEBUG("header_callback():=%s",buffer); // No need to end with new line \n as buffer already has \r\n
         fwrite(buffer, nitems, size, fp);
-	fflush(fp);
     }else {
         COMMONUTILITIES_ERROR("Inside header_callback() Invalid file pointer");
     }
-    return nitems * size;
+    return nitems * size;
+}
+
+/*
+ * This is Call back function used instead of header_callback when a resume journal or
+ * header map is kept. Store validators and headers of the response then dump the header
+ * same as header_callback or WriteMemoryCB.
+ * */
+static size_t sink_header_cb(char *buffer, size_t size, size_t nitems, void *userdata) {
+    DwnlSink_t *sink = userdata;
+    size_t len = size * nitems;
+    const char *code;
+
+    if(buffer != NULL && sink->journal != NULL) {
+        if(len > 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+            code = memchr(buffer, ' ', len);
+            sink->http_code = (code != NULL) ? atoi(code + 1) : 0;
+            sink->started = false;
+            /* New response, validators of a redirect or an old object are not valid */
+            if(sink->http_code != 206) {
+                sink->journal->etag[0] = '\0';
+                sink->journal->last_modified[0] = '\0';
+                sink->journal->total_size = -1;
+            }
+        }
+        journalParseHeader(sink->journal, buffer, len, sink->http_code);
+    }
+    if(buffer != NULL && sink->headerMap != NULL) {
+        headerMapAddLine(sink->headerMap, buffer, len);
+    }
+    if(sink->header_mem != NULL) {
+        return WriteMemoryCB(buffer, size, nitems, sink->header_mem);
+    }
+    if(sink->headerfile != NULL) {
+        return header_callback(buffer, size, nitems, sink->headerfile);
+    }
+    return len;
+}
+
+/* setSinkHeaderOpt(): Set header callback keeping the journal and header map of the sink
+ * Return : Type is CURLcode. In case of  Success : CURLE_OK
+ * */
+static CURLcode setSinkHeaderOpt(CURL *curl, DwnlSink_t *sink, FileDwnl_t *pfile_dwnl) {
+    CURLcode ret_code;
+
+    sink->curl = curl;
+    sink->pHeaderData = pfile_dwnl->pHeaderData;
+    sink->hashData = pfile_dwnl->hashData;
+    ret_code = curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, sink_header_cb);
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_HEADERFUNCTION set failed\n");
+        return ret_code;
+    }
+    ret_code = curl_easy_setopt(curl, CURLOPT_HEADERDATA, sink);
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_HEADERDATA set failed\n");
+    }
+    return ret_code;
+}
+
+/* rangeStart(): First byte of a range "<start>-[end]" or "<start>" given to urlHelperDownloadFile
+ * Return : curl_off_t : start, -1 when range is not a valid start or does not fit in curl_off_t
+ * */
+static curl_off_t rangeStart(const char *range) {
+    char *end = NULL;
+    long long start;
+
+    errno = 0;
+    start = strtoll(range, &end, 10);
+    if (end == range || (*end != '-' && *end != '\0') || errno == ERANGE || start < 0) {
+        COMMONUTILITIES_ERROR("rangeStart(): invalid start position %s\n", range);
+        return -1;
+    }
+    return (curl_off_t)start;
+}
+
+/* setIfRangeOpt(): Send If-Range with the current journal validator on a range request so that
+ * the server send the full object with 200 when it has changed. Called before every range request
+ * as a restarted download has new validators.
+ * Return : Type is CURLcode. In case of  Success : CURLE_OK
+ * */
+static CURLcode setIfRangeOpt(DwnlSink_t *sink) {
+    CURLcode ret_code = CURLE_OK;
+    const char *validator = journalIfRange(sink->journal);
+    char if_range[JOURNAL_VALIDATOR_LEN + 16];
+
+    if(validator == NULL) {
+        return ret_code;
+    }
+    if(sink->headers != NULL) {
+        curl_easy_setopt(sink->curl, CURLOPT_HTTPHEADER, NULL);
+        curl_slist_free_all(sink->headers);
+        sink->headers = NULL;
+    }
+    /* Request headers of the caller are replaced by the list, they are sent again with If-Range */
+    if(sink->pHeaderData != NULL && *sink->pHeaderData) {
+        sink->headers = curl_slist_append(sink->headers, sink->pHeaderData);
+    }
+    snprintf(if_range, sizeof(if_range), "If-Range: %s", validator);
+    sink->headers = curl_slist_append(sink->headers, if_range);
+    if(sink->hashData != NULL && sink->hashData->hashvalue != NULL && sink->hashData->hashtime != NULL) {
+        sink->headers = curl_slist_append(sink->headers, sink->hashData->hashvalue);
+        sink->headers = curl_slist_append(sink->headers, sink->hashData->hashtime);
+    }
+    ret_code = curl_easy_setopt(sink->curl, CURLOPT_HTTPHEADER, sink->headers);
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_HTTPHEADER failed:%s\n", curl_easy_strerror(ret_code));
+    }
+    return ret_code;
+}
+
+/* setFileWriteOpt(): Set the write callback used by urlHelperDownloadFile on a curl object
+ *                    so that other transfer drivers store data the same way
+ * curl : curl object
+ * data : DownloadData with pvOut holding an open FILE pointer
+ * headerfile : Header dump file, NULL to skip header dump
+ * Return : Type is CURLcode. In case of  Success : CURLE_OK
+ * */
+CURLcode setFileWriteOpt(CURL *curl, DownloadData *data, FILE *headerfile) {
+    CURLcode ret_code = -1;
+
+    if(curl == NULL || data == NULL || data->pvOut == NULL) {
+        COMMONUTILITIES_ERROR("setFileWriteOpt(): parameter is NULL\n");
+        return ret_code;
+    }
+    if(headerfile != NULL) {
+        ret_code = curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+        if(ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("CURL: CURLOPT_HEADERFUNCTION set failed\n");
+            return ret_code;
+        }
+        ret_code = curl_easy_setopt(curl, CURLOPT_HEADERDATA, headerfile);
+        if(ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("CURL: CURLOPT_HEADERDATA set failed\n");
+            return ret_code;
+        }
+    }
+    ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, download_func);
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_WRITEFUNCTION failed\n");
+        return ret_code;
+    }
+    ret_code = curl_easy_setopt(curl, CURLOPT_WRITEDATA, data);
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_WRITEDATA failed\n");
+    }
+    return ret_code;
+}
+
+/* setMemWriteOpt(): Set the write callbacks used by urlHelperDownloadToMem on a curl object
+ * curl : curl object
+ * pfile_dwnl : pDlData receive the body, pDlHeaderData receive header if not NULL.
+ * cancel_data : With a cancel token the body write to cancel_data->data stops once it is cancelled,
+ *               cancel_data must stay valid till the transfer ended. NULL to write pDlData without a token
+ * Return : Type is CURLcode. In case of  Success : CURLE_OK
+ * */
+CURLcode setMemWriteOpt(CURL *curl, FileDwnl_t *pfile_dwnl, MemCancelData_t *cancel_data) {
+    CURLcode ret_code = -1;
+
+    if(curl == NULL || pfile_dwnl == NULL || pfile_dwnl->pDlData == NULL) {
+        COMMONUTILITIES_ERROR("setMemWriteOpt(): parameter is NULL\n");
+        return ret_code;
+    }
+    if(pfile_dwnl->pDlHeaderData != NULL) {
+        ret_code = curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, WriteMemoryCB);
+        if(ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("CURL: CURLOPT_HEADERFUNCTION set failed\n");
+            return ret_code;
+        }
+        ret_code = curl_easy_setopt(curl, CURLOPT_HEADERDATA, pfile_dwnl->pDlHeaderData);
+        if(ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("CURL: CURLOPT_HEADERDATA set failed\n");
+            return ret_code;
+        }
+    }
+    if(cancel_data != NULL) {
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCancelCB);
+    }else {
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCB);
+    }
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_WRITEFUNCTION failed\n");
+        return ret_code;
+    }
+    if(cancel_data != NULL) {
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEDATA, cancel_data);
+    }else {
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEDATA, pfile_dwnl->pDlData);
+    }
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_WRITEDATA failed\n");
+    }
+    return ret_code;
+}
+
+/* setHeadRequestOpt(): Set url, tls, timeouts and mtls options of a header request
+ * Return : Type is CURLcode. In case of  Success : CURLE_OK
+ * */
+static CURLcode setHeadRequestOpt(CURL *curl, const char *url, MtlsAuth_t *sec) {
+    CURLcode ret_code;
+
+    ret_code = curl_easy_setopt(curl, CURLOPT_URL, url);
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: url set failed\n");
+        return ret_code;
+    }
+    ret_code = curl_easy_setopt(curl, CURLOPT_SSLVERSION, TLSVERSION);
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_SSLVERSION set failed\n");
+        return ret_code;
+    }
+    ret_code = curl_easy_setopt(curl, CURLOPT_TIMEOUT, 600L); //CURL_TLS_TIMEOUT = 600L - 10Min
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_TIMEOUT set failed\n");
+    }
+    ret_code = curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L); // connection timeout 30s
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: CURLOPT_CONNECTTIMEOUT set failed\n");
+    }
+    if(sec != NULL) {
+        setMtlsHeaders(curl, sec);
+    }
+    return CURLE_OK;
 }
 
 /* urlHelperGetHeaderInfo(): Used for get curl request header data
@@ -370,29 +1303,11 @@ int urlHelperGetHeaderInfo(const char* url, MtlsAuth_t *sec, const char* pathnam
     }
     curl = urlHelperCreateCurl();
     if(curl) {
-        ret_code = curl_easy_setopt(curl, CURLOPT_URL, url);
-        if(ret_code != CURLE_OK) {
-            COMMONUTILITIES_ERROR("CURL: url set failed\n");
-            urlHelperDestroyCurl(curl);
-            return ret_code;
-        }
-        ret_code = curl_easy_setopt(curl, CURLOPT_SSLVERSION, TLSVERSION);
+        ret_code = setHeadRequestOpt(curl, url, sec);
         if(ret_code != CURLE_OK) {
-            COMMONUTILITIES_ERROR("CURL: CURLOPT_SSLVERSION set failed\n");
             urlHelperDestroyCurl(curl);
             return ret_code;
         }
-        ret_code = curl_easy_setopt(curl, CURLOPT_TIMEOUT, 600L); //CURL_TLS_TIMEOUT = 600L - 10Min
-	if(ret_code != CURLE_OK) {
-            COMMONUTILITIES_ERROR("CURL: CURLOPT_TIMEOUT set failed\n");
-	}
-        ret_code = curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L); // connection timeout 30s
-	if(ret_code != CURLE_OK) {
-            COMMONUTILITIES_ERROR("CURL: CURLOPT_CONNECTTIMEOUT set failed\n");
-	}
-        if(sec != NULL) {
-            setMtlsHeaders(curl, sec);
-        }
         headerfile = fopen(pathname, "w");
         if(headerfile == NULL) {
             COMMONUTILITIES_ERROR("CURL: path=%s file unable to open\n", pathname);
@@ -426,25 +1341,52 @@ int urlHelperGetHeaderInfo(const char* url, MtlsAuth_t *sec, const char* pathnam
     }
     return 0;
 }
-/* setCommonCurlOpt(): Use for set curl option
+
+int urlHelperGetHeaderMap(const char* url, MtlsAuth_t *sec, HeaderMap_t *map, int* httpCode_ret_status, int *curl_ret_status) {
+    CURLcode ret_code = CURLE_OK;
+    CURL *curl;
+
+    if(url == NULL || httpCode_ret_status == NULL || map == NULL || curl_ret_status == NULL) {
+        COMMONUTILITIES_ERROR("urlHelperGetHeaderMap(): parameter is NULL\n");
+        return -1;
+    }
+    headerMapClear(map);
+    curl = urlHelperCreateCurl();
+    if(curl) {
+        ret_code = setHeadRequestOpt(curl, url, sec);
+        if(ret_code != CURLE_OK) {
+            urlHelperDestroyCurl(curl);
+            return ret_code;
+        }
+        ret_code = curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerMapCurlCB);
+        if(ret_code == CURLE_OK) {
+            ret_code = curl_easy_setopt(curl, CURLOPT_HEADERDATA, map);
+        }
+        if(ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("CURL: CURLOPT_HEADERFUNCTION set failed\n");
+            urlHelperDestroyCurl(curl);
+            return ret_code;
+        }
+        ret_code = curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+	if(ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("CURL: CURLOPT_NOBODY set failed\n");
+	}
+        *httpCode_ret_status = performRequest(curl, (CURLcode *)curl_ret_status); // Sending curl request
+        urlHelperDestroyCurl(curl);
+    }
+    return 0;
+}
+/* setCommonCurlBaseOpt(): Use for set curl options which do not depend on the url
  * curl : curl object
- * url: Server url
+ * sslverify : check OCSP status of the server certificate
  * Return : Type is CURLcode. In case of  Success : CURLE_OK
  *                              Failure case -1
  * */
-CURLcode setCommonCurlOpt(CURL *curl, const char *url, char *pPostFields, bool sslverify) {
+CURLcode setCommonCurlBaseOpt(CURL *curl, bool sslverify) {
     CURLcode ret_code = -1;
 
-    if(curl == NULL || url == NULL) {
-        COMMONUTILITIES_ERROR("setCommonCurlOpt(): curl parameter is NULL\n");
-        return ret_code;
-    }
-#ifdef CURL_DEBUG
-    COMMONUTILITIES_INFO("CURL: Going to set url: %s\n", url);
-#endif
-    ret_code = curl_easy_setopt(curl, CURLOPT_URL, url);
-    if(ret_code != CURLE_OK) {
-        COMMONUTILITIES_ERROR("CURL: url set failed\n");
+    if(curl == NULL) {
+        COMMONUTILITIES_ERROR("setCommonCurlBaseOpt(): curl parameter is NULL\n");
         return ret_code;
     }
     ret_code = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
@@ -489,6 +1431,42 @@ CURLcode setCommonCurlOpt(CURL *curl, const char *url, char *pPostFields, bool s
     if (ret_code != CURLE_OK) {
 	COMMONUTILITIES_ERROR( "CURL: CURLOPT_TCP_KEEPINTVL failed msg:%s\n", curl_easy_strerror(ret_code));
     }
+    return CURLE_OK;
+}
+
+/* setCommonCurlOpt(): Use for set curl option
+ * curl : curl object
+ * url: Server url
+ * Return : Type is CURLcode. In case of  Success : CURLE_OK
+ *                              Failure case -1
+ * */
+CURLcode setCommonCurlOpt(CURL *curl, const char *url, char *pPostFields, bool sslverify) {
+    CURLcode ret_code = -1;
+
+    if(curl == NULL || url == NULL) {
+        COMMONUTILITIES_ERROR("setCommonCurlOpt(): curl parameter is NULL\n");
+        return ret_code;
+    }
+#ifdef CURL_DEBUG
+    COMMONUTILITIES_INFO("CURL: Going to set url: %s\n", url);
+#endif
+    ret_code = curl_easy_setopt(curl, CURLOPT_URL, url);
+    if(ret_code != CURLE_OK) {
+        COMMONUTILITIES_ERROR("CURL: url set failed\n");
+        return ret_code;
+    }
+    /* Cached addresses of the host take DNS out of the request, curl resolves when none are fresh */
+    dnsCacheApply(curl, url);
+    ret_code = setCommonCurlBaseOpt(curl, sslverify);
+    if(ret_code != CURLE_OK) {
+        return ret_code;
+    }
+    /* Resume TLS sessions of earlier processes when persistent sessions are enabled */
+    if (tlsSessionCacheEnabled()) {
+        tlsSessionCacheSetopt(curl, url);
+    }
+    /* HTTP/2 with HTTP/1.1 fallback when the pool runs in HTTP/2 mode */
+    curlPoolSetHttpVersion(curl);
 
     if( pPostFields != NULL )
     {
@@ -528,21 +1506,36 @@ CURLcode setCurlDebugOpt(CURL *curl, DbgData_t *debug)
 /* setCurlProgress(): Use for save curl progress data
  * curl : curl object
  * curl_progress: This is the structer which contains file name to store
- * 		  curl progress.
+ * 		  curl progress. Binary record by default, text file with CURL_PROGRESS_TEXT
+ * 		  Callback is installed even when the record can not be opened so that
+ * 		  cancellation is still checked, only the record update is skipped.
  * Return : Type is CURLcode. In case of  Success : CURLE_OK
  * 				Failure case -1
  * */
 CURLcode setCurlProgress(CURL *curl, struct curlprogress *curl_progress) {
     CURLcode ret_code = -1;
+    CURLcode record_code = CURLE_OK;
     if(curl == NULL || curl_progress == NULL) {
         COMMONUTILITIES_INFO("setCurlProgress(): curl parameter is NULL\n");
         return ret_code;
     }
+    curl_progress->lastruntime = 0;
+    curl_progress->publisher = NULL;
+    curl_progress->cancel = NULL;
+#ifdef CURL_PROGRESS_TEXT
     curl_progress->prog_store = fopen(CURL_PROGRESS_FILE, "w");
     if(curl_progress->prog_store == NULL) {
         COMMONUTILITIES_ERROR("CURL:Failed to open %s file\n", CURL_PROGRESS_FILE);
-        return ret_code;
+        record_code = -1;
+    }
+#else
+    curl_progress->prog_store = NULL;
+    curl_progress->publisher = progressOpen(CURL_PROGRESS_RECORD);
+    if(curl_progress->publisher == NULL) {
+        COMMONUTILITIES_ERROR("CURL:Failed to open %s file\n", CURL_PROGRESS_RECORD);
+        record_code = -1;
     }
+#endif
     ret_code = curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, xferinfo);
     if(ret_code != CURLE_OK) {
         COMMONUTILITIES_ERROR("CURL: CURLOPT_XFERINFOFUNCTION failed\n");
@@ -556,7 +1549,7 @@ CURLcode setCurlProgress(CURL *curl, struct curlprogress *curl_progress) {
     if(ret_code != CURLE_OK) {
         COMMONUTILITIES_ERROR("CURL: CURLOPT_NOPROGRESS failed\n");
     }
-    ret_code = CURLE_OK;
+    ret_code = record_code;
     return ret_code;
 }
 
@@ -598,6 +1591,10 @@ void closeFile(DownloadData *data, struct curlprogress *prog, FILE *fp)
 		COMMONUTILITIES_INFO( "CURL: CLOSE Curl Progress Bar file\n");
 		fclose(prog->prog_store);
 	}
+	if ((prog != NULL) && (prog->publisher != NULL)) {
+		progressClose(prog->publisher);
+		prog->publisher = NULL;
+	}
 	if (fp != NULL) {
 		COMMONUTILITIES_INFO( "CURL: CLOSE Header Dump file\n");
 		fclose(fp);
@@ -613,12 +1610,91 @@ void closeFile(DownloadData *data, struct curlprogress *prog, FILE *fp)
  * */
 size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos, int chunk_dwnl_retry_time, 
     int *httpCode_ret_status, CURLcode *curl_ret_status) {
+    return downloadFileCommon(curl, file, dnl_start_pos, chunk_dwnl_retry_time, NULL, NULL, httpCode_ret_status, curl_ret_status);
+}
+
+/* urlHelperDownloadFileEx(): Use for download a file with the optional modes of opts
+ * curl : Curl Object
+ * pfile_dwnl : Request descriptor which contains download path
+ * opts : Optional download modes, NULL for none
+ * dnl_start_pos : Use for chunk Download if it is NULL in that case request is Full Downlaod
+ * httpCode_ret_status : Send back http status.
+ * curl_ret_status : Send back curl status
+ * Return Type size_t : Return no of bytes downloaded.
+ * */
+size_t urlHelperDownloadFileEx(CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, char *dnl_start_pos,
+    int *httpCode_ret_status, CURLcode *curl_ret_status) {
+    DwnlOptions_t no_opts;
+    size_t len;
+    bool stats_owner;
+    bool retry_owner;
+    int attempts;
+    int retry_delay;
+    unsigned long long attempt_start;
+
+    if(pfile_dwnl == NULL) {
+        COMMONUTILITIES_ERROR("urlHelperDownloadFileEx(): parameter is NULL\n");
+        return 0;
+    }
+    if(opts == NULL) {
+        memset(&no_opts, 0, sizeof(no_opts));
+        opts = &no_opts;
+    }
+    retry_owner = retryBegin(opts->retryData);
+    stats_owner = transferStatsBegin(curl, opts->statsData, opts->retryData);
+    while(1) {
+        attempts = (opts->retryData != NULL) ? opts->retryData->attempts : 0;
+        attempt_start = retryNowMs();
+        len = downloadFileCommon(curl, pfile_dwnl->pathname, dnl_start_pos, pfile_dwnl->chunk_dwnl_retry_time,
+                                 pfile_dwnl, opts, httpCode_ret_status, curl_ret_status);
+        if(!retry_owner || httpCode_ret_status == NULL || curl_ret_status == NULL) {
+            break;
+        }
+        retry_delay = retryAgain(opts, attempts, attempt_start, *curl_ret_status, *httpCode_ret_status);
+        if(retry_delay < 0 || retryWait((unsigned int)retry_delay, retryStop, opts->cancel) != 0) {
+            break;
+        }
+    }
+    if(retry_owner) {
+        retryEnd(opts->retryData);
+    }
+    if(stats_owner) {
+        transferStatsEnd(curl);
+    }
+    return len;
+}
+
+/* retryAgain(): Decide on a new attempt of a transfer which started its retry policy
+ * attempts : attempts of the policy before the transfer
+ * attempt_start : retryNowMs() at start of the transfer
+ * Return : int : wait in milliseconds, -1 when no retry must be done
+ * */
+static int retryAgain(DwnlOptions_t *opts, int attempts, unsigned long long attempt_start,
+    CURLcode curl_code, int http_code) {
+    /* Chunk download apply the policy itself, attempts are already recorded */
+    if(opts->retryData->attempts != attempts) {
+        return -1;
+    }
+    if(cancelTokenIsCancelled(opts->cancel)) {
+        COMMONUTILITIES_INFO("retryAgain(): transfer cancelled, no retry\n");
+        return -1;
+    }
+    return retryNext(opts->retryData, curl_code, http_code, (unsigned int)(retryNowMs() - attempt_start));
+}
+
+/* downloadFileCommon(): Download engine shared by urlHelperDownloadFile and urlHelperDownloadFileEx
+ * pfile_dwnl : Request descriptor, NULL for a plain download
+ * opts : Optional download modes, only given with pfile_dwnl. NULL for none
+ * Other parameters are same as urlHelperDownloadFile
+ * */
+static size_t downloadFileCommon(CURL *curl, const char *file, char *dnl_start_pos, int chunk_dwnl_retry_time,
+    FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status) {
 
     DownloadData data;
     DownloadData *pData = &data;
     struct curlprogress prog; // Use for store curl progress
     data.datasize = 0;
-    int seek_place = 0;
+    curl_off_t seek_place = 0;
     int retry = 2;
     char file_pt_pos[32] = { 0 };
     char file_open_mode[6] = { 0 };
@@ -626,7 +1702,33 @@ size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos,
     CURLcode ret_code = -1;
     FILE *headerfile = NULL;
     char header_dump[128];
-
+    DwnlSink_t sink;
+    DwnlOptions_t no_opts;
+    digestParam_t *digestData;
+    ResumeJournal_t journal;
+    char journal_pos[32];
+    long long journal_offset = 0;
+    retryParam_t *rp;
+    headerParam_t *headerData;
+    unsigned long long attempt_start = 0;
+    int retry_delay = -1;
+    ContentCacheEntry_t cache_entry;
+    bool cached = false;
+
+    if(opts == NULL) {
+        memset(&no_opts, 0, sizeof(no_opts));
+        opts = &no_opts;
+    }
+    digestData = opts->digestData;
+    rp = opts->retryData;
+    headerData = opts->headerData;
+    memset(&sink, 0, sizeof(sink));
+    sink.data = pData;
+    sink.cancel = opts->cancel;
+    if(headerData != NULL) {
+        sink.headerMap = headerData->map;
+        headerMapClear(sink.headerMap);
+    }
     if(curl == NULL || file == NULL || httpCode_ret_status == NULL || curl_ret_status == NULL) {
         COMMONUTILITIES_ERROR("urlHelperDownloadFile(): pathname not present or parameter is NULL\n");
         return 0;
@@ -634,6 +1736,74 @@ size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos,
         COMMONUTILITIES_INFO("urlHelperDownloadFile(): pathname:%s\n", file);
     }
 
+    /* Extract mode sends the archive straight to its output directory, file is not written.
+     * When the directory can not be used the archive is stored at file as before */
+    if(dnl_start_pos == NULL && opts->extractData != NULL) {
+        size_t extract_bytes = 0;
+        if(extractDownloadFile(curl, file, opts->extractData, digestData, sink.cancel, &extract_bytes,
+                               httpCode_ret_status, curl_ret_status) == EXTRACT_DWNL_DONE) {
+            return extract_bytes;
+        }
+        COMMONUTILITIES_INFO("urlHelperDownloadFile(): extraction not possible, store the archive\n");
+    }
+
+    /* Resume journal: when the caller did not give a start position the verified prefix
+     * recorded in the journal is used. Data after it is dropped as it may not be complete */
+    if(opts->journalData != NULL) {
+        sink.journal = &journal;
+        sink.file = file;
+        sink.sync_bytes = (opts->journalData->sync_bytes > 0) ? opts->journalData->sync_bytes : JOURNAL_SYNC_BYTES;
+        if(dnl_start_pos == NULL) {
+            journal_offset = journalResumeOffset(file, pfile_dwnl->url, &journal);
+        }
+        if(journal_offset > 0 && truncate(file, journal_offset) == 0) {
+            snprintf(journal_pos, sizeof(journal_pos), "%lld-", journal_offset);
+            dnl_start_pos = journal_pos;
+            sink.resumed = true;
+        }else {
+            journalInit(&journal, pfile_dwnl->url);
+        }
+    }
+
+    /* Delta mode builds the file from a seed and fetches only changed blocks. When there is
+     * no manifest, nothing to reuse or the result does not verify, a full download follows */
+    if(dnl_start_pos == NULL && opts->deltaData != NULL && opts->bwData == NULL
+       && opts->cacheData == NULL) {
+        size_t delta_bytes = 0;
+        if(deltaDownloadFile(curl, file, opts->deltaData, digestData, sink.cancel, &delta_bytes, httpCode_ret_status,
+                             curl_ret_status) == DELTA_DWNL_DONE) {
+            if(sink.journal != NULL) {
+                journalRemove(file);
+            }
+            return delta_bytes;
+        }
+        COMMONUTILITIES_INFO("urlHelperDownloadFile(): delta download not possible, use full download\n");
+    }
+
+    /* Segmented mode only applies to full downloads. When the server does not allow it
+     * we continue below with the single stream download. A governed or cached download is not split */
+    if(dnl_start_pos == NULL && opts->segmentData != NULL && opts->bwData == NULL
+       && opts->cacheData == NULL) {
+        size_t seg_bytes = 0;
+        if(segmentedDownloadFile(curl, file, opts->segmentData, headerData, sink.cancel, opts->preallocData,
+                                 &seg_bytes, httpCode_ret_status, curl_ret_status) == SEGMENT_DWNL_DONE) {
+            /* MD5 and SHA-256 only take data in file order, while the ranges are written concurrently
+             * at their own offsets. The sink can not update the digest, so it is taken from the
+             * stored file once every range is written */
+            if(digestData != NULL) {
+                if(*curl_ret_status != CURLE_OK || streamDigestFile(file, digestData) != 0) {
+                    digestData->digest_len = 0;
+                    digestData->digest_hex[0] = '\0';
+                }
+            }
+            if(sink.journal != NULL) {
+                journalRemove(file);
+            }
+            return seg_bytes;
+        }
+        COMMONUTILITIES_INFO("urlHelperDownloadFile(): segmented download not possible, use single stream\n");
+    }
+
     if(dnl_start_pos == NULL) {
         strncpy(file_open_mode, "wb", sizeof(file_open_mode) - 1);
     }else {
@@ -648,8 +1818,8 @@ size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos,
     }
     /*If the download request is not chunk download then dump header information to separate file
      * if the request is chunkdownload then already header information file is present so no need to dump
-     * again header information */
-    if (dnl_start_pos == NULL) {
+     * again header information. With a header map the file is written only when requested */
+    if (dnl_start_pos == NULL && (headerData == NULL || headerData->dump_file)) {
         snprintf(header_dump, sizeof(header_dump), "%s.header", file);
         COMMONUTILITIES_INFO("urlHelperDownloadFile(): Dump header info to file:%s\n", header_dump);
         headerfile = fopen(header_dump, "w");
@@ -672,32 +1842,80 @@ size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos,
             return ret_code;
         }
     }
-    ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, download_func);
+    /* With write-behind the callback only copy data and a separate thread write the file.
+     * On failure to start the writer the download continue with direct writes */
+    if(opts->writeBehind != NULL) {
+        sink.wb = writeBehindCreate(pData, opts->writeBehind);
+    }
+    if(digestData != NULL) {
+        sink.digest_type = digestData->type;
+        sink.digest = streamDigestCreate(digestData->type);
+    }
+    sinkGovernorStart(&sink, curl, opts->bwData);
+    if(opts->preallocData != NULL) {
+        sink.prealloc = opts->preallocData;
+        sink.prealloc->reserved = 0;
+        sink.prealloc->no_space = false;
+        sink.file = file;
+        sink.curl = curl;
+    }
+    sinkOwnHeaderMap(&sink, opts);
+    if(sink.journal != NULL || sink.headerMap != NULL) {
+        sink.headerfile = headerfile;
+        ret_code = setSinkHeaderOpt(curl, &sink, pfile_dwnl);
+        if(ret_code != CURLE_OK) {
+            closeSink(&sink);
+            closeFile(pData, NULL, headerfile);
+            return ret_code;
+        }
+    }
+    if(sink.wb != NULL || sink.digest != NULL || sink.journal != NULL || sink.gov != NULL || sink.cancel != NULL || sink.prealloc != NULL) {
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, download_sink_func);
+    }else {
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, download_func);
+    }
     if(ret_code != CURLE_OK) {
         COMMONUTILITIES_INFO("CURL: CURLOPT_WRITEFUNCTION failed\n");
+        closeSink(&sink);
         closeFile(pData, NULL, headerfile);
         return ret_code;
     }
-    ret_code = curl_easy_setopt(curl, CURLOPT_WRITEDATA, pData);
+    if(sink.wb != NULL || sink.digest != NULL || sink.journal != NULL || sink.gov != NULL || sink.cancel != NULL || sink.prealloc != NULL) {
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+    }else {
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEDATA, pData);
+    }
     if(ret_code != CURLE_OK) {
         COMMONUTILITIES_INFO("CURL: CURLOPT_WRITEDATA failed\n");
+        closeSink(&sink);
         closeFile(pData, NULL, headerfile);
         return ret_code;
     }
+    /* A full download is made conditional when the content cache has the url */
+    if(dnl_start_pos == NULL && opts->cacheData != NULL) {
+        cached = setCacheOpt(curl, &sink, pfile_dwnl, opts->cacheData, &cache_entry);
+    }
     ret_code = setCurlProgress(curl, &prog);
     if(ret_code != CURLE_OK) {
         COMMONUTILITIES_ERROR("CURL: Unable to set curl progress\n");
     }
+    prog.cancel = sink.cancel;
     /* Below block is used for chunk download */
     if(dnl_start_pos != NULL) {
-        seek_place = atoi(dnl_start_pos);
-        COMMONUTILITIES_INFO("CURL: Chunk Download Operation Start=%d\n", seek_place);
+        /* An invalid start position gives -1, which is answered with curl 33 below */
+        seek_place = rangeStart(dnl_start_pos);
+        COMMONUTILITIES_INFO("CURL: Chunk Download Operation Start=%" CURL_FORMAT_CURL_OFF_T "\n", seek_place);
         strncpy(file_pt_pos, dnl_start_pos, sizeof(file_pt_pos)-1);
+        /* With a retry policy its attempts and waits replace the fixed retry count and sleep */
+        if(retryBegin(rp)) {
+            sink.retry = rp;
+        }
         while(retry) {
-            COMMONUTILITIES_INFO("CURL: file seek position=%d chunk start %s and %s\n", seek_place, dnl_start_pos, file_pt_pos);
+            COMMONUTILITIES_INFO("CURL: file seek position=%" CURL_FORMAT_CURL_OFF_T " chunk start %s and %s\n", seek_place, dnl_start_pos, file_pt_pos);
             ret_code = curl_easy_setopt(curl, CURLOPT_RANGE, file_pt_pos);
             	if(ret_code != CURLE_OK) {
                     COMMONUTILITIES_ERROR("CURL: CURLOPT_RANGE failed msg:%s\n", curl_easy_strerror(ret_code));
+		    closeSink(&sink);
 		    closeFile(pData, &prog, headerfile);
 		    return ret_code;
                 }else {
@@ -705,43 +1923,65 @@ size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos,
 		    {
                         *httpCode_ret_status = 0;
 			*curl_ret_status = 33;
+			closeSink(&sink);
 			closeFile(pData, &prog, headerfile);
 			return CURLE_OK;
 		    }
-		    seek_ret = fseek((FILE*)data.pvOut, seek_place, SEEK_SET);
+		    /* Digest must cover the bytes already present in the file before the range */
+		    if(sink.digest != NULL) {
+		        sink.digest = rebuildDigest(sink.digest, digestData->type, (FILE*)data.pvOut, seek_place);
+		    }
+		    if(sink.journal != NULL) {
+		        setIfRangeOpt(&sink);
+		    }
+		    seek_ret = fseeko((FILE*)data.pvOut, (off_t)seek_place, SEEK_SET);
 		    if (seek_ret != 0) {
 		    /* If file pointer seek fail return curl 33 error so
 		     * full download should trigger */
 			COMMONUTILITIES_ERROR( "CURL: fseek failed ret=%d\n", seek_ret);
 			*httpCode_ret_status = 0;
 			*curl_ret_status = 33;
+			closeSink(&sink);
 			closeFile(pData, &prog, headerfile);
 			return 0;
 		     }
                 }
+                attempt_start = retryNowMs();
                 *httpCode_ret_status = performRequest(curl, curl_ret_status);
+                /* ftell below must see every received byte */
+                writeBehindFlush(sink.wb);
+                if(rp != NULL) {
+                    retry_delay = retryNext(rp, *curl_ret_status, *httpCode_ret_status, (unsigned int)(retryNowMs() - attempt_start));
+                }
                  if((*curl_ret_status == 18) || (*curl_ret_status == 28) || (*curl_ret_status == 56)) {
                      seek_place = 0;
-                     seek_place = ftell((FILE*)data.pvOut);
+                     seek_place = (curl_off_t)ftello((FILE*)data.pvOut);
 		     if( seek_place < 0)
 		     {
 		         COMMONUTILITIES_ERROR( "Invalid Usage, parameter seek_place being negative \n");
 			 *httpCode_ret_status = 0;
 			 *curl_ret_status = 33;
+			 closeSink(&sink);
 			 closeFile(pData, &prog, headerfile);
                          return CURLE_OK;
 		     }
                      memset(file_pt_pos, '\0', sizeof(file_pt_pos));
-		     sprintf(file_pt_pos, "%d-", seek_place);
+		     snprintf(file_pt_pos, sizeof(file_pt_pos), "%" CURL_FORMAT_CURL_OFF_T "-", seek_place);
                  }else if ((*curl_ret_status == 33) || (*curl_ret_status == 36)) {
 		     COMMONUTILITIES_ERROR( "CURL: Received curl error=%d and go for full Download\n",*curl_ret_status);
 		     break;	
 		 } else if((*curl_ret_status == 0) && ((*httpCode_ret_status == 206) || (*httpCode_ret_status == 200))) {
                      COMMONUTILITIES_INFO("CURL: File Download Done curl ret=%d and http=%d\n", *curl_ret_status, *httpCode_ret_status);
                      break;
-                 }else {
+                 }else if(rp == NULL) {
                       retry--;
                  }
+                 if(rp != NULL) {
+                     if(retry_delay < 0 || retryWait((unsigned int)retry_delay, retryStop, sink.cancel) != 0) {
+                         break;
+                     }
+                     continue;
+                 }
                  if(chunk_dwnl_retry_time != 0) {
                      COMMONUTILITIES_INFO("CURL: Reboot flag is false. So Go to sleep For =%d sec\n", chunk_dwnl_retry_time);
                      sleep(chunk_dwnl_retry_time);
@@ -751,18 +1991,46 @@ size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos,
     }else {
         COMMONUTILITIES_INFO("CURL:Download Operation Start\n");
         *httpCode_ret_status = performRequest(curl, curl_ret_status); // Sending curl request
+        if(cached && *curl_ret_status == CURLE_OK && *httpCode_ret_status == 304) {
+            /* Without optional modes the sink only passes the data to fileWrite */
+            if(serveCached(&cache_entry, &sink, download_sink_func, &sink) == 0) {
+                *httpCode_ret_status = 200;
+                opts->cacheData->hit = true;
+            }else {
+                *curl_ret_status = CURLE_WRITE_ERROR;
+            }
+        }
+        if(cached) {
+            contentCacheRelease(&cache_entry);
+        }
+    }
+    if(sink.wb != NULL) {
+        /* Report only the bytes which really reached the file */
+        data.datasize = writeBehindClose(sink.wb);
+        sink.wb = NULL;
     }
+    finishDigest(sink.digest, digestData, *curl_ret_status);
+    finishJournal(&sink, *curl_ret_status, *httpCode_ret_status);
     /* Close Downloaded File */
     fflush((FILE*)data.pvOut);
+    if(sink.prealloc != NULL && sink.prealloc->reserved > 0 && *curl_ret_status != CURLE_OK) {
+        preallocRelease(fileno((FILE*)data.pvOut));
+    }
     fclose((FILE*)data.pvOut);
     /* Close curl progess save file */
     if(prog.prog_store) {
         fflush(prog.prog_store);
         fclose(prog.prog_store);
     }
+    progressClose(prog.publisher);
     if (headerfile != NULL) {
         fclose(headerfile);
     }
+    if(dnl_start_pos == NULL && opts->cacheData != NULL && pfile_dwnl->pPostFields == NULL
+       && !opts->cacheData->hit && *curl_ret_status == CURLE_OK && *httpCode_ret_status == 200) {
+        storeCached(curl, &sink, pfile_dwnl, opts->cacheData, file, NULL, 0);
+    }
+    closeSink(&sink);
     COMMONUTILITIES_INFO("CURL:Download Operation Done. File data.datasize:%zu and curl code=%d\n", data.datasize, *curl_ret_status);
     return data.datasize;
 }
@@ -771,21 +2039,126 @@ size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos,
  * curl : Curl Object
  * pMem : pointer to dynamically allocated memory where the data will be stored. Allocated memory will grow as needed
  * pszMem : pointer to the allocated memory size. If a reallocation occurs, this value is updated
+ * 	    Buffer is presized from memData size hint or Content-Length and grows geometrically.
+ * 	    With memData arena and pDlData->pvOut NULL the buffer is taken from the arena.
+ * 	    Body over memData budget is spilled to a file and pvOut is a read only mapping of it.
  * httpCode_ret_status : Send back http status.
  * curl_ret_status : Send back curl status
  * Return Type size_t : Return no of bytes downloaded.
  * */
 size_t urlHelperDownloadToMem( CURL *curl, FileDwnl_t *pfile_dwnl, int *httpCode_ret_status, CURLcode *curl_ret_status )
+{
+    return urlHelperDownloadToMemEx(curl, pfile_dwnl, NULL, httpCode_ret_status, curl_ret_status);
+}
+
+/* urlHelperDownloadToMemEx(): Same as urlHelperDownloadToMem with the optional download modes of opts
+ * opts : Optional download modes, NULL for none
+ * Other parameters are same as urlHelperDownloadToMem
+ * Return Type size_t : Return no of bytes downloaded.
+ * */
+size_t urlHelperDownloadToMemEx( CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status )
+{
+    DwnlOptions_t no_opts;
+    size_t len;
+    bool retry_owner;
+    int attempts;
+    int retry_delay;
+    unsigned long long attempt_start;
+
+    if( opts == NULL )
+    {
+        memset(&no_opts, 0, sizeof(no_opts));
+        opts = &no_opts;
+    }
+    /* Invalid parameters fail in downloadToMemOnce without a retry */
+    retry_owner = ( curl != NULL && pfile_dwnl != NULL && pfile_dwnl->pDlData != NULL && httpCode_ret_status != NULL && curl_ret_status != NULL )
+                  && retryBegin(opts->retryData);
+    while( 1 )
+    {
+        attempts = retry_owner ? opts->retryData->attempts : 0;
+        attempt_start = retryNowMs();
+        len = downloadToMemOnce(curl, pfile_dwnl, opts, httpCode_ret_status, curl_ret_status);
+        if( !retry_owner )
+        {
+            break;
+        }
+        retry_delay = retryAgain(opts, attempts, attempt_start, *curl_ret_status, *httpCode_ret_status);
+        if( retry_delay < 0 || retryWait((unsigned int)retry_delay, retryStop, opts->cancel) != 0 )
+        {
+            break;
+        }
+    }
+    if( retry_owner )
+    {
+        retryEnd(opts->retryData);
+    }
+    return len;
+}
+
+/* downloadToMemOnce(): One attempt of urlHelperDownloadToMemEx, parameters are same but opts is not NULL */
+static size_t downloadToMemOnce( CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status )
 {
     CURLcode ret_code = -1;
     size_t len = 0;
+    DwnlSink_t sink;
+    ContentCacheEntry_t cache_entry;
+    bool cached = false;
+    bool stats_owner;
 
     if( curl != NULL && pfile_dwnl != NULL && pfile_dwnl->pDlData != NULL && httpCode_ret_status != NULL && curl_ret_status != NULL )
     {
-        *((char *)pfile_dwnl->pDlData->pvOut) = 0;
+        memset(&sink, 0, sizeof(sink));
+        sink.data = pfile_dwnl->pDlData;
+        sink.curl = curl;
+        sink.mem = opts->memData;
+        sink.spill_fd = -1;
+        sink.cancel = opts->cancel;
+        if( sink.mem != NULL && sink.mem->spilled )
+        {
+            urlHelperReleaseMem(sink.data, sink.mem);   // mapping of a previous attempt
+        }
+        if( sink.mem != NULL && sink.mem->arena != NULL && sink.data->pvOut == NULL )
+        {
+            memArenaTake(sink.mem, sink.data);
+        }
         pfile_dwnl->pDlData->datasize = 0;
-        
-	if(pfile_dwnl->pDlHeaderData != NULL)
+        if( memReserve(pfile_dwnl->pDlData, 1, sink.mem) != 0 )
+        {
+            COMMONUTILITIES_ERROR("urlHelperDownloadToMem: no memory for download buffer\n");
+            *httpCode_ret_status = 0;
+            *curl_ret_status = CURLE_OUT_OF_MEMORY;
+            return 0;
+        }
+        *((char *)pfile_dwnl->pDlData->pvOut) = 0;
+        if( opts->digestData != NULL )
+        {
+            sink.digest = streamDigestCreate(opts->digestData->type);
+        }
+        stats_owner = transferStatsBegin(curl, opts->statsData, opts->retryData);
+        sinkGovernorStart(&sink, curl, opts->bwData);
+        if( opts->headerData != NULL && opts->headerData->map != NULL )
+        {
+            sink.headerMap = opts->headerData->map;
+            headerMapClear(sink.headerMap);
+        }
+        else
+        {
+            sinkOwnHeaderMap(&sink, opts);
+        }
+        if( sink.headerMap != NULL )
+        {
+            if( pfile_dwnl->pDlHeaderData != NULL )
+            {
+                *((char *)pfile_dwnl->pDlHeaderData->pvOut) = 0;
+                pfile_dwnl->pDlHeaderData->datasize = 0;
+                sink.header_mem = pfile_dwnl->pDlHeaderData;
+            }
+            if( setSinkHeaderOpt(curl, &sink, pfile_dwnl) == CURLE_OK )
+            {
+                COMMONUTILITIES_INFO("urlHelperDownloadToMem: Header Map Request Set\n");
+            }
+        }
+        else if(pfile_dwnl->pDlHeaderData != NULL)
 	{
             *((char *)pfile_dwnl->pDlHeaderData->pvOut) = 0;
             pfile_dwnl->pDlHeaderData->datasize = 0;
@@ -809,13 +2182,61 @@ size_t urlHelperDownloadToMem( CURL *curl, FileDwnl_t *pfile_dwnl, int *httpCode
 	     }
 	}
 
-        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteMemoryCB);
+        if( opts->encodingData != NULL )
+        {
+            setEncodingOpt(curl, opts->encodingData);
+        }
+        if( opts->cacheData != NULL )
+        {
+            cached = setCacheOpt(curl, &sink, pfile_dwnl, opts->cacheData, &cache_entry);
+        }
+        ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, mem_sink_func);
         if( ret_code == CURLE_OK )
         {
-            ret_code = curl_easy_setopt(curl, CURLOPT_WRITEDATA, pfile_dwnl->pDlData);
+            ret_code = curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
             if( ret_code == CURLE_OK )
             {
+               if( sink.cancel != NULL )
+               {
+                   setCancelProgress(curl, sink.cancel);
+               }
                *httpCode_ret_status = performRequest(curl, curl_ret_status); // Sending curl request
+               if( sink.cancel != NULL )
+               {
+                   setCancelProgress(curl, NULL);
+               }
+               if( cached && *curl_ret_status == CURLE_OK && *httpCode_ret_status == 304 )
+               {
+                   /* Reserve the whole body at once unless it goes over budget to the spill file */
+                   if( sink.mem == NULL || sink.mem->budget == 0 || (size_t)cache_entry.size <= sink.mem->budget )
+                   {
+                       memReserve(sink.data, (size_t)cache_entry.size + 1, sink.mem);
+                   }
+                   sink.sized = true;
+                   if( serveCached(&cache_entry, &sink, mem_sink_func, &sink) == 0 )
+                   {
+                       *httpCode_ret_status = 200;
+                       opts->cacheData->hit = true;
+                   }
+                   else
+                   {
+                       *curl_ret_status = CURLE_WRITE_ERROR;
+                   }
+               }
+               if( sink.spilling && memSpillMap(&sink) != 0 && *curl_ret_status == CURLE_OK )
+               {
+                   *curl_ret_status = CURLE_WRITE_ERROR;
+               }
+               finishDigest(sink.digest, opts->digestData, *curl_ret_status);
+               if( opts->encodingData != NULL )
+               {
+                   finishEncoding(curl, &sink, opts->encodingData, pfile_dwnl->pDlData->datasize);
+               }
+               if( opts->cacheData != NULL && pfile_dwnl->pPostFields == NULL && !opts->cacheData->hit
+                   && *curl_ret_status == CURLE_OK && *httpCode_ret_status == 200 )
+               {
+                   storeCached(curl, &sink, pfile_dwnl, opts->cacheData, NULL, pfile_dwnl->pDlData->pvOut, pfile_dwnl->pDlData->datasize);
+               }
             }
             else
 	    {
@@ -828,7 +2249,27 @@ size_t urlHelperDownloadToMem( CURL *curl, FileDwnl_t *pfile_dwnl, int *httpCode
              COMMONUTILITIES_ERROR("urlHelperDownloadToMem: CURLOPT_WRITEFUNCTION failed\n");
              *httpCode_ret_status = 0;
          }
+         if( cached )
+         {
+             contentCacheRelease(&cache_entry);
+             curl_easy_setopt(curl, CURLOPT_HTTPHEADER, NULL);
+             curl_slist_free_all(sink.headers);
+         }
          len = pfile_dwnl->pDlData->datasize;
+         memArenaCommit(sink.mem, pfile_dwnl->pDlData);
+         streamDigestDestroy(sink.digest);
+         if( sink.own_map != NULL )
+         {
+             /* Handle must not keep the header callback of this call */
+             curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, NULL);
+             curl_easy_setopt(curl, CURLOPT_HEADERDATA, NULL);
+             headerMapDestroy(sink.own_map);
+         }
+         sinkGovernorEnd(&sink);
+         if( stats_owner )
+         {
+             transferStatsEnd(curl);
+         }
     }
 
     return len;
@@ -889,6 +2330,30 @@ CURLcode SetPostFields( CURL *curl, char *pPostFields )
     return ret_code;
 }
 
+void urlHelperReleaseMem( DownloadData *pDlData, memParam_t *mem )
+{
+    if( pDlData == NULL || pDlData->pvOut == NULL )
+    {
+        return;
+    }
+    if( mem != NULL && mem->spilled )
+    {
+        munmap( pDlData->pvOut, pDlData->memsize );
+        mem->spilled = false;
+    }
+    else if( mem != NULL && mem->in_arena )
+    {
+        mem->in_arena = false;      // arena memory is reused by resetting the arena
+    }
+    else
+    {
+        free( pDlData->pvOut );
+    }
+    pDlData->pvOut = NULL;
+    pDlData->datasize = 0;
+    pDlData->memsize = 0;
+}
+
 int allocDowndLoadDataMem( DownloadData *pDwnData, int szDataSize )
 {
     void *ptr;
@@ -915,89 +2380,11 @@ int allocDowndLoadDataMem( DownloadData *pDwnData, int szDataSize )
     return iRet;
 }
 
+/* checkDeviceInternetConnection(): Check internet access with the connectivity prober.
+ * A verdict younger than CONNECTIVITY_PROBE_TTL_MS is reused without network access */
 bool checkDeviceInternetConnection(long timeout_ms)
 {
-	bool status = false;
-	CURL *curl;
-    CURLcode res;
-    CURLcode ret_code = CURLE_OK;
-    char *url = "http://xfinity.com";
-
-    // Initialize the curl session
-    curl = curl_easy_init();
-    if(curl) {
-        // Set the URL to retrieve
-	ret_code = curl_easy_setopt(curl, CURLOPT_URL, url);
-        if ( ret_code != CURLE_OK){
-	    COMMONUTILITIES_ERROR("curl_easy_setopt failed for CURLOPT_URL \n");
-	    urlHelperDestroyCurl(curl);
-	    return ret_code;
-	}
-        // Set private data and custom headers
-	ret_code = curl_easy_setopt(curl, CURLOPT_PRIVATE,url);
-        if ( ret_code != CURLE_OK){
-	    COMMONUTILITIES_ERROR("curl_easy_setopt failed for CURLOPT_PRIVATE \n");
-	    urlHelperDestroyCurl(curl);
-	    return ret_code;
-	}
-        struct curl_slist *chunk = NULL;
-        chunk = curl_slist_append(chunk, "Cache-Control: no-cache, no-store");
-	ret_code = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
-        if ( ret_code != CURLE_OK){
-	    COMMONUTILITIES_ERROR("curl_easy_setopt failed for CURLOPT_HTTPHEADER \n");
-	    urlHelperDestroyCurl(curl);
-	    return ret_code;
-	}
-        // Set user agent
-	ret_code = curl_easy_setopt(curl, CURLOPT_USERAGENT, "RDKCaptiveCheck/1.0");
-        if ( ret_code != CURLE_OK){
-	    COMMONUTILITIES_ERROR("curl_easy_setopt failed for CURLOPT_USERAGENT \n");
-	    urlHelperDestroyCurl(curl);
-	    return ret_code;
-	}
-
-        // Set request type to GET
-	ret_code = curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
-        if ( ret_code != CURLE_OK){
-	    COMMONUTILITIES_ERROR("curl_easy_setopt failed for CURLOPT_HTTPGET \n");
-	    urlHelperDestroyCurl(curl);
-	    return ret_code;
-	}
-
-        // Set write callback function
-	ret_code = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeFunction);
-        if ( ret_code != CURLE_OK){
-	    COMMONUTILITIES_ERROR("curl_easy_setopt failed for CURLOPT_WRITEFUNCTION \n");
-	    urlHelperDestroyCurl(curl);
-	    return ret_code;
-	}
-
-        // Set timeout in milliseconds
-        if (curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms) != CURLE_OK) {
-            COMMONUTILITIES_ERROR("curl_easy_setopt failed for CURLOPT_TIMEOUT_MS \n");
-        }
-
-        // Make the request
-        res = curl_easy_perform(curl);
-
-        // Get HTTP response code
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-		
-        // Check for errors
-        if(res != CURLE_OK)
-		    COMMONUTILITIES_ERROR( "curl_easy_perform() failed: %s\n\n",curl_easy_strerror(res));
-
-        // Clean up the curl session
-        curl_easy_cleanup(curl);
-        curl_slist_free_all(chunk); // Free the custom headers list
-		
-		if(http_code == 302)
-		{
-			status = true;
-		}
-    }
-    return status;
+    return (connectivityProbe(timeout_ms, false) == PROBE_ONLINE);
 }
 
 // Define your write callback function
@@ -1061,6 +2448,10 @@ size_t (*getWriteMemoryCB(void)) ( void *pvContents, size_t szOneContent, size_t
 	return &WriteMemoryCB;
 }
 
+size_t (*getWriteMemoryCancelCB(void)) ( void *pvContents, size_t szOneContent, size_t numContentItems, void *userp ) {
+	return &WriteMemoryCancelCB;
+}
+
 size_t (*getheader_callback(void)) (char *buffer, size_t size, size_t nitems, void *userdata) {
 	return &header_callback;
 }
@@ -67,6 +67,170 @@ typedef struct hashParam {
     char *hashtime;
 }hashParam_t;
 
+/* Structure Use for segmented (parallel byte range) download */
+typedef struct segmentParam {
+    int segments;               /* number of parallel ranges, less than 2 means single stream */
+    size_t min_segment_size;    /* smallest range worth a separate connection, 0 for default */
+    int segment_retry;          /* retry count for each failed range */
+}segmentParam_t;
+
+#define WRITE_BEHIND_THREAD     0   /* buffers written with fwrite by a writer thread */
+#define WRITE_BEHIND_IO_URING   1   /* buffers written by io_uring, writer thread when not available */
+
+/* Structure Use for write-behind (disk writes done by a separate thread or io_uring) download */
+typedef struct writeBehindParam {
+    int buffers;                /* ring depth, 0 for default */
+    size_t buffer_size;         /* size of each ring buffer, 0 for default */
+    int backend;                /* WRITE_BEHIND_THREAD or WRITE_BEHIND_IO_URING */
+}writeBehindParam_t;
+
+#define DIGEST_MAX_LEN 32
+
+typedef enum {
+    DIGEST_NONE = 0,
+    DIGEST_MD5,
+    DIGEST_SHA256
+}digestType_t;
+
+/* Structure Use for digest computed while data is received.
+ * digest_len is 0 when the download did not complete. Segmented downloads write ranges out of
+ * order, so their digest is read back from the file once it is complete. Delta downloads take it
+ * from the pass that checks the manifest digest */
+typedef struct digestParam {
+    digestType_t type;                          /* requested algorithm */
+    unsigned char digest[DIGEST_MAX_LEN];       /* binary digest */
+    unsigned int digest_len;                    /* length of digest, 0 if not available */
+    char digest_hex[DIGEST_MAX_LEN * 2 + 1];    /* lower case hex string of digest */
+}digestParam_t;
+
+/* Structure Use for resume journal (<pathname>.journal) kept while a file is downloaded */
+typedef struct journalParam {
+    size_t sync_bytes;          /* received bytes between journal updates, 0 for default */
+}journalParam_t;
+
+#define RETRY_MAX_RECORDS 8
+
+/* Result and timing of one attempt of a transfer */
+typedef struct retryAttempt {
+    CURLcode curl_code;
+    int http_code;
+    unsigned int duration_ms;   /* time spent in the attempt */
+    unsigned int delay_ms;      /* wait before next attempt, 0 for the last attempt */
+}retryAttempt_t;
+
+/* Structure Use for retry policy of a transfer. Fields after classify are filled by the retry engine */
+typedef struct retryParam {
+    int max_attempts;           /* attempts including the first one, 0 for default */
+    unsigned int base_delay_ms; /* smallest wait between attempts, 0 for default */
+    unsigned int max_delay_ms;  /* largest wait between attempts, 0 for default */
+    unsigned int budget_ms;     /* limit for all attempts and waits, 0 for no limit */
+    int (*classify)(CURLcode curl_code, int http_code); /* retryClass_t of a result, NULL for retryClassify */
+    int attempts;               /* attempts done */
+    unsigned int elapsed_ms;    /* time since first attempt */
+    retryAttempt_t attempt[RETRY_MAX_RECORDS]; /* first RETRY_MAX_RECORDS attempts */
+}retryParam_t;
+
+/* Caller owned memory that in-memory downloads are carved from. Set used to 0 to reuse the whole arena */
+typedef struct memArena {
+    char *base;
+    size_t size;
+    size_t used;                /* bytes handed out to downloads */
+}memArena_t;
+
+/* Structure Use for sizing of in-memory (urlHelperDownloadToMem) download buffer.
+ * Release the buffer with urlHelperReleaseMem when arena or budget is used */
+typedef struct memParam {
+    size_t size_hint;           /* expected body size, 0 to use Content-Length of the response */
+    memArena_t *arena;          /* take pDlData buffer from arena, NULL to use the caller's pDlData buffer */
+    bool in_arena;              /* set by download: pDlData->pvOut is inside arena and must not be freed */
+    size_t budget;              /* largest body kept in memory, 0 for no limit */
+    bool spilled;               /* set by download: body went to a spill file, pDlData->pvOut is a read only mapping of it */
+}memParam_t;
+
+/* Structure Use for response headers kept in memory instead of the <pathname>.header dump */
+typedef struct headerParam {
+    struct headerMap *map;      /* filled with headers of the final response, created with headerMapCreate */
+    bool dump_file;             /* also write <pathname>.header */
+}headerParam_t;
+
+/* Structure Use for bandwidth governor of a download (token bucket in the write path, see bandwidthGovernor.h).
+ * Rate can be changed while the download runs with doInteruptDwnl or bwGovernorSetHandleRate */
+typedef struct bwParam {
+    unsigned long long rate;    /* bytes per second at start, 0 for no limit */
+    unsigned long long burst;   /* bytes allowed at once after idle time, 0 for default */
+}bwParam_t;
+
+#define ENCODING_NAME_LEN 32
+
+/* Structure Use for compressed transfer of in-memory downloads. Body is decoded by curl while it is
+ * received, pDlData holds the decoded body. Fields after accept are set by the download */
+typedef struct encodingParam {
+    const char *accept;         /* Accept-Encoding value, NULL for every encoding curl is built with */
+    curl_off_t wire_bytes;      /* body bytes received, before decoding */
+    curl_off_t decoded_bytes;   /* body bytes after decoding */
+    char encoding[ENCODING_NAME_LEN]; /* Content-Encoding of response, empty when not encoded */
+}encodingParam_t;
+
+/* Structure Use for conditional GET with the content cache (see contentCache.h). A full GET download
+ * sends If-None-Match / If-Modified-Since of the cached response. On 304 the cached body is delivered
+ * as if the server sent it and 200 is reported, a 200 response with validators is stored.
+ * Fields are set by the download */
+typedef struct cacheParam {
+    bool hit;                   /* server answered 304, body came from the cache */
+    bool stored;                /* response was stored in the cache */
+}cacheParam_t;
+
+/* Structure Use for block delta download (see deltaDownload.h). Blocks of the file found in the seed
+ * are copied from it, only the other blocks are requested with multi-range requests */
+typedef struct deltaParam {
+    const char *manifest_url;   /* block checksum manifest of the file */
+    const char *seed;           /* local file sharing blocks with the new one, e.g. the running image */
+    long long reused_bytes;     /* set by download: bytes copied from seed */
+    long long fetched_bytes;    /* set by download: bytes received */
+}deltaParam_t;
+
+/* Structure Use for preallocated download (see preallocFile.h). Space for the whole file is checked
+ * and reserved from Content-Length before the first byte is written */
+typedef struct preallocParam {
+    long long reserved;         /* set by download: bytes reserved on disk, 0 when not done */
+    bool no_space;              /* set by download: refused as the file system has not enough free space */
+}preallocParam_t;
+
+/* Structure Use for streamed archive extraction (see extractDownload.h). A tar or tar.gz archive is
+ * extracted while it is received into a staging directory next to out_path and is not stored at pathname.
+ * Members are moved into out_path only once the archive is complete and matches expected_digest.
+ * Journal, segmented, delta, write-behind and cache modes do not apply to it, a digest is of the archive bytes */
+typedef struct extractParam {
+    const char *out_path;       /* existing directory the archive is extracted into */
+    long long entries;          /* set by download: archive members extracted */
+    long long extracted_bytes;  /* set by download: bytes of extracted files */
+    bool complete;              /* set by download: whole archive extracted and moved to out_path */
+    const char *expected_digest; /* hex SHA-256 or MD5 the archive must have before it is moved, NULL to skip the check */
+}extractParam_t;
+
+/* Structure Use for timing breakdown of a transfer (see transferStats.h). All fields are set by the
+ * download: phase times are of the last request, byte and redirect counts add up every request made
+ * for the transfer including retries, chunk resumes and parallel ranges */
+typedef struct statsParam {
+    long long namelookup_us;    /* start until the name was resolved */
+    long long connect_us;       /* start until the TCP connection was made */
+    long long appconnect_us;    /* start until the TLS handshake was done, 0 for plain http */
+    long long pretransfer_us;   /* start until the request could be sent */
+    long long starttransfer_us; /* start until the first response byte */
+    long long total_us;         /* whole request */
+    long long bytes_down;       /* body bytes received */
+    long long bytes_up;         /* body bytes sent */
+    long long speed_down;       /* bytes per second received over the whole transfer */
+    long long speed_up;         /* bytes per second sent over the whole transfer */
+    long long elapsed_us;       /* time since the transfer started */
+    int redirects;              /* redirects followed */
+    int requests;               /* requests made */
+    int failures;               /* requests ended with a curl error or http status >= 400 */
+    int retries;                /* attempts of DwnlOptions_t.retryData before the last request, 0 without a policy */
+    CURLcode curl_code;         /* result of the last request */
+    long http_code;
+}statsParam_t;
+
 typedef struct filedwnl {
         char *pPostFields;
         char *pHeaderData;
@@ -79,6 +243,35 @@ typedef struct filedwnl {
         hashParam_t *hashData;
 }FileDwnl_t;
 
+/* Structure Use for the optional download modes of the Ex functions (urlHelperDownloadFileEx,
+ * urlHelperDownloadToMemEx, doHttpFileDownloadEx, doAuthHttpFileDownloadEx, asyncDwnlSubmit).
+ * It is kept apart from FileDwnl_t so that the layout of FileDwnl_t does not change.
+ * Clear the whole structure before use, every mode which is not NULL is applied */
+typedef struct dwnlOptions {
+        segmentParam_t *segmentData;
+        writeBehindParam_t *writeBehind;
+        digestParam_t *digestData;
+        journalParam_t *journalData;
+        retryParam_t *retryData;    /* retry policy of the transfer, not supported by asyncDwnlSubmit */
+        memParam_t *memData;
+        headerParam_t *headerData;
+        bwParam_t *bwData;
+        struct cancelToken *cancel; /* cancellation of this transfer (see cancelToken.h), NULL for setForceStop only */
+        encodingParam_t *encodingData; /* compressed transfer of urlHelperDownloadToMemEx, NULL for identity */
+        cacheParam_t *cacheData;    /* conditional GET with the content cache, NULL to bypass the cache */
+        deltaParam_t *deltaData;    /* block delta download from a seed file, NULL for full download */
+        preallocParam_t *preallocData; /* reserve disk space of the whole file first, NULL for plain append */
+        extractParam_t *extractData; /* extract the archive while it is received, NULL to store the file */
+        statsParam_t *statsData;    /* timing breakdown of the transfer, NULL if not required */
+}DwnlOptions_t;
+
+/* Structure Use as write data of a memory download which stops once its cancel token is cancelled
+ * (see setMemWriteOpt) */
+typedef struct memCancelData {
+        DownloadData *data;
+        struct cancelToken *cancel;
+}MemCancelData_t;
+
 #ifdef CURL_DEBUG
 typedef struct debugdata {
         char trace_ascii; /* 1 or 0 */
@@ -89,11 +282,15 @@ int my_trace(CURL *handle, curl_infotype type, char *data, size_t size, void *us
 CURLcode setCurlDebugOpt(CURL *curl, DbgData_t *debug);
 #endif
 
-/*Below structure use for store curl progress */
+/*Below structure use for store curl progress.
+ * By default progress goes to the binary record CURL_PROGRESS_RECORD (see progressReport.h),
+ * text file CURL_PROGRESS_FILE is written instead when built with CURL_PROGRESS_TEXT */
 struct curlprogress {
     FILE *prog_store;
-    curl_off_t lastruntime; /* type depends on version, see above */
+    curl_off_t lastruntime; /* monotonic time in ms of last progress update */
     CURL *curl;
+    struct progressPublisher *publisher;
+    struct cancelToken *cancel; /* transfer is aborted when cancelled, NULL if not required */
 };
 
 /*#define SWUPDATELOG(level, ...) do { \
@@ -114,6 +311,15 @@ int urlHelperGetHeaderInfo(const char* url,
                              int *httpCode_ret_status,
                              int *curl_ret_status);
 
+/* urlHelperGetHeaderMap(): Same as urlHelperGetHeaderInfo but headers are stored in a header map, no file is written
+ * map : HeaderMap_t from headerMapCreate, cleared before the request
+ * */
+int urlHelperGetHeaderMap(const char* url,
+                          MtlsAuth_t *sec,
+                          struct headerMap *map,
+                          int *httpCode_ret_status,
+                          int *curl_ret_status);
+
 /* urlHelperDownloadFile(): Use for download a file
  * curl : Curl Object
  * file : path with file name to download image
@@ -123,14 +329,43 @@ int urlHelperGetHeaderInfo(const char* url,
  * Return Type size_t : Return no of bytes downloaded.
  * */
 size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos, int chunk_dwnl_retry_time, int* httpCode_ret_status, CURLcode *curl_ret_status);
+
+/* urlHelperDownloadFileEx(): Same as urlHelperDownloadFile but takes the full request descriptor
+ * and applies the optional download modes of opts.
+ * curl : Curl Object
+ * pfile_dwnl : Request descriptor. pathname and chunk_dwnl_retry_time are used as in urlHelperDownloadFile
+ * opts : Optional download modes, NULL for none
+ * dnl_start_pos : Use for chunk Download if it is NULL in that case request is Full Downlaod
+ * httpCode_ret_status : Send back http status.
+ * curl_ret_status : Send back curl status
+ * Return Type size_t : Return no of bytes downloaded.
+ * */
+size_t urlHelperDownloadFileEx(CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, char *dnl_start_pos,
+                               int *httpCode_ret_status, CURLcode *curl_ret_status);
 size_t urlHelperDownloadToMem( CURL *curl, FileDwnl_t *pFileData, int *httpCode_ret_status, CURLcode *curl_ret_status );
 
+/* urlHelperDownloadToMemEx(): Same as urlHelperDownloadToMem with the optional download modes of opts
+ * opts : Optional download modes, NULL for none. segmentData, writeBehind, journalData, deltaData,
+ *        preallocData and extractData only apply to file downloads
+ * */
+size_t urlHelperDownloadToMemEx( CURL *curl, FileDwnl_t *pFileData, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status );
+
+/* urlHelperReleaseMem(): Release the buffer of urlHelperDownloadToMem, heap, arena or spill file mapping
+ * pDlData : Download data, pvOut is NULL after the call
+ * mem : memData used for the download, NULL if none
+ * */
+void urlHelperReleaseMem( DownloadData *pDlData, memParam_t *mem );
+
 CURL *urlHelperCreateCurl(void);
 void urlHelperDestroyCurl(CURL *ctx);
 CURLcode setMtlsHeaders(CURL *curl, MtlsAuth_t *sec);
 CURLcode setCommonCurlOpt(CURL *curl, const char *url, char *pPostFields, bool sslverify);
+CURLcode setCommonCurlBaseOpt(CURL *curl, bool sslverify);
 CURLcode setCurlProgress(CURL *curl, struct curlprogress *curl_progress);
 CURLcode setThrottleMode(CURL *curl, curl_off_t max_dwnl_speed);
+CURLcode setFileWriteOpt(CURL *curl, DownloadData *data, FILE *headerfile);
+CURLcode setMemWriteOpt(CURL *curl, FileDwnl_t *pfile_dwnl, MemCancelData_t *cancel_data);
+int getForceStop(void);
 char *printCurlError(int curl_ret_code);
 struct curl_slist* SetRequestHeaders(CURL *curl, struct curl_slist *pslist, char *pHeader);
 CURLcode SetPostFields(CURL *curl, char *pPostFields);
@@ -0,0 +1,400 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "writeBehind.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+#include "uringWriter.h"
+
+/* Below structure is one slot of the ring */
+typedef struct wbBuffer {
+    char *data;
+    size_t len;
+} WbBuffer_t;
+
+/* Single producer (curl callback) single consumer (writer thread) ring.
+ * Slots are handed over through head/tail, the semaphores are only used to sleep
+ * when the ring is full or empty.
+ * */
+struct writeBehind {
+    DownloadData *data;
+    FILE *fp;
+    WbBuffer_t *ring;
+    int count;
+    size_t buf_size;
+    atomic_uint head;           /* next slot published by producer */
+    atomic_uint tail;           /* next slot written by consumer */
+    atomic_int error;
+    atomic_bool stop;
+    atomic_size_t written;
+    WbBuffer_t *cur;            /* slot being filled by producer, NULL if none */
+    sem_t filled;
+    sem_t freed;
+    pthread_mutex_t drainLock;
+    pthread_cond_t drained;
+    pthread_t writer;
+    UringWriter_t *uring;       /* io_uring backend, NULL when the writer thread is used */
+    char **bufs;                /* ring buffers as registered with io_uring */
+    int *idle;                  /* buffers free to be filled, completions come in any order */
+    int idle_count;
+    int cur_index;              /* buffer index of cur */
+    int inflight;               /* writes queued to io_uring and not completed */
+    int unsent;                 /* writes queued but not yet sent to the kernel */
+    int batch;                  /* writes sent together with one system call */
+    off_t offset;               /* file offset of next io_uring write */
+    bool resync;                /* offset must be taken from the FILE position */
+};
+
+/* Writer thread. Write each published buffer with a single large write */
+static void *writeBehindThread(void *arg) {
+    WriteBehind_t *wb = (WriteBehind_t *)arg;
+    WbBuffer_t *buf;
+    unsigned int tail;
+    size_t ret;
+
+    while (1) {
+        sem_wait(&wb->filled);
+        tail = atomic_load_explicit(&wb->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&wb->head, memory_order_acquire)) {
+            if (atomic_load(&wb->stop)) {
+                break;
+            }
+            continue;
+        }
+        buf = &wb->ring[tail % wb->count];
+        if (atomic_load(&wb->error) == 0) {
+            ret = fwrite(buf->data, 1, buf->len, wb->fp);
+            if (ret != buf->len) {
+                COMMONUTILITIES_ERROR("%s: fwrite failed %zu of %zu\n", __FUNCTION__, ret, buf->len);
+                atomic_store(&wb->error, 1);
+            }
+            atomic_fetch_add(&wb->written, ret);
+        }
+        buf->len = 0;
+        atomic_store_explicit(&wb->tail, tail + 1, memory_order_release);
+        sem_post(&wb->freed);
+        pthread_mutex_lock(&wb->drainLock);
+        pthread_cond_broadcast(&wb->drained);
+        pthread_mutex_unlock(&wb->drainLock);
+    }
+    return NULL;
+}
+
+/* publishCurrent(): Give the slot being filled to the writer thread */
+static void publishCurrent(WriteBehind_t *wb) {
+    if (wb->cur == NULL) {
+        return;
+    }
+    if (wb->cur->len == 0) {
+        /* Keep the empty slot for the next data */
+        return;
+    }
+    wb->cur = NULL;
+    atomic_fetch_add_explicit(&wb->head, 1, memory_order_release);
+    sem_post(&wb->filled);
+}
+
+/* uringReap(): Take completed io_uring writes, their buffers become idle */
+static void uringReap(WriteBehind_t *wb) {
+    long long res;
+    int index;
+
+    while (uringWriterReap(wb->uring, &index, &res) == 1) {
+        if (res != (long long)wb->ring[index].len) {
+            COMMONUTILITIES_ERROR("%s: write failed %lld of %zu\n", __FUNCTION__, res, wb->ring[index].len);
+            atomic_store(&wb->error, 1);
+        }
+        if (res > 0) {
+            atomic_fetch_add(&wb->written, (size_t)res);
+        }
+        wb->ring[index].len = 0;
+        wb->idle[wb->idle_count++] = index;
+        wb->inflight--;
+    }
+}
+
+/* uringSend(): Give the queued writes to the kernel, wait for one completion when asked */
+static int uringSend(WriteBehind_t *wb, bool wait) {
+    if (uringWriterSubmit(wb->uring, wait) != 0) {
+        atomic_store(&wb->error, 1);
+        return -1;
+    }
+    wb->unsent = 0;
+    uringReap(wb);
+    return 0;
+}
+
+/* uringPublish(): Queue the buffer being filled at the next file offset. Writes are sent
+ * in batches so that one system call carries several buffers */
+static void uringPublish(WriteBehind_t *wb) {
+    off_t pos;
+
+    if (wb->cur == NULL || wb->cur->len == 0) {
+        return;
+    }
+    /* The FILE may have been moved since the last flush, e.g. for a resumed download */
+    if (wb->resync) {
+        pos = (fflush(wb->fp) == 0) ? ftello(wb->fp) : -1;
+        if (pos < 0) {
+            COMMONUTILITIES_ERROR("%s: ftello failed\n", __FUNCTION__);
+            atomic_store(&wb->error, 1);
+            return;
+        }
+        wb->offset = pos;
+        wb->resync = false;
+    }
+    if (uringWriterQueue(wb->uring, wb->cur_index, wb->cur->len, (long long)wb->offset) != 0) {
+        COMMONUTILITIES_ERROR("%s: submission queue full\n", __FUNCTION__);
+        atomic_store(&wb->error, 1);
+        return;
+    }
+    wb->offset += (off_t)wb->cur->len;
+    wb->cur = NULL;
+    wb->inflight++;
+    if (++wb->unsent >= wb->batch) {
+        uringSend(wb, false);
+    }
+}
+
+/* uringNextBuffer(): Take an idle buffer, wait for a completion only when every buffer is queued
+ * Return : int : 0 on success, -1 on failure
+ * */
+static int uringNextBuffer(WriteBehind_t *wb) {
+    uringReap(wb);
+    while (wb->idle_count == 0) {
+        /* Backpressure: only here curl waits for the disk */
+        if (uringSend(wb, true) != 0) {
+            return -1;
+        }
+    }
+    wb->cur_index = wb->idle[--wb->idle_count];
+    wb->cur = &wb->ring[wb->cur_index];
+    wb->cur->len = 0;
+    return 0;
+}
+
+/* uringStart(): Use io_uring for the ring when the kernel allows it
+ * Return : int : 0 on success, -1 when the writer thread must be used
+ * */
+static int uringStart(WriteBehind_t *wb) {
+    int i;
+
+    wb->bufs = (char **)calloc(wb->count, sizeof(char *));
+    wb->idle = (int *)calloc(wb->count, sizeof(int));
+    if (wb->bufs != NULL && wb->idle != NULL) {
+        for (i = 0; i < wb->count; i++) {
+            wb->bufs[i] = wb->ring[i].data;
+            wb->idle[i] = wb->count - 1 - i;
+        }
+        fflush(wb->fp);
+        wb->uring = uringWriterCreate(fileno(wb->fp), wb->bufs, wb->count, wb->buf_size);
+    }
+    if (wb->uring == NULL) {
+        free(wb->bufs);
+        free(wb->idle);
+        wb->bufs = NULL;
+        wb->idle = NULL;
+        return -1;
+    }
+    wb->idle_count = wb->count;
+    wb->batch = (wb->count / 2 < WRITE_BEHIND_URING_BATCH) ? wb->count / 2 : WRITE_BEHIND_URING_BATCH;
+    if (wb->batch < 1) {
+        wb->batch = 1;
+    }
+    wb->resync = true;
+    return 0;
+}
+
+/* uringFlush(): Send every buffer and wait for all writes, then move the FILE past them */
+static void uringFlush(WriteBehind_t *wb) {
+    uringPublish(wb);
+    while (wb->inflight > 0) {
+        if (uringSend(wb, true) != 0) {
+            break;
+        }
+    }
+    if (!wb->resync && fseeko(wb->fp, wb->offset, SEEK_SET) != 0) {
+        COMMONUTILITIES_ERROR("%s: fseeko failed\n", __FUNCTION__);
+        atomic_store(&wb->error, 1);
+    }
+    wb->resync = true;
+}
+
+WriteBehind_t *writeBehindCreate(DownloadData *data, writeBehindParam_t *param) {
+    WriteBehind_t *wb = NULL;
+    int i;
+
+    if (data == NULL || data->pvOut == NULL) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return NULL;
+    }
+    wb = (WriteBehind_t *)calloc(1, sizeof(WriteBehind_t));
+    if (wb == NULL) {
+        COMMONUTILITIES_ERROR("%s: calloc failed\n", __FUNCTION__);
+        return NULL;
+    }
+    wb->data = data;
+    wb->fp = (FILE *)data->pvOut;
+    wb->count = (param != NULL && param->buffers > 1) ? param->buffers : WRITE_BEHIND_BUFFERS;
+    wb->buf_size = (param != NULL && param->buffer_size > 0) ? param->buffer_size : WRITE_BEHIND_BUF_SIZE;
+    /* Whole pages so that every full buffer is an aligned write */
+    wb->buf_size = (wb->buf_size + WRITE_BEHIND_ALIGN - 1) & ~((size_t)WRITE_BEHIND_ALIGN - 1);
+    wb->ring = (WbBuffer_t *)calloc(wb->count, sizeof(WbBuffer_t));
+    if (wb->ring == NULL) {
+        COMMONUTILITIES_ERROR("%s: calloc failed\n", __FUNCTION__);
+        free(wb);
+        return NULL;
+    }
+    for (i = 0; i < wb->count; i++) {
+        if (posix_memalign((void **)&wb->ring[i].data, WRITE_BEHIND_ALIGN, wb->buf_size) != 0) {
+            COMMONUTILITIES_ERROR("%s: buffer allocation failed\n", __FUNCTION__);
+            wb->ring[i].data = NULL;
+            break;
+        }
+    }
+    if (i == wb->count && param != NULL && param->backend == WRITE_BEHIND_IO_URING) {
+        if (uringStart(wb) == 0) {
+            COMMONUTILITIES_INFO("%s: io_uring writer with %d buffers of %zu bytes\n", __FUNCTION__, wb->count, wb->buf_size);
+            return wb;
+        }
+        COMMONUTILITIES_INFO("%s: io_uring not usable, use writer thread\n", __FUNCTION__);
+    }
+    if (i == wb->count) {
+        sem_init(&wb->filled, 0, 0);
+        sem_init(&wb->freed, 0, wb->count);
+        pthread_mutex_init(&wb->drainLock, NULL);
+        pthread_cond_init(&wb->drained, NULL);
+        if (pthread_create(&wb->writer, NULL, writeBehindThread, wb) == 0) {
+            COMMONUTILITIES_INFO("%s: writer started with %d buffers of %zu bytes\n", __FUNCTION__, wb->count, wb->buf_size);
+            return wb;
+        }
+        COMMONUTILITIES_ERROR("%s: pthread_create failed\n", __FUNCTION__);
+        sem_destroy(&wb->filled);
+        sem_destroy(&wb->freed);
+        pthread_mutex_destroy(&wb->drainLock);
+        pthread_cond_destroy(&wb->drained);
+    }
+    for (i = 0; i < wb->count; i++) {
+        free(wb->ring[i].data);
+    }
+    free(wb->ring);
+    free(wb);
+    return NULL;
+}
+
+size_t writeBehindCurlCB(void *ptr, size_t size, size_t nmemb, void *userp) {
+    WriteBehind_t *wb = (WriteBehind_t *)userp;
+    size_t len = size * nmemb;
+    size_t done = 0;
+    size_t chunk;
+
+    /* Same as download_func, returning zero make curl lib return 23 error code */
+    if (getForceStop() == 1) {
+        COMMONUTILITIES_INFO("writeBehindCurlCB Stopping Download\n");
+        return 0;
+    }
+    while (done < len) {
+        if (atomic_load(&wb->error) != 0) {
+            return 0;
+        }
+        if (wb->cur == NULL && wb->uring != NULL) {
+            if (uringNextBuffer(wb) != 0) {
+                return 0;
+            }
+        } else if (wb->cur == NULL) {
+            /* Backpressure: only here curl waits for the disk */
+            sem_wait(&wb->freed);
+            wb->cur = &wb->ring[atomic_load_explicit(&wb->head, memory_order_relaxed) % wb->count];
+            wb->cur->len = 0;
+        }
+        chunk = wb->buf_size - wb->cur->len;
+        if (chunk > len - done) {
+            chunk = len - done;
+        }
+        memcpy(wb->cur->data + wb->cur->len, (char *)ptr + done, chunk);
+        wb->cur->len += chunk;
+        done += chunk;
+        if (wb->cur->len == wb->buf_size) {
+            if (wb->uring != NULL) {
+                uringPublish(wb);
+            } else {
+                publishCurrent(wb);
+            }
+        }
+    }
+    wb->data->datasize += len;
+    return nmemb;
+}
+
+int writeBehindFlush(WriteBehind_t *wb) {
+    if (wb == NULL) {
+        return -1;
+    }
+    if (wb->uring != NULL) {
+        uringFlush(wb);
+        return (atomic_load(&wb->error) == 0) ? 0 : -1;
+    }
+    publishCurrent(wb);
+    pthread_mutex_lock(&wb->drainLock);
+    while (atomic_load(&wb->tail) != atomic_load(&wb->head)) {
+        pthread_cond_wait(&wb->drained, &wb->drainLock);
+    }
+    pthread_mutex_unlock(&wb->drainLock);
+    fflush(wb->fp);
+    return (atomic_load(&wb->error) == 0) ? 0 : -1;
+}
+
+size_t writeBehindClose(WriteBehind_t *wb) {
+    size_t written;
+    int i;
+
+    if (wb == NULL) {
+        return 0;
+    }
+    if (writeBehindFlush(wb) != 0) {
+        COMMONUTILITIES_ERROR("%s: data lost, disk write failed\n", __FUNCTION__);
+    }
+    if (wb->uring != NULL) {
+        uringWriterDestroy(wb->uring);
+        free(wb->bufs);
+        free(wb->idle);
+        written = atomic_load(&wb->written);
+        goto done;
+    }
+    atomic_store(&wb->stop, true);
+    sem_post(&wb->filled);
+    pthread_join(wb->writer, NULL);
+    written = atomic_load(&wb->written);
+    sem_destroy(&wb->filled);
+    sem_destroy(&wb->freed);
+    pthread_mutex_destroy(&wb->drainLock);
+    pthread_cond_destroy(&wb->drained);
+done:
+    for (i = 0; i < wb->count; i++) {
+        free(wb->ring[i].data);
+    }
+    free(wb->ring);
+    free(wb);
+    COMMONUTILITIES_INFO("%s: writer stopped, %zu bytes written\n", __FUNCTION__, written);
+    return written;
+}
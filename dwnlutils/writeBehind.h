@@ -0,0 +1,67 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef  _RDK_WRITEBEHIND_H_
+#define  _RDK_WRITEBEHIND_H_
+
+#include "urlHelper.h"
+
+#ifndef WRITE_BEHIND_BUFFERS //This is to provide an option Define custom ring depth using DFLAGS
+#define WRITE_BEHIND_BUFFERS 8
+#endif
+
+#ifndef WRITE_BEHIND_BUF_SIZE //This is to provide an option Define custom buffer size using DFLAGS
+#define WRITE_BEHIND_BUF_SIZE (256 * 1024)
+#endif
+
+#ifndef WRITE_BEHIND_URING_BATCH //This is to provide an option Define custom count of buffers sent to io_uring at once using DFLAGS
+#define WRITE_BEHIND_URING_BATCH 4
+#endif
+
+#define WRITE_BEHIND_ALIGN 4096
+
+typedef struct writeBehind WriteBehind_t;
+
+/* writeBehindCreate(): Start a writer thread which drains a ring of buffers into data->pvOut.
+ *                      With WRITE_BEHIND_IO_URING the full buffers are written by io_uring at their
+ *                      file offset instead, without thread. The FILE position is moved past the
+ *                      written data on every flush. Kernels without io_uring use the writer thread
+ * data : DownloadData with pvOut holding an open FILE pointer. datasize is updated for every accepted byte
+ * param : ring depth, buffer size and backend, 0 fields use defaults
+ * Return : WriteBehind_t * : writer object, NULL on failure
+ * */
+WriteBehind_t *writeBehindCreate(DownloadData *data, writeBehindParam_t *param);
+
+/* writeBehindCurlCB(): curl write callback copying received data into the ring.
+ *                      Blocks only when every buffer of the ring is waiting for the disk.
+ *                      Return 0 on force stop or on a failed disk write so curl stops with error 23.
+ * userp : WriteBehind_t * returned by writeBehindCreate
+ * */
+size_t writeBehindCurlCB(void *ptr, size_t size, size_t nmemb, void *userp);
+
+/* writeBehindFlush(): Hand the partly filled buffer to the writer and wait till the ring is empty
+ * Return : int : 0 on success, -1 if a disk write failed
+ * */
+int writeBehindFlush(WriteBehind_t *wb);
+
+/* writeBehindClose(): Flush, stop the writer thread and free the ring. NULL is allowed.
+ * Return : size_t : bytes really written to the file since writeBehindCreate
+ * */
+size_t writeBehindClose(WriteBehind_t *wb);
+
+#endif
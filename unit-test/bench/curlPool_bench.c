@@ -0,0 +1,145 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Connection count and latency of concurrent requests to one host, with and without the
+ * HTTP/2 mode of the curl pool. Handles take their options from setCommonCurlOpt and run in one
+ * multi handle set up as the async engine and segmented downloads do. Every round starts from a
+ * cold pool, as a new update cycle does.
+ *
+ * Build : make curlPool_bench
+ * Usage : curlPool_bench <https url> <requests> <rounds> <http1|http2> [ca file]
+ *
+ * The server must speak h2 and HTTP/1.1 over TLS. A response delay of a few ms makes the
+ * requests of HTTP/1.1 overlap as they do against a real backend. ca file is needed for a
+ * local server with a self signed certificate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "urlHelper.h"
+#include "curlPool.h"
+#include "retryPolicy.h"
+
+#define BENCH_MAX_REQUESTS 64
+
+/* benchSink(): Body is dropped */
+static size_t benchSink(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    return size * nmemb;
+}
+
+/* benchRound(): Run requests concurrent requests of url
+ * connects : Send back the connections opened
+ * Return : int : 0 on success, -1 when a request failed
+ * */
+static int benchRound(const char *url, int requests, const char *ca_file, long *connects)
+{
+    CURL *curl[BENCH_MAX_REQUESTS];
+    CURLM *multi;
+    CURLMsg *msg;
+    long http_code;
+    long count;
+    int running = 1;
+    int left;
+    int ret = 0;
+    int i;
+
+    multi = curl_multi_init();
+    if (multi == NULL) {
+        return -1;
+    }
+    /* Same as the async engine, streams are only multiplexed when the handles negotiated h2 */
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    for (i = 0; i < requests; i++) {
+        curl[i] = urlHelperCreateCurl();
+        if (curl[i] == NULL || setCommonCurlOpt(curl[i], url, NULL, false) != CURLE_OK) {
+            fprintf(stderr, "unable to set up request %d\n", i);
+            requests = i + (curl[i] != NULL);
+            ret = -1;
+            break;
+        }
+        curl_easy_setopt(curl[i], CURLOPT_WRITEFUNCTION, benchSink);
+        if (ca_file != NULL) {
+            curl_easy_setopt(curl[i], CURLOPT_CAINFO, ca_file);
+        }
+        curl_multi_add_handle(multi, curl[i]);
+    }
+    while (ret == 0 && running > 0) {
+        curl_multi_perform(multi, &running);
+        if (running > 0) {
+            curl_multi_poll(multi, NULL, 0, 100, NULL);
+        }
+    }
+    while ((msg = curl_multi_info_read(multi, &left)) != NULL) {
+        http_code = 0;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_code);
+        if (msg->msg == CURLMSG_DONE && (msg->data.result != CURLE_OK || http_code != 200)) {
+            fprintf(stderr, "request failed curl=%d http=%ld\n", msg->data.result, http_code);
+            ret = -1;
+        }
+    }
+    for (i = 0; i < requests; i++) {
+        if (curl[i] == NULL) {
+            continue;
+        }
+        count = 0;
+        curl_easy_getinfo(curl[i], CURLINFO_NUM_CONNECTS, &count);
+        *connects += count;
+        curl_multi_remove_handle(multi, curl[i]);
+        urlHelperDestroyCurl(curl[i]);
+    }
+    curl_multi_cleanup(multi);
+    /* Next round starts cold */
+    curlPoolCleanup();
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long long start;
+    unsigned long long total_ms = 0;
+    long connects = 0;
+    int requests;
+    int rounds;
+    int i;
+
+    if (argc < 5 || (strcmp(argv[4], "http1") != 0 && strcmp(argv[4], "http2") != 0)) {
+        fprintf(stderr, "usage: %s <https url> <requests> <rounds> <http1|http2> [ca file]\n", argv[0]);
+        return 1;
+    }
+    requests = atoi(argv[2]);
+    rounds = atoi(argv[3]);
+    if (requests <= 0 || requests > BENCH_MAX_REQUESTS || rounds <= 0) {
+        fprintf(stderr, "requests must be 1 to %d, rounds at least 1\n", BENCH_MAX_REQUESTS);
+        return 1;
+    }
+    curlPoolSetHttp2(strcmp(argv[4], "http2") == 0);
+    for (i = 0; i < rounds; i++) {
+        start = retryNowMs();
+        if (benchRound(argv[1], requests, (argc > 5) ? argv[5] : NULL, &connects) != 0) {
+            fprintf(stderr, "round %d failed\n", i);
+            return 1;
+        }
+        total_ms += retryNowMs() - start;
+    }
+    printf("%s requests=%d rounds=%d connections/round=%.1f latency/round=%llums\n", argv[4], requests, rounds,
+           (double)connects / rounds, total_ms / (unsigned long long)rounds);
+    return 0;
+}
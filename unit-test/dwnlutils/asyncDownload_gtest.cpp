@@ -0,0 +1,298 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+#include <pthread.h>
+
+extern "C" {
+#include "downloadUtil.h"
+#include "asyncDownload.h"
+#include "cancelToken.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_asyncDownload_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+using ::testing::Return;
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+/* Completion data filled by the callback running on the event loop thread */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int calls;
+    int req_id;
+    asyncDwnlResult_t result;
+} CbData_t;
+
+static void testCallback(int req_id, FileDwnl_t *pfile_dwnl, asyncDwnlResult_t *result, void *userdata)
+{
+    CbData_t *cbdata = (CbData_t *)userdata;
+    pthread_mutex_lock(&cbdata->lock);
+    cbdata->calls++;
+    cbdata->req_id = req_id;
+    cbdata->result = *result;
+    pthread_cond_signal(&cbdata->cond);
+    pthread_mutex_unlock(&cbdata->lock);
+}
+
+static bool waitCallback(CbData_t *cbdata, int seconds)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += seconds;
+    pthread_mutex_lock(&cbdata->lock);
+    while (cbdata->calls == 0) {
+        if (pthread_cond_timedwait(&cbdata->cond, &cbdata->lock, &ts) != 0) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cbdata->lock);
+    return cbdata->calls > 0;
+}
+
+class asyncDownloadTestFixture : public ::testing::Test {
+	protected:
+
+        CurlWrapperMock mockCurlWrapper;
+        FileDwnl_t req_data;
+        DownloadData dData;
+        char buf[64];
+
+        asyncDownloadTestFixture()
+        {
+            g_CurlWrapperMock = &mockCurlWrapper;
+        }
+        virtual ~asyncDownloadTestFixture()
+        {
+            g_CurlWrapperMock = NULL;
+        }
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            memset(&req_data, 0, sizeof(req_data));
+            dData.pvOut = buf;
+            dData.datasize = 0;
+            dData.memsize = sizeof(buf);
+            req_data.pDlData = &dData;
+            snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+            EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+            EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            asyncDwnlShutdown();
+        }
+};
+
+/*1.asyncDwnlSubmit*/
+TEST_F(asyncDownloadTestFixture, asyncDwnlSubmit_NULL_param)
+{
+    EXPECT_EQ(asyncDwnlSubmit(NULL, NULL, NULL, NULL, NULL), DWNL_FAIL);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlSubmit_no_output)
+{
+    req_data.pDlData = NULL;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, NULL, NULL, NULL, NULL), DWNL_FAIL);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlSubmit_retryData)
+{
+    DwnlOptions_t opts;
+    retryParam_t retryData;
+
+    memset(&opts, 0, sizeof(opts));
+    memset(&retryData, 0, sizeof(retryData));
+    opts.retryData = &retryData;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, &opts, NULL, NULL, NULL), DWNL_FAIL);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlSubmit_unsupported_modes)
+{
+    DwnlOptions_t opts;
+    digestParam_t digestData;
+    writeBehindParam_t writeBehind;
+    headerParam_t headerData;
+    bwParam_t bwData;
+    journalParam_t journalData;
+    cacheParam_t cacheData;
+    memParam_t memData;
+
+    memset(&opts, 0, sizeof(opts));
+    opts.digestData = &digestData;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, &opts, NULL, NULL, NULL), DWNL_FAIL);
+    memset(&opts, 0, sizeof(opts));
+    opts.writeBehind = &writeBehind;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, &opts, NULL, NULL, NULL), DWNL_FAIL);
+    memset(&opts, 0, sizeof(opts));
+    opts.headerData = &headerData;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, &opts, NULL, NULL, NULL), DWNL_FAIL);
+    memset(&opts, 0, sizeof(opts));
+    opts.bwData = &bwData;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, &opts, NULL, NULL, NULL), DWNL_FAIL);
+    memset(&opts, 0, sizeof(opts));
+    opts.journalData = &journalData;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, &opts, NULL, NULL, NULL), DWNL_FAIL);
+    memset(&opts, 0, sizeof(opts));
+    opts.cacheData = &cacheData;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, &opts, NULL, NULL, NULL), DWNL_FAIL);
+    memset(&opts, 0, sizeof(opts));
+    opts.memData = &memData;
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, &opts, NULL, NULL, NULL), DWNL_FAIL);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlSubmit_setCommonCurlOpt_fail)
+{
+    req_data.url[0] = '\0';
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,CURLOPT_URL,_)).WillOnce(Return(CURLE_URL_MALFORMAT));
+    EXPECT_EQ(asyncDwnlSubmit(&req_data, NULL, NULL, NULL, NULL), DWNL_FAIL);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlSubmit_callback_called)
+{
+    CbData_t cbdata;
+    int id;
+    memset(&cbdata, 0, sizeof(cbdata));
+    pthread_mutex_init(&cbdata.lock, NULL);
+    pthread_cond_init(&cbdata.cond, NULL);
+
+    /* URL option is mocked so the transfer ends with an error, still the callback must run */
+    id = asyncDwnlSubmit(&req_data, NULL, NULL, testCallback, &cbdata);
+    EXPECT_GT(id, 0);
+    EXPECT_TRUE(waitCallback(&cbdata, 5));
+    EXPECT_EQ(cbdata.calls, 1);
+    EXPECT_EQ(cbdata.req_id, id);
+    EXPECT_EQ(cbdata.result.state, ASYNC_DWNL_DONE);
+    EXPECT_NE(cbdata.result.curl_code, CURLE_OK);
+    /* Record with callback is released after the callback */
+    EXPECT_EQ(asyncDwnlPoll(id, NULL), ASYNC_DWNL_UNKNOWN);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlSubmit_cancel_token)
+{
+    CbData_t cbdata;
+    DwnlOptions_t opts;
+    CancelToken_t *token = cancelTokenCreate(NULL);
+    int id;
+    memset(&cbdata, 0, sizeof(cbdata));
+    memset(&opts, 0, sizeof(opts));
+    pthread_mutex_init(&cbdata.lock, NULL);
+    pthread_cond_init(&cbdata.cond, NULL);
+
+    /* Request of a cancelled token is not started */
+    cancelTokenCancel(token);
+    opts.cancel = token;
+    id = asyncDwnlSubmit(&req_data, &opts, NULL, testCallback, &cbdata);
+    EXPECT_GT(id, 0);
+    EXPECT_TRUE(waitCallback(&cbdata, 5));
+    EXPECT_EQ(cbdata.result.state, ASYNC_DWNL_CANCELLED);
+    EXPECT_EQ(cbdata.result.curl_code, CURLE_ABORTED_BY_CALLBACK);
+    cancelTokenDestroy(token);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlSubmit_ids_unique)
+{
+    int id1 = asyncDwnlSubmit(&req_data, NULL, NULL, NULL, NULL);
+    int id2 = asyncDwnlSubmit(&req_data, NULL, NULL, NULL, NULL);
+    EXPECT_GT(id1, 0);
+    EXPECT_GT(id2, 0);
+    EXPECT_NE(id1, id2);
+}
+
+/*2.asyncDwnlPoll*/
+TEST_F(asyncDownloadTestFixture, asyncDwnlPoll_unknown_id)
+{
+    asyncDwnlResult_t result;
+    EXPECT_EQ(asyncDwnlPoll(-5, &result), ASYNC_DWNL_UNKNOWN);
+    EXPECT_EQ(result.state, ASYNC_DWNL_UNKNOWN);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlPoll_without_callback)
+{
+    asyncDwnlResult_t result;
+    asyncDwnlState_t state = ASYNC_DWNL_UNKNOWN;
+    int i;
+    int id = asyncDwnlSubmit(&req_data, NULL, NULL, NULL, NULL);
+    ASSERT_GT(id, 0);
+    for (i = 0; i < 500; i++) {
+        state = asyncDwnlPoll(id, &result);
+        if (state == ASYNC_DWNL_DONE) {
+            break;
+        }
+        EXPECT_TRUE(state == ASYNC_DWNL_QUEUED || state == ASYNC_DWNL_RUNNING);
+        usleep(10000);
+    }
+    EXPECT_EQ(state, ASYNC_DWNL_DONE);
+    EXPECT_EQ(result.state, ASYNC_DWNL_DONE);
+    /* Final result is given only once */
+    EXPECT_EQ(asyncDwnlPoll(id, NULL), ASYNC_DWNL_UNKNOWN);
+}
+
+/*3.asyncDwnlCancel*/
+TEST_F(asyncDownloadTestFixture, asyncDwnlCancel_unknown_id)
+{
+    EXPECT_EQ(asyncDwnlCancel(12345), DWNL_FAIL);
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlCancel_finished_request)
+{
+    CbData_t cbdata;
+    int id;
+    memset(&cbdata, 0, sizeof(cbdata));
+    pthread_mutex_init(&cbdata.lock, NULL);
+    pthread_cond_init(&cbdata.cond, NULL);
+    id = asyncDwnlSubmit(&req_data, NULL, NULL, testCallback, &cbdata);
+    ASSERT_GT(id, 0);
+    EXPECT_TRUE(waitCallback(&cbdata, 5));
+    EXPECT_EQ(asyncDwnlCancel(id), DWNL_FAIL);
+}
+
+/*4.asyncDwnlShutdown*/
+TEST_F(asyncDownloadTestFixture, asyncDwnlShutdown_not_started)
+{
+    asyncDwnlShutdown();
+    asyncDwnlShutdown();
+}
+TEST_F(asyncDownloadTestFixture, asyncDwnlShutdown_restart)
+{
+    CbData_t cbdata;
+    memset(&cbdata, 0, sizeof(cbdata));
+    pthread_mutex_init(&cbdata.lock, NULL);
+    pthread_cond_init(&cbdata.cond, NULL);
+    EXPECT_GT(asyncDwnlSubmit(&req_data, NULL, NULL, NULL, NULL), 0);
+    asyncDwnlShutdown();
+    /* Engine is started again on next submit */
+    EXPECT_GT(asyncDwnlSubmit(&req_data, NULL, NULL, testCallback, &cbdata), 0);
+    EXPECT_TRUE(waitCallback(&cbdata, 5));
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
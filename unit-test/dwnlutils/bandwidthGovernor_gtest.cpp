@@ -0,0 +1,215 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include "headerMap.h"
+}
+#include <pthread.h>
+#include <time.h>
+
+extern "C" {
+#include "bandwidthGovernor.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_bandwidthGovernor_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+
+static int stopFlag;
+
+static int testStop(void *arg)
+{
+    (void)arg;
+    return stopFlag;
+}
+
+static long long nowMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void *setRateLater(void *arg)
+{
+    usleep(100000);
+    bwGovernorSetRate((BwGovernor_t *)arg, 0, 0);
+    return NULL;
+}
+
+class bandwidthGovernorTestFixture : public ::testing::Test {
+	protected:
+        BwGovernor_t *gov;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            stopFlag = 0;
+            gov = NULL;
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            bwGovernorDestroy(gov);
+            bwGovernorSetRate(bwGovernorTotal(), 0, 0);
+        }
+};
+
+/*1.bwGovernorCreate*/
+TEST_F(bandwidthGovernorTestFixture, bwGovernorCreate_rate)
+{
+    gov = bwGovernorCreate(1000, 0);
+    ASSERT_NE(gov, nullptr);
+    EXPECT_EQ(bwGovernorGetRate(gov), 1000);
+    bwGovernorSetRate(gov, 5000, 0);
+    EXPECT_EQ(bwGovernorGetRate(gov), 5000);
+    EXPECT_EQ(bwGovernorGetRate(NULL), 0);
+    EXPECT_EQ(bwGovernorGetRate(bwGovernorTotal()), 0);
+    bwGovernorDestroy(bwGovernorTotal());
+}
+
+/*2.bwGovernorConsume*/
+TEST_F(bandwidthGovernorTestFixture, bwGovernorConsume_no_limit)
+{
+    long long start = nowMs();
+
+    gov = bwGovernorCreate(0, 0);
+    ASSERT_NE(gov, nullptr);
+    EXPECT_EQ(bwGovernorConsume(gov, 100 * 1024 * 1024, NULL, NULL), 0);
+    EXPECT_EQ(bwGovernorConsume(NULL, 100 * 1024 * 1024, NULL, NULL), 0);
+    EXPECT_LT(nowMs() - start, 100);
+}
+TEST_F(bandwidthGovernorTestFixture, bwGovernorConsume_rate)
+{
+    long long start;
+
+    gov = bwGovernorCreate(100000, 20000);
+    ASSERT_NE(gov, nullptr);
+    start = nowMs();
+    /* Burst pass at once, next 50000 bytes take half a second */
+    EXPECT_EQ(bwGovernorConsume(gov, 20000, NULL, NULL), 0);
+    EXPECT_LT(nowMs() - start, 100);
+    EXPECT_EQ(bwGovernorConsume(gov, 50000, NULL, NULL), 0);
+    EXPECT_GE(nowMs() - start, 400);
+    EXPECT_LT(nowMs() - start, 1500);
+}
+TEST_F(bandwidthGovernorTestFixture, bwGovernorConsume_total)
+{
+    long long start;
+
+    bwGovernorSetRate(bwGovernorTotal(), 100000, 20000);
+    start = nowMs();
+    EXPECT_EQ(bwGovernorConsume(NULL, 70000, NULL, NULL), 0);
+    EXPECT_GE(nowMs() - start, 400);
+    EXPECT_LT(nowMs() - start, 1500);
+}
+TEST_F(bandwidthGovernorTestFixture, bwGovernorConsume_live_rate_change)
+{
+    pthread_t th;
+    long long start;
+
+    gov = bwGovernorCreate(1000, 0);
+    ASSERT_NE(gov, nullptr);
+    ASSERT_EQ(pthread_create(&th, NULL, setRateLater, gov), 0);
+    start = nowMs();
+    /* Debt of about 100 seconds at 1000 bytes/s is dropped when the limit is removed */
+    EXPECT_EQ(bwGovernorConsume(gov, 100000 + BW_MIN_BURST, NULL, NULL), 0);
+    EXPECT_LT(nowMs() - start, 2000);
+    pthread_join(th, NULL);
+}
+TEST_F(bandwidthGovernorTestFixture, bwGovernorConsume_stop)
+{
+    gov = bwGovernorCreate(1000, 0);
+    ASSERT_NE(gov, nullptr);
+    stopFlag = 1;
+    EXPECT_EQ(bwGovernorConsume(gov, 100000, testStop, NULL), -1);
+}
+
+/*3.bwGovernorSetHandleRate*/
+TEST_F(bandwidthGovernorTestFixture, bwGovernorSetHandleRate_attached)
+{
+    int handle;
+
+    gov = bwGovernorCreate(1000, 0);
+    ASSERT_NE(gov, nullptr);
+    EXPECT_EQ(bwGovernorSetHandleRate(&handle, 2000, 0), -1);
+    EXPECT_EQ(bwGovernorAttach(&handle, gov), 0);
+    EXPECT_EQ(bwGovernorSetHandleRate(&handle, 2000, 0), 0);
+    EXPECT_EQ(bwGovernorGetRate(gov), 2000);
+    bwGovernorDetach(&handle);
+    EXPECT_EQ(bwGovernorSetHandleRate(&handle, 3000, 0), -1);
+    EXPECT_EQ(bwGovernorGetRate(gov), 2000);
+    EXPECT_EQ(bwGovernorAttach(NULL, gov), -1);
+    EXPECT_EQ(bwGovernorSetHandleRate(NULL, 3000, 0), -1);
+}
+TEST_F(bandwidthGovernorTestFixture, bwGovernorAttach_full)
+{
+    int handle[BW_MAX_ATTACHED + 1];
+    int i;
+
+    gov = bwGovernorCreate(1000, 0);
+    ASSERT_NE(gov, nullptr);
+    for (i = 0; i < BW_MAX_ATTACHED; i++) {
+        EXPECT_EQ(bwGovernorAttach(&handle[i], gov), 0);
+    }
+    EXPECT_EQ(bwGovernorAttach(&handle[BW_MAX_ATTACHED], gov), -1);
+    for (i = 0; i < BW_MAX_ATTACHED; i++) {
+        bwGovernorDetach(&handle[i]);
+    }
+    EXPECT_EQ(bwGovernorAttach(&handle[BW_MAX_ATTACHED], gov), 0);
+    bwGovernorDetach(&handle[BW_MAX_ATTACHED]);
+}
+
+/*4.bwGovernorReadCB*/
+TEST_F(bandwidthGovernorTestFixture, bwGovernorReadCB_file)
+{
+    char buffer[16] = { 0 };
+    FILE *fp = fopen("/tmp/bwgovernor_upload.txt", "w+");
+
+    ASSERT_NE(fp, nullptr);
+    fputs("upload data", fp);
+    rewind(fp);
+    EXPECT_EQ(bwGovernorReadCB(buffer, 1, sizeof(buffer), fp), 11);
+    EXPECT_STREQ(buffer, "upload data");
+    EXPECT_EQ(bwGovernorReadCB(buffer, 1, sizeof(buffer), fp), 0);
+    fclose(fp);
+    unlink("/tmp/bwgovernor_upload.txt");
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
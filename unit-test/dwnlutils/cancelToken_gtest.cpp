@@ -0,0 +1,126 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+#include <pthread.h>
+
+extern "C" {
+#include "cancelToken.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_cancelToken_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+
+static void *cancelLater(void *arg)
+{
+    usleep(10000);
+    cancelTokenCancel((CancelToken_t *)arg);
+    return NULL;
+}
+
+class cancelTokenTestFixture : public ::testing::Test {
+	protected:
+        CancelToken_t *group;
+        CancelToken_t *token;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            group = cancelTokenCreate(NULL);
+            ASSERT_NE(group, nullptr);
+            token = cancelTokenCreate(group);
+            ASSERT_NE(token, nullptr);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            cancelTokenDestroy(token);
+            cancelTokenDestroy(group);
+        }
+};
+
+/*1.cancelTokenCancel*/
+TEST_F(cancelTokenTestFixture, cancelTokenCancel_token)
+{
+    EXPECT_FALSE(cancelTokenIsCancelled(token));
+    cancelTokenCancel(token);
+    EXPECT_TRUE(cancelTokenIsCancelled(token));
+    EXPECT_FALSE(cancelTokenIsCancelled(group));
+}
+TEST_F(cancelTokenTestFixture, cancelTokenCancel_group)
+{
+    CancelToken_t *other = cancelTokenCreate(NULL);
+    ASSERT_NE(other, nullptr);
+    cancelTokenCancel(group);
+    EXPECT_TRUE(cancelTokenIsCancelled(group));
+    EXPECT_TRUE(cancelTokenIsCancelled(token));
+    EXPECT_FALSE(cancelTokenIsCancelled(other));
+    cancelTokenDestroy(other);
+}
+TEST_F(cancelTokenTestFixture, cancelTokenCancel_other_thread)
+{
+    pthread_t th;
+    int loops = 0;
+
+    ASSERT_EQ(pthread_create(&th, NULL, cancelLater, token), 0);
+    while (!cancelTokenIsCancelled(token) && loops < 5000) {
+        usleep(1000);
+        loops++;
+    }
+    EXPECT_TRUE(cancelTokenIsCancelled(token));
+    pthread_join(th, NULL);
+}
+TEST_F(cancelTokenTestFixture, cancelTokenCancel_NULL)
+{
+    cancelTokenCancel(NULL);
+    cancelTokenReset(NULL);
+    cancelTokenDestroy(NULL);
+    EXPECT_FALSE(cancelTokenIsCancelled(NULL));
+}
+
+/*2.cancelTokenReset*/
+TEST_F(cancelTokenTestFixture, cancelTokenReset_token)
+{
+    cancelTokenCancel(token);
+    cancelTokenReset(token);
+    EXPECT_FALSE(cancelTokenIsCancelled(token));
+    cancelTokenCancel(group);
+    cancelTokenReset(token);
+    EXPECT_TRUE(cancelTokenIsCancelled(token));
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
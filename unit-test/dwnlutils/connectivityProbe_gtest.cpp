@@ -0,0 +1,180 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <atomic>
+#include <unistd.h>
+
+extern "C" {
+#include "urlHelper.h"
+#include "connectivityProbe.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_connectivityProbe_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+static CURLcode httpCode(long code, void *param)
+{
+    *(long *)param = code;
+    return CURLE_OK;
+}
+
+class connectivityProbeTestFixture : public ::testing::Test {
+	protected:
+        CurlWrapperMock mockCurlWrapper;
+
+	connectivityProbeTestFixture()
+        {
+            g_CurlWrapperMock = &mockCurlWrapper;
+        }
+        virtual ~connectivityProbeTestFixture()
+        {
+            g_CurlWrapperMock = NULL;
+        }
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            connectivityProbeConfigure(NULL, 0, 60000);
+            EXPECT_CALL(mockCurlWrapper, curl_easy_setopt(_,_,_))
+                    .WillRepeatedly(Return(CURLE_OK));
+            EXPECT_CALL(mockCurlWrapper, curl_easy_strerror(_))
+                    .WillRepeatedly(Return("curl error"));
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+        }
+};
+
+/*1.connectivityProbe*/
+TEST_F(connectivityProbeTestFixture, connectivityProbe_online_cached)
+{
+    ProbeResult_t result;
+
+    EXPECT_CALL(mockCurlWrapper, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_OK));
+    EXPECT_CALL(mockCurlWrapper, curl_easy_getinfo(_,_,_)).Times(1)
+            .WillOnce(Invoke([](CURL *curl, CURLINFO info, void *param){ return httpCode(302, param); }));
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_ONLINE);
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_ONLINE);
+    EXPECT_TRUE(checkDeviceInternetConnection(2000));
+    EXPECT_EQ(connectivityProbeLast(&result), 0);
+    EXPECT_EQ(result.verdict, PROBE_ONLINE);
+    EXPECT_EQ(result.endpoint, 0);
+}
+TEST_F(connectivityProbeTestFixture, connectivityProbe_invalidate)
+{
+    EXPECT_CALL(mockCurlWrapper, curl_easy_perform(_)).Times(2).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(mockCurlWrapper, curl_easy_getinfo(_,_,_)).Times(2)
+            .WillRepeatedly(Invoke([](CURL *curl, CURLINFO info, void *param){ return httpCode(302, param); }));
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_ONLINE);
+    connectivityProbeInvalidate();
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_ONLINE);
+}
+TEST_F(connectivityProbeTestFixture, connectivityProbe_force)
+{
+    EXPECT_CALL(mockCurlWrapper, curl_easy_perform(_)).Times(2).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(mockCurlWrapper, curl_easy_getinfo(_,_,_)).Times(2)
+            .WillRepeatedly(Invoke([](CURL *curl, CURLINFO info, void *param){ return httpCode(302, param); }));
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_ONLINE);
+    EXPECT_EQ(connectivityProbe(2000, true), PROBE_ONLINE);
+}
+TEST_F(connectivityProbeTestFixture, connectivityProbe_captive)
+{
+    EXPECT_CALL(mockCurlWrapper, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_OK));
+    EXPECT_CALL(mockCurlWrapper, curl_easy_getinfo(_,_,_)).Times(1)
+            .WillOnce(Invoke([](CURL *curl, CURLINFO info, void *param){ return httpCode(200, param); }));
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_CAPTIVE);
+    EXPECT_FALSE(checkDeviceInternetConnection(2000));
+}
+TEST_F(connectivityProbeTestFixture, connectivityProbe_offline)
+{
+    EXPECT_CALL(mockCurlWrapper, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_COULDNT_RESOLVE_HOST));
+    EXPECT_CALL(mockCurlWrapper, curl_easy_getinfo(_,_,_)).Times(1).WillOnce(Return(CURLE_OK));
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_OFFLINE);
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_OFFLINE);
+}
+TEST_F(connectivityProbeTestFixture, connectivityProbe_unknown_not_cached)
+{
+    ProbeResult_t result;
+
+    EXPECT_CALL(mockCurlWrapper, curl_easy_perform(_)).Times(2).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(mockCurlWrapper, curl_easy_getinfo(_,_,_)).Times(2).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_EQ(connectivityProbe(0, false), PROBE_UNKNOWN);
+    EXPECT_EQ(connectivityProbe(0, false), PROBE_UNKNOWN);
+    EXPECT_EQ(connectivityProbeLast(&result), 0);
+    EXPECT_EQ(result.endpoint, -1);
+}
+TEST_F(connectivityProbeTestFixture, connectivityProbe_parallel_endpoints)
+{
+    ProbeEndpoint_t endpoints[2];
+    static std::atomic<int> calls(0);
+
+    memset(endpoints, 0, sizeof(endpoints));
+    snprintf(endpoints[0].url, sizeof(endpoints[0].url), "http://127.0.0.1/generate_204");
+    endpoints[0].expect_code = 204;
+    endpoints[0].ip_resolve = CURL_IPRESOLVE_V4;
+    snprintf(endpoints[1].url, sizeof(endpoints[1].url), "http://[::1]/generate_204");
+    endpoints[1].expect_code = 204;
+    endpoints[1].ip_resolve = CURL_IPRESOLVE_V6;
+    EXPECT_EQ(connectivityProbeConfigure(endpoints, 2, 0), 0);
+    /* One address family fails, the other one answers */
+    EXPECT_CALL(mockCurlWrapper, curl_easy_perform(_)).Times(2)
+            .WillRepeatedly(Invoke([](CURL *curl){
+                    return (calls++ == 0) ? CURLE_COULDNT_CONNECT : CURLE_OK;
+                }));
+    EXPECT_CALL(mockCurlWrapper, curl_easy_getinfo(_,_,_)).Times(2)
+            .WillRepeatedly(Invoke([](CURL *curl, CURLINFO info, void *param){ return httpCode(204, param); }));
+    EXPECT_EQ(connectivityProbe(2000, false), PROBE_ONLINE);
+    /* Losing endpoint may still be running, wait for it before the mock goes away */
+    usleep(100000);
+}
+
+/*2.connectivityProbeConfigure*/
+TEST_F(connectivityProbeTestFixture, connectivityProbeConfigure_invalid)
+{
+    ProbeEndpoint_t endpoint;
+
+    memset(&endpoint, 0, sizeof(endpoint));
+    EXPECT_EQ(connectivityProbeConfigure(&endpoint, 0, 0), -1);
+    EXPECT_EQ(connectivityProbeConfigure(&endpoint, PROBE_MAX_ENDPOINTS + 1, 0), -1);
+    EXPECT_EQ(connectivityProbeLast(NULL), -1);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
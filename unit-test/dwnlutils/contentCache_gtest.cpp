@@ -0,0 +1,169 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+extern "C" {
+#include "contentCache.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_contentCache_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define CACHE_TEST_DIR "/tmp/contentCache_test"
+#define CACHE_TEST_FILE "/tmp/contentCache_test.body"
+
+using namespace testing;
+using namespace std;
+
+class contentCacheTestFixture : public ::testing::Test {
+	protected:
+        ContentCacheEntry_t entry;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            system("rm -rf " CACHE_TEST_DIR);
+            contentCacheConfigure(CACHE_TEST_DIR, 0);
+            memset(&entry, 0, sizeof(entry));
+            entry.fd = -1;
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            contentCacheRelease(&entry);
+            system("rm -rf " CACHE_TEST_DIR);
+            unlink(CACHE_TEST_FILE);
+        }
+
+        string readBody(ContentCacheEntry_t *e)
+        {
+            char buf[256];
+            ssize_t len = contentCacheRead(e, buf, sizeof(buf), 0);
+            return (len > 0) ? string(buf, len) : string();
+        }
+};
+
+/*1.contentCacheStoreMem*/
+TEST_F(contentCacheTestFixture, contentCacheStoreMem_lookup)
+{
+    EXPECT_EQ(contentCacheLookup("http://dcm.test.invalid/settings", &entry), -1);
+    EXPECT_EQ(contentCacheStoreMem("http://dcm.test.invalid/settings", "\"v1\"", "Tue, 01 Oct 2024 10:00:00 GMT", "{\"a\":1}", 7), 0);
+    ASSERT_EQ(contentCacheLookup("http://dcm.test.invalid/settings", &entry), 0);
+    EXPECT_STREQ(entry.etag, "\"v1\"");
+    EXPECT_STREQ(entry.last_modified, "Tue, 01 Oct 2024 10:00:00 GMT");
+    EXPECT_EQ(entry.size, 7);
+    EXPECT_EQ(readBody(&entry), "{\"a\":1}");
+    /* Other url is not served */
+    contentCacheRelease(&entry);
+    EXPECT_EQ(contentCacheLookup("http://dcm.test.invalid/settings2", &entry), -1);
+}
+TEST_F(contentCacheTestFixture, contentCacheStoreMem_without_validator)
+{
+    EXPECT_EQ(contentCacheStoreMem("http://dcm.test.invalid/settings", NULL, "", "body", 4), -1);
+    EXPECT_EQ(contentCacheLookup("http://dcm.test.invalid/settings", &entry), -1);
+}
+TEST_F(contentCacheTestFixture, contentCacheStoreMem_over_limit)
+{
+    contentCacheConfigure(CACHE_TEST_DIR, 4);
+    EXPECT_EQ(contentCacheStoreMem("http://dcm.test.invalid/settings", "\"v1\"", NULL, "12345", 5), -1);
+    EXPECT_EQ(contentCacheSize(), 0ULL);
+}
+TEST_F(contentCacheTestFixture, contentCacheStoreMem_same_body_stored_once)
+{
+    EXPECT_EQ(contentCacheStoreMem("http://a.test.invalid/fw.bin", "\"x\"", NULL, "0123456789", 10), 0);
+    EXPECT_EQ(contentCacheStoreMem("http://b.test.invalid/fw.bin", "\"y\"", NULL, "0123456789", 10), 0);
+    EXPECT_EQ(contentCacheSize(), 10ULL);
+    /* Body stays while the other url refers to it */
+    contentCacheRemove("http://a.test.invalid/fw.bin");
+    EXPECT_EQ(contentCacheLookup("http://a.test.invalid/fw.bin", &entry), -1);
+    ASSERT_EQ(contentCacheLookup("http://b.test.invalid/fw.bin", &entry), 0);
+    EXPECT_EQ(readBody(&entry), "0123456789");
+}
+
+/*2.contentCacheStoreFile*/
+TEST_F(contentCacheTestFixture, contentCacheStoreFile_lookup)
+{
+    FILE *fp = fopen(CACHE_TEST_FILE, "w");
+    ASSERT_NE(fp, nullptr);
+    fputs("firmware image", fp);
+    fclose(fp);
+    EXPECT_EQ(contentCacheStoreFile("http://fw.test.invalid/image.bin", NULL, "Wed, 02 Oct 2024 10:00:00 GMT", CACHE_TEST_FILE), 0);
+    ASSERT_EQ(contentCacheLookup("http://fw.test.invalid/image.bin", &entry), 0);
+    EXPECT_STREQ(entry.etag, "");
+    EXPECT_EQ(readBody(&entry), "firmware image");
+    EXPECT_EQ(contentCacheStoreFile("http://fw.test.invalid/none.bin", "\"v\"", NULL, "/tmp/contentCache_missing"), -1);
+}
+
+/*3.contentCacheValidators*/
+TEST_F(contentCacheTestFixture, contentCacheValidators_headers)
+{
+    struct curl_slist *list;
+
+    snprintf(entry.etag, sizeof(entry.etag), "%s", "\"abc\"");
+    list = contentCacheValidators(&entry, NULL);
+    ASSERT_NE(list, nullptr);
+    EXPECT_STREQ(list->data, "If-None-Match: \"abc\"");
+    EXPECT_EQ(list->next, nullptr);
+    curl_slist_free_all(list);
+
+    snprintf(entry.last_modified, sizeof(entry.last_modified), "%s", "Tue, 01 Oct 2024 10:00:00 GMT");
+    list = contentCacheValidators(&entry, NULL);
+    ASSERT_NE(list, nullptr);
+    ASSERT_NE(list->next, nullptr);
+    EXPECT_STREQ(list->next->data, "If-Modified-Since: Tue, 01 Oct 2024 10:00:00 GMT");
+    curl_slist_free_all(list);
+}
+
+/*4.LRU eviction*/
+TEST_F(contentCacheTestFixture, contentCache_lru_eviction)
+{
+    contentCacheConfigure(CACHE_TEST_DIR, 100);
+    EXPECT_EQ(contentCacheStoreMem("http://c.test.invalid/a", "\"a\"", NULL, string(60, 'a').c_str(), 60), 0);
+    usleep(10000);
+    EXPECT_EQ(contentCacheStoreMem("http://c.test.invalid/b", "\"b\"", NULL, string(30, 'b').c_str(), 30), 0);
+    usleep(10000);
+    /* Use of a makes b the least recently used */
+    ASSERT_EQ(contentCacheLookup("http://c.test.invalid/a", &entry), 0);
+    contentCacheRelease(&entry);
+    usleep(10000);
+    EXPECT_EQ(contentCacheStoreMem("http://c.test.invalid/c", "\"c\"", NULL, string(30, 'c').c_str(), 30), 0);
+    EXPECT_EQ(contentCacheSize(), 90ULL);
+    EXPECT_EQ(contentCacheLookup("http://c.test.invalid/b", &entry), -1);
+    ASSERT_EQ(contentCacheLookup("http://c.test.invalid/a", &entry), 0);
+    contentCacheRelease(&entry);
+    EXPECT_EQ(contentCacheLookup("http://c.test.invalid/c", &entry), 0);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
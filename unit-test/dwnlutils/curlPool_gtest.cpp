@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include "curlPool.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_curlPool_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+
+extern "C" {
+    int (*getcurlPoolIdleCount(void)) (void);
+}
+
+class curlPoolTestFixture : public ::testing::Test {
+	protected:
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            curlPoolCleanup();
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            curlPoolCleanup();
+        }
+};
+
+/*1.curlPoolAcquire*/
+TEST_F(curlPoolTestFixture, curlPoolAcquire_returns_handle)
+{
+    CURL *curl = curlPoolAcquire();
+    EXPECT_NE(curl, nullptr);
+    EXPECT_NE(curlPoolGetShare(), nullptr);
+    curlPoolRelease(curl);
+}
+
+/*2.curlPoolRelease*/
+TEST_F(curlPoolTestFixture, curlPoolRelease_NULL_handle)
+{
+    auto idleCount = getcurlPoolIdleCount();
+    curlPoolRelease(NULL);
+    EXPECT_EQ(idleCount(), 0);
+}
+TEST_F(curlPoolTestFixture, curlPoolRelease_handle_recycled)
+{
+    auto idleCount = getcurlPoolIdleCount();
+    CURL *first = curlPoolAcquire();
+    ASSERT_NE(first, nullptr);
+    curlPoolRelease(first);
+    EXPECT_EQ(idleCount(), 1);
+
+    CURL *second = curlPoolAcquire();
+    EXPECT_EQ(second, first);
+    EXPECT_EQ(idleCount(), 0);
+    curlPoolRelease(second);
+}
+TEST_F(curlPoolTestFixture, curlPoolRelease_idle_limit)
+{
+    auto idleCount = getcurlPoolIdleCount();
+    CURL *handles[CURL_POOL_MAX_IDLE + 2];
+    int i;
+
+    for (i = 0; i < CURL_POOL_MAX_IDLE + 2; i++) {
+        handles[i] = curlPoolAcquire();
+        ASSERT_NE(handles[i], nullptr);
+    }
+    for (i = 0; i < CURL_POOL_MAX_IDLE + 2; i++) {
+        curlPoolRelease(handles[i]);
+    }
+    EXPECT_EQ(idleCount(), CURL_POOL_MAX_IDLE);
+}
+
+/*3.curlPoolCleanup*/
+TEST_F(curlPoolTestFixture, curlPoolCleanup_frees_idle_handles)
+{
+    auto idleCount = getcurlPoolIdleCount();
+    curlPoolRelease(curlPoolAcquire());
+    EXPECT_EQ(idleCount(), 1);
+    curlPoolCleanup();
+    EXPECT_EQ(idleCount(), 0);
+    /* The pool is usable again after cleanup */
+    CURL *curl = curlPoolAcquire();
+    EXPECT_NE(curl, nullptr);
+    curlPoolRelease(curl);
+}
+
+/*4.curlPoolSetHttpVersion*/
+TEST_F(curlPoolTestFixture, curlPoolSetHttpVersion_http2_mode)
+{
+    CURL *curl = curlPoolAcquire();
+    ASSERT_NE(curl, nullptr);
+    EXPECT_FALSE(curlPoolHttp2());
+    EXPECT_EQ(curlPoolSetHttpVersion(curl), CURLE_OK);
+    curlPoolSetHttp2(true);
+    EXPECT_TRUE(curlPoolHttp2());
+    EXPECT_EQ(curlPoolSetHttpVersion(curl), CURLE_OK);
+    curlPoolSetHttp2(false);
+    EXPECT_FALSE(curlPoolHttp2());
+    EXPECT_EQ(curlPoolSetHttpVersion(NULL), CURLE_BAD_FUNCTION_ARGUMENT);
+    curlPoolRelease(curl);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <string>
+
+extern "C" {
+#include "urlHelper.h"
+#include "curlProfile.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_curlProfile_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+using ::testing::Return;
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+class curlProfileTestFixture : public ::testing::Test {
+	protected:
+
+        CurlWrapperMock mockCurlWrapper;
+        curlProfileOpt_t opt;
+
+        curlProfileTestFixture()
+        {
+            g_CurlWrapperMock = &mockCurlWrapper;
+        }
+        virtual ~curlProfileTestFixture()
+        {
+            g_CurlWrapperMock = NULL;
+        }
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            memset(&opt, 0, sizeof(opt));
+            opt.header = "Content-Type: application/json";
+            opt.auth_token = "Authorization: Bearer token";
+            EXPECT_CALL(mockCurlWrapper, curl_easy_setopt(_, _, _)).WillRepeatedly(Return(CURLE_OK));
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            curlProfileCleanup();
+        }
+};
+
+TEST_F(curlProfileTestFixture, TestName_Build_InvalidParam)
+{
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_JSONRPC_LOCAL, NULL), -1);
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_MAX, &opt), -1);
+    /* xconf profile is only useful with a client certificate */
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_XCONF_MTLS, &opt), -1);
+    EXPECT_FALSE(curlProfileReady(CURL_PROFILE_XCONF_MTLS));
+    EXPECT_FALSE(curlProfileReady(CURL_PROFILE_MAX));
+}
+
+TEST_F(curlProfileTestFixture, TestName_Build_SetoptFail)
+{
+    EXPECT_CALL(mockCurlWrapper, curl_easy_setopt(_, CURLOPT_SSLVERSION, _)).WillOnce(Return(CURLE_UNKNOWN_OPTION));
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_SSR_DOWNLOAD, &opt), -1);
+    EXPECT_FALSE(curlProfileReady(CURL_PROFILE_SSR_DOWNLOAD));
+}
+
+TEST_F(curlProfileTestFixture, TestName_Create_NotBuilt)
+{
+    EXPECT_EQ(curlProfileCreate(CURL_PROFILE_JSONRPC_LOCAL, "http://127.0.0.1:9998/jsonrpc", NULL), nullptr);
+    EXPECT_EQ(curlProfileCreate(CURL_PROFILE_MAX, "http://127.0.0.1:9998/jsonrpc", NULL), nullptr);
+}
+
+TEST_F(curlProfileTestFixture, TestName_Create_Success)
+{
+    char body[] = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"org.rdk.System.getDeviceInfo\"}";
+    CURL *curl;
+
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_JSONRPC_LOCAL, &opt), 0);
+    EXPECT_TRUE(curlProfileReady(CURL_PROFILE_JSONRPC_LOCAL));
+    EXPECT_EQ(curlProfileCreate(CURL_PROFILE_JSONRPC_LOCAL, NULL, body), nullptr);
+    curl = curlProfileCreate(CURL_PROFILE_JSONRPC_LOCAL, "http://127.0.0.1:9998/jsonrpc", body);
+    EXPECT_NE(curl, nullptr);
+    urlHelperDestroyCurl(curl);
+}
+
+TEST_F(curlProfileTestFixture, TestName_Create_UrlFail)
+{
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_SSR_DOWNLOAD, &opt), 0);
+    EXPECT_CALL(mockCurlWrapper, curl_easy_setopt(_, CURLOPT_URL, _)).WillOnce(Return(CURLE_OUT_OF_MEMORY));
+    EXPECT_EQ(curlProfileCreate(CURL_PROFILE_SSR_DOWNLOAD, "https://ssr.example.com/fw.bin", NULL), nullptr);
+}
+
+TEST_F(curlProfileTestFixture, TestName_Create_BoundLimit)
+{
+    CURL *curl[CURL_PROFILE_MAX_BOUND];
+    CURL *extra;
+    int i;
+
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_SSR_DOWNLOAD, &opt), 0);
+    for (i = 0; i < CURL_PROFILE_MAX_BOUND; i++) {
+        curl[i] = curlProfileCreate(CURL_PROFILE_SSR_DOWNLOAD, "https://ssr.example.com/fw.bin", NULL);
+        EXPECT_NE(curl[i], nullptr);
+    }
+    EXPECT_EQ(curlProfileCreate(CURL_PROFILE_SSR_DOWNLOAD, "https://ssr.example.com/fw.bin", NULL), nullptr);
+    /* a destroyed handle frees its slot */
+    urlHelperDestroyCurl(curl[0]);
+    extra = curlProfileCreate(CURL_PROFILE_SSR_DOWNLOAD, "https://ssr.example.com/fw.bin", NULL);
+    EXPECT_NE(extra, nullptr);
+    urlHelperDestroyCurl(extra);
+    for (i = 1; i < CURL_PROFILE_MAX_BOUND; i++) {
+        urlHelperDestroyCurl(curl[i]);
+    }
+}
+
+TEST_F(curlProfileTestFixture, TestName_Rebuild_InUse)
+{
+    CURL *curl;
+    CURL *next;
+
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_JSONRPC_LOCAL, &opt), 0);
+    curl = curlProfileCreate(CURL_PROFILE_JSONRPC_LOCAL, "http://127.0.0.1:9998/jsonrpc", NULL);
+    EXPECT_NE(curl, nullptr);
+    /* new token while a request of the old one is running */
+    opt.auth_token = "Authorization: Bearer renewed";
+    EXPECT_EQ(curlProfileBuild(CURL_PROFILE_JSONRPC_LOCAL, &opt), 0);
+    next = curlProfileCreate(CURL_PROFILE_JSONRPC_LOCAL, "http://127.0.0.1:9998/jsonrpc", NULL);
+    EXPECT_NE(next, nullptr);
+    urlHelperDestroyCurl(curl);
+    urlHelperDestroyCurl(next);
+    EXPECT_TRUE(curlProfileReady(CURL_PROFILE_JSONRPC_LOCAL));
+}
+
+TEST_F(curlProfileTestFixture, TestName_Request_InvalidParam)
+{
+    FileDwnl_t file_dwnl;
+    int http_code = 0;
+
+    memset(&file_dwnl, 0, sizeof(file_dwnl));
+    snprintf(file_dwnl.url, sizeof(file_dwnl.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+    EXPECT_EQ(curlProfileRequest(CURL_PROFILE_JSONRPC_LOCAL, NULL, NULL, &http_code), -1);
+    EXPECT_EQ(curlProfileRequest(CURL_PROFILE_JSONRPC_LOCAL, &file_dwnl, NULL, NULL), -1);
+    /* uploads go through performS3PutUpload */
+    EXPECT_EQ(curlProfileRequest(CURL_PROFILE_S3_PUT, &file_dwnl, NULL, &http_code), -1);
+    /* not built */
+    EXPECT_EQ(curlProfileRequest(CURL_PROFILE_JSONRPC_LOCAL, &file_dwnl, NULL, &http_code), -1);
+}
+
+TEST_F(curlProfileTestFixture, TestName_BaseOpt)
+{
+    CURL *curl = (CURL *)&opt;
+
+    EXPECT_CALL(mockCurlWrapper, curl_easy_setopt(_, _, _)).Times(7).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_EQ(setCommonCurlBaseOpt(curl, false), CURLE_OK);
+    EXPECT_CALL(mockCurlWrapper, curl_easy_setopt(_, _, _)).Times(8).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_EQ(setCommonCurlBaseOpt(curl, true), CURLE_OK);
+    EXPECT_NE(setCommonCurlBaseOpt(NULL, true), CURLE_OK);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
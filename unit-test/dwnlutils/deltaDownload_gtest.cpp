@@ -0,0 +1,364 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+extern "C" {
+#include "urlHelper.h"
+#include "deltaDownload.h"
+#include "curlPool.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_deltaDownload_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define DELTA_TEST_NEW "/tmp/delta_test.new"
+#define DELTA_TEST_SEED "/tmp/delta_test.seed"
+#define DELTA_TEST_MANIFEST "/tmp/delta_test.manifest"
+#define DELTA_TEST_OUT "/tmp/delta_test.out"
+
+using namespace testing;
+using namespace std;
+using ::testing::Return;
+
+extern "C" {
+    size_t (*getdelta_write(void)) (void *ptr, size_t size, size_t nmemb, void *userdata);
+    size_t (*getdelta_header_cb(void)) (char *buffer, size_t size, size_t nitems, void *userdata);
+}
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+class deltaDownloadTestFixture : public ::testing::Test {
+	protected:
+
+        CurlWrapperMock mockCurlWrapper;
+        DeltaManifest_t manifest;
+
+        deltaDownloadTestFixture()
+        {
+            g_CurlWrapperMock = &mockCurlWrapper;
+        }
+        virtual ~deltaDownloadTestFixture()
+        {
+            g_CurlWrapperMock = NULL;
+        }
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            memset(&manifest, 0, sizeof(manifest));
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            deltaManifestFree(&manifest);
+            unlink(DELTA_TEST_NEW);
+            unlink(DELTA_TEST_SEED);
+            unlink(DELTA_TEST_MANIFEST);
+            unlink(DELTA_TEST_OUT);
+            curlPoolCleanup();
+        }
+
+        static string pattern(size_t len, unsigned int seed)
+        {
+            string data(len, '\0');
+            for (size_t i = 0; i < len; i++) {
+                seed = seed * 1103515245 + 12345;
+                data[i] = (char)(seed >> 16);
+            }
+            return data;
+        }
+
+        static void writeFile(const char *file, const string &data)
+        {
+            ofstream out(file, ios::binary);
+            out << data;
+        }
+
+        static string readFile(const char *file)
+        {
+            ifstream in(file, ios::binary);
+            stringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        }
+
+        void loadManifest(size_t block_size)
+        {
+            ASSERT_EQ(deltaManifestWrite(DELTA_TEST_NEW, block_size, DELTA_TEST_MANIFEST), 0);
+            string text = readFile(DELTA_TEST_MANIFEST);
+            ASSERT_EQ(deltaManifestParse(text.c_str(), text.size(), &manifest), 0);
+        }
+};
+
+/*1.deltaWeakSum*/
+TEST_F(deltaDownloadTestFixture, deltaWeakSum_known_value)
+{
+    const unsigned char data[] = {1, 2, 3};
+    /* a = 6, b = 3*1 + 2*2 + 1*3 = 10 */
+    EXPECT_EQ(deltaWeakSum(data, sizeof(data)), (10U << 16) | 6U);
+    EXPECT_EQ(deltaWeakSum(data, 0), 0U);
+}
+
+/*2.deltaManifestWrite and deltaManifestParse*/
+TEST_F(deltaDownloadTestFixture, deltaManifest_round_trip)
+{
+    string data = pattern(10000, 1);
+    writeFile(DELTA_TEST_NEW, data);
+    loadManifest(4096);
+    EXPECT_EQ(manifest.length, 10000);
+    EXPECT_EQ(manifest.block_size, 4096);
+    EXPECT_EQ(manifest.count, 3);
+    EXPECT_EQ(strlen(manifest.sha256), 64);
+    EXPECT_EQ(manifest.blocks[0].weak, deltaWeakSum((const unsigned char *)data.data(), 4096));
+    EXPECT_EQ(manifest.blocks[2].weak, deltaWeakSum((const unsigned char *)data.data() + 8192, 10000 - 8192));
+    EXPECT_EQ(manifest.blocks[1].seed_offset, -1);
+}
+TEST_F(deltaDownloadTestFixture, deltaManifestParse_invalid)
+{
+    const char *no_magic = "Length: 10\nBlocksize: 4\n\n";
+    const char *no_digest = "dwnl-delta: 1\nLength: 10\nBlocksize: 4\n\n";
+    const char *short_list = "dwnl-delta: 1\nLength: 10\nBlocksize: 8\n"
+                             "SHA-256: 0000000000000000000000000000000000000000000000000000000000000000\n\n"
+                             "00000001 0000000000000000000000000000000000000000000000000000000000000000\n";
+    EXPECT_EQ(deltaManifestParse(NULL, 0, &manifest), -1);
+    EXPECT_EQ(deltaManifestParse(no_magic, strlen(no_magic), &manifest), -1);
+    EXPECT_EQ(deltaManifestParse(no_digest, strlen(no_digest), &manifest), -1);
+    EXPECT_EQ(deltaManifestParse(short_list, strlen(short_list), &manifest), -1);
+    EXPECT_EQ(manifest.blocks, nullptr);
+}
+TEST_F(deltaDownloadTestFixture, deltaManifestParse_count_not_in_body)
+{
+    /* Block count from the header is refused before anything is allocated for it */
+    const char *huge = "dwnl-delta: 1\nLength: 9223372036854775807\nBlocksize: 1\n"
+                       "SHA-256: 0000000000000000000000000000000000000000000000000000000000000000\n\n"
+                       "00000001 0000000000000000000000000000000000000000000000000000000000000000\n";
+    const char *over_max = "dwnl-delta: 1\nLength: 1099511627776\nBlocksize: 1024\n"
+                           "SHA-256: 0000000000000000000000000000000000000000000000000000000000000000\n\n";
+    EXPECT_EQ(deltaManifestParse(huge, strlen(huge), &manifest), -1);
+    EXPECT_EQ(manifest.blocks, nullptr);
+    EXPECT_EQ(manifest.count, 0u);
+    EXPECT_EQ(deltaManifestParse(over_max, strlen(over_max), &manifest), -1);
+    EXPECT_EQ(manifest.blocks, nullptr);
+}
+
+/*3.deltaMatchSeed*/
+TEST_F(deltaDownloadTestFixture, deltaMatchSeed_same_file)
+{
+    string data = pattern(10000, 2);
+    writeFile(DELTA_TEST_NEW, data);
+    writeFile(DELTA_TEST_SEED, data);
+    loadManifest(1024);
+    EXPECT_EQ(deltaMatchSeed(&manifest, DELTA_TEST_SEED), 10000);
+    EXPECT_EQ(manifest.blocks[9].seed_offset, 9216);
+}
+TEST_F(deltaDownloadTestFixture, deltaMatchSeed_shifted_and_changed)
+{
+    string data = pattern(16384, 3);
+    string seed = pattern(100, 4) + data;
+    /* Block 5 of the new file is different from the seed */
+    seed[100 + 5 * 1024 + 7] ^= 0x55;
+    writeFile(DELTA_TEST_NEW, data);
+    writeFile(DELTA_TEST_SEED, seed);
+    loadManifest(1024);
+    EXPECT_EQ(deltaMatchSeed(&manifest, DELTA_TEST_SEED), 15 * 1024);
+    EXPECT_EQ(manifest.blocks[0].seed_offset, 100);
+    EXPECT_EQ(manifest.blocks[5].seed_offset, -1);
+    EXPECT_EQ(manifest.blocks[6].seed_offset, 100 + 6 * 1024);
+}
+TEST_F(deltaDownloadTestFixture, deltaMatchSeed_concurrent)
+{
+    DeltaManifest_t other;
+    string data = pattern(64 * 1024, 5);
+    string text;
+    writeFile(DELTA_TEST_NEW, data);
+    writeFile(DELTA_TEST_SEED, data);
+    loadManifest(1024);
+    /* Second manifest of another file with fewer, larger blocks */
+    writeFile(DELTA_TEST_OUT, pattern(16 * 1024, 6));
+    ASSERT_EQ(deltaManifestWrite(DELTA_TEST_OUT, 4096, DELTA_TEST_MANIFEST), 0);
+    text = readFile(DELTA_TEST_MANIFEST);
+    ASSERT_EQ(deltaManifestParse(text.c_str(), text.size(), &other), 0);
+    long long reused[2] = {0, 0};
+    std::thread scan([&]() {
+        for (int i = 0; i < 20; i++) {
+            reused[1] += deltaMatchSeed(&other, DELTA_TEST_OUT);
+        }
+    });
+    for (int i = 0; i < 20; i++) {
+        reused[0] += deltaMatchSeed(&manifest, DELTA_TEST_SEED);
+    }
+    scan.join();
+    EXPECT_EQ(reused[0], 20LL * 64 * 1024);
+    EXPECT_EQ(reused[1], 20LL * 16 * 1024);
+    EXPECT_EQ(manifest.blocks[63].seed_offset, 63 * 1024);
+    EXPECT_EQ(other.blocks[3].seed_offset, 3 * 4096);
+    deltaManifestFree(&other);
+}
+TEST_F(deltaDownloadTestFixture, deltaMatchSeed_missing_seed)
+{
+    writeFile(DELTA_TEST_NEW, pattern(2048, 5));
+    loadManifest(1024);
+    EXPECT_EQ(deltaMatchSeed(&manifest, "/tmp/delta_test.none"), -1);
+}
+
+/*4.delta_header_cb*/
+TEST_F(deltaDownloadTestFixture, delta_header_cb_boundary_and_range)
+{
+    auto header_cb = getdelta_header_cb();
+    DeltaFetch_t fetch;
+    char status[] = "HTTP/1.1 206 Partial Content\r\n";
+    char type[] = "Content-Type: multipart/byteranges; boundary=\"3d6b6a416f9b5\"\r\n";
+    char range[] = "Content-Range: bytes 100-199/1000\r\n";
+    memset(&fetch, 0, sizeof(fetch));
+    EXPECT_EQ(header_cb(status, 1, strlen(status), &fetch), strlen(status));
+    EXPECT_EQ(header_cb(type, 1, strlen(type), &fetch), strlen(type));
+    EXPECT_STREQ(fetch.boundary, "--3d6b6a416f9b5");
+    /* Redirect clears what the previous response set */
+    header_cb(status, 1, strlen(status), &fetch);
+    EXPECT_STREQ(fetch.boundary, "");
+    EXPECT_EQ(header_cb(range, 1, strlen(range), &fetch), strlen(range));
+    EXPECT_EQ(fetch.offset, 100);
+    EXPECT_EQ(fetch.remaining, 100);
+}
+
+/*5.delta_write*/
+TEST_F(deltaDownloadTestFixture, delta_write_multipart)
+{
+    auto write_cb = getdelta_write();
+    DeltaFetch_t fetch;
+    string body = "\r\n--B1\r\nContent-Type: application/octet-stream\r\nContent-Range: bytes 2-4/10\r\n\r\nabc"
+                  "\r\n--B1\r\nContent-Range: bytes 7-8/10\r\n\r\nxy\r\n--B1--\r\n";
+    memset(&fetch, 0, sizeof(fetch));
+    fetch.fd = open(DELTA_TEST_OUT, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fetch.fd, 0);
+    ASSERT_EQ(ftruncate(fetch.fd, 10), 0);
+    fetch.length = 10;
+    fetch.http_code = 206;
+    snprintf(fetch.boundary, sizeof(fetch.boundary), "%s", "--B1");
+    /* Body arrives in small pieces, delimiters are split between calls */
+    for (size_t pos = 0; pos < body.size(); pos += 5) {
+        size_t len = min((size_t)5, body.size() - pos);
+        ASSERT_EQ(write_cb((void *)(body.data() + pos), 1, len, &fetch), len);
+    }
+    close(fetch.fd);
+    EXPECT_EQ(fetch.received, 5);
+    EXPECT_EQ(readFile(DELTA_TEST_OUT), string("\0\0abc\0\0xy\0", 10));
+}
+TEST_F(deltaDownloadTestFixture, delta_write_single_range)
+{
+    auto write_cb = getdelta_write();
+    DeltaFetch_t fetch;
+    char data[] = "12345";
+    memset(&fetch, 0, sizeof(fetch));
+    fetch.fd = open(DELTA_TEST_OUT, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fetch.fd, 0);
+    fetch.length = 10;
+    fetch.http_code = 206;
+    fetch.offset = 3;
+    fetch.remaining = 4;
+    /* More data than the range asked for is refused */
+    EXPECT_EQ(write_cb(data, 1, 5, &fetch), 0);
+    EXPECT_EQ(fetch.received, 4);
+    close(fetch.fd);
+}
+TEST_F(deltaDownloadTestFixture, delta_write_range_ignored)
+{
+    auto write_cb = getdelta_write();
+    DeltaFetch_t fetch;
+    char data[] = "whole file";
+    memset(&fetch, 0, sizeof(fetch));
+    fetch.fd = -1;
+    fetch.http_code = 200;
+    EXPECT_EQ(write_cb(data, 1, strlen(data), &fetch), 0);
+    EXPECT_TRUE(fetch.range_ignored);
+}
+TEST_F(deltaDownloadTestFixture, delta_write_outside_file)
+{
+    auto write_cb = getdelta_write();
+    DeltaFetch_t fetch;
+    char data[] = "abcd";
+    memset(&fetch, 0, sizeof(fetch));
+    fetch.fd = -1;
+    fetch.length = 10;
+    fetch.http_code = 206;
+    fetch.offset = 8;
+    fetch.remaining = 4;
+    EXPECT_EQ(write_cb(data, 1, 4, &fetch), 0);
+}
+
+/*6.deltaDownloadFile*/
+TEST_F(deltaDownloadTestFixture, deltaDownloadFile_NULL_param)
+{
+    deltaParam_t delta = {"http://fw.test.invalid/fw.bin.delta", DELTA_TEST_SEED, 0, 0};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    EXPECT_EQ(deltaDownloadFile(NULL, DELTA_TEST_OUT, &delta, NULL, NULL, &bytes, &httpCode, &curl_code), DELTA_DWNL_NOT_POSSIBLE);
+}
+TEST_F(deltaDownloadTestFixture, deltaDownloadFile_seed_is_file)
+{
+    CURL *curl = curl_easy_init();
+    deltaParam_t delta = {"http://fw.test.invalid/fw.bin.delta", DELTA_TEST_SEED, 0, 0};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    writeFile(DELTA_TEST_SEED, pattern(100, 6));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(0);
+    EXPECT_EQ(deltaDownloadFile(curl, DELTA_TEST_SEED, &delta, NULL, NULL, &bytes, &httpCode, &curl_code), DELTA_DWNL_NOT_POSSIBLE);
+    EXPECT_EQ(readFile(DELTA_TEST_SEED).size(), 100);
+    curl_easy_cleanup(curl);
+}
+TEST_F(deltaDownloadTestFixture, deltaDownloadFile_no_manifest)
+{
+    CURL *curl = curl_easy_init();
+    deltaParam_t delta = {"http://fw.test.invalid/fw.bin.delta", DELTA_TEST_SEED, 0, 0};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    writeFile(DELTA_TEST_SEED, pattern(100, 7));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).WillOnce(Return(CURLE_COULDNT_CONNECT));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_EQ(deltaDownloadFile(curl, DELTA_TEST_OUT, &delta, NULL, NULL, &bytes, &httpCode, &curl_code), DELTA_DWNL_NOT_POSSIBLE);
+    EXPECT_EQ(access(DELTA_TEST_OUT, F_OK), -1);
+    curl_easy_cleanup(curl);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
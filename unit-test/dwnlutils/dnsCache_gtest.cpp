@@ -0,0 +1,191 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+#include <time.h>
+
+extern "C" {
+#include "dnsCache.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_dnsCache_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define DNS_TEST_FILE "/tmp/dnsCache_test.cache"
+
+using namespace testing;
+using namespace std;
+
+class dnsCacheTestFixture : public ::testing::Test {
+	protected:
+        CURL *curl;
+        char addrs[DNS_ADDRS_MAX_LEN];
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            unlink(DNS_TEST_FILE);
+            memset(addrs, 0, sizeof(addrs));
+            curl = curl_easy_init();
+            ASSERT_NE(curl, nullptr);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            dnsCacheRelease(curl);
+            curl_easy_cleanup(curl);
+            unlink(DNS_TEST_FILE);
+        }
+
+        void writeEntry(const char *host, long port, long long expiry, const char *ips)
+        {
+            FILE *fp = fopen(DNS_TEST_FILE, "a");
+            ASSERT_NE(fp, nullptr);
+            fprintf(fp, "%s %ld %lld %s\n", host, port, expiry, ips);
+            fclose(fp);
+        }
+};
+
+/*1.dnsCacheApply*/
+TEST_F(dnsCacheTestFixture, dnsCacheApply_fresh_entry)
+{
+    writeEntry("xconf.test.invalid", 443, (long long)time(NULL) + 3600, "10.0.0.1,[fd00::1]");
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "https://xconf.test.invalid/xconf/swu/stb"), 1);
+    EXPECT_EQ(dnsCacheLookup("xconf.test.invalid", 443, addrs, sizeof(addrs)), 0);
+    EXPECT_STREQ(addrs, "10.0.0.1,[fd00::1]");
+    /* Port is part of the key */
+    EXPECT_EQ(dnsCacheApply(curl, "http://xconf.test.invalid:8080/"), 0);
+}
+TEST_F(dnsCacheTestFixture, dnsCacheApply_expired_entry)
+{
+    writeEntry("ssr.test.invalid", 443, (long long)time(NULL) - 10, "10.0.0.2");
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "https://ssr.test.invalid/file.bin"), 0);
+    EXPECT_EQ(dnsCacheLookup("ssr.test.invalid", 443, addrs, sizeof(addrs)), -1);
+}
+TEST_F(dnsCacheTestFixture, dnsCacheApply_ip_host)
+{
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "http://127.0.0.1:8080/file"), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "http://[::1]:8080/file"), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "not a url"), 0);
+    EXPECT_EQ(dnsCacheApply(NULL, "http://localhost/"), 0);
+}
+TEST_F(dnsCacheTestFixture, dnsCacheApply_disabled)
+{
+    writeEntry("xconf.test.invalid", 443, (long long)time(NULL) + 3600, "10.0.0.1");
+    EXPECT_EQ(dnsCacheConfigure(NULL, 0), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "https://xconf.test.invalid/"), 0);
+    EXPECT_EQ(dnsCacheLookup("xconf.test.invalid", 443, addrs, sizeof(addrs)), -1);
+}
+TEST_F(dnsCacheTestFixture, dnsCacheApply_learns_host)
+{
+    int i;
+
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "http://localhost:8080/file"), 0);
+    /* Host is resolved in the background for next transfers */
+    for (i = 0; i < 100 && dnsCacheLookup("localhost", 8080, addrs, sizeof(addrs)) != 0; i++) {
+        usleep(20000);
+    }
+    EXPECT_EQ(dnsCacheLookup("localhost", 8080, addrs, sizeof(addrs)), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "http://localhost:8080/file"), 1);
+}
+
+/*2.dnsCacheRefresh*/
+TEST_F(dnsCacheTestFixture, dnsCacheRefresh_persistent)
+{
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheRefresh("localhost", 443), 0);
+    EXPECT_EQ(dnsCacheLookup("localhost", 443, addrs, sizeof(addrs)), 0);
+    EXPECT_TRUE(strstr(addrs, "127.0.0.1") != NULL || strstr(addrs, "[::1]") != NULL);
+    /* A new process start finds the entry in the file */
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    memset(addrs, 0, sizeof(addrs));
+    EXPECT_EQ(dnsCacheLookup("localhost", 443, addrs, sizeof(addrs)), 0);
+    EXPECT_NE(addrs[0], '\0');
+}
+TEST_F(dnsCacheTestFixture, dnsCacheRefresh_invalid)
+{
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheRefresh(NULL, 443), -1);
+    EXPECT_EQ(dnsCacheRefresh("", 443), -1);
+}
+
+/*3.dnsCacheDone*/
+TEST_F(dnsCacheTestFixture, dnsCacheDone_connect_failure)
+{
+    writeEntry("upload.test.invalid", 443, (long long)time(NULL) + 3600, "10.0.0.3");
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "https://upload.test.invalid/"), 1);
+    dnsCacheDone(curl, CURLE_OK);
+    EXPECT_EQ(dnsCacheLookup("upload.test.invalid", 443, addrs, sizeof(addrs)), 0);
+    dnsCacheDone(curl, CURLE_COULDNT_CONNECT);
+    EXPECT_EQ(dnsCacheLookup("upload.test.invalid", 443, addrs, sizeof(addrs)), -1);
+    /* Next transfer falls back to normal resolution */
+    EXPECT_EQ(dnsCacheApply(curl, "https://upload.test.invalid/"), 0);
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheLookup("upload.test.invalid", 443, addrs, sizeof(addrs)), -1);
+}
+
+TEST_F(dnsCacheTestFixture, dnsCacheDone_timeout_retry)
+{
+    writeEntry("ssr.test.invalid", 443, (long long)time(NULL) + 3600, "10.0.0.4");
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "https://ssr.test.invalid/"), 1);
+    EXPECT_EQ(dnsCacheDone(curl, CURLE_WRITE_ERROR), 0);
+    EXPECT_EQ(dnsCacheLookup("ssr.test.invalid", 443, addrs, sizeof(addrs)), 0);
+    /* No response was received, the handle is ready for one more attempt */
+    EXPECT_EQ(dnsCacheDone(curl, CURLE_OPERATION_TIMEDOUT), 1);
+    EXPECT_EQ(dnsCacheLookup("ssr.test.invalid", 443, addrs, sizeof(addrs)), -1);
+    EXPECT_EQ(dnsCacheDone(curl, CURLE_OPERATION_TIMEDOUT), 0);
+}
+TEST_F(dnsCacheTestFixture, dnsCacheDone_tls_failure)
+{
+    writeEntry("ssr.test.invalid", 443, (long long)time(NULL) + 3600, "10.0.0.4");
+    EXPECT_EQ(dnsCacheConfigure(DNS_TEST_FILE, 60), 0);
+    EXPECT_EQ(dnsCacheApply(curl, "https://ssr.test.invalid/"), 1);
+    EXPECT_EQ(dnsCacheDone(curl, CURLE_SSL_CONNECT_ERROR), 1);
+    EXPECT_EQ(dnsCacheLookup("ssr.test.invalid", 443, addrs, sizeof(addrs)), -1);
+}
+
+/*4.dnsCacheConfigure*/
+TEST_F(dnsCacheTestFixture, dnsCacheConfigure_invalid)
+{
+    EXPECT_EQ(dnsCacheConfigure("", 0), -1);
+    EXPECT_EQ(dnsCacheLookup(NULL, 443, addrs, sizeof(addrs)), -1);
+    EXPECT_EQ(dnsCacheLookup("localhost", 443, NULL, 0), -1);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -23,6 +23,8 @@
 
 extern "C" {
 #include "downloadUtil.h"
+#include "bandwidthGovernor.h"
+#include "retryPolicy.h"
 }
 #include "mocks/curl_mock.h"
 #include "mocks/mock_urlHelper.h"
@@ -157,6 +159,21 @@ TEST_F(downloadUtilTestFixture, doInteruptDwnl_max_dwlSpeed_0)
     //CURL *curl = (CURL *) malloc(sizeof(CURL));
     EXPECT_EQ(doInteruptDwnl(curl, 0), CURLE_OK);
 }
+TEST_F(downloadUtilTestFixture, doInteruptDwnl_governed)
+{
+    int curl;
+    BwGovernor_t *gov = bwGovernorCreate(20000, 0);
+    ASSERT_NE(gov, nullptr);
+    ASSERT_EQ(bwGovernorAttach(&curl, gov), 0);
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_pause(_,_)).Times(0);
+    EXPECT_CALL(*g_urlHelperMock, setThrottleMode(_,_)).Times(0);
+    EXPECT_EQ(doInteruptDwnl(&curl, 50000), CURLE_OK);
+    EXPECT_EQ(bwGovernorGetRate(gov), 50000);
+    EXPECT_EQ(doInteruptDwnl(&curl, 0), CURLE_OK);
+    EXPECT_EQ(bwGovernorGetRate(gov), 0);
+    bwGovernorDetach(&curl);
+    bwGovernorDestroy(gov);
+}
 
 /*4. doGetDwnlBytes*/
 TEST_F(downloadUtilTestFixture, doGetDwnlBytes_curl_NULL)
@@ -544,6 +561,215 @@ TEST_F(downloadUtilTestFixture, doHttpFileDownload_downloadToFile)
     EXPECT_NE(doHttpFileDownload(Curl_req, &req_data, sec, 200000, range, &httpCode), -1);
     free(sec);
 }
+TEST_F(downloadUtilTestFixture, doHttpFileDownload_segmented_downloadToFile)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    segmentParam_t segData;
+    void *Curl_req = NULL;
+    int httpCode = 0;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    segData.segments = 4;
+    segData.min_segment_size = 0;
+    segData.segment_retry = 0;
+
+    Curl_req = doCurlInit();
+    opts.segmentData = &segData;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/file.bin");
+    snprintf(req_data.pathname, sizeof(req_data.pathname), "%s", "/tmp/file.bin");
+
+    EXPECT_CALL(*g_urlHelperMock, setCommonCurlOpt(_,_,_,_)).WillOnce(Return(CURLE_OK));
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFile(_,_,_,_,_,_)).Times(0);
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFileEx(_,&req_data,_,NULL,_,_))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, char *dnl_start_pos, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 200;
+            *curl_ret_status = CURLE_OK;
+            return 2000000;
+            }));
+
+    EXPECT_EQ(doHttpFileDownloadEx(Curl_req, &req_data, &opts, NULL, 0, NULL, &httpCode), 0);
+    EXPECT_EQ(httpCode, 200);
+}
+TEST_F(downloadUtilTestFixture, doHttpFileDownload_bwData_speed)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    bwParam_t bwData;
+    void *Curl_req = NULL;
+    int httpCode = 0;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&bwData, 0, sizeof(bwData));
+    bwData.rate = 1000;
+
+    Curl_req = doCurlInit();
+    opts.bwData = &bwData;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/file.bin");
+    snprintf(req_data.pathname, sizeof(req_data.pathname), "%s", "/tmp/file.bin");
+
+    EXPECT_CALL(*g_urlHelperMock, setCommonCurlOpt(_,_,_,_)).WillOnce(Return(CURLE_OK));
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFileEx(_,&req_data,_,NULL,_,_))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, char *dnl_start_pos, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            EXPECT_EQ(dwnl_opts->bwData->rate, 50000);
+            *httpCode_ret_status = 200;
+            *curl_ret_status = CURLE_OK;
+            return 2000000;
+            }));
+
+    EXPECT_EQ(doHttpFileDownloadEx(Curl_req, &req_data, &opts, NULL, 50000, NULL, &httpCode), 0);
+    /* Speed of the call does not change the caller's settings */
+    EXPECT_EQ(opts.bwData, &bwData);
+    EXPECT_EQ(bwData.rate, 1000);
+}
+TEST_F(downloadUtilTestFixture, doHttpFileDownload_headerData_downloadToFile)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    headerParam_t headerData;
+    void *Curl_req = NULL;
+    int httpCode = 0;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&headerData, 0, sizeof(headerData));
+
+    Curl_req = doCurlInit();
+    opts.headerData = &headerData;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/file.bin");
+    snprintf(req_data.pathname, sizeof(req_data.pathname), "%s", "/tmp/file.bin");
+
+    EXPECT_CALL(*g_urlHelperMock, setCommonCurlOpt(_,_,_,_)).WillOnce(Return(CURLE_OK));
+    /* Only the extended download fills the header map */
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFile(_,_,_,_,_,_)).Times(0);
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFileEx(_,&req_data,_,NULL,_,_))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, char *dnl_start_pos, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 200;
+            *curl_ret_status = CURLE_OK;
+            return 1000;
+            }));
+
+    EXPECT_EQ(doHttpFileDownloadEx(Curl_req, &req_data, &opts, NULL, 0, NULL, &httpCode), 0);
+    EXPECT_EQ(httpCode, 200);
+}
+TEST_F(downloadUtilTestFixture, doHttpFileDownload_retry_downloadToMem)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    retryParam_t retryData;
+    void *Curl_req = NULL;
+    int httpCode = 0;
+    DownloadData dData;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&retryData, 0, sizeof(retryData));
+    retryData.max_attempts = 4;
+    retryData.base_delay_ms = 1;
+    retryData.max_delay_ms = 2;
+
+    Curl_req = doCurlInit();
+    req_data.pDlData = &dData;
+    opts.retryData = &retryData;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+
+    EXPECT_CALL(*g_urlHelperMock, setCommonCurlOpt(_,_,_,_)).WillOnce(Return(CURLE_OK));
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadToMemEx(_,_,_,_,_))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 0;
+            *curl_ret_status = CURLE_COULDNT_CONNECT;
+            return 0;
+            }))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 503;
+            *curl_ret_status = CURLE_OK;
+            return 0;
+            }))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 200;
+            *curl_ret_status = CURLE_OK;
+            return 20;
+            }));
+
+    EXPECT_EQ(doHttpFileDownloadEx(Curl_req, &req_data, &opts, NULL, 0, NULL, &httpCode), 0);
+    EXPECT_EQ(httpCode, 200);
+    EXPECT_EQ(retryData.attempts, 3);
+    EXPECT_EQ(retryData.attempt[0].curl_code, CURLE_COULDNT_CONNECT);
+    EXPECT_GE(retryData.attempt[0].delay_ms, 1);
+    EXPECT_EQ(retryData.attempt[1].http_code, 503);
+    EXPECT_EQ(retryData.attempt[2].delay_ms, 0);
+    /* Policy was ended, so it can begin again */
+    EXPECT_TRUE(retryBegin(&retryData));
+    retryEnd(&retryData);
+}
+TEST_F(downloadUtilTestFixture, doHttpFileDownload_retry_downloadToFile)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    retryParam_t retryData;
+    void *Curl_req = NULL;
+    int httpCode = 0;
+    char range[] = "100-";
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&retryData, 0, sizeof(retryData));
+    retryData.max_attempts = 3;
+    retryData.base_delay_ms = 1;
+    retryData.max_delay_ms = 2;
+
+    Curl_req = doCurlInit();
+    opts.retryData = &retryData;
+    req_data.chunk_dwnl_retry_time = 10;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/file.bin");
+    snprintf(req_data.pathname, sizeof(req_data.pathname), "%s", "/tmp/file.bin");
+
+    EXPECT_CALL(*g_urlHelperMock, setCommonCurlOpt(_,_,_,_)).WillOnce(Return(CURLE_OK));
+    /* Fixed retries with sleep of the legacy chunk download must not run under the policy */
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFile(_,_,_,_,_,_)).Times(0);
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFileEx(_,&req_data,_,range,_,_))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, char *dnl_start_pos, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 206;
+            *curl_ret_status = CURLE_OK;
+            return 1000;
+            }));
+
+    EXPECT_EQ(doHttpFileDownloadEx(Curl_req, &req_data, &opts, NULL, 0, range, &httpCode), 0);
+    EXPECT_EQ(httpCode, 206);
+}
+TEST_F(downloadUtilTestFixture, doHttpFileDownload_retry_fatal_error)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    retryParam_t retryData;
+    void *Curl_req = NULL;
+    int httpCode = 0;
+    DownloadData dData;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&retryData, 0, sizeof(retryData));
+    retryData.base_delay_ms = 1;
+
+    Curl_req = doCurlInit();
+    req_data.pDlData = &dData;
+    opts.retryData = &retryData;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+
+    EXPECT_CALL(*g_urlHelperMock, setCommonCurlOpt(_,_,_,_)).WillOnce(Return(CURLE_OK));
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadToMemEx(_,_,_,_,_))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 404;
+            *curl_ret_status = CURLE_OK;
+            return 0;
+            }));
+
+    EXPECT_EQ(doHttpFileDownloadEx(Curl_req, &req_data, &opts, NULL, 0, NULL, &httpCode), 0);
+    EXPECT_EQ(httpCode, 404);
+    EXPECT_EQ(retryData.attempts, 1);
+}
 
 /*8. doAuthHttpFileDownload*/
 TEST_F(downloadUtilTestFixture, doAuthHttpFileDownload_SetRequestHeaders_fails)
@@ -630,6 +856,63 @@ TEST_F(downloadUtilTestFixture, doAuthHttpFileDownload_httpcode_NULL)
 
     EXPECT_EQ(doAuthHttpFileDownload(Curl_req, &req_data, NULL), -1);
 }
+TEST_F(downloadUtilTestFixture, doAuthHttpFileDownloadEx_options_downloadToFile)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    retryParam_t retryData;
+    void *Curl_req = NULL;
+    int httpCode = 0;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&retryData, 0, sizeof(retryData));
+    opts.retryData = &retryData;
+
+    Curl_req = doCurlInit();
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/file.bin");
+    snprintf(req_data.pathname, sizeof(req_data.pathname), "%s", "/tmp/file.bin");
+
+    EXPECT_CALL(*g_urlHelperMock, setCommonCurlOpt(_,_,_,_)).WillOnce(Return(CURLE_OK));
+    /* Options are applied by the extended download only */
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFile(_,_,_,_,_,_)).Times(0);
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadFileEx(_,&req_data,&opts,NULL,_,_))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, char *dnl_start_pos, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 200;
+            *curl_ret_status = CURLE_OK;
+            return 1000;
+            }));
+
+    EXPECT_EQ(doAuthHttpFileDownloadEx(Curl_req, &req_data, &opts, &httpCode), 0);
+    EXPECT_EQ(httpCode, 200);
+}
+TEST_F(downloadUtilTestFixture, doAuthHttpFileDownloadEx_options_downloadToMem)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    void *Curl_req = NULL;
+    int httpCode = 0;
+    DownloadData dData;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+
+    Curl_req = doCurlInit();
+    req_data.pDlData = &dData;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+
+    EXPECT_CALL(*g_urlHelperMock, setCommonCurlOpt(_,_,_,_)).WillOnce(Return(CURLE_OK));
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadToMem(_,_,_,_)).Times(0);
+    EXPECT_CALL(*g_urlHelperMock, urlHelperDownloadToMemEx(_,&req_data,&opts,_,_))
+            .WillOnce(Invoke([](CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *dwnl_opts, int *httpCode_ret_status, CURLcode *curl_ret_status) {
+            *httpCode_ret_status = 200;
+            *curl_ret_status = CURLE_OK;
+            return 20;
+            }));
+
+    EXPECT_EQ(doAuthHttpFileDownloadEx(Curl_req, &req_data, &opts, &httpCode), 0);
+    EXPECT_EQ(httpCode, 200);
+}
 
 GTEST_API_ int main(int argc, char *argv[]){
     char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
@@ -0,0 +1,386 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glob.h>
+#include <zlib.h>
+
+extern "C" {
+#include "urlHelper.h"
+#include "extractDownload.h"
+#include "curlPool.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_extractDownload_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define EXTRACT_TEST_DIR "/tmp/extractDownload_test"
+#define EXTRACT_TEST_FILE "/tmp/extractDownload_test.tgz"
+#define EXTRACT_TEST_STAGING EXTRACT_TEST_DIR ".??????"
+
+using namespace testing;
+using namespace std;
+using ::testing::Return;
+
+extern "C" {
+    size_t (*getextract_write(void)) (void *ptr, size_t size, size_t nmemb, void *userdata);
+    size_t (*getextract_header_cb(void)) (char *buffer, size_t size, size_t nitems, void *userdata);
+    int (*getextractMove(void)) (const char *src, const char *dst);
+    int (*getextractRemoveTree(void)) (const char *path, bool keep_top);
+    int (*getextractVerify(void)) (const extractParam_t *extract, const digestParam_t *digest);
+}
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+class extractDownloadTestFixture : public ::testing::Test {
+	protected:
+
+        CurlWrapperMock mockCurlWrapper;
+        ExtractFetch_t fetch;
+
+        extractDownloadTestFixture()
+        {
+            g_CurlWrapperMock = &mockCurlWrapper;
+        }
+        virtual ~extractDownloadTestFixture()
+        {
+            g_CurlWrapperMock = NULL;
+        }
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            system("rm -rf " EXTRACT_TEST_DIR);
+            mkdir(EXTRACT_TEST_DIR, 0755);
+            memset(&fetch, 0, sizeof(fetch));
+            fetch.out_path = EXTRACT_TEST_DIR;
+            fetch.range_start = -1;
+            fetch.ts = tarStreamCreate(EXTRACT_TEST_DIR);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            tarStreamDestroy(fetch.ts);
+            streamDigestDestroy(fetch.digest);
+            system("rm -rf " EXTRACT_TEST_DIR);
+            unlink(EXTRACT_TEST_FILE ".header");
+            curlPoolCleanup();
+        }
+
+        /* Response code seen by the write callback */
+        void responseCode(long code)
+        {
+            EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_, CURLINFO_RESPONSE_CODE, _))
+                .WillRepeatedly(Invoke([code](CURL *, CURLINFO, void *param) {
+                    *(long *)param = code;
+                    return CURLE_OK;
+                }));
+        }
+
+        static string tgz(const string &name, const string &data)
+        {
+            char h[512];
+            unsigned int sum = 0;
+            memset(h, 0, sizeof(h));
+            snprintf(h, 100, "%s", name.c_str());
+            snprintf(h + 100, 8, "%07o", 0644);
+            snprintf(h + 124, 12, "%011o", (unsigned int)data.size());
+            snprintf(h + 136, 12, "%011o", 0);
+            h[156] = '0';
+            memcpy(h + 257, "ustar", 6);
+            memset(h + 148, ' ', 8);
+            for (int i = 0; i < 512; i++) {
+                sum += (unsigned char)h[i];
+            }
+            snprintf(h + 148, 8, "%06o", sum);
+            string tar = string(h, 512) + data + string((512 - data.size() % 512) % 512, '\0') + string(1024, '\0');
+
+            z_stream zs;
+            string out(compressBound(tar.size()) + 64, '\0');
+            memset(&zs, 0, sizeof(zs));
+            deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+            zs.next_in = (Bytef *)tar.data();
+            zs.avail_in = tar.size();
+            zs.next_out = (Bytef *)&out[0];
+            zs.avail_out = out.size();
+            deflate(&zs, Z_FINISH);
+            out.resize(zs.total_out);
+            deflateEnd(&zs);
+            return out;
+        }
+
+        static string readFile(const char *file)
+        {
+            ifstream in(file, ios::binary);
+            stringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        }
+
+        size_t feed(const string &data, size_t from, size_t len)
+        {
+            return getextract_write()((void *)(data.data() + from), 1, len, &fetch);
+        }
+
+        static string sha256(const string &data)
+        {
+            digestParam_t digest;
+            StreamDigest_t *ctx = streamDigestCreate(DIGEST_SHA256);
+            memset(&digest, 0, sizeof(digest));
+            streamDigestUpdate(ctx, data.data(), data.size());
+            streamDigestFinal(ctx, &digest);
+            streamDigestDestroy(ctx);
+            return digest.digest_hex;
+        }
+
+        static size_t stagingLeft(void)
+        {
+            glob_t g;
+            size_t count = 0;
+            if (glob(EXTRACT_TEST_STAGING, 0, NULL, &g) == 0) {
+                count = g.gl_pathc;
+            }
+            globfree(&g);
+            return count;
+        }
+};
+
+/*1.extract_header_cb*/
+TEST_F(extractDownloadTestFixture, extract_header_cb_range)
+{
+    auto header_cb = getextract_header_cb();
+    char status[] = "HTTP/1.1 206 Partial Content\r\n";
+    char range[] = "Content-Range: bytes 4096-9999/10000\r\n";
+    EXPECT_EQ(header_cb(range, 1, strlen(range), &fetch), strlen(range));
+    EXPECT_EQ(fetch.range_start, 4096);
+    /* Redirect clears what the previous response set */
+    EXPECT_EQ(header_cb(status, 1, strlen(status), &fetch), strlen(status));
+    EXPECT_EQ(fetch.range_start, -1);
+}
+
+/*2.extract_write*/
+TEST_F(extractDownloadTestFixture, extract_write_archive_in_pieces)
+{
+    string data(100000, 'f');
+    string archive = tgz("fw/image.bin", data);
+    digestParam_t digest;
+    memset(&digest, 0, sizeof(digest));
+    digest.type = DIGEST_SHA256;
+    fetch.digest_type = DIGEST_SHA256;
+    fetch.digest = streamDigestCreate(DIGEST_SHA256);
+    responseCode(200);
+    for (size_t pos = 0; pos < archive.size(); pos += 100) {
+        size_t len = min((size_t)100, archive.size() - pos);
+        ASSERT_EQ(feed(archive, pos, len), len);
+    }
+    EXPECT_EQ(fetch.received, (long long)archive.size());
+    EXPECT_EQ(tarStreamFinish(fetch.ts, NULL, NULL), TAR_STREAM_OK);
+    EXPECT_EQ(readFile(EXTRACT_TEST_DIR "/fw/image.bin"), data);
+    EXPECT_EQ(streamDigestFinal(fetch.digest, &digest), 0);
+    EXPECT_EQ(digest.digest_len, 32u);
+}
+TEST_F(extractDownloadTestFixture, extract_write_error_page_dropped)
+{
+    string page = "<html>Not Found</html>";
+    responseCode(404);
+    EXPECT_EQ(feed(page, 0, page.size()), page.size());
+    EXPECT_FALSE(fetch.feeding);
+    EXPECT_EQ(fetch.received, 0);
+}
+TEST_F(extractDownloadTestFixture, extract_write_resume_and_restart)
+{
+    string archive = tgz("file.bin", string(50000, 'r'));
+    size_t half = archive.size() / 2;
+    responseCode(200);
+    ASSERT_EQ(feed(archive, 0, half), half);
+
+    /* 206 continues the same stream */
+    fetch.checked = false;
+    fetch.range_start = (long long)half;
+    responseCode(206);
+    ASSERT_EQ(feed(archive, half, 10), 10u);
+    EXPECT_EQ(fetch.received, (long long)half + 10);
+
+    /* 200 to a range request restarts extraction from the first byte */
+    fetch.checked = false;
+    responseCode(200);
+    ASSERT_EQ(feed(archive, 0, archive.size()), archive.size());
+    EXPECT_EQ(fetch.received, (long long)archive.size());
+    EXPECT_EQ(tarStreamFinish(fetch.ts, NULL, NULL), TAR_STREAM_OK);
+    EXPECT_EQ(readFile(EXTRACT_TEST_DIR "/file.bin"), string(50000, 'r'));
+}
+TEST_F(extractDownloadTestFixture, extract_write_wrong_range)
+{
+    string archive = tgz("file.bin", "x");
+    fetch.received = 100;
+    fetch.range_start = 0;
+    responseCode(206);
+    EXPECT_EQ(feed(archive, 0, archive.size()), 0u);
+    EXPECT_TRUE(fetch.failed);
+}
+TEST_F(extractDownloadTestFixture, extract_write_not_archive)
+{
+    string data(2048, 'z');
+    responseCode(200);
+    EXPECT_EQ(feed(data, 0, data.size()), 0u);
+    EXPECT_TRUE(fetch.failed);
+}
+
+/*3.extractDownloadFile*/
+TEST_F(extractDownloadTestFixture, extractDownloadFile_NULL_param)
+{
+    extractParam_t extract = {EXTRACT_TEST_DIR, 0, 0, false};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    EXPECT_EQ(extractDownloadFile(NULL, EXTRACT_TEST_FILE, &extract, NULL, NULL, &bytes, &httpCode, &curl_code), EXTRACT_DWNL_NOT_POSSIBLE);
+    EXPECT_EQ(extractDownloadFile((CURL *)0x1, EXTRACT_TEST_FILE, NULL, NULL, NULL, &bytes, &httpCode, &curl_code), EXTRACT_DWNL_NOT_POSSIBLE);
+}
+TEST_F(extractDownloadTestFixture, extractDownloadFile_missing_dir)
+{
+    CURL *curl = curl_easy_init();
+    extractParam_t extract = {EXTRACT_TEST_DIR "/missing", 0, 0, false};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(0);
+    EXPECT_EQ(extractDownloadFile(curl, EXTRACT_TEST_FILE, &extract, NULL, NULL, &bytes, &httpCode, &curl_code), EXTRACT_DWNL_NOT_POSSIBLE);
+    curl_easy_cleanup(curl);
+}
+TEST_F(extractDownloadTestFixture, extractDownloadFile_resume_on_partial_file)
+{
+    CURL *curl = curl_easy_init();
+    extractParam_t extract = {EXTRACT_TEST_DIR, 0, 0, false};
+    digestParam_t digest;
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    memset(&digest, 0, sizeof(digest));
+    digest.type = DIGEST_SHA256;
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+    /* First request and EXTRACT_DWNL_RETRY range requests */
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(EXTRACT_DWNL_RETRY + 1).WillRepeatedly(Return(CURLE_PARTIAL_FILE));
+    responseCode(200);
+    EXPECT_EQ(extractDownloadFile(curl, EXTRACT_TEST_FILE, &extract, &digest, NULL, &bytes, &httpCode, &curl_code), EXTRACT_DWNL_DONE);
+    EXPECT_EQ(curl_code, CURLE_PARTIAL_FILE);
+    EXPECT_EQ(httpCode, 200);
+    EXPECT_FALSE(extract.complete);
+    EXPECT_EQ(digest.digest_len, 0u);
+    EXPECT_EQ(bytes, 0u);
+    curl_easy_cleanup(curl);
+}
+
+TEST_F(extractDownloadTestFixture, extractDownloadFile_failed_staging_removed)
+{
+    CURL *curl = curl_easy_init();
+    extractParam_t extract = {EXTRACT_TEST_DIR, 0, 0, false, NULL};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    system("echo old > " EXTRACT_TEST_DIR "/kept");
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).WillOnce(Return(CURLE_COULDNT_CONNECT));
+    responseCode(0);
+    EXPECT_EQ(extractDownloadFile(curl, EXTRACT_TEST_FILE, &extract, NULL, NULL, &bytes, &httpCode, &curl_code), EXTRACT_DWNL_DONE);
+    EXPECT_EQ(curl_code, CURLE_COULDNT_CONNECT);
+    EXPECT_FALSE(extract.complete);
+    EXPECT_EQ(readFile(EXTRACT_TEST_DIR "/kept"), "old\n");
+    EXPECT_EQ(stagingLeft(), 0u);
+    curl_easy_cleanup(curl);
+}
+
+/*4.extractVerify*/
+TEST_F(extractDownloadTestFixture, extractVerify_digest)
+{
+    auto verify = getextractVerify();
+    string expected = sha256("archive");
+    extractParam_t extract = {EXTRACT_TEST_DIR, 0, 0, false, NULL};
+    digestParam_t digest;
+    memset(&digest, 0, sizeof(digest));
+    EXPECT_EQ(verify(&extract, NULL), 0);
+    extract.expected_digest = expected.c_str();
+    /* Incomplete download has no digest */
+    EXPECT_EQ(verify(&extract, &digest), -1);
+    EXPECT_EQ(verify(&extract, NULL), -1);
+    StreamDigest_t *ctx = streamDigestCreate(DIGEST_SHA256);
+    streamDigestUpdate(ctx, "archive", 7);
+    streamDigestFinal(ctx, &digest);
+    streamDigestDestroy(ctx);
+    EXPECT_EQ(verify(&extract, &digest), 0);
+    string upper = expected;
+    for (auto &c : upper) c = toupper(c);
+    extract.expected_digest = upper.c_str();
+    EXPECT_EQ(verify(&extract, &digest), 0);
+    upper[0] = (upper[0] == '0') ? '1' : '0';
+    EXPECT_EQ(verify(&extract, &digest), -1);
+}
+
+/*5.extractMove*/
+TEST_F(extractDownloadTestFixture, extractMove_merge)
+{
+    auto move = getextractMove();
+    system("rm -rf " EXTRACT_TEST_DIR ".stage");
+    system("mkdir -p " EXTRACT_TEST_DIR ".stage/fw/sub " EXTRACT_TEST_DIR "/fw");
+    system("echo new > " EXTRACT_TEST_DIR ".stage/fw/image.bin");
+    system("echo sub > " EXTRACT_TEST_DIR ".stage/fw/sub/part.bin");
+    system("echo top > " EXTRACT_TEST_DIR ".stage/top.txt");
+    system("echo old > " EXTRACT_TEST_DIR "/fw/image.bin");
+    system("echo other > " EXTRACT_TEST_DIR "/fw/other.bin");
+    EXPECT_EQ(move(EXTRACT_TEST_DIR ".stage", EXTRACT_TEST_DIR), 0);
+    EXPECT_EQ(readFile(EXTRACT_TEST_DIR "/fw/image.bin"), "new\n");
+    EXPECT_EQ(readFile(EXTRACT_TEST_DIR "/fw/sub/part.bin"), "sub\n");
+    EXPECT_EQ(readFile(EXTRACT_TEST_DIR "/fw/other.bin"), "other\n");
+    EXPECT_EQ(readFile(EXTRACT_TEST_DIR "/top.txt"), "top\n");
+    EXPECT_NE(access(EXTRACT_TEST_DIR ".stage/top.txt", F_OK), 0);
+    EXPECT_EQ(getextractRemoveTree()(EXTRACT_TEST_DIR ".stage", false), 0);
+    EXPECT_NE(access(EXTRACT_TEST_DIR ".stage", F_OK), 0);
+}
+TEST_F(extractDownloadTestFixture, extractMove_symlink_not_followed)
+{
+    auto move = getextractMove();
+    system("rm -rf " EXTRACT_TEST_DIR ".stage " EXTRACT_TEST_DIR ".outside");
+    system("mkdir -p " EXTRACT_TEST_DIR ".stage/fw " EXTRACT_TEST_DIR ".outside");
+    system("echo new > " EXTRACT_TEST_DIR ".stage/fw/image.bin");
+    symlink(EXTRACT_TEST_DIR ".outside", EXTRACT_TEST_DIR "/fw");
+    /* A directory can not replace the link, nothing is written through it */
+    EXPECT_EQ(move(EXTRACT_TEST_DIR ".stage", EXTRACT_TEST_DIR), -1);
+    EXPECT_NE(access(EXTRACT_TEST_DIR ".outside/image.bin", F_OK), 0);
+    system("rm -rf " EXTRACT_TEST_DIR ".stage " EXTRACT_TEST_DIR ".outside");
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
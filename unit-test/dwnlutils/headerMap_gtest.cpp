@@ -0,0 +1,146 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include "headerMap.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_headerMap_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+
+class headerMapTestFixture : public ::testing::Test {
+	protected:
+        HeaderMap_t *map;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            map = headerMapCreate();
+            ASSERT_NE(map, nullptr);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            headerMapDestroy(map);
+        }
+
+        void addLine(const char *line)
+        {
+            headerMapCurlCB((char *)line, 1, strlen(line), map);
+        }
+};
+
+/*1.headerMapAddLine*/
+TEST_F(headerMapTestFixture, headerMapAddLine_invalid)
+{
+    EXPECT_EQ(headerMapAddLine(NULL, "a: b", 4), -1);
+    EXPECT_EQ(headerMapAddLine(map, NULL, 4), -1);
+    EXPECT_EQ(headerMapAddLine(map, "no colon\r\n", 10), -1);
+    EXPECT_EQ(headerMapAddLine(map, "\r\n", 2), 0);
+}
+TEST_F(headerMapTestFixture, headerMapAddLine_status_and_values)
+{
+    addLine("HTTP/1.1 200 OK\r\n");
+    addLine("Content-Length: 1234\r\n");
+    addLine("ETag:   \"abc\"  \r\n");
+    addLine("\r\n");
+    EXPECT_EQ(headerMapStatus(map), 200);
+    EXPECT_STREQ(headerMapGet(map, "content-length"), "1234");
+    EXPECT_STREQ(headerMapGet(map, "ETAG"), "\"abc\"");
+    EXPECT_EQ(headerMapGet(map, "Location"), nullptr);
+    EXPECT_EQ(headerMapContentLength(map), 1234);
+}
+TEST_F(headerMapTestFixture, headerMapAddLine_repeated_header)
+{
+    addLine("HTTP/1.1 200 OK\r\n");
+    addLine("Cache-Control: no-cache\r\n");
+    addLine("cache-control: no-store\r\n");
+    EXPECT_STREQ(headerMapGet(map, "Cache-Control"), "no-cache, no-store");
+}
+TEST_F(headerMapTestFixture, headerMapAddLine_redirect_keeps_final)
+{
+    addLine("HTTP/1.1 302 Found\r\n");
+    addLine("Location: http://127.0.0.1/new\r\n");
+    addLine("HTTP/1.1 200 OK\r\n");
+    addLine("Content-Length: 10\r\n");
+    EXPECT_EQ(headerMapStatus(map), 200);
+    EXPECT_EQ(headerMapGet(map, "Location"), nullptr);
+    EXPECT_EQ(headerMapContentLength(map), 10);
+}
+TEST_F(headerMapTestFixture, headerMapAddLine_many_headers)
+{
+    char line[64];
+    char name[32];
+    int i;
+
+    addLine("HTTP/2 200\r\n");
+    for (i = 0; i < 500; i++) {
+        snprintf(line, sizeof(line), "X-Header-%d: value-%d\r\n", i, i);
+        addLine(line);
+    }
+    for (i = 0; i < 500; i++) {
+        snprintf(name, sizeof(name), "x-header-%d", i);
+        snprintf(line, sizeof(line), "value-%d", i);
+        ASSERT_NE(headerMapGet(map, name), nullptr);
+        EXPECT_STREQ(headerMapGet(map, name), line);
+    }
+}
+
+/*2.headerMapContentLength*/
+TEST_F(headerMapTestFixture, headerMapContentLength_invalid)
+{
+    EXPECT_EQ(headerMapContentLength(NULL), -1);
+    EXPECT_EQ(headerMapContentLength(map), -1);
+    addLine("Content-Length: 12ab\r\n");
+    EXPECT_EQ(headerMapContentLength(map), -1);
+}
+
+/*3.headerMapClear*/
+TEST_F(headerMapTestFixture, headerMapClear_empty)
+{
+    addLine("HTTP/1.1 404 Not Found\r\n");
+    addLine("Server: test\r\n");
+    headerMapClear(map);
+    EXPECT_EQ(headerMapStatus(map), 0);
+    EXPECT_EQ(headerMapGet(map, "Server"), nullptr);
+    headerMapClear(NULL);
+    headerMapDestroy(NULL);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
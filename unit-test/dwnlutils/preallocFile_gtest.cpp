@@ -0,0 +1,119 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+extern "C" {
+#include "preallocFile.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_preallocFile_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define PREALLOC_TEST_FILE "/tmp/preallocFile_test.bin"
+
+using namespace testing;
+using namespace std;
+
+class preallocFileTestFixture : public ::testing::Test {
+	protected:
+        int fd;
+        preallocParam_t prealloc;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            fd = open(PREALLOC_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0644);
+            memset(&prealloc, 0, sizeof(prealloc));
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            close(fd);
+            unlink(PREALLOC_TEST_FILE);
+        }
+};
+
+/*1.preallocFile*/
+TEST_F(preallocFileTestFixture, preallocFile_NULL_param)
+{
+    EXPECT_EQ(preallocFile(-1, PREALLOC_TEST_FILE, 0, 4096, &prealloc), PREALLOC_NOT_DONE);
+    EXPECT_EQ(preallocFile(fd, NULL, 0, 4096, &prealloc), PREALLOC_NOT_DONE);
+    EXPECT_EQ(preallocFile(fd, PREALLOC_TEST_FILE, 0, 4096, NULL), PREALLOC_NOT_DONE);
+}
+TEST_F(preallocFileTestFixture, preallocFile_length_unknown)
+{
+    EXPECT_EQ(preallocFile(fd, PREALLOC_TEST_FILE, 0, -1, &prealloc), PREALLOC_NOT_DONE);
+    EXPECT_EQ(prealloc.reserved, 0);
+    EXPECT_FALSE(prealloc.no_space);
+}
+TEST_F(preallocFileTestFixture, preallocFile_reserve_keeps_size)
+{
+    struct stat st;
+    int ret = preallocFile(fd, PREALLOC_TEST_FILE, 0, 1024 * 1024, &prealloc);
+    if (ret == PREALLOC_NOT_DONE) {
+        GTEST_SKIP() << "fallocate not supported on /tmp";
+    }
+    ASSERT_EQ(ret, PREALLOC_DONE);
+    EXPECT_EQ(prealloc.reserved, 1024 * 1024);
+    ASSERT_EQ(fstat(fd, &st), 0);
+    EXPECT_EQ(st.st_size, 0);
+    EXPECT_GE((long long)st.st_blocks * 512, 1024 * 1024);
+
+    /* Unused reservation is given back */
+    EXPECT_EQ(write(fd, "data", 4), 4);
+    preallocRelease(fd);
+    ASSERT_EQ(fstat(fd, &st), 0);
+    EXPECT_EQ(st.st_size, 4);
+    EXPECT_LT((long long)st.st_blocks * 512, 1024 * 1024);
+}
+TEST_F(preallocFileTestFixture, preallocFile_no_space)
+{
+    struct stat st;
+    /* 1 PB is more than any test machine has free */
+    EXPECT_EQ(preallocFile(fd, PREALLOC_TEST_FILE, 0, 1LL << 50, &prealloc), PREALLOC_NO_SPACE);
+    EXPECT_TRUE(prealloc.no_space);
+    EXPECT_EQ(prealloc.reserved, 0);
+    ASSERT_EQ(fstat(fd, &st), 0);
+    EXPECT_EQ(st.st_blocks, 0);
+}
+
+/*2.preallocRelease*/
+TEST_F(preallocFileTestFixture, preallocRelease_invalid_fd)
+{
+    preallocRelease(-1);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include "progressReport.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_progressReport_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+#define TEST_RECORD "/tmp/progressReport_gtest.bin"
+
+using namespace testing;
+using namespace std;
+
+class progressReportTestFixture : public ::testing::Test {
+	protected:
+        ProgressRecord_t rec;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            memset(&rec, 0, sizeof(rec));
+            unlink(TEST_RECORD);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            unlink(TEST_RECORD);
+        }
+};
+
+/*1.progressOpen*/
+TEST_F(progressReportTestFixture, progressOpen_NULL_path)
+{
+    EXPECT_EQ(progressOpen(NULL), nullptr);
+}
+TEST_F(progressReportTestFixture, progressOpen_bad_path)
+{
+    EXPECT_EQ(progressOpen("/tmp/no_such_dir/progress.bin"), nullptr);
+}
+TEST_F(progressReportTestFixture, progressOpen_record_running)
+{
+    ProgressPublisher_t *pub = progressOpen(TEST_RECORD);
+    ASSERT_NE(pub, nullptr);
+    EXPECT_EQ(progressRead(TEST_RECORD, &rec), 0);
+    EXPECT_EQ(rec.magic, PROGRESS_MAGIC);
+    EXPECT_EQ(rec.version, PROGRESS_VERSION);
+    EXPECT_EQ(rec.state, PROGRESS_RUNNING);
+    EXPECT_EQ(rec.seq % 2, 0);
+    EXPECT_EQ(rec.eta_sec, -1);
+    progressClose(pub);
+}
+
+/*2.progressPublish*/
+TEST_F(progressReportTestFixture, progressPublish_rates_and_eta)
+{
+    ProgressPublisher_t *pub = progressOpen(TEST_RECORD);
+    ASSERT_NE(pub, nullptr);
+    progressPublish(pub, 0, 10000, 1000);
+    progressPublish(pub, 1000, 10000, 2000);
+    progressPublish(pub, 4000, 10000, 3000);
+    EXPECT_EQ(progressRead(TEST_RECORD, &rec), 0);
+    EXPECT_EQ(rec.dlnow, 4000);
+    EXPECT_EQ(rec.dltotal, 10000);
+    EXPECT_EQ(rec.rate_now, 3000);
+    EXPECT_EQ(rec.rate_avg, 2000);
+    EXPECT_EQ(rec.eta_sec, 3);
+    EXPECT_EQ(rec.elapsed_ms, 2000);
+    progressPublish(pub, 10000, 10000, 4000);
+    EXPECT_EQ(progressRead(TEST_RECORD, &rec), 0);
+    EXPECT_EQ(rec.eta_sec, 0);
+    progressClose(pub);
+}
+TEST_F(progressReportTestFixture, progressPublish_unknown_total)
+{
+    ProgressPublisher_t *pub = progressOpen(TEST_RECORD);
+    ASSERT_NE(pub, nullptr);
+    progressPublish(pub, 0, 0, 1000);
+    progressPublish(pub, 5000, 0, 2000);
+    EXPECT_EQ(progressRead(TEST_RECORD, &rec), 0);
+    EXPECT_EQ(rec.dltotal, 0);
+    EXPECT_EQ(rec.eta_sec, -1);
+    EXPECT_EQ(rec.rate_avg, 5000);
+    progressClose(pub);
+}
+TEST_F(progressReportTestFixture, progressPublish_NULL)
+{
+    progressPublish(NULL, 1, 2, 3);
+    progressClose(NULL);
+}
+
+/*3.progressClose*/
+TEST_F(progressReportTestFixture, progressClose_record_done)
+{
+    ProgressPublisher_t *pub = progressOpen(TEST_RECORD);
+    ASSERT_NE(pub, nullptr);
+    progressPublish(pub, 100, 100, 1000);
+    progressClose(pub);
+    EXPECT_EQ(progressRead(TEST_RECORD, &rec), 0);
+    EXPECT_EQ(rec.state, PROGRESS_DONE);
+    EXPECT_EQ(rec.dlnow, 100);
+}
+
+/*4.progressRead*/
+TEST_F(progressReportTestFixture, progressRead_invalid)
+{
+    EXPECT_EQ(progressRead(NULL, &rec), -1);
+    EXPECT_EQ(progressRead(TEST_RECORD, NULL), -1);
+    EXPECT_EQ(progressRead(TEST_RECORD, &rec), -1);
+    FILE *fp = fopen(TEST_RECORD, "w");
+    ASSERT_NE(fp, nullptr);
+    fwrite(&rec, 1, sizeof(rec), fp);
+    fclose(fp);
+    EXPECT_EQ(progressRead(TEST_RECORD, &rec), -1);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include "resumeJournal.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_resumeJournal_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define JR_TEST_FILE "/tmp/resumeJournal_test.bin"
+#define JR_TEST_URL "https://example.com/image.bin"
+
+using namespace testing;
+using namespace std;
+
+class resumeJournalTestFixture : public ::testing::Test {
+	protected:
+        ResumeJournal_t jr;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            journalInit(&jr, JR_TEST_URL);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            journalRemove(JR_TEST_FILE);
+            unlink(JR_TEST_FILE);
+        }
+
+        void writeFile(size_t len)
+        {
+            FILE *fp = fopen(JR_TEST_FILE, "wb");
+            ASSERT_NE(fp, nullptr);
+            for (size_t i = 0; i < len; i++) {
+                fputc('a', fp);
+            }
+            fclose(fp);
+        }
+
+        void parse(const char *line, int http_code)
+        {
+            journalParseHeader(&jr, line, strlen(line), http_code);
+        }
+};
+
+/*1.journalSave and journalLoad*/
+TEST_F(resumeJournalTestFixture, journalSave_journalLoad_roundtrip)
+{
+    ResumeJournal_t out;
+    snprintf(jr.etag, sizeof(jr.etag), "\"abc-123\"");
+    snprintf(jr.last_modified, sizeof(jr.last_modified), "Wed, 21 Oct 2015 07:28:00 GMT");
+    jr.total_size = 5000000;
+    jr.offset = 1048576;
+    EXPECT_EQ(journalSave(JR_TEST_FILE, &jr), 0);
+    EXPECT_EQ(journalLoad(JR_TEST_FILE, &out), 0);
+    EXPECT_STREQ(out.url, JR_TEST_URL);
+    EXPECT_STREQ(out.etag, "\"abc-123\"");
+    EXPECT_STREQ(out.last_modified, "Wed, 21 Oct 2015 07:28:00 GMT");
+    EXPECT_EQ(out.total_size, 5000000);
+    EXPECT_EQ(out.offset, 1048576);
+}
+TEST_F(resumeJournalTestFixture, journalLoad_not_present)
+{
+    EXPECT_EQ(journalLoad(JR_TEST_FILE, &jr), -1);
+    EXPECT_EQ(journalLoad(NULL, &jr), -1);
+}
+TEST_F(resumeJournalTestFixture, journalLoad_invalid_content)
+{
+    FILE *fp = fopen(JR_TEST_FILE JOURNAL_SUFFIX, "w");
+    ASSERT_NE(fp, nullptr);
+    fputs("etag=\"x\"\n", fp);
+    fclose(fp);
+    EXPECT_EQ(journalLoad(JR_TEST_FILE, &jr), -1);
+}
+TEST_F(resumeJournalTestFixture, journalLoad_large_offset)
+{
+    ResumeJournal_t out;
+    jr.total_size = 5368709120LL;
+    jr.offset = 3221225472LL;
+    EXPECT_EQ(journalSave(JR_TEST_FILE, &jr), 0);
+    EXPECT_EQ(journalLoad(JR_TEST_FILE, &out), 0);
+    EXPECT_EQ(out.total_size, 5368709120LL);
+    EXPECT_EQ(out.offset, 3221225472LL);
+}
+TEST_F(resumeJournalTestFixture, journalLoad_damaged_offset)
+{
+    FILE *fp = fopen(JR_TEST_FILE JOURNAL_SUFFIX, "w");
+    ASSERT_NE(fp, nullptr);
+    fputs("url=" JR_TEST_URL "\noffset=12ab\n", fp);
+    fclose(fp);
+    EXPECT_EQ(journalLoad(JR_TEST_FILE, &jr), -1);
+    fp = fopen(JR_TEST_FILE JOURNAL_SUFFIX, "w");
+    ASSERT_NE(fp, nullptr);
+    fputs("url=" JR_TEST_URL "\noffset=99999999999999999999\n", fp);
+    fclose(fp);
+    EXPECT_EQ(journalLoad(JR_TEST_FILE, &jr), -1);
+}
+
+/*2.journalParseHeader*/
+TEST_F(resumeJournalTestFixture, journalParseHeader_full_response)
+{
+    parse("ETag: \"v1\"\r\n", 200);
+    parse("last-modified: Wed, 21 Oct 2015 07:28:00 GMT\r\n", 200);
+    parse("Content-Length: 4096\r\n", 200);
+    EXPECT_STREQ(jr.etag, "\"v1\"");
+    EXPECT_STREQ(jr.last_modified, "Wed, 21 Oct 2015 07:28:00 GMT");
+    EXPECT_EQ(jr.total_size, 4096);
+}
+TEST_F(resumeJournalTestFixture, journalParseHeader_partial_response)
+{
+    parse("Content-Length: 96\r\n", 206);
+    EXPECT_EQ(jr.total_size, -1);
+    parse("Content-Range: bytes 4000-4095/4096\r\n", 206);
+    EXPECT_EQ(jr.total_size, 4096);
+    parse("Content-Range: bytes 4000-4095/*\r\n", 206);
+    EXPECT_EQ(jr.total_size, 4096);
+    parse("Content-Range: bytes 0-99/4294967296\r\n", 206);
+    EXPECT_EQ(jr.total_size, 4294967296LL);
+    parse("Content-Range: bytes 0-99/99999999999999999999\r\n", 206);
+    EXPECT_EQ(jr.total_size, -1);
+}
+
+/*3.journalIfRange*/
+TEST_F(resumeJournalTestFixture, journalIfRange_validators)
+{
+    EXPECT_EQ(journalIfRange(&jr), nullptr);
+    snprintf(jr.etag, sizeof(jr.etag), "W/\"weak\"");
+    EXPECT_EQ(journalIfRange(&jr), nullptr);
+    snprintf(jr.last_modified, sizeof(jr.last_modified), "Wed, 21 Oct 2015 07:28:00 GMT");
+    EXPECT_STREQ(journalIfRange(&jr), "Wed, 21 Oct 2015 07:28:00 GMT");
+    snprintf(jr.etag, sizeof(jr.etag), "\"strong\"");
+    EXPECT_STREQ(journalIfRange(&jr), "\"strong\"");
+}
+
+/*4.journalResumeOffset*/
+TEST_F(resumeJournalTestFixture, journalResumeOffset_valid)
+{
+    ResumeJournal_t out;
+    writeFile(3000);
+    snprintf(jr.etag, sizeof(jr.etag), "\"v1\"");
+    jr.total_size = 8000;
+    jr.offset = 2048;
+    ASSERT_EQ(journalSave(JR_TEST_FILE, &jr), 0);
+    EXPECT_EQ(journalResumeOffset(JR_TEST_FILE, JR_TEST_URL, &out), 2048);
+    EXPECT_STREQ(out.etag, "\"v1\"");
+}
+TEST_F(resumeJournalTestFixture, journalResumeOffset_other_url)
+{
+    ResumeJournal_t out;
+    writeFile(3000);
+    snprintf(jr.etag, sizeof(jr.etag), "\"v1\"");
+    jr.offset = 2048;
+    ASSERT_EQ(journalSave(JR_TEST_FILE, &jr), 0);
+    EXPECT_EQ(journalResumeOffset(JR_TEST_FILE, "https://example.com/other.bin", &out), 0);
+}
+TEST_F(resumeJournalTestFixture, journalResumeOffset_file_shorter)
+{
+    ResumeJournal_t out;
+    writeFile(1000);
+    snprintf(jr.etag, sizeof(jr.etag), "\"v1\"");
+    jr.offset = 2048;
+    ASSERT_EQ(journalSave(JR_TEST_FILE, &jr), 0);
+    EXPECT_EQ(journalResumeOffset(JR_TEST_FILE, JR_TEST_URL, &out), 0);
+}
+TEST_F(resumeJournalTestFixture, journalResumeOffset_no_validator)
+{
+    ResumeJournal_t out;
+    writeFile(3000);
+    jr.offset = 2048;
+    ASSERT_EQ(journalSave(JR_TEST_FILE, &jr), 0);
+    EXPECT_EQ(journalResumeOffset(JR_TEST_FILE, JR_TEST_URL, &out), 0);
+}
+TEST_F(resumeJournalTestFixture, journalResumeOffset_already_complete)
+{
+    ResumeJournal_t out;
+    writeFile(3000);
+    snprintf(jr.etag, sizeof(jr.etag), "\"v1\"");
+    jr.total_size = 3000;
+    jr.offset = 3000;
+    ASSERT_EQ(journalSave(JR_TEST_FILE, &jr), 0);
+    EXPECT_EQ(journalResumeOffset(JR_TEST_FILE, JR_TEST_URL, &out), 0);
+}
+
+/*5.journalRemove*/
+TEST_F(resumeJournalTestFixture, journalRemove_present)
+{
+    ASSERT_EQ(journalSave(JR_TEST_FILE, &jr), 0);
+    journalRemove(JR_TEST_FILE);
+    EXPECT_NE(access(JR_TEST_FILE JOURNAL_SUFFIX, F_OK), 0);
+    journalRemove(NULL);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include "retryPolicy.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_retryPolicy_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+
+static int alwaysRetry(CURLcode curl_code, int http_code)
+{
+    return RETRY_AGAIN;
+}
+
+class retryPolicyTestFixture : public ::testing::Test {
+	protected:
+        retryParam_t rp;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            memset(&rp, 0, sizeof(rp));
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+        }
+};
+
+/*1.retryClassify*/
+TEST_F(retryPolicyTestFixture, retryClassify_curl_codes)
+{
+    EXPECT_EQ(retryClassify(CURLE_OK, 200), RETRY_DONE);
+    EXPECT_EQ(retryClassify(CURLE_OK, 206), RETRY_DONE);
+    EXPECT_EQ(retryClassify(CURLE_COULDNT_CONNECT, 0), RETRY_AGAIN);
+    EXPECT_EQ(retryClassify(CURLE_OPERATION_TIMEDOUT, 0), RETRY_AGAIN);
+    EXPECT_EQ(retryClassify(CURLE_PARTIAL_FILE, 200), RETRY_AGAIN);
+    EXPECT_EQ(retryClassify(CURLE_WRITE_ERROR, 200), RETRY_FATAL);
+    EXPECT_EQ(retryClassify(CURLE_RANGE_ERROR, 0), RETRY_FATAL);
+    EXPECT_EQ(retryClassify(CURLE_SSL_CERTPROBLEM, 0), RETRY_FATAL);
+}
+TEST_F(retryPolicyTestFixture, retryClassify_http_codes)
+{
+    EXPECT_EQ(retryClassify(CURLE_OK, 408), RETRY_AGAIN);
+    EXPECT_EQ(retryClassify(CURLE_OK, 429), RETRY_AGAIN);
+    EXPECT_EQ(retryClassify(CURLE_OK, 503), RETRY_AGAIN);
+    EXPECT_EQ(retryClassify(CURLE_OK, 501), RETRY_FATAL);
+    EXPECT_EQ(retryClassify(CURLE_OK, 404), RETRY_FATAL);
+    EXPECT_EQ(retryClassify(CURLE_OK, 403), RETRY_FATAL);
+}
+TEST_F(retryPolicyTestFixture, retryNetworkError_list)
+{
+    EXPECT_TRUE(retryNetworkError(CURLE_COULDNT_RESOLVE_HOST));
+    EXPECT_TRUE(retryNetworkError(CURLE_WRITE_ERROR));
+    EXPECT_FALSE(retryNetworkError(CURLE_OK));
+    EXPECT_FALSE(retryNetworkError(CURLE_SSL_CERTPROBLEM));
+}
+
+/*2.retryBegin and retryEnd*/
+TEST_F(retryPolicyTestFixture, retryBegin_nested)
+{
+    EXPECT_FALSE(retryBegin(NULL));
+    EXPECT_TRUE(retryBegin(&rp));
+    EXPECT_FALSE(retryBegin(&rp));
+    retryEnd(&rp);
+    EXPECT_TRUE(retryBegin(&rp));
+    retryEnd(&rp);
+}
+TEST_F(retryPolicyTestFixture, retryNext_not_begun)
+{
+    rp.classify = alwaysRetry;
+    EXPECT_EQ(retryNext(&rp, CURLE_COULDNT_CONNECT, 0, 0), -1);
+    EXPECT_EQ(rp.attempts, 1);
+}
+
+/*3.retryNext*/
+TEST_F(retryPolicyTestFixture, retryNext_stop_on_success_and_fatal)
+{
+    retryBegin(&rp);
+    EXPECT_EQ(retryNext(&rp, CURLE_OK, 200, 5), -1);
+    EXPECT_EQ(rp.attempts, 1);
+    EXPECT_EQ(rp.attempt[0].duration_ms, 5);
+    EXPECT_EQ(retryNext(&rp, CURLE_OK, 404, 5), -1);
+    retryEnd(&rp);
+    EXPECT_EQ(retryNext(NULL, CURLE_COULDNT_CONNECT, 0, 0), -1);
+}
+TEST_F(retryPolicyTestFixture, retryNext_max_attempts)
+{
+    rp.max_attempts = 3;
+    rp.base_delay_ms = 1;
+    rp.max_delay_ms = 1;
+    retryBegin(&rp);
+    EXPECT_EQ(retryNext(&rp, CURLE_COULDNT_CONNECT, 0, 0), 1);
+    EXPECT_EQ(retryNext(&rp, CURLE_COULDNT_CONNECT, 0, 0), 1);
+    EXPECT_EQ(retryNext(&rp, CURLE_COULDNT_CONNECT, 0, 0), -1);
+    EXPECT_EQ(rp.attempts, 3);
+    EXPECT_EQ(rp.attempt[2].delay_ms, 0);
+    retryEnd(&rp);
+}
+TEST_F(retryPolicyTestFixture, retryNext_decorrelated_jitter_limits)
+{
+    int delay;
+    unsigned int prev;
+    rp.max_attempts = 100;
+    rp.base_delay_ms = 10;
+    rp.max_delay_ms = 500;
+    rp.classify = alwaysRetry;
+    retryBegin(&rp);
+    prev = rp.base_delay_ms;
+    for (int i = 0; i < 50; i++) {
+        delay = retryNext(&rp, CURLE_OK, 500, 0);
+        ASSERT_GE(delay, 10);
+        ASSERT_LE(delay, 500);
+        ASSERT_LE((unsigned int)delay, (prev * 3 > 10) ? prev * 3 : 10);
+        prev = (unsigned int)delay;
+    }
+    retryEnd(&rp);
+}
+TEST_F(retryPolicyTestFixture, retryNext_first_delay_jittered)
+{
+    retryParam_t policies[16];
+    int first[16];
+    bool spread = false;
+    for (int i = 0; i < 16; i++) {
+        memset(&policies[i], 0, sizeof(retryParam_t));
+        policies[i].base_delay_ms = 100;
+        policies[i].max_delay_ms = 10000;
+        retryBegin(&policies[i]);
+        first[i] = retryNext(&policies[i], CURLE_COULDNT_CONNECT, 0, 0);
+        retryEnd(&policies[i]);
+        EXPECT_GE(first[i], 100);
+        EXPECT_LE(first[i], 300);
+        spread = spread || (first[i] != first[0]);
+    }
+    EXPECT_TRUE(spread);
+}
+TEST_F(retryPolicyTestFixture, retryNext_time_budget)
+{
+    rp.max_attempts = 10;
+    rp.base_delay_ms = 1000;
+    rp.budget_ms = 500;
+    retryBegin(&rp);
+    EXPECT_EQ(retryNext(&rp, CURLE_COULDNT_CONNECT, 0, 0), -1);
+    retryEnd(&rp);
+}
+
+/*4.retryWait*/
+TEST_F(retryPolicyTestFixture, retryWait_sleeps)
+{
+    unsigned long long start = retryNowMs();
+    EXPECT_EQ(0, retryWait(20, NULL, NULL));
+    EXPECT_GE(retryNowMs() - start, 20);
+}
+
+static int stopCalls;
+
+static int stopSecondCall(void *arg)
+{
+    stopCalls++;
+    return (stopCalls > 1) ? *(int *)arg : 0;
+}
+
+TEST_F(retryPolicyTestFixture, retryWait_stopped)
+{
+    int stop = 1;
+    unsigned long long start;
+
+    stopCalls = 0;
+    start = retryNowMs();
+    EXPECT_EQ(-1, retryWait(5000, stopSecondCall, &stop));
+    EXPECT_LT(retryNowMs() - start, 1000);
+    EXPECT_EQ(2, stopCalls);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
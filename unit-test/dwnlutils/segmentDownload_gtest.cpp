@@ -0,0 +1,204 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include "urlHelper.h"
+#include "segmentDownload.h"
+#include "curlPool.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_segmentDownload_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+
+using namespace testing;
+using namespace std;
+using ::testing::Return;
+
+typedef struct probeData {
+    FILE *headerfile;
+    bool accept_ranges;
+    void *map;
+} ProbeData_t;
+
+extern "C" {
+    size_t (*getprobe_header_cb(void)) (char *buffer, size_t size, size_t nitems, void *userdata);
+    int (*getsegmentPlan(void)) (curl_off_t length, segmentParam_t *seg, Segment_t *segs);
+}
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+class segmentDownloadTestFixture : public ::testing::Test {
+	protected:
+
+        CurlWrapperMock mockCurlWrapper;
+
+        segmentDownloadTestFixture()
+        {
+            g_CurlWrapperMock = &mockCurlWrapper;
+        }
+        virtual ~segmentDownloadTestFixture()
+        {
+            g_CurlWrapperMock = NULL;
+        }
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            curlPoolCleanup();
+        }
+};
+
+/*1.segmentedDownloadFile*/
+TEST_F(segmentDownloadTestFixture, segmentedDownloadFile_NULL_param)
+{
+    segmentParam_t seg = {4, 0, 0};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    EXPECT_EQ(segmentedDownloadFile(NULL, "/tmp/seg_test.bin", &seg, NULL, NULL, NULL, &bytes, &httpCode, &curl_code), SEGMENT_DWNL_NOT_POSSIBLE);
+}
+TEST_F(segmentDownloadTestFixture, segmentedDownloadFile_single_segment)
+{
+    CURL *curl = curl_easy_init();
+    segmentParam_t seg = {1, 0, 0};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(0);
+    EXPECT_EQ(segmentedDownloadFile(curl, "/tmp/seg_test.bin", &seg, NULL, NULL, NULL, &bytes, &httpCode, &curl_code), SEGMENT_DWNL_NOT_POSSIBLE);
+    curl_easy_cleanup(curl);
+}
+TEST_F(segmentDownloadTestFixture, segmentedDownloadFile_no_range_support)
+{
+    CURL *curl = curl_easy_init();
+    segmentParam_t seg = {4, 0, 0};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).WillOnce(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_EQ(segmentedDownloadFile(curl, "/tmp/seg_test.bin", &seg, NULL, NULL, NULL, &bytes, &httpCode, &curl_code), SEGMENT_DWNL_NOT_POSSIBLE);
+    EXPECT_EQ(bytes, 0);
+    EXPECT_EQ(access("/tmp/seg_test.bin.header", F_OK), 0);
+    unlink("/tmp/seg_test.bin.header");
+    curl_easy_cleanup(curl);
+}
+TEST_F(segmentDownloadTestFixture, segmentedDownloadFile_probe_fail)
+{
+    CURL *curl = curl_easy_init();
+    segmentParam_t seg = {4, 0, 0};
+    size_t bytes = 0;
+    int httpCode = 0;
+    CURLcode curl_code = CURLE_OK;
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_)).WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).WillOnce(Return(CURLE_COULDNT_CONNECT));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_)).Times(0);
+    EXPECT_EQ(segmentedDownloadFile(curl, "/tmp/seg_test.bin", &seg, NULL, NULL, NULL, &bytes, &httpCode, &curl_code), SEGMENT_DWNL_NOT_POSSIBLE);
+    unlink("/tmp/seg_test.bin.header");
+    curl_easy_cleanup(curl);
+}
+
+/*2.probe_header_cb*/
+TEST_F(segmentDownloadTestFixture, probe_header_cb_accept_ranges)
+{
+    auto header_cb = getprobe_header_cb();
+    ProbeData_t probe = {NULL, false, NULL};
+    char status[] = "HTTP/1.1 200 OK\r\n";
+    char ranges[] = "accept-ranges: bytes\r\n";
+    EXPECT_EQ(header_cb(status, 1, strlen(status), &probe), strlen(status));
+    EXPECT_FALSE(probe.accept_ranges);
+    EXPECT_EQ(header_cb(ranges, 1, strlen(ranges), &probe), strlen(ranges));
+    EXPECT_TRUE(probe.accept_ranges);
+}
+TEST_F(segmentDownloadTestFixture, probe_header_cb_redirect_resets)
+{
+    auto header_cb = getprobe_header_cb();
+    ProbeData_t probe = {NULL, false, NULL};
+    char ranges[] = "Accept-Ranges: bytes\r\n";
+    char status[] = "HTTP/1.1 200 OK\r\n";
+    char none[] = "Accept-Ranges: none\r\n";
+    header_cb(ranges, 1, strlen(ranges), &probe);
+    EXPECT_TRUE(probe.accept_ranges);
+    header_cb(status, 1, strlen(status), &probe);
+    header_cb(none, 1, strlen(none), &probe);
+    EXPECT_FALSE(probe.accept_ranges);
+}
+
+/*3.segmentPlan*/
+TEST_F(segmentDownloadTestFixture, segmentPlan_split)
+{
+    auto plan = getsegmentPlan();
+    Segment_t segs[SEGMENT_MAX_COUNT];
+    segmentParam_t seg = {4, 1000, 0};
+    EXPECT_EQ(plan(10001, &seg, segs), 4);
+    EXPECT_EQ(segs[0].start, 0);
+    EXPECT_EQ(segs[0].end, 2499);
+    EXPECT_EQ(segs[1].start, 2500);
+    EXPECT_EQ(segs[3].start, 7500);
+    EXPECT_EQ(segs[3].end, 10000);
+    EXPECT_EQ(segs[3].written, 0);
+}
+TEST_F(segmentDownloadTestFixture, segmentPlan_limited_by_min_size)
+{
+    auto plan = getsegmentPlan();
+    Segment_t segs[SEGMENT_MAX_COUNT];
+    segmentParam_t seg = {8, 1000, 0};
+    EXPECT_EQ(plan(3500, &seg, segs), 3);
+    EXPECT_EQ(segs[2].end, 3499);
+}
+TEST_F(segmentDownloadTestFixture, segmentPlan_too_small)
+{
+    auto plan = getsegmentPlan();
+    Segment_t segs[SEGMENT_MAX_COUNT];
+    segmentParam_t seg = {4, 0, 0};
+    EXPECT_LT(plan(SEGMENT_MIN_SIZE_DEFAULT, &seg, segs), 2);
+}
+TEST_F(segmentDownloadTestFixture, segmentPlan_max_count)
+{
+    auto plan = getsegmentPlan();
+    Segment_t segs[SEGMENT_MAX_COUNT];
+    segmentParam_t seg = {SEGMENT_MAX_COUNT + 10, 1, 0};
+    EXPECT_EQ(plan(100000, &seg, segs), SEGMENT_MAX_COUNT);
+    EXPECT_EQ(segs[SEGMENT_MAX_COUNT - 1].end, 99999);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
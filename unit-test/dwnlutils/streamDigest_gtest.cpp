@@ -0,0 +1,162 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+
+extern "C" {
+#include "urlHelper.h"
+#include "streamDigest.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_streamDigest_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define DIGEST_TEST_FILE "/tmp/streamDigest_test.bin"
+
+#define ABC_SHA256 "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+#define ABC_MD5 "900150983cd24fb0d6963f7d28e17f72"
+
+using namespace testing;
+using namespace std;
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+class streamDigestTestFixture : public ::testing::Test {
+	protected:
+        digestParam_t out;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            memset(&out, 0, sizeof(out));
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            unlink(DIGEST_TEST_FILE);
+        }
+
+        void writeFile(const char *content)
+        {
+            FILE *fp = fopen(DIGEST_TEST_FILE, "wb");
+            ASSERT_NE(fp, nullptr);
+            fwrite(content, 1, strlen(content), fp);
+            fclose(fp);
+        }
+};
+
+/*1.streamDigestCreate*/
+TEST_F(streamDigestTestFixture, streamDigestCreate_unknown_type)
+{
+    EXPECT_EQ(streamDigestCreate(DIGEST_NONE), nullptr);
+    EXPECT_EQ(streamDigestCreate((digestType_t)10), nullptr);
+}
+TEST_F(streamDigestTestFixture, streamDigestDestroy_NULL)
+{
+    streamDigestDestroy(NULL);
+}
+
+/*2.streamDigestUpdate and streamDigestFinal*/
+TEST_F(streamDigestTestFixture, streamDigestFinal_sha256_split_updates)
+{
+    StreamDigest_t *ctx = streamDigestCreate(DIGEST_SHA256);
+    ASSERT_NE(ctx, nullptr);
+    EXPECT_EQ(streamDigestUpdate(ctx, "a", 1), 0);
+    EXPECT_EQ(streamDigestUpdate(ctx, "bc", 2), 0);
+    EXPECT_EQ(streamDigestFinal(ctx, &out), 0);
+    EXPECT_EQ(out.digest_len, 32);
+    EXPECT_STREQ(out.digest_hex, ABC_SHA256);
+    EXPECT_EQ(out.digest[0], 0xba);
+    streamDigestDestroy(ctx);
+}
+TEST_F(streamDigestTestFixture, streamDigestFinal_md5)
+{
+    StreamDigest_t *ctx = streamDigestCreate(DIGEST_MD5);
+    ASSERT_NE(ctx, nullptr);
+    EXPECT_EQ(streamDigestUpdate(ctx, "abc", 3), 0);
+    EXPECT_EQ(streamDigestFinal(ctx, &out), 0);
+    EXPECT_EQ(out.digest_len, 16);
+    EXPECT_STREQ(out.digest_hex, ABC_MD5);
+    streamDigestDestroy(ctx);
+}
+TEST_F(streamDigestTestFixture, streamDigestUpdate_NULL_param)
+{
+    EXPECT_EQ(streamDigestUpdate(NULL, "abc", 3), -1);
+    EXPECT_EQ(streamDigestFinal(NULL, &out), -1);
+}
+
+/*3.streamDigestPrefix*/
+TEST_F(streamDigestTestFixture, streamDigestPrefix_resume_state)
+{
+    writeFile("abXXXX");
+    FILE *fp = fopen(DIGEST_TEST_FILE, "rb+");
+    ASSERT_NE(fp, nullptr);
+    StreamDigest_t *ctx = streamDigestCreate(DIGEST_SHA256);
+    ASSERT_NE(ctx, nullptr);
+    EXPECT_EQ(streamDigestPrefix(ctx, fp, 2), 0);
+    EXPECT_EQ(streamDigestUpdate(ctx, "c", 1), 0);
+    EXPECT_EQ(streamDigestFinal(ctx, &out), 0);
+    EXPECT_STREQ(out.digest_hex, ABC_SHA256);
+    streamDigestDestroy(ctx);
+    fclose(fp);
+}
+TEST_F(streamDigestTestFixture, streamDigestPrefix_short_file)
+{
+    writeFile("ab");
+    FILE *fp = fopen(DIGEST_TEST_FILE, "rb");
+    ASSERT_NE(fp, nullptr);
+    StreamDigest_t *ctx = streamDigestCreate(DIGEST_MD5);
+    ASSERT_NE(ctx, nullptr);
+    EXPECT_EQ(streamDigestPrefix(ctx, fp, 10), -1);
+    EXPECT_EQ(streamDigestPrefix(ctx, NULL, 1), -1);
+    streamDigestDestroy(ctx);
+    fclose(fp);
+}
+
+/*4.streamDigestFile*/
+TEST_F(streamDigestTestFixture, streamDigestFile_sha256)
+{
+    writeFile("abc");
+    out.type = DIGEST_SHA256;
+    EXPECT_EQ(streamDigestFile(DIGEST_TEST_FILE, &out), 0);
+    EXPECT_STREQ(out.digest_hex, ABC_SHA256);
+}
+TEST_F(streamDigestTestFixture, streamDigestFile_missing_file)
+{
+    out.type = DIGEST_MD5;
+    EXPECT_EQ(streamDigestFile("/tmp/streamDigest_not_present.bin", &out), -1);
+    EXPECT_EQ(streamDigestFile(NULL, &out), -1);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+
+extern "C" {
+#include "tlsSessionCache.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_tlsSessionCache_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define TLS_TEST_FILE "/tmp/tlsSessionCache_test.sessions"
+#define TLS_TEST_KEY "xconf.test.invalid:443:0123456789abcdef0123456789abcdef"
+
+using namespace testing;
+using namespace std;
+
+class tlsSessionCacheTestFixture : public ::testing::Test {
+	protected:
+        SSL_SESSION *session;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            unlink(TLS_TEST_FILE);
+            session = makeSession(300);
+            ASSERT_NE(session, nullptr);
+            ASSERT_EQ(tlsSessionCacheEnable(TLS_TEST_FILE), 0);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            SSL_SESSION_free(session);
+            tlsSessionCacheDisable();
+            unlink(TLS_TEST_FILE);
+        }
+
+        SSL_SESSION *makeSession(long timeout)
+        {
+            static const unsigned char master[48] = { 1, 2, 3, 4 };
+            static const unsigned char id[32] = { 5, 6, 7, 8 };
+            static const unsigned char suite[2] = { 0xC0, 0x2F };
+            SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+            SSL *ssl = (ctx != NULL) ? SSL_new(ctx) : NULL;
+            SSL_SESSION *sess = SSL_SESSION_new();
+
+            if (sess != NULL && ssl != NULL) {
+                SSL_SESSION_set_cipher(sess, SSL_CIPHER_find(ssl, suite));
+                SSL_SESSION_set_protocol_version(sess, TLS1_2_VERSION);
+                SSL_SESSION_set1_master_key(sess, master, sizeof(master));
+                SSL_SESSION_set1_id(sess, id, sizeof(id));
+                SSL_SESSION_set_time(sess, time(NULL));
+                SSL_SESSION_set_timeout(sess, timeout);
+            }
+            SSL_free(ssl);
+            SSL_CTX_free(ctx);
+            return sess;
+        }
+};
+
+/*1.tlsSessionCachePut*/
+TEST_F(tlsSessionCacheTestFixture, tlsSessionCachePut_get)
+{
+    SSL_SESSION *out;
+    unsigned char master[48];
+
+    EXPECT_TRUE(tlsSessionCacheEnabled());
+    EXPECT_EQ(tlsSessionCachePut(TLS_TEST_KEY, session), 0);
+    out = tlsSessionCacheGet(TLS_TEST_KEY);
+    ASSERT_NE(out, nullptr);
+    EXPECT_EQ(SSL_SESSION_get_master_key(out, master, sizeof(master)), sizeof(master));
+    EXPECT_EQ(master[3], 4);
+    SSL_SESSION_free(out);
+    EXPECT_EQ(tlsSessionCacheGet("other.test.invalid:443:-"), nullptr);
+}
+TEST_F(tlsSessionCacheTestFixture, tlsSessionCachePut_owner_only_file)
+{
+    struct stat st;
+
+    EXPECT_EQ(tlsSessionCachePut(TLS_TEST_KEY, session), 0);
+    ASSERT_EQ(stat(TLS_TEST_FILE, &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0600);
+}
+TEST_F(tlsSessionCacheTestFixture, tlsSessionCachePut_invalid)
+{
+    EXPECT_EQ(tlsSessionCachePut(NULL, session), -1);
+    EXPECT_EQ(tlsSessionCachePut(TLS_TEST_KEY, NULL), -1);
+    EXPECT_EQ(tlsSessionCachePut("key with space", session), -1);
+    tlsSessionCacheDisable();
+    EXPECT_EQ(tlsSessionCachePut(TLS_TEST_KEY, session), -1);
+}
+
+/*2.tlsSessionCacheGet*/
+TEST_F(tlsSessionCacheTestFixture, tlsSessionCacheGet_next_process)
+{
+    SSL_SESSION *out;
+
+    EXPECT_EQ(tlsSessionCachePut(TLS_TEST_KEY, session), 0);
+    /* Sessions are read again from the file as by a new process */
+    tlsSessionCacheDisable();
+    EXPECT_EQ(tlsSessionCacheGet(TLS_TEST_KEY), nullptr);
+    EXPECT_EQ(tlsSessionCacheEnable(TLS_TEST_FILE), 0);
+    out = tlsSessionCacheGet(TLS_TEST_KEY);
+    ASSERT_NE(out, nullptr);
+    SSL_SESSION_free(out);
+}
+TEST_F(tlsSessionCacheTestFixture, tlsSessionCacheGet_expired)
+{
+    SSL_SESSION *old = makeSession(300);
+
+    ASSERT_NE(old, nullptr);
+    SSL_SESSION_set_time(old, time(NULL) - 600);
+    EXPECT_EQ(tlsSessionCachePut(TLS_TEST_KEY, old), 0);
+    EXPECT_EQ(tlsSessionCacheGet(TLS_TEST_KEY), nullptr);
+    SSL_SESSION_free(old);
+}
+TEST_F(tlsSessionCacheTestFixture, tlsSessionCacheGet_replaced_when_full)
+{
+    char key[64];
+    SSL_SESSION *out;
+    int i;
+
+    for (i = 0; i <= TLS_SESSION_MAX; i++) {
+        snprintf(key, sizeof(key), "host%d.test.invalid:443:-", i);
+        EXPECT_EQ(tlsSessionCachePut(key, session), 0);
+    }
+    snprintf(key, sizeof(key), "host%d.test.invalid:443:-", TLS_SESSION_MAX);
+    out = tlsSessionCacheGet(key);
+    ASSERT_NE(out, nullptr);
+    SSL_SESSION_free(out);
+}
+
+/*3.tlsSessionCacheEnable*/
+TEST_F(tlsSessionCacheTestFixture, tlsSessionCacheEnable_invalid)
+{
+    EXPECT_EQ(tlsSessionCacheEnable(""), -1);
+    EXPECT_EQ(tlsSessionCacheSetopt(NULL, "https://localhost/"), CURLE_BAD_FUNCTION_ARGUMENT);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
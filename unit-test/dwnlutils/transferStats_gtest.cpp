@@ -0,0 +1,293 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+extern "C" {
+#include "urlHelper.h"
+#include "transferStats.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_transferStats_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define STATS_TEST_FILE "/tmp/transferStats_test.json"
+
+using namespace testing;
+using namespace std;
+using ::testing::Return;
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+/* Values reported by the mocked curl_easy_getinfo, times in microseconds */
+static struct {
+    curl_off_t namelookup;
+    curl_off_t connect;
+    curl_off_t appconnect;
+    curl_off_t pretransfer;
+    curl_off_t starttransfer;
+    curl_off_t total;
+    curl_off_t size_down;
+    curl_off_t size_up;
+    curl_off_t speed_down;
+    long redirects;
+    long http_code;
+} sample;
+
+static CURLcode fillInfo(CURL *curl, CURLINFO info, void *param) {
+    switch (info) {
+        case CURLINFO_NAMELOOKUP_TIME_T: *(curl_off_t *)param = sample.namelookup; break;
+        case CURLINFO_CONNECT_TIME_T: *(curl_off_t *)param = sample.connect; break;
+        case CURLINFO_APPCONNECT_TIME_T: *(curl_off_t *)param = sample.appconnect; break;
+        case CURLINFO_PRETRANSFER_TIME_T: *(curl_off_t *)param = sample.pretransfer; break;
+        case CURLINFO_STARTTRANSFER_TIME_T: *(curl_off_t *)param = sample.starttransfer; break;
+        case CURLINFO_TOTAL_TIME_T: *(curl_off_t *)param = sample.total; break;
+        case CURLINFO_SIZE_DOWNLOAD_T: *(curl_off_t *)param = sample.size_down; break;
+        case CURLINFO_SIZE_UPLOAD_T: *(curl_off_t *)param = sample.size_up; break;
+        case CURLINFO_SPEED_DOWNLOAD_T: *(curl_off_t *)param = sample.speed_down; break;
+        case CURLINFO_REDIRECT_COUNT: *(long *)param = sample.redirects; break;
+        case CURLINFO_RESPONSE_CODE: *(long *)param = sample.http_code; break;
+        default: break;
+    }
+    return CURLE_OK;
+}
+
+class transferStatsTestFixture : public ::testing::Test {
+	protected:
+
+        CurlWrapperMock mockCurlWrapper;
+        statsParam_t stats;
+        int handles[3];
+        CURL *curl;
+
+        transferStatsTestFixture()
+        {
+            g_CurlWrapperMock = &mockCurlWrapper;
+        }
+        virtual ~transferStatsTestFixture()
+        {
+            g_CurlWrapperMock = NULL;
+        }
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            /* handles are only compared, curl is mocked */
+            curl = (CURL *)&handles[0];
+            memset(&stats, 0, sizeof(stats));
+            sample.namelookup = 3000;
+            sample.connect = 5000;
+            sample.appconnect = 40000;
+            sample.pretransfer = 41000;
+            sample.starttransfer = 141000;
+            sample.total = 1141000;
+            sample.size_down = 4 * 1024 * 1024;
+            sample.size_up = 0;
+            sample.speed_down = 4 * 1024 * 1024;
+            sample.redirects = 1;
+            sample.http_code = 200;
+            EXPECT_CALL(mockCurlWrapper, curl_easy_getinfo(_, _, _)).WillRepeatedly(Invoke(fillInfo));
+            transferStatsHistogramEnable(false);
+            transferStatsHistogramReset();
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            transferStatsEnd((CURL *)&handles[0]);
+            transferStatsEnd((CURL *)&handles[1]);
+            transferStatsEnd((CURL *)&handles[2]);
+            unlink(STATS_TEST_FILE);
+        }
+
+        static void SetUpTestCase()
+        {
+            printf("%s\n", __func__);
+        }
+
+        static void TearDownTestCase()
+        {
+            printf("%s\n", __func__);
+        }
+};
+
+TEST_F(transferStatsTestFixture, TestName_Begin_NullParam)
+{
+    EXPECT_FALSE(transferStatsBegin(NULL, &stats, NULL));
+    EXPECT_FALSE(transferStatsBegin(curl, NULL, NULL));
+}
+
+TEST_F(transferStatsTestFixture, TestName_Collect_FillsBoundStats)
+{
+    EXPECT_TRUE(transferStatsBegin(curl, &stats, NULL));
+    transferStatsCollect(curl, CURLE_OK);
+    EXPECT_EQ(stats.namelookup_us, 3000);
+    EXPECT_EQ(stats.connect_us, 5000);
+    EXPECT_EQ(stats.appconnect_us, 40000);
+    EXPECT_EQ(stats.pretransfer_us, 41000);
+    EXPECT_EQ(stats.starttransfer_us, 141000);
+    EXPECT_EQ(stats.total_us, 1141000);
+    EXPECT_EQ(stats.bytes_down, 4 * 1024 * 1024);
+    EXPECT_EQ(stats.redirects, 1);
+    EXPECT_EQ(stats.requests, 1);
+    EXPECT_EQ(stats.failures, 0);
+    EXPECT_EQ(stats.retries, 0);
+    EXPECT_EQ(stats.http_code, 200);
+    EXPECT_EQ(stats.curl_code, CURLE_OK);
+    EXPECT_GT(stats.speed_down, 0);
+}
+
+TEST_F(transferStatsTestFixture, TestName_Begin_NestedKeepsStats)
+{
+    statsParam_t inner;
+
+    EXPECT_TRUE(transferStatsBegin(curl, &stats, NULL));
+    transferStatsCollect(curl, CURLE_OK);
+    EXPECT_FALSE(transferStatsBegin(curl, &inner, NULL));
+    transferStatsCollect(curl, CURLE_OK);
+    EXPECT_EQ(stats.requests, 2);
+    EXPECT_EQ(stats.bytes_down, 8 * 1024 * 1024);
+    EXPECT_EQ(stats.redirects, 2);
+}
+
+TEST_F(transferStatsTestFixture, TestName_Collect_RetryAfterFailure)
+{
+    retryParam_t retry;
+
+    memset(&retry, 0, sizeof(retry));
+    EXPECT_TRUE(transferStatsBegin(curl, &stats, &retry));
+    sample.http_code = 503;
+    transferStatsCollect(curl, CURLE_OK);
+    retry.attempts++;
+    transferStatsCollect(curl, CURLE_OPERATION_TIMEDOUT);
+    retry.attempts++;
+    sample.http_code = 200;
+    transferStatsCollect(curl, CURLE_OK);
+    EXPECT_EQ(stats.requests, 3);
+    EXPECT_EQ(stats.failures, 2);
+    EXPECT_EQ(stats.retries, 2);
+    EXPECT_EQ(stats.curl_code, CURLE_OK);
+}
+
+TEST_F(transferStatsTestFixture, TestName_Inherit_ParallelRangesNoRetry)
+{
+    CURL *seg1 = (CURL *)&handles[1];
+    CURL *seg2 = (CURL *)&handles[2];
+
+    EXPECT_TRUE(transferStatsBegin(curl, &stats, NULL));
+    EXPECT_TRUE(transferStatsInherit(seg1, curl));
+    EXPECT_TRUE(transferStatsInherit(seg2, curl));
+    EXPECT_FALSE(transferStatsInherit(seg2, curl));
+    transferStatsCollect(seg1, CURLE_OK);
+    transferStatsCollect(seg2, CURLE_OK);
+    transferStatsEnd(seg1);
+    transferStatsEnd(seg2);
+    transferStatsCollect(seg1, CURLE_OK);
+    EXPECT_EQ(stats.requests, 2);
+    EXPECT_EQ(stats.retries, 0);
+    EXPECT_EQ(stats.bytes_down, 8 * 1024 * 1024);
+}
+
+TEST_F(transferStatsTestFixture, TestName_Inherit_UnboundParent)
+{
+    EXPECT_FALSE(transferStatsInherit((CURL *)&handles[1], curl));
+}
+
+TEST_F(transferStatsTestFixture, TestName_End_StopsCollect)
+{
+    EXPECT_TRUE(transferStatsBegin(curl, &stats, NULL));
+    transferStatsEnd(curl);
+    transferStatsCollect(curl, CURLE_OK);
+    EXPECT_EQ(stats.requests, 0);
+}
+
+TEST_F(transferStatsTestFixture, TestName_Histogram_DisabledByDefault)
+{
+    TransferHistogram_t hist;
+
+    transferStatsCollect(curl, CURLE_OK);
+    transferStatsHistogramGet(&hist);
+    EXPECT_EQ(hist.requests, 0u);
+}
+
+TEST_F(transferStatsTestFixture, TestName_Histogram_Buckets)
+{
+    TransferHistogram_t hist;
+
+    transferStatsHistogramEnable(true);
+    transferStatsCollect(curl, CURLE_OK);
+    /* Connection of the pool, no connect phases */
+    sample.namelookup = 0;
+    sample.connect = 0;
+    sample.appconnect = 0;
+    sample.size_down = 0;
+    sample.http_code = 404;
+    transferStatsCollect(curl, CURLE_OK);
+    transferStatsHistogramGet(&hist);
+    EXPECT_EQ(hist.requests, 2u);
+    EXPECT_EQ(hist.failures, 1u);
+    EXPECT_EQ(hist.reused, 1u);
+    EXPECT_EQ(hist.bytes_down, 4u * 1024 * 1024);
+    EXPECT_EQ(hist.phase_ms[TRANSFER_PHASE_DNS][2], 1u);      /* 3 ms */
+    EXPECT_EQ(hist.phase_ms[TRANSFER_PHASE_CONNECT][2], 1u);  /* 2 ms */
+    EXPECT_EQ(hist.phase_ms[TRANSFER_PHASE_TLS][6], 1u);      /* 35 ms */
+    EXPECT_EQ(hist.phase_ms[TRANSFER_PHASE_TTFB][7], 2u);     /* 100 ms */
+    EXPECT_EQ(hist.phase_ms[TRANSFER_PHASE_BODY][10], 2u);    /* 1000 ms */
+    EXPECT_EQ(hist.phase_ms[TRANSFER_PHASE_TOTAL][11], 2u);   /* 1141 ms */
+    EXPECT_EQ(hist.speed_kbps[13], 1u);                       /* 4096 KiB/s */
+    transferStatsHistogramReset();
+    transferStatsHistogramGet(&hist);
+    EXPECT_EQ(hist.requests, 0u);
+}
+
+TEST_F(transferStatsTestFixture, TestName_Histogram_Dump)
+{
+    std::ifstream in;
+    std::stringstream text;
+
+    EXPECT_EQ(transferStatsHistogramDump(NULL), -1);
+    transferStatsHistogramEnable(true);
+    transferStatsCollect(curl, CURLE_OK);
+    EXPECT_EQ(transferStatsHistogramDump(STATS_TEST_FILE), 0);
+    in.open(STATS_TEST_FILE);
+    text << in.rdbuf();
+    EXPECT_NE(text.str().find("{\"requests\":1,\"failures\":0,\"reused\":0,"), std::string::npos);
+    EXPECT_NE(text.str().find("\"buckets\":[0,1,2,4,8,"), std::string::npos);
+    EXPECT_NE(text.str().find("\"dns\":[0,0,1,0,"), std::string::npos);
+    EXPECT_NE(text.str().find("\"speed_kbps\":["), std::string::npos);
+    EXPECT_EQ(access(STATS_TEST_FILE ".tmp", F_OK), -1);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+
+extern "C" {
+#include "uringWriter.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_uringWriter_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define URING_TEST_FILE "/tmp/uringWriter_test.bin"
+#define URING_TEST_BUF 4096
+
+using namespace testing;
+using namespace std;
+
+class uringWriterTestFixture : public ::testing::Test {
+	protected:
+        int fd;
+        char *bufs[2];
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            fd = open(URING_TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0644);
+            bufs[0] = (char *)malloc(URING_TEST_BUF);
+            bufs[1] = (char *)malloc(URING_TEST_BUF);
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            free(bufs[0]);
+            free(bufs[1]);
+            close(fd);
+            unlink(URING_TEST_FILE);
+        }
+};
+
+/*1.uringWriterCreate*/
+TEST_F(uringWriterTestFixture, uringWriterCreate_NULL_param)
+{
+    EXPECT_EQ(uringWriterCreate(-1, bufs, 2, URING_TEST_BUF), nullptr);
+    EXPECT_EQ(uringWriterCreate(fd, NULL, 2, URING_TEST_BUF), nullptr);
+    EXPECT_EQ(uringWriterCreate(fd, bufs, 0, URING_TEST_BUF), nullptr);
+    uringWriterDestroy(NULL);
+}
+
+/*2.uringWriterQueue, uringWriterSubmit and uringWriterReap*/
+TEST_F(uringWriterTestFixture, uringWriter_writes_at_offset)
+{
+    UringWriter_t *uw = uringWriterCreate(fd, bufs, 2, URING_TEST_BUF);
+    int index = -1;
+    long long result = 0;
+    int done = 0;
+    char check[8] = {0};
+    if (uw == NULL) {
+        GTEST_SKIP() << "io_uring not available";
+    }
+    memcpy(bufs[0], "abcd", 4);
+    memcpy(bufs[1], "wxyz", 4);
+    /* Queued writes reach the file only when submitted */
+    EXPECT_EQ(uringWriterQueue(uw, 1, 4, 4), 0);
+    EXPECT_EQ(uringWriterQueue(uw, 0, 4, 0), 0);
+    EXPECT_EQ(uringWriterReap(uw, &index, &result), 0);
+    while (done < 2) {
+        ASSERT_EQ(uringWriterSubmit(uw, true), 0);
+        while (uringWriterReap(uw, &index, &result) == 1) {
+            EXPECT_EQ(result, 4);
+            done++;
+        }
+    }
+    EXPECT_EQ(pread(fd, check, 8, 0), 8);
+    EXPECT_EQ(string(check, 8), "abcdwxyz");
+    uringWriterDestroy(uw);
+}
+TEST_F(uringWriterTestFixture, uringWriterQueue_full)
+{
+    UringWriter_t *uw = uringWriterCreate(fd, bufs, 2, URING_TEST_BUF);
+    int index;
+    long long result;
+    int i;
+    int queued = 0;
+    if (uw == NULL) {
+        GTEST_SKIP() << "io_uring not available";
+    }
+    for (i = 0; i < 64; i++) {
+        if (uringWriterQueue(uw, i % 2, 1, i) == 0) {
+            queued++;
+        }
+    }
+    EXPECT_LT(queued, 64);
+    EXPECT_EQ(uringWriterSubmit(uw, false), 0);
+    while (queued > 0) {
+        ASSERT_EQ(uringWriterSubmit(uw, true), 0);
+        while (uringWriterReap(uw, &index, &result) == 1) {
+            queued--;
+        }
+    }
+    EXPECT_EQ(uringWriterQueue(uw, 0, 1, 0), 0);
+    uringWriterSubmit(uw, true);
+    uringWriterDestroy(uw);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -19,11 +19,21 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
 #include <unistd.h>
+#include <sys/mman.h>
 
 extern "C" {
 #include "downloadUtil.h"
 #include "urlHelper.h"
+#include "cancelToken.h"
+#include "dnsCache.h"
+#include "curlPool.h"
+#include "contentCache.h"
+#include "progressReport.h"
+#include "resumeJournal.h"
 }
 #include "mocks/curl_mock.h"
 
@@ -50,6 +60,7 @@ extern "C" {
 
 extern "C" {
     size_t (*getWriteMemoryCB(void)) ( void *pvContents, size_t szOneContent, size_t numContentItems, void *userp ); 
+    size_t (*getWriteMemoryCancelCB(void)) ( void *pvContents, size_t szOneContent, size_t numContentItems, void *userp );
 }
 
 extern "C" {
@@ -283,6 +294,7 @@ TEST_F(urlHelperTestFixture, xferinfo_file_not_NULL)
     int ret;
     struct curlprogress *newinfo;
     newinfo = (struct curlprogress *) malloc (sizeof(struct curlprogress));
+    memset(newinfo, 0, sizeof(struct curlprogress));
     newinfo->prog_store = fopen("/tmp/file.txt", "w");
     
     auto myFunctionPtr = getxferinfo();
@@ -293,11 +305,27 @@ TEST_F(urlHelperTestFixture, xferinfo_file_NULL)
 {
     struct curlprogress *newinfo;
         newinfo = (struct curlprogress *) malloc (sizeof(struct curlprogress));
+    memset(newinfo, 0, sizeof(struct curlprogress));
     newinfo->prog_store = NULL;
 
     auto myFunctionPtr = getxferinfo();
     EXPECT_EQ(myFunctionPtr(newinfo, 2, 3, 4, 5), 0);
 }
+TEST_F(urlHelperTestFixture, xferinfo_cancelled)
+{
+    struct curlprogress newinfo;
+    CancelToken_t *token = cancelTokenCreate(NULL);
+    ASSERT_NE(token, nullptr);
+    memset(&newinfo, 0, sizeof(newinfo));
+    newinfo.lastruntime = 0x7fffffffffffLL;
+    newinfo.cancel = token;
+
+    auto myFunctionPtr = getxferinfo();
+    EXPECT_EQ(myFunctionPtr(&newinfo, 0, 0, 0, 0), 0);
+    cancelTokenCancel(token);
+    EXPECT_NE(myFunctionPtr(&newinfo, 0, 0, 0, 0), 0);
+    cancelTokenDestroy(token);
+}
 
 /*10.download_func*/
 TEST_F(urlHelperTestFixture, download_func_forcestop_1) //revisit
@@ -356,7 +384,53 @@ TEST_F(urlHelperTestFixture, WriteMemoryCB_memory_not_allocated)
     EXPECT_EQ(myFunctionPtr(newstring, 1, 4, pdata), 4);
 }
 
-/*12.header_callback*/
+TEST_F(urlHelperTestFixture, WriteMemoryCB_geometric_growth)
+{
+    char chunk[100];
+    DownloadData data;
+    size_t memsize = 0;
+    int grow = 0;
+    int i;
+
+    memset(chunk, 'a', sizeof(chunk));
+    data.datasize = 0;
+    data.memsize = 0;
+    data.pvOut = NULL;
+    auto myFunctionPtr = getWriteMemoryCB();
+    for (i = 0; i < 1000; i++) {
+        EXPECT_EQ(myFunctionPtr(chunk, 1, sizeof(chunk), &data), sizeof(chunk));
+        if (data.memsize != memsize) {
+            grow++;
+            memsize = data.memsize;
+        }
+    }
+    EXPECT_EQ(data.datasize, 100000);
+    EXPECT_EQ(((char *)data.pvOut)[data.datasize], 0);
+    EXPECT_LE(grow, 8);
+    free(data.pvOut);
+}
+
+TEST_F(urlHelperTestFixture, WriteMemoryCancelCB_token)
+{
+    char chunk[16];
+    DownloadData data;
+    MemCancelData_t cancel_data;
+    CancelToken_t *token = cancelTokenCreate(NULL);
+
+    memset(chunk, 'a', sizeof(chunk));
+    memset(&data, 0, sizeof(data));
+    cancel_data.data = &data;
+    cancel_data.cancel = token;
+    auto myFunctionPtr = getWriteMemoryCancelCB();
+    EXPECT_EQ(myFunctionPtr(chunk, 1, sizeof(chunk), &cancel_data), sizeof(chunk));
+    EXPECT_EQ(data.datasize, sizeof(chunk));
+    cancelTokenCancel(token);
+    EXPECT_EQ(myFunctionPtr(chunk, 1, sizeof(chunk), &cancel_data), 0);
+    EXPECT_EQ(data.datasize, sizeof(chunk));
+    free(data.pvOut);
+    cancelTokenDestroy(token);
+}
+
 TEST_F(urlHelperTestFixture, header_callback_Null_file) /*Source file*/
 {
     char output[20] ="outstring";
@@ -448,8 +522,10 @@ TEST_F(urlHelperTestFixture, urlHelperGetHeaderInfo_valid_inputs)
     memcpy(sec->cert_type, "P12", 3);
     memcpy(sec->key_pas, "key_pas", 7);
 
+    /* 12 request options plus CURLOPT_SHARE set by the curl pool */
     EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
-            .Times(12)
+            .Times(13)
+            .WillOnce(Return(CURLE_OK))
             .WillOnce(Return(CURLE_OK))
             .WillOnce(Return(CURLE_OK))
             .WillOnce(Return(CURLE_OK))
@@ -520,6 +596,19 @@ TEST_F(urlHelperTestFixture, setCommonCurlOpt_arg3_NULL)
 
     EXPECT_EQ(setCommonCurlOpt( Curl_req, url, NULL, false), CURLE_OK);
 }
+TEST_F(urlHelperTestFixture, setCommonCurlOpt_http2)
+{
+    void *Curl_req = NULL;
+    char url[30] = "https://xfinity.com";
+    Curl_req = doCurlInit();
+    /* HTTP version and stream wait are added to the common options */
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .Times(10)
+            .WillRepeatedly(Return(CURLE_OK));
+    curlPoolSetHttp2(true);
+    EXPECT_EQ(setCommonCurlOpt( Curl_req, url, NULL, false), CURLE_OK);
+    curlPoolSetHttp2(false);
+}
 TEST_F(urlHelperTestFixture, setCommonCurlOpt_arg1_NULL)
 {
     char url[30] = "http://xfinity.com";
@@ -581,6 +670,27 @@ TEST_F(urlHelperTestFixture, setCurlProgress_valid_inputs)
     EXPECT_EQ(setCurlProgress(Curl_req, newinfo), CURLE_OK);
 }
 
+TEST_F(urlHelperTestFixture, setCurlProgress_no_record)
+{
+    void *Curl_req = NULL;
+    struct curlprogress newinfo;
+    int ret;
+
+    /* Record path taken by a directory can not be opened */
+    ret = system("rm -f " CURL_PROGRESS_RECORD " && mkdir -p " CURL_PROGRESS_RECORD);
+    Curl_req = doCurlInit();
+    memset(&newinfo, 0, sizeof(newinfo));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .Times(3)
+            .WillRepeatedly(Return(CURLE_OK));
+
+    /* Callback is still installed for the cancel check */
+    EXPECT_EQ(setCurlProgress(Curl_req, &newinfo), -1);
+    EXPECT_EQ(newinfo.publisher, nullptr);
+    ret = system("rmdir " CURL_PROGRESS_RECORD);
+    (void)ret;
+}
+
 /*17.setThrottleMode*/
 TEST_F(urlHelperTestFixture, setThrottleMode_arg1_NULL)
 {
@@ -626,6 +736,7 @@ TEST_F(urlHelperTestFixture, closeFile_arg2)
     int ret;
     struct curlprogress *newinfo;
     newinfo = (struct curlprogress *) malloc (sizeof(struct curlprogress));
+    memset(newinfo, 0, sizeof(struct curlprogress));
     newinfo->prog_store = fopen("/tmp/file.txt", "w");
     closeFile(NULL, newinfo, NULL);
     free(newinfo);
@@ -645,6 +756,7 @@ TEST_F(urlHelperTestFixture, closeFile_all_arg)
     pdata = (DownloadData *) malloc(sizeof(DownloadData));
     curlprogress *newinfo;
     newinfo = (struct curlprogress *) malloc (sizeof(struct curlprogress));
+    memset(newinfo, 0, sizeof(struct curlprogress));
     newinfo->prog_store = fopen("/tmp/file.txt", "w");
     pdata->pvOut=fopen("/tmp/file2.txt", "w");
     FILE *fp = fopen("/tmp/file3.txt", "w");
@@ -718,6 +830,29 @@ TEST_F(urlHelperTestFixture, urlHelperDownloadFile_Curl56_Logic_Success)
     EXPECT_EQ(urlHelperDownloadFile(Curl_req, pathname, (char*)"0", 0, &httpcode, &curl_status), 0);
 }
 
+// Start position which is not a number or does not fit in curl_off_t asks for a full download
+TEST_F(urlHelperTestFixture, urlHelperDownloadFile_invalid_start)
+{
+    void *Curl_req = nullptr;
+    Curl_req = doCurlInit();
+
+    char pathname[32] = "/tmp/file.txt";
+    CURLcode curl_status = CURLE_OK;
+    int httpcode = 200;
+
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_, _, _))
+        .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_))
+        .Times(0);
+
+    EXPECT_EQ(urlHelperDownloadFile(Curl_req, pathname, (char*)"99999999999999999999-", 0, &httpcode, &curl_status), 0);
+    EXPECT_EQ(curl_status, CURLE_RANGE_ERROR);
+    EXPECT_EQ(httpcode, 0);
+    curl_status = CURLE_OK;
+    EXPECT_EQ(urlHelperDownloadFile(Curl_req, pathname, (char*)"abc-", 0, &httpcode, &curl_status), 0);
+    EXPECT_EQ(curl_status, CURLE_RANGE_ERROR);
+}
+
 // Test multiple retries for CURL 56: should succeed after five attempts
 TEST_F(urlHelperTestFixture, urlHelperDownloadFile_Curl56_NORetry_Success)
 {
@@ -936,6 +1071,7 @@ TEST_F(urlHelperTestFixture, urlHelperDownloadToMem_pDlHeaderData_Not_NULL)
     char header[64]  = "Content-Type: application/json";
     char pvout[256];
     DownloadData dData;
+    memset(&req_data, 0, sizeof(req_data));
     dData.datasize = 7;
 
     Curl_req = doCurlInit();
@@ -958,6 +1094,338 @@ TEST_F(urlHelperTestFixture, urlHelperDownloadToMem_pDlHeaderData_Not_NULL)
 
     EXPECT_EQ(urlHelperDownloadToMem(Curl_req, &req_data, &httpCode, &curl_status), CURLE_OK);
 }
+TEST_F(urlHelperTestFixture, urlHelperDownloadToMem_arena)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    DownloadData dData;
+    memParam_t mem;
+    memArena_t arena;
+    char base[64];
+    int httpCode = 0;
+    CURLcode curl_status = CURLE_FAILED_INIT;
+    void *Curl_req = NULL;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&dData, 0, sizeof(dData));
+    memset(&mem, 0, sizeof(mem));
+    arena.base = base;
+    arena.size = sizeof(base);
+    arena.used = 16;
+    mem.arena = &arena;
+    req_data.pDlData = &dData;
+    opts.memData = &mem;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+
+    Curl_req = doCurlInit();
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_OK));
+
+    EXPECT_EQ(urlHelperDownloadToMemEx(Curl_req, &req_data, &opts, &httpCode, &curl_status), 0);
+    EXPECT_TRUE(mem.in_arena);
+    EXPECT_EQ((char *)dData.pvOut, base + 16);
+    EXPECT_EQ(dData.memsize, sizeof(base) - 16);
+    EXPECT_EQ(arena.used, 24);
+}
+TEST_F(urlHelperTestFixture, urlHelperDownloadToMem_encoding)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    DownloadData dData;
+    encodingParam_t enc;
+    int httpCode = 0;
+    CURLcode curl_status = CURLE_FAILED_INIT;
+    void *Curl_req = NULL;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&dData, 0, sizeof(dData));
+    memset(&enc, 0, sizeof(enc));
+    enc.decoded_bytes = 99;
+    req_data.pDlData = &dData;
+    opts.encodingData = &enc;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+
+    Curl_req = doCurlInit();
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_))
+            .WillRepeatedly(Invoke([](CURL *curl, CURLINFO info, void *param){
+                    if (info == CURLINFO_SIZE_DOWNLOAD_T) {
+                        *(curl_off_t *)param = 120;
+                    }
+                    return CURLE_OK;
+                }));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_OK));
+
+    EXPECT_EQ(urlHelperDownloadToMemEx(Curl_req, &req_data, &opts, &httpCode, &curl_status), 0);
+    EXPECT_EQ(enc.wire_bytes, 120);
+    EXPECT_EQ(enc.decoded_bytes, 0);
+    EXPECT_STREQ(enc.encoding, "");
+}
+TEST_F(urlHelperTestFixture, urlHelperDownloadToMem_retry)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    DownloadData dData;
+    retryParam_t retryData;
+    int httpCode = 0;
+    CURLcode curl_status = CURLE_FAILED_INIT;
+    void *Curl_req = NULL;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&dData, 0, sizeof(dData));
+    memset(&retryData, 0, sizeof(retryData));
+    retryData.base_delay_ms = 1;
+    retryData.max_delay_ms = 1;
+    req_data.pDlData = &dData;
+    opts.retryData = &retryData;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+
+    Curl_req = doCurlInit();
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(2)
+            .WillOnce(Return(CURLE_COULDNT_CONNECT))
+            .WillOnce(Return(CURLE_OK));
+
+    urlHelperDownloadToMemEx(Curl_req, &req_data, &opts, &httpCode, &curl_status);
+    EXPECT_EQ(curl_status, CURLE_OK);
+    EXPECT_EQ(retryData.attempts, 2);
+    EXPECT_EQ(retryData.attempt[0].curl_code, CURLE_COULDNT_CONNECT);
+    free(dData.pvOut);
+    doStopDownload(Curl_req);
+}
+
+TEST_F(urlHelperTestFixture, urlHelperDownloadToMem_not_modified)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    DownloadData dData;
+    cacheParam_t cache;
+    int httpCode = 0;
+    CURLcode curl_status = CURLE_FAILED_INIT;
+    void *Curl_req = NULL;
+
+    system("rm -rf /tmp/urlHelper_cache_test");
+    contentCacheConfigure("/tmp/urlHelper_cache_test", 0);
+    ASSERT_EQ(contentCacheStoreMem("http://127.0.0.1:9998/dcm", "\"v1\"", NULL, "{\"cached\":true}", 15), 0);
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&dData, 0, sizeof(dData));
+    memset(&cache, 0, sizeof(cache));
+    req_data.pDlData = &dData;
+    opts.cacheData = &cache;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/dcm");
+
+    Curl_req = doCurlInit();
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_))
+            .WillRepeatedly(Invoke([](CURL *curl, CURLINFO info, void *param){
+                    if (info == CURLINFO_RESPONSE_CODE) {
+                        *(long *)param = 304;
+                    }
+                    return CURLE_OK;
+                }));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_OK));
+
+    EXPECT_EQ(urlHelperDownloadToMemEx(Curl_req, &req_data, &opts, &httpCode, &curl_status), 15);
+    EXPECT_EQ(httpCode, 200);
+    EXPECT_TRUE(cache.hit);
+    EXPECT_FALSE(cache.stored);
+    EXPECT_STREQ((char *)dData.pvOut, "{\"cached\":true}");
+    urlHelperReleaseMem(&dData, NULL);
+    system("rm -rf /tmp/urlHelper_cache_test");
+}
+TEST_F(urlHelperTestFixture, urlHelperDownloadFileEx_not_modified)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    cacheParam_t cache;
+    char body[32] = { 0 };
+    int httpCode = 0;
+    CURLcode curl_status = CURLE_FAILED_INIT;
+    void *Curl_req = NULL;
+    FILE *fp;
+
+    system("rm -rf /tmp/urlHelper_cache_test");
+    contentCacheConfigure("/tmp/urlHelper_cache_test", 0);
+    ASSERT_EQ(contentCacheStoreMem("http://127.0.0.1:9998/fw.bin", NULL, "Tue, 01 Oct 2024 10:00:00 GMT", "cached image", 12), 0);
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&cache, 0, sizeof(cache));
+    opts.cacheData = &cache;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/fw.bin");
+    snprintf(req_data.pathname, sizeof(req_data.pathname), "%s", "/tmp/urlHelper_cache_test.bin");
+
+    Curl_req = doCurlInit();
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_))
+            .WillRepeatedly(Invoke([](CURL *curl, CURLINFO info, void *param){
+                    if (info == CURLINFO_RESPONSE_CODE) {
+                        *(long *)param = 304;
+                    }
+                    return CURLE_OK;
+                }));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_OK));
+
+    EXPECT_EQ(urlHelperDownloadFileEx(Curl_req, &req_data, &opts, NULL, &httpCode, &curl_status), 12);
+    EXPECT_EQ(httpCode, 200);
+    EXPECT_TRUE(cache.hit);
+    fp = fopen("/tmp/urlHelper_cache_test.bin", "r");
+    ASSERT_NE(fp, nullptr);
+    EXPECT_EQ(fread(body, 1, sizeof(body) - 1, fp), 12u);
+    fclose(fp);
+    EXPECT_STREQ(body, "cached image");
+    unlink("/tmp/urlHelper_cache_test.bin");
+    unlink("/tmp/urlHelper_cache_test.bin.header");
+    system("rm -rf /tmp/urlHelper_cache_test");
+}
+TEST_F(urlHelperTestFixture, urlHelperDownloadFileEx_resume_keeps_headers)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    journalParam_t journal;
+    ResumeJournal_t jr;
+    char header[] = "X-Custom: yes";
+    int httpCode = 0;
+    CURLcode curl_status = CURLE_FAILED_INIT;
+    void *Curl_req = NULL;
+    static vector<string> sent;
+    FILE *fp;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&journal, 0, sizeof(journal));
+    memset(&jr, 0, sizeof(jr));
+    opts.journalData = &journal;
+    req_data.pHeaderData = header;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/fw.bin");
+    snprintf(req_data.pathname, sizeof(req_data.pathname), "%s", "/tmp/urlHelper_resume_test.bin");
+    fp = fopen(req_data.pathname, "w");
+    ASSERT_NE(fp, nullptr);
+    fputs("0123456789", fp);
+    fclose(fp);
+    snprintf(jr.url, sizeof(jr.url), "%s", req_data.url);
+    snprintf(jr.etag, sizeof(jr.etag), "%s", "\"v1\"");
+    jr.total_size = 100;
+    jr.offset = 10;
+    ASSERT_EQ(journalSave(req_data.pathname, &jr), 0);
+    sent.clear();
+
+    Curl_req = doCurlInit();
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .WillRepeatedly(Invoke([](CURL *curl, CURLoption option, void *param){
+                    struct curl_slist *item;
+                    if (option == CURLOPT_HTTPHEADER) {
+                        for (item = (struct curl_slist *)param; item != NULL; item = item->next) {
+                            sent.push_back(item->data);
+                        }
+                    }
+                    return CURLE_OK;
+                }));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_))
+            .WillRepeatedly(Invoke([](CURL *curl, CURLINFO info, void *param){
+                    if (info == CURLINFO_RESPONSE_CODE) {
+                        *(long *)param = 206;
+                    }
+                    return CURLE_OK;
+                }));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_OK));
+
+    urlHelperDownloadFileEx(Curl_req, &req_data, &opts, NULL, &httpCode, &curl_status);
+    EXPECT_EQ(httpCode, 206);
+    EXPECT_NE(find(sent.begin(), sent.end(), "X-Custom: yes"), sent.end());
+    EXPECT_NE(find(sent.begin(), sent.end(), "If-Range: \"v1\""), sent.end());
+    journalRemove(req_data.pathname);
+    unlink(req_data.pathname);
+    unlink("/tmp/urlHelper_resume_test.bin.header");
+}
+TEST_F(urlHelperTestFixture, urlHelperDownloadToMem_arena_full)
+{
+    FileDwnl_t req_data;
+    DwnlOptions_t opts;
+    DownloadData dData;
+    memParam_t mem;
+    memArena_t arena;
+    char base[64];
+    int httpCode = 0;
+    CURLcode curl_status = CURLE_FAILED_INIT;
+    void *Curl_req = NULL;
+
+    memset(&req_data, 0, sizeof(req_data));
+    memset(&opts, 0, sizeof(opts));
+    memset(&dData, 0, sizeof(dData));
+    memset(&mem, 0, sizeof(mem));
+    arena.base = base;
+    arena.size = sizeof(base);
+    arena.used = sizeof(base);
+    mem.arena = &arena;
+    req_data.pDlData = &dData;
+    opts.memData = &mem;
+    snprintf(req_data.url, sizeof(req_data.url), "%s", "http://127.0.0.1:9998/jsonrpc");
+
+    Curl_req = doCurlInit();
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_setopt(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_getinfo(_,_,_))
+            .WillRepeatedly(Return(CURLE_OK));
+    EXPECT_CALL(*g_CurlWrapperMock, curl_easy_perform(_)).Times(1).WillOnce(Return(CURLE_OK));
+
+    EXPECT_EQ(urlHelperDownloadToMemEx(Curl_req, &req_data, &opts, &httpCode, &curl_status), 0);
+    EXPECT_FALSE(mem.in_arena);
+    ASSERT_NE(dData.pvOut, nullptr);
+    EXPECT_TRUE((char *)dData.pvOut < base || (char *)dData.pvOut >= base + sizeof(base));
+    EXPECT_EQ(arena.used, sizeof(base));
+    free(dData.pvOut);
+}
+TEST_F(urlHelperTestFixture, urlHelperReleaseMem_heap_and_arena)
+{
+    DownloadData dData;
+    memParam_t mem;
+    char base[16];
+
+    memset(&mem, 0, sizeof(mem));
+    urlHelperReleaseMem(NULL, &mem);
+    dData.pvOut = malloc(32);
+    dData.datasize = 4;
+    dData.memsize = 32;
+    urlHelperReleaseMem(&dData, NULL);
+    EXPECT_EQ(dData.pvOut, nullptr);
+    EXPECT_EQ(dData.datasize, 0);
+    EXPECT_EQ(dData.memsize, 0);
+
+    mem.in_arena = true;
+    dData.pvOut = base;
+    dData.memsize = sizeof(base);
+    urlHelperReleaseMem(&dData, &mem);
+    EXPECT_EQ(dData.pvOut, nullptr);
+    EXPECT_FALSE(mem.in_arena);
+}
+TEST_F(urlHelperTestFixture, urlHelperReleaseMem_spilled)
+{
+    DownloadData dData;
+    memParam_t mem;
+
+    memset(&mem, 0, sizeof(mem));
+    dData.pvOut = mmap(NULL, 4096, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(dData.pvOut, MAP_FAILED);
+    dData.datasize = 4095;
+    dData.memsize = 4096;
+    mem.spilled = true;
+    urlHelperReleaseMem(&dData, &mem);
+    EXPECT_EQ(dData.pvOut, nullptr);
+    EXPECT_FALSE(mem.spilled);
+}
 TEST_F(urlHelperTestFixture, urlHelperDownloadToMem_curl_NULL)
 {
     FileDwnl_t req_data;
@@ -1184,6 +1652,8 @@ GTEST_API_ int main(int argc, char *argv[]){
 
     snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
     ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    /* Curl option counts must not depend on addresses cached by earlier runs */
+    dnsCacheConfigure(NULL, 0);
 	    ::testing::InitGoogleTest(&argc, argv);
 	        //testing::Mock::AllowLeak(mock);
 		return RUN_ALL_TESTS();
@@ -0,0 +1,308 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <chrono>
+#include <unistd.h>
+
+extern "C" {
+#include "downloadUtil.h"
+#include "writeBehind.h"
+}
+#include "mocks/curl_mock.h"
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtilities_writeBehind_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define WB_TEST_FILE "/tmp/writeBehind_test.bin"
+
+using namespace testing;
+using namespace std;
+
+CurlWrapperMock *g_CurlWrapperMock = NULL;
+
+class writeBehindTestFixture : public ::testing::Test {
+	protected:
+        DownloadData data;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            setForceStop(0);
+            data.pvOut = fopen(WB_TEST_FILE, "wb");
+            data.datasize = 0;
+            data.memsize = 0;
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            setForceStop(0);
+            if (data.pvOut != NULL) {
+                fclose((FILE *)data.pvOut);
+            }
+            unlink(WB_TEST_FILE);
+        }
+
+        long fileSize()
+        {
+            struct stat st;
+            if (stat(WB_TEST_FILE, &st) != 0) {
+                return -1;
+            }
+            return (long)st.st_size;
+        }
+};
+
+/*1.writeBehindCreate*/
+TEST_F(writeBehindTestFixture, writeBehindCreate_NULL_param)
+{
+    DownloadData empty;
+    empty.pvOut = NULL;
+    EXPECT_EQ(writeBehindCreate(NULL, NULL), nullptr);
+    EXPECT_EQ(writeBehindCreate(&empty, NULL), nullptr);
+}
+TEST_F(writeBehindTestFixture, writeBehindClose_NULL)
+{
+    EXPECT_EQ(writeBehindClose(NULL), 0);
+}
+
+/*2.writeBehindCurlCB*/
+TEST_F(writeBehindTestFixture, writeBehindCurlCB_data_written_in_order)
+{
+    writeBehindParam_t param = {2, 100};     /* rounded up to one page, ring is full often */
+    char chunk[1000];
+    size_t i;
+    WriteBehind_t *wb = writeBehindCreate(&data, &param);
+    ASSERT_NE(wb, nullptr);
+
+    for (i = 0; i < 300; i++) {
+        memset(chunk, (int)(i & 0xff), sizeof(chunk));
+        EXPECT_EQ(writeBehindCurlCB(chunk, 1, sizeof(chunk), wb), sizeof(chunk));
+    }
+    EXPECT_EQ(data.datasize, 300 * sizeof(chunk));
+    EXPECT_EQ(writeBehindClose(wb), 300 * sizeof(chunk));
+    fclose((FILE *)data.pvOut);
+    data.pvOut = NULL;
+
+    EXPECT_EQ(fileSize(), (long)(300 * sizeof(chunk)));
+    FILE *fp = fopen(WB_TEST_FILE, "rb");
+    ASSERT_NE(fp, nullptr);
+    for (i = 0; i < 300; i++) {
+        ASSERT_EQ(fread(chunk, 1, sizeof(chunk), fp), sizeof(chunk));
+        EXPECT_EQ((unsigned char)chunk[0], (unsigned char)(i & 0xff));
+        EXPECT_EQ((unsigned char)chunk[sizeof(chunk) - 1], (unsigned char)(i & 0xff));
+    }
+    fclose(fp);
+}
+TEST_F(writeBehindTestFixture, writeBehindCurlCB_force_stop)
+{
+    char chunk[16] = "force stop test";
+    WriteBehind_t *wb = writeBehindCreate(&data, NULL);
+    ASSERT_NE(wb, nullptr);
+    setForceStop(1);
+    EXPECT_EQ(writeBehindCurlCB(chunk, 1, sizeof(chunk), wb), 0);
+    EXPECT_EQ(data.datasize, 0);
+    EXPECT_EQ(writeBehindClose(wb), 0);
+}
+TEST_F(writeBehindTestFixture, writeBehindCurlCB_disk_error)
+{
+    char chunk[4096];
+    size_t ret = 0;
+    int i;
+    writeBehindParam_t param = {2, 4096};
+    fclose((FILE *)data.pvOut);
+    /* Read only stream, every write fails */
+    data.pvOut = fopen(WB_TEST_FILE, "rb");
+    ASSERT_NE(data.pvOut, nullptr);
+    setvbuf((FILE *)data.pvOut, NULL, _IONBF, 0);
+    WriteBehind_t *wb = writeBehindCreate(&data, &param);
+    ASSERT_NE(wb, nullptr);
+    memset(chunk, 'a', sizeof(chunk));
+    for (i = 0; i < 100; i++) {
+        ret = writeBehindCurlCB(chunk, 1, sizeof(chunk), wb);
+        if (ret == 0) {
+            break;
+        }
+    }
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(writeBehindFlush(wb), -1);
+    EXPECT_EQ(writeBehindClose(wb), 0);
+}
+
+/*3.writeBehindFlush*/
+TEST_F(writeBehindTestFixture, writeBehindFlush_partial_buffer)
+{
+    char chunk[10] = "123456789";
+    WriteBehind_t *wb = writeBehindCreate(&data, NULL);
+    ASSERT_NE(wb, nullptr);
+    EXPECT_EQ(writeBehindCurlCB(chunk, 1, 9, wb), 9);
+    EXPECT_EQ(writeBehindFlush(wb), 0);
+    EXPECT_EQ(fileSize(), 9);
+    EXPECT_EQ(writeBehindCurlCB(chunk, 1, 9, wb), 9);
+    EXPECT_EQ(writeBehindClose(wb), 18);
+    EXPECT_EQ(data.datasize, 18);
+}
+TEST_F(writeBehindTestFixture, writeBehindFlush_NULL)
+{
+    EXPECT_EQ(writeBehindFlush(NULL), -1);
+}
+
+/*4.io_uring backend*/
+TEST_F(writeBehindTestFixture, writeBehindCurlCB_io_uring_in_order)
+{
+    writeBehindParam_t param = {4, 100, WRITE_BEHIND_IO_URING};
+    char chunk[1000];
+    size_t i;
+    WriteBehind_t *wb = writeBehindCreate(&data, &param);
+    ASSERT_NE(wb, nullptr);
+
+    for (i = 0; i < 300; i++) {
+        memset(chunk, (int)(i & 0xff), sizeof(chunk));
+        EXPECT_EQ(writeBehindCurlCB(chunk, 1, sizeof(chunk), wb), sizeof(chunk));
+    }
+    EXPECT_EQ(writeBehindClose(wb), 300 * sizeof(chunk));
+    EXPECT_EQ(ftell((FILE *)data.pvOut), (long)(300 * sizeof(chunk)));
+    fclose((FILE *)data.pvOut);
+    data.pvOut = NULL;
+
+    FILE *fp = fopen(WB_TEST_FILE, "rb");
+    ASSERT_NE(fp, nullptr);
+    for (i = 0; i < 300; i++) {
+        ASSERT_EQ(fread(chunk, 1, sizeof(chunk), fp), sizeof(chunk));
+        EXPECT_EQ((unsigned char)chunk[0], (unsigned char)(i & 0xff));
+        EXPECT_EQ((unsigned char)chunk[sizeof(chunk) - 1], (unsigned char)(i & 0xff));
+    }
+    fclose(fp);
+}
+TEST_F(writeBehindTestFixture, writeBehindFlush_io_uring_follows_file_position)
+{
+    writeBehindParam_t param = {2, 4096, WRITE_BEHIND_IO_URING};
+    char chunk[10] = "123456789";
+    fputs("prefix", (FILE *)data.pvOut);
+    WriteBehind_t *wb = writeBehindCreate(&data, &param);
+    ASSERT_NE(wb, nullptr);
+    EXPECT_EQ(writeBehindCurlCB(chunk, 1, 9, wb), 9);
+    EXPECT_EQ(writeBehindFlush(wb), 0);
+    EXPECT_EQ(fileSize(), 15);
+    EXPECT_EQ(ftell((FILE *)data.pvOut), 15);
+    /* Position moved by the caller between flushes is used for next data */
+    fseek((FILE *)data.pvOut, 6, SEEK_SET);
+    EXPECT_EQ(writeBehindCurlCB(chunk, 1, 3, wb), 3);
+    EXPECT_EQ(writeBehindClose(wb), 12);
+    EXPECT_EQ(fileSize(), 15);
+}
+TEST_F(writeBehindTestFixture, writeBehindFlush_io_uring_large_offset)
+{
+    writeBehindParam_t param = {2, 4096, WRITE_BEHIND_IO_URING};
+    char chunk[10] = "123456789";
+    off_t start = (off_t)5 * 1024 * 1024 * 1024;
+    /* Sparse file, resumed past what a 32 bit long holds */
+    ASSERT_EQ(fseeko((FILE *)data.pvOut, start, SEEK_SET), 0);
+    WriteBehind_t *wb = writeBehindCreate(&data, &param);
+    ASSERT_NE(wb, nullptr);
+    EXPECT_EQ(writeBehindCurlCB(chunk, 1, 9, wb), 9);
+    EXPECT_EQ(writeBehindFlush(wb), 0);
+    EXPECT_EQ(ftello((FILE *)data.pvOut), start + 9);
+    EXPECT_EQ(writeBehindClose(wb), 9);
+}
+TEST_F(writeBehindTestFixture, writeBehindCurlCB_io_uring_disk_error)
+{
+    char chunk[4096];
+    size_t ret = 0;
+    int i;
+    writeBehindParam_t param = {2, 4096, WRITE_BEHIND_IO_URING};
+    fclose((FILE *)data.pvOut);
+    data.pvOut = fopen(WB_TEST_FILE, "rb");
+    ASSERT_NE(data.pvOut, nullptr);
+    WriteBehind_t *wb = writeBehindCreate(&data, &param);
+    ASSERT_NE(wb, nullptr);
+    memset(chunk, 'a', sizeof(chunk));
+    for (i = 0; i < 100; i++) {
+        ret = writeBehindCurlCB(chunk, 1, sizeof(chunk), wb);
+        if (ret == 0) {
+            break;
+        }
+    }
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(writeBehindFlush(wb), -1);
+    EXPECT_EQ(writeBehindClose(wb), 0);
+}
+
+/*5.Benchmark of the write paths, run with --gtest_also_run_disabled_tests.
+ *  Image size in MB is taken from WB_BENCH_MB, 512 by default */
+TEST_F(writeBehindTestFixture, DISABLED_writeBehind_benchmark)
+{
+    const size_t chunk_size = 16 * 1024;       /* CURL_MAX_WRITE_SIZE, what curl hands to the callback */
+    const char *env = getenv("WB_BENCH_MB");
+    size_t total = (size_t)((env != NULL) ? atoi(env) : 512) * 1024 * 1024;
+    const char *names[] = {"direct fwrite", "writer thread", "io_uring"};
+    char *chunk = (char *)malloc(chunk_size);
+    int mode;
+    ASSERT_NE(chunk, nullptr);
+    memset(chunk, 'x', chunk_size);
+
+    for (mode = 0; mode < 3; mode++) {
+        writeBehindParam_t param = {0, 0, (mode == 2) ? WRITE_BEHIND_IO_URING : WRITE_BEHIND_THREAD};
+        WriteBehind_t *wb = NULL;
+        double worst = 0;
+        size_t done;
+        if (data.pvOut != NULL) {
+            fclose((FILE *)data.pvOut);
+        }
+        data.pvOut = fopen(WB_TEST_FILE, "wb");
+        data.datasize = 0;
+        if (mode > 0) {
+            wb = writeBehindCreate(&data, &param);
+            ASSERT_NE(wb, nullptr);
+        }
+        auto start = chrono::steady_clock::now();
+        for (done = 0; done < total; done += chunk_size) {
+            auto cb_start = chrono::steady_clock::now();
+            if (wb != NULL) {
+                ASSERT_EQ(writeBehindCurlCB(chunk, 1, chunk_size, wb), chunk_size);
+            } else {
+                ASSERT_EQ(fwrite(chunk, 1, chunk_size, (FILE *)data.pvOut), chunk_size);
+            }
+            double cb = chrono::duration<double, milli>(chrono::steady_clock::now() - cb_start).count();
+            worst = (cb > worst) ? cb : worst;
+        }
+        writeBehindClose(wb);
+        fflush((FILE *)data.pvOut);
+        fdatasync(fileno((FILE *)data.pvOut));
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("%-14s %zu MB in %.3f s, %.0f MB/s, longest callback %.2f ms\n", names[mode],
+               total >> 20, secs, (total >> 20) / secs, worst);
+    }
+    free(chunk);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -32,8 +32,16 @@ extern "C" CURLcode curl_easy_setopt(CURL *curl, CURLoption option, ...)
         cout << "g_CurlWrapperMock object is NULL" << endl;
         return CURLE_OK;
     }
+    void* param = NULL;
+    /* Forward pointer options as void* so that tests can check strings and lists */
+    if (option >= CURLOPTTYPE_OBJECTPOINT && option < CURLOPTTYPE_FUNCTIONPOINT) {
+        va_list args;
+        va_start(args, option);
+        param = va_arg(args, void*);
+        va_end(args);
+    }
     printf("Inside Mock Function curl_easy_setopt\n");
-    return g_CurlWrapperMock->curl_easy_setopt(curl, option, NULL);
+    return g_CurlWrapperMock->curl_easy_setopt(curl, option, param);
 }
 
 extern "C" CURLcode curl_easy_perform(CURL *curl)
@@ -95,6 +95,30 @@ extern "C" size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_
     return g_urlHelperMock->urlHelperDownloadFile( curl, file, dnl_start_pos, chunk_dwnl_retry_time, httpCode_ret_status, curl_ret_status);
 }
 
+extern "C" size_t urlHelperDownloadFileEx(CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, char *dnl_start_pos, int *httpCode_ret_status, CURLcode *curl_ret_status)
+{
+    if (!g_urlHelperMock)
+    {
+        cout << "g_urlHelperMock object is NULL" << endl;
+        return 0;
+    }
+    printf("Inside Mock Function urlHelperDownloadFileEx\n");
+
+    return g_urlHelperMock->urlHelperDownloadFileEx( curl, pfile_dwnl, opts, dnl_start_pos, httpCode_ret_status, curl_ret_status);
+}
+
+extern "C" size_t urlHelperDownloadToMemEx( CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status )
+{
+    if (!g_urlHelperMock)
+    {
+        cout << "g_urlHelperMock object is NULL" << endl;
+        return 0;
+    }
+    printf("Inside Mock Function urlHelperDownloadToMemEx\n");
+
+    return g_urlHelperMock->urlHelperDownloadToMemEx(curl, pfile_dwnl, opts, httpCode_ret_status, curl_ret_status);
+}
+
 extern "C" CURLcode setMtlsHeaders(CURL *curl, MtlsAuth_t *sec)
 {
     if (!g_urlHelperMock)
@@ -119,3 +143,14 @@ extern "C" struct curl_slist* SetRequestHeaders( CURL *curl, struct curl_slist *
     return g_urlHelperMock->SetRequestHeaders(curl, pslist, pHeader);
 }
 
+extern "C" int getForceStop(void)
+{
+    if (!g_urlHelperMock)
+    {
+        cout << "g_urlHelperMock object is NULL" << endl;
+        return 0;
+    }
+    printf("Inside Mock Function getForceStop\n");
+
+    return g_urlHelperMock->getForceStop();
+}
@@ -30,6 +30,8 @@
 #undef urlHelperPutReuqest
 #undef urlHelperDownloadToMem
 #undef urlHelperDownloadFile
+#undef urlHelperDownloadFileEx
+#undef urlHelperDownloadToMemEx
 #undef setMtlsHeaders 
 #undef SetRequestHeaders
 
@@ -68,6 +70,8 @@ typedef struct filedwnl {
         bool sslverify;
         hashParam_t *hashData;
 }FileDwnl_t;
+
+typedef struct dwnlOptions DwnlOptions_t;
 #endif
 
 
@@ -80,8 +84,11 @@ public:
     virtual int urlHelperPutReuqest(CURL *curl, void *upData, int *httpCode_ret_status, CURLcode *curl_ret_status) = 0;
     virtual size_t urlHelperDownloadToMem( CURL *curl, FileDwnl_t *pfile_dwnl, int *httpCode_ret_status, CURLcode *curl_ret_status ) = 0;
     virtual size_t urlHelperDownloadFile(CURL *curl, const char *file, char *dnl_start_pos, int chunk_dwnl_retry_time, int *httpCode_ret_status, CURLcode *curl_ret_status) = 0;
+    virtual size_t urlHelperDownloadFileEx(CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, char *dnl_start_pos, int *httpCode_ret_status, CURLcode *curl_ret_status) = 0;
+    virtual size_t urlHelperDownloadToMemEx( CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status ) = 0;
     virtual CURLcode setMtlsHeaders(CURL *curl, MtlsAuth_t *sec) = 0;
     virtual struct curl_slist* SetRequestHeaders( CURL *curl, struct curl_slist *pslist, char *pHeader ) = 0;
+    virtual int getForceStop(void) = 0;
 };
 
 class urlHelperMock : public urlHelperInterface {
@@ -92,8 +99,11 @@ public:
     MOCK_METHOD2(setThrottleMode, CURLcode (CURL *curl, curl_off_t max_dwnl_speed));
     MOCK_METHOD4(urlHelperPutReuqest, int (CURL *curl, void *upData, int *httpCode_ret_status, CURLcode *curl_ret_status));
     MOCK_METHOD6(urlHelperDownloadFile, size_t (CURL *curl, const char *file, char *dnl_start_pos, int chunk_dwnl_retry_time, int *httpCode_ret_status, CURLcode *curl_ret_status));
+    MOCK_METHOD6(urlHelperDownloadFileEx, size_t (CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, char *dnl_start_pos, int *httpCode_ret_status, CURLcode *curl_ret_status));
+    MOCK_METHOD5(urlHelperDownloadToMemEx, size_t ( CURL *curl, FileDwnl_t *pfile_dwnl, DwnlOptions_t *opts, int *httpCode_ret_status, CURLcode *curl_ret_status ));
     MOCK_METHOD4(urlHelperDownloadToMem, size_t ( CURL *curl, FileDwnl_t *pfile_dwnl, int *httpCode_ret_status, CURLcode *curl_ret_status ));
     MOCK_METHOD2(setMtlsHeaders, CURLcode (CURL *curl, MtlsAuth_t *sec));
     MOCK_METHOD3(SetRequestHeaders, struct curl_slist* ( CURL *curl, struct curl_slist *pslist, char *pHeader ));
+    MOCK_METHOD0(getForceStop, int (void));
 };
 #endif
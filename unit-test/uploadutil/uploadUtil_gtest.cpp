@@ -26,6 +26,7 @@
 extern "C" {
 #include "uploadUtil.h"
 #include "urlHelper.h"
+#include "curlProfile.h"
 #include <stdio.h>
 #include <string.h>
 #include <curl/curl.h>
@@ -83,6 +84,10 @@ CURLcode setMtlsHeaders(CURL* curl, MtlsAuth_t* auth) {
     return CURLE_OK; // Mock success
 }
 
+CURL* curlProfileCreate(curlProfileId_t id, const char* url, char* pPostFields) {
+    return NULL; // No profile built, legacy options are set
+}
+
 // Provide the missing status tracking function with C linkage
 extern "C" void __uploadutil_set_status(long http_code, int curl_code) {
     // Mock implementation - just track the values
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+extern "C" {
+#include "tarStream.h"
+}
+
+#define GTEST_DEFAULT_RESULT_FILEPATH "/tmp/Gtest_Report/"
+#define GTEST_DEFAULT_RESULT_FILENAME "CommonUtils_tarStream_gtest_report.json"
+#define GTEST_REPORT_FILEPATH_SIZE 256
+#define TAR_TEST_DIR "/tmp/tarStream_test"
+#define TAR_TEST_ARCHIVE "/tmp/tarStream_test.tgz"
+
+using namespace testing;
+using namespace std;
+
+/* tarMember(): One ustar member, header and data padded to 512 bytes */
+static string tarMember(const string &name, char type, const string &data, const string &link = "", int mode = 0644)
+{
+    char h[512];
+    unsigned int sum = 0;
+
+    memset(h, 0, sizeof(h));
+    snprintf(h, 100, "%s", name.c_str());
+    snprintf(h + 100, 8, "%07o", mode);
+    snprintf(h + 108, 8, "%07o", 0);
+    snprintf(h + 116, 8, "%07o", 0);
+    snprintf(h + 124, 12, "%011o", (unsigned int)data.size());
+    snprintf(h + 136, 12, "%011o", 1700000000U);
+    h[156] = type;
+    snprintf(h + 157, 100, "%s", link.c_str());
+    memcpy(h + 257, "ustar", 6);
+    memcpy(h + 263, "00", 2);
+    memset(h + 148, ' ', 8);
+    for (int i = 0; i < 512; i++) {
+        sum += (unsigned char)h[i];
+    }
+    snprintf(h + 148, 8, "%06o", sum);
+    string out(h, 512);
+    out += data;
+    out.append((512 - data.size() % 512) % 512, '\0');
+    return out;
+}
+
+static string tarEnd()
+{
+    return string(1024, '\0');
+}
+
+static string gzipData(const string &in)
+{
+    z_stream zs;
+    string out(compressBound(in.size()) + 64, '\0');
+
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    zs.next_in = (Bytef *)in.data();
+    zs.avail_in = in.size();
+    zs.next_out = (Bytef *)&out[0];
+    zs.avail_out = out.size();
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+static string readFile(const string &path)
+{
+    ifstream f(path, ios::binary);
+    stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+static string pattern(size_t len)
+{
+    string s(len, '\0');
+    for (size_t i = 0; i < len; i++) {
+        s[i] = (char)((i * 31 + i / 7) & 0xff);
+    }
+    return s;
+}
+
+class tarStreamTestFixture : public ::testing::Test {
+	protected:
+        long long entries;
+        long long bytes;
+
+	virtual void SetUp()
+        {
+            printf("%s\n", __func__);
+            system("rm -rf " TAR_TEST_DIR " /tmp/tarStream_outside");
+            mkdir(TAR_TEST_DIR, 0755);
+            entries = -1;
+            bytes = -1;
+        }
+
+        virtual void TearDown()
+        {
+            printf("%s\n", __func__);
+            system("rm -rf " TAR_TEST_DIR " /tmp/tarStream_outside");
+            unlink(TAR_TEST_ARCHIVE);
+        }
+
+        /* Feed data in pieces of step bytes */
+        int feed(TarStream_t *ts, const string &data, size_t step)
+        {
+            int ret = TAR_STREAM_OK;
+            for (size_t i = 0; i < data.size() && ret == TAR_STREAM_OK; i += step) {
+                ret = tarStreamWrite(ts, data.data() + i, min(step, data.size() - i));
+            }
+            return ret;
+        }
+};
+
+/*1.tarStreamCreate*/
+TEST_F(tarStreamTestFixture, tarStreamCreate_missing_dir)
+{
+    EXPECT_EQ(tarStreamCreate(NULL), nullptr);
+    EXPECT_EQ(tarStreamCreate("/tmp/tarStream_test/missing"), nullptr);
+    EXPECT_EQ(tarStreamWrite(NULL, "x", 1), TAR_STREAM_ERROR);
+    EXPECT_EQ(tarStreamFinish(NULL, NULL, NULL), TAR_STREAM_ERROR);
+    tarStreamDestroy(NULL);
+}
+
+/*2.tarStreamWrite*/
+TEST_F(tarStreamTestFixture, tarStreamWrite_plain_byte_by_byte)
+{
+    string data = pattern(1500);
+    string archive = tarMember("dir/", '5', "") + tarMember("dir/file.bin", '0', data) + tarEnd();
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, archive, 1), TAR_STREAM_OK);
+    EXPECT_EQ(tarStreamFinish(ts, &entries, &bytes), TAR_STREAM_OK);
+    tarStreamDestroy(ts);
+    EXPECT_EQ(entries, 2);
+    EXPECT_EQ(bytes, 1500);
+    EXPECT_EQ(readFile(TAR_TEST_DIR "/dir/file.bin"), data);
+}
+TEST_F(tarStreamTestFixture, tarStreamWrite_gzip_links_and_long_name)
+{
+    struct stat st;
+    string data = pattern(200000);
+    string long_name = "deep/" + string(150, 'n') + "/file";
+    string archive = tarMember("./", '5', "") + tarMember("a.txt", '0', "hello\n", "", 0751)
+                   + tarMember("././@LongLink", 'L', long_name + string(1, '\0'))
+                   + tarMember("shortened", '0', data)
+                   + tarMember("sl", '2', "", "a.txt") + tarMember("hl", '1', "", "a.txt") + tarEnd();
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, gzipData(archive), 777), TAR_STREAM_OK);
+    EXPECT_EQ(tarStreamFinish(ts, &entries, &bytes), TAR_STREAM_OK);
+    tarStreamDestroy(ts);
+    EXPECT_EQ(entries, 4);
+    EXPECT_EQ(bytes, 200006);
+    EXPECT_EQ(readFile(string(TAR_TEST_DIR "/") + long_name), data);
+    ASSERT_EQ(stat(TAR_TEST_DIR "/a.txt", &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0751);
+    EXPECT_EQ(st.st_mtime, 1700000000);
+    EXPECT_EQ(st.st_nlink, 2);
+    EXPECT_EQ(readFile(TAR_TEST_DIR "/hl"), "hello\n");
+    char target[64] = {0};
+    EXPECT_EQ(readlink(TAR_TEST_DIR "/sl", target, sizeof(target) - 1), 5);
+    EXPECT_STREQ(target, "a.txt");
+}
+TEST_F(tarStreamTestFixture, tarStreamWrite_pax_path)
+{
+    string record = "29 path=pax/named/member.txt\n";
+    string archive = tarMember("PaxHeaders/x", 'x', record) + tarMember("short", '0', "pax") + tarEnd();
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, archive, 4096), TAR_STREAM_OK);
+    EXPECT_EQ(tarStreamFinish(ts, &entries, &bytes), TAR_STREAM_OK);
+    tarStreamDestroy(ts);
+    EXPECT_EQ(readFile(TAR_TEST_DIR "/pax/named/member.txt"), "pax");
+    EXPECT_NE(access(TAR_TEST_DIR "/short", F_OK), 0);
+}
+TEST_F(tarStreamTestFixture, tarStreamWrite_parent_path_refused)
+{
+    string archive = tarMember("../tarStream_outside", '0', "evil") + tarEnd();
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, archive, 512), TAR_STREAM_ERROR);
+    EXPECT_EQ(tarStreamWrite(ts, "x", 1), TAR_STREAM_ERROR);
+    EXPECT_EQ(tarStreamFinish(ts, NULL, NULL), TAR_STREAM_ERROR);
+    tarStreamDestroy(ts);
+    EXPECT_NE(access("/tmp/tarStream_outside", F_OK), 0);
+}
+TEST_F(tarStreamTestFixture, tarStreamWrite_through_symlink_refused)
+{
+    mkdir("/tmp/tarStream_outside", 0755);
+    string archive = tarMember("ln", '2', "", "/tmp/tarStream_outside") + tarMember("ln/evil", '0', "evil") + tarEnd();
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, archive, 512), TAR_STREAM_ERROR);
+    tarStreamDestroy(ts);
+    EXPECT_NE(access("/tmp/tarStream_outside/evil", F_OK), 0);
+}
+TEST_F(tarStreamTestFixture, tarStreamWrite_hardlink_through_symlink_refused)
+{
+    mkdir("/tmp/tarStream_outside", 0755);
+    std::ofstream("/tmp/tarStream_outside/secret") << "secret";
+    string archive = tarMember("ln", '2', "", "/tmp/tarStream_outside") + tarMember("hl", '1', "", "ln/secret") + tarEnd();
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, archive, 512), TAR_STREAM_ERROR);
+    tarStreamDestroy(ts);
+    EXPECT_NE(access(TAR_TEST_DIR "/hl", F_OK), 0);
+    struct stat st;
+    ASSERT_EQ(stat("/tmp/tarStream_outside/secret", &st), 0);
+    EXPECT_EQ(st.st_nlink, 1);
+}
+TEST_F(tarStreamTestFixture, tarStreamWrite_hardlink_to_symlink_refused)
+{
+    string archive = tarMember("sl", '2', "", "/etc/hostname") + tarMember("hl", '1', "", "sl") + tarEnd();
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, archive, 512), TAR_STREAM_ERROR);
+    tarStreamDestroy(ts);
+    EXPECT_NE(access(TAR_TEST_DIR "/hl", F_OK), 0);
+}
+TEST_F(tarStreamTestFixture, tarStreamWrite_unsupported)
+{
+    /* xz magic */
+    string data = string("\xfd" "7zXZ", 5) + string(1024, 'x');
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, data, 100), TAR_STREAM_UNSUPPORTED);
+    tarStreamDestroy(ts);
+}
+
+/*3.tarStreamFinish*/
+TEST_F(tarStreamTestFixture, tarStreamFinish_truncated_gzip)
+{
+    string archive = gzipData(tarMember("file.bin", '0', pattern(100000)) + tarEnd());
+    TarStream_t *ts = tarStreamCreate(TAR_TEST_DIR);
+    ASSERT_NE(ts, nullptr);
+    EXPECT_EQ(feed(ts, archive.substr(0, archive.size() - 6), 1000), TAR_STREAM_OK);
+    EXPECT_EQ(tarStreamFinish(ts, &entries, &bytes), TAR_STREAM_ERROR);
+    tarStreamDestroy(ts);
+    EXPECT_EQ(entries, 1);
+}
+
+/*4.tarStreamExtractFile*/
+TEST_F(tarStreamTestFixture, tarStreamExtractFile_tgz)
+{
+    string data = pattern(70000);
+    ofstream(TAR_TEST_ARCHIVE, ios::binary) << gzipData(tarMember("fw/image.bin", '0', data) + tarEnd());
+    EXPECT_EQ(tarStreamExtractFile(TAR_TEST_ARCHIVE, TAR_TEST_DIR), TAR_STREAM_OK);
+    EXPECT_EQ(readFile(TAR_TEST_DIR "/fw/image.bin"), data);
+    EXPECT_EQ(tarStreamExtractFile("/tmp/tarStream_missing.tgz", TAR_TEST_DIR), TAR_STREAM_ERROR);
+    EXPECT_EQ(tarStreamExtractFile(NULL, TAR_TEST_DIR), TAR_STREAM_ERROR);
+}
+
+GTEST_API_ int main(int argc, char *argv[]){
+    char testresults_fullfilepath[GTEST_REPORT_FILEPATH_SIZE];
+    char buffer[GTEST_REPORT_FILEPATH_SIZE];
+
+    memset( testresults_fullfilepath, 0, GTEST_REPORT_FILEPATH_SIZE );
+    memset( buffer, 0, GTEST_REPORT_FILEPATH_SIZE );
+
+    snprintf( testresults_fullfilepath, GTEST_REPORT_FILEPATH_SIZE, "json:%s%s" , GTEST_DEFAULT_RESULT_FILEPATH , GTEST_DEFAULT_RESULT_FILENAME);
+    ::testing::GTEST_FLAG(output) = testresults_fullfilepath;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
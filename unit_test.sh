@@ -49,6 +49,92 @@ echo "*********** Return value of json_parse_gtest $jsonparse"
 dwnlutils=$?
 echo "*********** Return value of downloadUtil_gtest $dwnlutils"
 
+./curlPool_gtest
+curlpool=$?
+echo "*********** Return value of curlPool_gtest $curlpool"
+
+./segmentDownload_gtest
+segdwnl=$?
+echo "*********** Return value of segmentDownload_gtest $segdwnl"
+
+./asyncDownload_gtest
+asyncdwnl=$?
+echo "*********** Return value of asyncDownload_gtest $asyncdwnl"
+
+./writeBehind_gtest
+writebehind=$?
+echo "*********** Return value of writeBehind_gtest $writebehind"
+
+./streamDigest_gtest
+streamdigest=$?
+echo "*********** Return value of streamDigest_gtest $streamdigest"
+
+./resumeJournal_gtest
+resumejournal=$?
+echo "*********** Return value of resumeJournal_gtest $resumejournal"
+
+./retryPolicy_gtest
+retrypolicy=$?
+echo "*********** Return value of retryPolicy_gtest $retrypolicy"
+
+./progressReport_gtest
+progressreport=$?
+echo "*********** Return value of progressReport_gtest $progressreport"
+
+./headerMap_gtest
+headermap=$?
+echo "*********** Return value of headerMap_gtest $headermap"
+
+./bandwidthGovernor_gtest
+bwgovernor=$?
+echo "*********** Return value of bandwidthGovernor_gtest $bwgovernor"
+
+./cancelToken_gtest
+canceltoken=$?
+echo "*********** Return value of cancelToken_gtest $canceltoken"
+
+./connectivityProbe_gtest
+connprobe=$?
+echo "*********** Return value of connectivityProbe_gtest $connprobe"
+
+./dnsCache_gtest
+dnscache=$?
+echo "*********** Return value of dnsCache_gtest $dnscache"
+
+./tlsSessionCache_gtest
+tlssession=$?
+echo "*********** Return value of tlsSessionCache_gtest $tlssession"
+
+./contentCache_gtest
+contentcache=$?
+echo "*********** Return value of contentCache_gtest $contentcache"
+
+./deltaDownload_gtest
+deltadwnl=$?
+echo "*********** Return value of deltaDownload_gtest $deltadwnl"
+
+./uringWriter_gtest
+uringwriter=$?
+echo "*********** Return value of uringWriter_gtest $uringwriter"
+
+./preallocFile_gtest
+preallocfile=$?
+echo "*********** Return value of preallocFile_gtest $preallocfile"
+
+./tarStream_gtest
+tarstream=$?
+echo "*********** Return value of tarStream_gtest $tarstream"
+
+./extractDownload_gtest
+extractdwnl=$?
+echo "*********** Return value of extractDownload_gtest $extractdwnl"
+./transferStats_gtest
+transferstats=$?
+echo "*********** Return value of transferStats_gtest $transferstats"
+./curlProfile_gtest
+curlprofile=$?
+echo "*********** Return value of curlProfile_gtest $curlprofile"
+
 ./uploadutil/mtls_upload_gtest
 mtls_upload=$?
 echo "*********** Return value of downloadUtil_gtest $mtls_upload"
@@ -67,7 +153,7 @@ echo "*********** Return value of downloadUtil_gtest $uploadUtil"
 upload_status=$?
 echo "*********** Return value of downloadUtil_gtest $upload_status"
 
-if [ "$systemutils" = "0" ] && [ "$utils" = "0" ] && [ "$upload_status" = "0" ] && [ "$uploadUtil" = "0" ] && [ "$codebig_upload" = "0" ] && [ "$mtls_upload" = "0" ] && [ "$deviceapi" = "0" ] && [ "$urlhelper" = "0" ] && [ "$jsonparse" = "0" ] && [ "$dwnlutils" = "0" ]; then
+if [ "$systemutils" = "0" ] && [ "$utils" = "0" ] && [ "$upload_status" = "0" ] && [ "$uploadUtil" = "0" ] && [ "$codebig_upload" = "0" ] && [ "$mtls_upload" = "0" ] && [ "$deviceapi" = "0" ] && [ "$urlhelper" = "0" ] && [ "$jsonparse" = "0" ] && [ "$dwnlutils" = "0" ] && [ "$curlpool" = "0" ] && [ "$segdwnl" = "0" ] && [ "$asyncdwnl" = "0" ] && [ "$writebehind" = "0" ] && [ "$streamdigest" = "0" ] && [ "$resumejournal" = "0" ] && [ "$retrypolicy" = "0" ] && [ "$progressreport" = "0" ] && [ "$headermap" = "0" ] && [ "$bwgovernor" = "0" ] && [ "$canceltoken" = "0" ] && [ "$connprobe" = "0" ] && [ "$dnscache" = "0" ] && [ "$tlssession" = "0" ] && [ "$contentcache" = "0" ] && [ "$deltadwnl" = "0" ] && [ "$uringwriter" = "0" ] && [ "$preallocfile" = "0" ] && [ "$tarstream" = "0" ] && [ "$extractdwnl" = "0" ] && [ "$transferstats" = "0" ] && [ "$curlprofile" = "0" ]; then
     cd ../
 
     lcov --capture --directory . --output-file coverage.info
@@ -22,6 +22,8 @@
 
 #include "uploadUtil.h"
 #include "downloadUtil.h"
+#include "bandwidthGovernor.h"
+#include "curlProfile.h"
 #include <stdio.h>
 #include <string.h>
 #include <curl/curl.h>
@@ -74,30 +76,37 @@ int performS3PutUpload(const char *s3url, const char *localfile, MtlsAuth_t *aut
     CURLcode ret_code = CURLE_OK;
     FILE *fp = NULL;
     long http_code = 0;
+    bool from_profile = false;
     
     if (!s3url || !localfile) {
         COMMONUTILITIES_ERROR("%s: Invalid parameters\n", __FUNCTION__);
         return -1;
     }
     
-    curl = (CURL *)doCurlInit();
-    if (!curl) {
-        COMMONUTILITIES_ERROR("%s: CURL init failed\n", __FUNCTION__);
-        return -1;
-    }
-    
-    /* Set common curl options with NULL POST fields for PUT operation */
+    /* A built S3 PUT profile already holds the common and upload options */
+    curl = curlProfileCreate(CURL_PROFILE_S3_PUT, s3url, NULL);
+    if (curl) {
+        from_profile = true;
+    } else {
+        curl = (CURL *)doCurlInit();
+        if (!curl) {
+            COMMONUTILITIES_ERROR("%s: CURL init failed\n", __FUNCTION__);
+            return -1;
+        }
+        
+        /* Set common curl options with NULL POST fields for PUT operation */
 #ifdef L2UPLOADENABLED
-    ret_code = setCommonCurlOpt(curl, s3url, NULL, false);
+        ret_code = setCommonCurlOpt(curl, s3url, NULL, false);
 #else
-    ret_code = setCommonCurlOpt(curl, s3url, NULL, true);
+        ret_code = setCommonCurlOpt(curl, s3url, NULL, true);
 #endif
-    
-    if (ret_code != CURLE_OK) {
-        COMMONUTILITIES_ERROR("%s: setCommonCurlOpt failed: %s\n",
-                __FUNCTION__, curl_easy_strerror(ret_code));
-        urlHelperDestroyCurl(curl);
-        return -1;
+        
+        if (ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("%s: setCommonCurlOpt failed: %s\n",
+                    __FUNCTION__, curl_easy_strerror(ret_code));
+            urlHelperDestroyCurl(curl);
+            return -1;
+        }
     }
     
     /* Apply mTLS if provided */
@@ -122,13 +131,24 @@ int performS3PutUpload(const char *s3url, const char *localfile, MtlsAuth_t *aut
     curl_off_t filesize = ftell(fp);
     fseek(fp, 0, SEEK_SET);
     
-    ret_code = curl_easy_setopt(curl, CURLOPT_PUT, 1L);
-    if (ret_code != CURLE_OK) {
-        COMMONUTILITIES_ERROR("%s: CURLOPT_PUT failed: %s\n",
-                __FUNCTION__, curl_easy_strerror(ret_code));
-        fclose(fp);
-        urlHelperDestroyCurl(curl);
-        return -1;
+    if (!from_profile) {
+        ret_code = curl_easy_setopt(curl, CURLOPT_PUT, 1L);
+        if (ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("%s: CURLOPT_PUT failed: %s\n",
+                    __FUNCTION__, curl_easy_strerror(ret_code));
+            fclose(fp);
+            urlHelperDestroyCurl(curl);
+            return -1;
+        }
+        /* Upload data is read through the bandwidth governor so the total cap of the process applies */
+        ret_code = curl_easy_setopt(curl, CURLOPT_READFUNCTION, bwGovernorReadCB);
+        if (ret_code != CURLE_OK) {
+            COMMONUTILITIES_ERROR("%s: CURLOPT_READFUNCTION failed: %s\n",
+                    __FUNCTION__, curl_easy_strerror(ret_code));
+            fclose(fp);
+            urlHelperDestroyCurl(curl);
+            return -1;
+        }
     }
     ret_code = curl_easy_setopt(curl, CURLOPT_READDATA, fp);
     if (ret_code != CURLE_OK) {
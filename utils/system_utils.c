@@ -19,6 +19,7 @@
 #include <ctype.h>
 #include "rdkv_cdl_log_wrapper.h"
 #include "system_utils.h"
+#include "tarStream.h"
 #include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
@@ -962,6 +963,8 @@ void copyCommandOutput (char *cmd, char *out, int len)
 }
 
 /** @brief This Function extracts the tar file in given path.
+ *         Plain and gzip compressed archives are extracted in process, the tar
+ *         command is run only for other compressions.
  *
  *  @param[in]  in_file  input tar file path
  *  @param[out] out_path Output directory
@@ -972,6 +975,7 @@ void copyCommandOutput (char *cmd, char *out, int len)
 int tarExtract(char *in_file, char *out_path)
 {
     char buff[MAX_BUFF_SIZE] = {0};
+    int ret;
 
     if(in_file == NULL) {
         COMMONUTILITIES_ERROR("Invalid input path\n");
@@ -982,6 +986,11 @@ int tarExtract(char *in_file, char *out_path)
         return RDK_API_FAILURE;
     }
 
+    ret = tarStreamExtractFile(in_file, out_path);
+    if(ret != TAR_STREAM_UNSUPPORTED) {
+        return (ret == TAR_STREAM_OK) ? RDK_API_SUCCESS : RDK_API_FAILURE;
+    }
+
     snprintf(buff, MAX_BUFF_SIZE, "tar -xvf %s -C %s", in_file, out_path);
 
     copyCommandOutput(buff, NULL, 0);
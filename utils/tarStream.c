@@ -0,0 +1,709 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "tarStream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "rdkv_cdl_log_wrapper.h"
+
+#define TAR_BLOCK 512
+#define TAR_PATH_MAX PATH_MAX
+
+/* Offsets of the ustar header fields */
+#define TAR_NAME        0
+#define TAR_MODE        100
+#define TAR_SIZE        124
+#define TAR_MTIME       136
+#define TAR_CHKSUM      148
+#define TAR_TYPE        156
+#define TAR_LINKNAME    157
+#define TAR_MAGIC       257
+#define TAR_PREFIX      345
+
+enum { TAR_FORMAT_DETECT, TAR_FORMAT_RAW, TAR_FORMAT_GZIP };
+enum { TAR_STATE_HEADER, TAR_STATE_DATA, TAR_STATE_META, TAR_STATE_SKIP, TAR_STATE_PAD, TAR_STATE_END };
+
+struct tarStream {
+    char out_path[TAR_PATH_MAX];
+    int format;                     /* compression found from the first byte */
+    z_stream zs;
+    bool zs_init;
+    bool gz_end;                    /* gzip member ended and its CRC checked */
+    unsigned char *zbuf;            /* inflated data */
+    unsigned char block[TAR_BLOCK]; /* header being received */
+    size_t block_len;
+    int state;
+    long long remaining;            /* data bytes left of current member */
+    size_t padding;                 /* bytes up to next header */
+    int fd;                         /* regular file being written, -1 otherwise */
+    char path[TAR_PATH_MAX];        /* output path of current member */
+    mode_t mode;
+    long long mtime;
+    char last_dir[TAR_PATH_MAX];    /* parent directory known to exist */
+    char meta_type;                 /* 'L', 'K' or 'x' being collected */
+    char *meta;
+    size_t meta_len;
+    char long_name[TAR_PATH_MAX];   /* name of next member from GNU 'L' or pax path */
+    char long_link[TAR_PATH_MAX];   /* link of next member from GNU 'K' or pax linkpath */
+    long long pax_size;             /* size of next member from pax, -1 if not given */
+    bool seen_header;
+    long long entries;
+    long long bytes;
+    int error;
+};
+
+TarStream_t *tarStreamCreate(const char *out_path) {
+    TarStream_t *ts;
+    struct stat st;
+
+    if (out_path == NULL || stat(out_path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        COMMONUTILITIES_ERROR("%s: output directory %s not present\n", __FUNCTION__, (out_path != NULL) ? out_path : "NULL");
+        return NULL;
+    }
+    ts = (TarStream_t *)calloc(1, sizeof(TarStream_t));
+    if (ts == NULL) {
+        COMMONUTILITIES_ERROR("%s: calloc failed\n", __FUNCTION__);
+        return NULL;
+    }
+    snprintf(ts->out_path, sizeof(ts->out_path), "%s", out_path);
+    ts->fd = -1;
+    ts->pax_size = -1;
+    return ts;
+}
+
+/* tarNumber(): Octal number field, or base-256 used by GNU tar for large values
+ * Return : long long : value, -1 when the field is not valid
+ * */
+static long long tarNumber(const unsigned char *field, size_t len) {
+    long long value = 0;
+    size_t i = 0;
+
+    if (field[0] & 0x80) {
+        value = field[0] & 0x3f;
+        for (i = 1; i < len; i++) {
+            if (value > (LLONG_MAX >> 8)) {
+                return -1;
+            }
+            value = (value << 8) | field[i];
+        }
+        return value;
+    }
+    while (i < len && (field[i] == ' ' || field[i] == '\0')) {
+        i++;
+    }
+    for (; i < len && field[i] >= '0' && field[i] <= '7'; i++) {
+        value = (value << 3) | (field[i] - '0');
+    }
+    return value;
+}
+
+/* tarChecksum(): Header checksum with the checksum field counted as spaces. Old writers used
+ * signed bytes so both sums are accepted
+ * */
+static bool tarChecksum(const unsigned char *block) {
+    long long expected = tarNumber(block + TAR_CHKSUM, 8);
+    long long usum = 0;
+    long long ssum = 0;
+    int i;
+
+    for (i = 0; i < TAR_BLOCK; i++) {
+        unsigned char c = (i >= TAR_CHKSUM && i < TAR_CHKSUM + 8) ? ' ' : block[i];
+        usum += c;
+        ssum += (signed char)c;
+    }
+    return (expected == usum || expected == ssum);
+}
+
+/* tarMemberPath(): Output path of a member name. A leading "/" or "./" is dropped like tar does,
+ * names with a ".." component are refused
+ * Return : int : 0 on success, 1 when the name is the output directory itself, -1 when refused
+ * */
+static int tarMemberPath(TarStream_t *ts, const char *name, char *out, size_t out_len) {
+    const char *p;
+    const char *seg;
+    size_t seg_len;
+
+    while (*name == '/' || (name[0] == '.' && (name[1] == '/' || name[1] == '\0'))) {
+        name += (*name == '/') ? 1 : (name[1] == '/' ? 2 : 1);
+    }
+    if (*name == '\0') {
+        return 1;
+    }
+    for (p = name; *p != '\0'; p = seg + seg_len) {
+        while (*p == '/') {
+            p++;
+        }
+        seg = p;
+        seg_len = strcspn(seg, "/");
+        if (seg_len == 2 && seg[0] == '.' && seg[1] == '.') {
+            COMMONUTILITIES_ERROR("%s: member %s leaves the output directory, refused\n", __FUNCTION__, name);
+            return -1;
+        }
+    }
+    if ((size_t)snprintf(out, out_len, "%s/%s", ts->out_path, name) >= out_len) {
+        COMMONUTILITIES_ERROR("%s: member name too long %s\n", __FUNCTION__, name);
+        return -1;
+    }
+    return 0;
+}
+
+/* tarMakeParents(): Create missing parent directories of path below the output directory.
+ * A parent which exists and is not a real directory, e.g. a symbolic link extracted before, is refused
+ * */
+static int tarMakeParents(TarStream_t *ts, char *path) {
+    char *slash = strrchr(path, '/');
+    char *p;
+    struct stat st;
+    size_t base = strlen(ts->out_path);
+
+    if (slash == NULL || (size_t)(slash - path) <= base) {
+        return 0;
+    }
+    *slash = '\0';
+    /* Members of one directory usually follow each other */
+    if (strcmp(path, ts->last_dir) == 0) {
+        *slash = '/';
+        return 0;
+    }
+    for (p = path + base + 1; ; p++) {
+        if (*p != '/' && *p != '\0') {
+            continue;
+        }
+        char c = *p;
+        *p = '\0';
+        if (mkdir(path, 0755) != 0 && (errno != EEXIST || lstat(path, &st) != 0 || !S_ISDIR(st.st_mode))) {
+            COMMONUTILITIES_ERROR("%s: unable to create directory %s errno=%d\n", __FUNCTION__, path, errno);
+            *p = c;
+            *slash = '/';
+            return -1;
+        }
+        *p = c;
+        if (c == '\0') {
+            break;
+        }
+    }
+    snprintf(ts->last_dir, sizeof(ts->last_dir), "%s", path);
+    *slash = '/';
+    return 0;
+}
+
+/* tarRemove(): Remove an existing non directory at path so the member replaces it */
+static int tarRemove(const char *path) {
+    struct stat st;
+
+    if (lstat(path, &st) != 0) {
+        return 0;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        COMMONUTILITIES_ERROR("%s: %s is a directory\n", __FUNCTION__, path);
+        return -1;
+    }
+    return unlink(path);
+}
+
+static int tarWriteAll(int fd, const unsigned char *data, size_t len) {
+    ssize_t ret;
+
+    while (len > 0) {
+        ret = write(fd, data, len);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += ret;
+        len -= (size_t)ret;
+    }
+    return 0;
+}
+
+/* tarCloseFile(): Set mode and time of the extracted file. Set-user-ID and set-group-ID bits are not restored */
+static int tarCloseFile(TarStream_t *ts) {
+    struct timespec times[2];
+    int ret = 0;
+
+    if (ts->fd < 0) {
+        return 0;
+    }
+    times[0].tv_sec = (time_t)ts->mtime;
+    times[0].tv_nsec = 0;
+    times[1] = times[0];
+    if (fchmod(ts->fd, ts->mode & 0777) != 0 || futimens(ts->fd, times) != 0) {
+        COMMONUTILITIES_INFO("%s: attributes of %s not set errno=%d\n", __FUNCTION__, ts->path, errno);
+    }
+    if (close(ts->fd) != 0) {
+        COMMONUTILITIES_ERROR("%s: close of %s failed errno=%d\n", __FUNCTION__, ts->path, errno);
+        ret = -1;
+    }
+    ts->fd = -1;
+    return ret;
+}
+
+/* tarOpenFile(): Create a regular member. An existing file is replaced, never written through a link */
+static int tarOpenFile(TarStream_t *ts) {
+    ts->fd = open(ts->path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (ts->fd < 0 && errno == EEXIST && tarRemove(ts->path) == 0) {
+        ts->fd = open(ts->path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    }
+    if (ts->fd < 0) {
+        COMMONUTILITIES_ERROR("%s: unable to create %s errno=%d\n", __FUNCTION__, ts->path, errno);
+        return -1;
+    }
+    return 0;
+}
+
+/* tarPax(): Keep path, linkpath and size of pax extended header records "<len> <key>=<value>\n" */
+static int tarPax(TarStream_t *ts) {
+    size_t pos = 0;
+
+    while (pos < ts->meta_len) {
+        char *rec = ts->meta + pos;
+        char *end;
+        char *key;
+        char *eq;
+        unsigned long len = strtoul(rec, &end, 10);
+
+        if (len == 0 || *end != ' ' || len > ts->meta_len - pos || rec[len - 1] != '\n') {
+            COMMONUTILITIES_ERROR("%s: pax header not valid\n", __FUNCTION__);
+            return -1;
+        }
+        rec[len - 1] = '\0';
+        key = end + 1;
+        eq = strchr(key, '=');
+        if (eq != NULL) {
+            *eq = '\0';
+            if (strcmp(key, "path") == 0) {
+                snprintf(ts->long_name, sizeof(ts->long_name), "%s", eq + 1);
+            } else if (strcmp(key, "linkpath") == 0) {
+                snprintf(ts->long_link, sizeof(ts->long_link), "%s", eq + 1);
+            } else if (strcmp(key, "size") == 0) {
+                ts->pax_size = strtoll(eq + 1, NULL, 10);
+            }
+        }
+        pos += len;
+    }
+    return 0;
+}
+
+/* tarMetaDone(): Apply a GNU long name or pax header to the next member */
+static int tarMetaDone(TarStream_t *ts) {
+    int ret = 0;
+
+    ts->meta[ts->meta_len] = '\0';
+    if (ts->meta_type == 'L') {
+        snprintf(ts->long_name, sizeof(ts->long_name), "%s", ts->meta);
+    } else if (ts->meta_type == 'K') {
+        snprintf(ts->long_link, sizeof(ts->long_link), "%s", ts->meta);
+    } else {
+        ret = tarPax(ts);
+    }
+    free(ts->meta);
+    ts->meta = NULL;
+    ts->meta_len = 0;
+    return ret;
+}
+
+/* tarLinkTarget(): Check a hard link target resolves below the output directory. Every component
+ * must be a real directory and the target a regular file, a symbolic link extracted before is refused
+ * */
+static int tarLinkTarget(TarStream_t *ts, char *target) {
+    char *p;
+    char c;
+    struct stat st;
+
+    for (p = target + strlen(ts->out_path) + 1; ; p++) {
+        if (*p != '/' && *p != '\0') {
+            continue;
+        }
+        c = *p;
+        *p = '\0';
+        if (lstat(target, &st) != 0 || (c == '\0' ? !S_ISREG(st.st_mode) : !S_ISDIR(st.st_mode))) {
+            COMMONUTILITIES_ERROR("%s: link target %s is not a member, refused\n", __FUNCTION__, target);
+            *p = c;
+            return -1;
+        }
+        *p = c;
+        if (c == '\0') {
+            break;
+        }
+    }
+    return 0;
+}
+
+/* tarLink(): Extract a symbolic or hard link member */
+static int tarLink(TarStream_t *ts, char type, const char *linkname) {
+    char target[TAR_PATH_MAX];
+
+    if (tarRemove(ts->path) != 0) {
+        return -1;
+    }
+    if (type == '2') {
+        if (symlink(linkname, ts->path) != 0) {
+            COMMONUTILITIES_ERROR("%s: symlink %s failed errno=%d\n", __FUNCTION__, ts->path, errno);
+            return -1;
+        }
+        return 0;
+    }
+    /* Hard link target is a member extracted before, never reached through a symbolic link */
+    if (tarMemberPath(ts, linkname, target, sizeof(target)) != 0 || tarLinkTarget(ts, target) != 0
+        || linkat(AT_FDCWD, target, AT_FDCWD, ts->path, 0) != 0) {
+        COMMONUTILITIES_ERROR("%s: link %s to %s failed errno=%d\n", __FUNCTION__, ts->path, linkname, errno);
+        return -1;
+    }
+    return 0;
+}
+
+/* tarHeader(): Start the member described by the header in ts->block */
+static int tarHeader(TarStream_t *ts) {
+    const unsigned char *b = ts->block;
+    char name[TAR_PATH_MAX];
+    char link[TAR_PATH_MAX];
+    char type = (char)b[TAR_TYPE];
+    long long size;
+    int path_ret;
+    int i;
+
+    for (i = 0; i < TAR_BLOCK && b[i] == 0; i++);
+    if (i == TAR_BLOCK) {
+        /* End of archive, the rest is padding of the last record */
+        ts->state = TAR_STATE_END;
+        return TAR_STREAM_OK;
+    }
+    if (!tarChecksum(b)) {
+        COMMONUTILITIES_ERROR("%s: header checksum not valid\n", __FUNCTION__);
+        return ts->seen_header ? TAR_STREAM_ERROR : TAR_STREAM_UNSUPPORTED;
+    }
+    ts->seen_header = true;
+    size = (ts->pax_size >= 0) ? ts->pax_size : tarNumber(b + TAR_SIZE, 12);
+    if (size < 0) {
+        COMMONUTILITIES_ERROR("%s: member size not valid\n", __FUNCTION__);
+        return TAR_STREAM_ERROR;
+    }
+    ts->remaining = size;
+    ts->padding = (size_t)((TAR_BLOCK - (size % TAR_BLOCK)) % TAR_BLOCK);
+    ts->state = (size > 0) ? TAR_STATE_SKIP : TAR_STATE_HEADER;
+
+    if (type == 'L' || type == 'K' || type == 'x') {
+        if (size > TAR_STREAM_META_MAX || (ts->meta = (char *)malloc((size_t)size + 1)) == NULL) {
+            COMMONUTILITIES_ERROR("%s: extended header of %lld bytes not supported\n", __FUNCTION__, size);
+            return TAR_STREAM_ERROR;
+        }
+        ts->meta_type = type;
+        ts->meta_len = 0;
+        ts->state = TAR_STATE_META;
+        if (size == 0) {
+            ts->state = TAR_STATE_HEADER;
+            return (tarMetaDone(ts) == 0) ? TAR_STREAM_OK : TAR_STREAM_ERROR;
+        }
+        return TAR_STREAM_OK;
+    }
+
+    if (ts->long_name[0] != '\0') {
+        snprintf(name, sizeof(name), "%s", ts->long_name);
+    } else if (memcmp(b + TAR_MAGIC, "ustar", 5) == 0 && b[TAR_PREFIX] != '\0') {
+        snprintf(name, sizeof(name), "%.*s/%.*s", (int)strnlen((const char *)b + TAR_PREFIX, 155), b + TAR_PREFIX,
+                 (int)strnlen((const char *)b + TAR_NAME, 100), b + TAR_NAME);
+    } else {
+        snprintf(name, sizeof(name), "%.*s", (int)strnlen((const char *)b + TAR_NAME, 100), b + TAR_NAME);
+    }
+    if (ts->long_link[0] != '\0') {
+        snprintf(link, sizeof(link), "%s", ts->long_link);
+    } else {
+        snprintf(link, sizeof(link), "%.*s", (int)strnlen((const char *)b + TAR_LINKNAME, 100), b + TAR_LINKNAME);
+    }
+    ts->long_name[0] = '\0';
+    ts->long_link[0] = '\0';
+    ts->pax_size = -1;
+
+    if (type == 'g') {
+        return TAR_STREAM_OK;   /* pax global header, data skipped */
+    }
+    path_ret = tarMemberPath(ts, name, ts->path, sizeof(ts->path));
+    if (path_ret < 0) {
+        return TAR_STREAM_ERROR;
+    }
+    if (path_ret == 1) {
+        return TAR_STREAM_OK;   /* "./" entry of the output directory */
+    }
+    ts->mode = (mode_t)tarNumber(b + TAR_MODE, 8);
+    ts->mtime = tarNumber(b + TAR_MTIME, 12);
+    if (tarMakeParents(ts, ts->path) != 0) {
+        return TAR_STREAM_ERROR;
+    }
+    switch (type) {
+        case '0':
+        case '\0':
+        case '7':
+            if (tarOpenFile(ts) != 0) {
+                return TAR_STREAM_ERROR;
+            }
+            ts->entries++;
+            if (size > 0) {
+                ts->state = TAR_STATE_DATA;
+            } else if (tarCloseFile(ts) != 0) {
+                return TAR_STREAM_ERROR;
+            }
+            break;
+        case '5':
+            if (mkdir(ts->path, (ts->mode & 0777) | 0700) != 0 && errno != EEXIST) {
+                COMMONUTILITIES_ERROR("%s: unable to create directory %s errno=%d\n", __FUNCTION__, ts->path, errno);
+                return TAR_STREAM_ERROR;
+            }
+            ts->entries++;
+            break;
+        case '1':
+        case '2':
+            if (tarLink(ts, type, link) != 0) {
+                return TAR_STREAM_ERROR;
+            }
+            ts->entries++;
+            break;
+        default:
+            /* Devices, fifos and vendor types are not extracted, same as tar run without privileges */
+            COMMONUTILITIES_INFO("%s: member %s of type %c skipped\n", __FUNCTION__, name, type);
+            break;
+    }
+    return TAR_STREAM_OK;
+}
+
+/* tarData(): Parse inflated archive bytes */
+static int tarData(TarStream_t *ts, const unsigned char *data, size_t len) {
+    size_t n;
+    int ret;
+
+    while (len > 0) {
+        switch (ts->state) {
+            case TAR_STATE_HEADER:
+                n = TAR_BLOCK - ts->block_len;
+                n = (n < len) ? n : len;
+                memcpy(ts->block + ts->block_len, data, n);
+                ts->block_len += n;
+                if (ts->block_len == TAR_BLOCK) {
+                    ts->block_len = 0;
+                    ret = tarHeader(ts);
+                    if (ret != TAR_STREAM_OK) {
+                        return ret;
+                    }
+                }
+                break;
+            case TAR_STATE_DATA:
+            case TAR_STATE_META:
+            case TAR_STATE_SKIP:
+                n = ((long long)len < ts->remaining) ? len : (size_t)ts->remaining;
+                if (ts->state == TAR_STATE_DATA) {
+                    if (tarWriteAll(ts->fd, data, n) != 0) {
+                        COMMONUTILITIES_ERROR("%s: write of %s failed errno=%d\n", __FUNCTION__, ts->path, errno);
+                        return TAR_STREAM_ERROR;
+                    }
+                    ts->bytes += (long long)n;
+                } else if (ts->state == TAR_STATE_META) {
+                    memcpy(ts->meta + ts->meta_len, data, n);
+                    ts->meta_len += n;
+                }
+                ts->remaining -= (long long)n;
+                if (ts->remaining == 0) {
+                    if (ts->state == TAR_STATE_DATA && tarCloseFile(ts) != 0) {
+                        return TAR_STREAM_ERROR;
+                    }
+                    if (ts->state == TAR_STATE_META && tarMetaDone(ts) != 0) {
+                        return TAR_STREAM_ERROR;
+                    }
+                    ts->state = (ts->padding > 0) ? TAR_STATE_PAD : TAR_STATE_HEADER;
+                }
+                break;
+            case TAR_STATE_PAD:
+                n = (len < ts->padding) ? len : ts->padding;
+                ts->padding -= n;
+                if (ts->padding == 0) {
+                    ts->state = TAR_STATE_HEADER;
+                }
+                break;
+            default:
+                n = len;
+                break;
+        }
+        data += n;
+        len -= n;
+    }
+    return TAR_STREAM_OK;
+}
+
+/* tarInflate(): Inflate gzip data into the tar parser. Concatenated gzip members are accepted */
+static int tarInflate(TarStream_t *ts, const unsigned char *data, size_t len) {
+    int zret;
+    int ret;
+    size_t produced;
+
+    ts->zs.next_in = (Bytef *)data;
+    ts->zs.avail_in = (uInt)len;
+    while (ts->zs.avail_in > 0) {
+        if (ts->gz_end) {
+            if (ts->state == TAR_STATE_END) {
+                return TAR_STREAM_OK;   /* data after the archive is ignored like tar does */
+            }
+            inflateReset(&ts->zs);
+            ts->gz_end = false;
+        }
+        do {
+            ts->zs.next_out = ts->zbuf;
+            ts->zs.avail_out = TAR_STREAM_BUF_SIZE;
+            zret = inflate(&ts->zs, Z_NO_FLUSH);
+            if (zret != Z_OK && zret != Z_STREAM_END && zret != Z_BUF_ERROR) {
+                COMMONUTILITIES_ERROR("%s: gzip data not valid zlib=%d %s\n", __FUNCTION__, zret, (ts->zs.msg != NULL) ? ts->zs.msg : "");
+                return TAR_STREAM_ERROR;
+            }
+            produced = TAR_STREAM_BUF_SIZE - ts->zs.avail_out;
+            if (produced > 0) {
+                ret = tarData(ts, ts->zbuf, produced);
+                if (ret != TAR_STREAM_OK) {
+                    return ret;
+                }
+            }
+            if (zret == Z_STREAM_END) {
+                ts->gz_end = true;
+                break;
+            }
+        } while (ts->zs.avail_out == 0);
+        if (!ts->gz_end && zret == Z_BUF_ERROR && ts->zs.avail_in > 0) {
+            return TAR_STREAM_ERROR;
+        }
+    }
+    return TAR_STREAM_OK;
+}
+
+int tarStreamWrite(TarStream_t *ts, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+
+    if (ts == NULL || (data == NULL && len > 0)) {
+        return TAR_STREAM_ERROR;
+    }
+    if (ts->error != TAR_STREAM_OK || len == 0) {
+        return ts->error;
+    }
+    if (ts->format == TAR_FORMAT_DETECT) {
+        /* gzip starts with 1f 8b, a tar header starts with a member name */
+        if (p[0] == 0x1f) {
+            ts->zbuf = (unsigned char *)malloc(TAR_STREAM_BUF_SIZE);
+            if (ts->zbuf == NULL || inflateInit2(&ts->zs, 15 + 16) != Z_OK) {
+                COMMONUTILITIES_ERROR("%s: inflate init failed\n", __FUNCTION__);
+                ts->error = TAR_STREAM_ERROR;
+                return ts->error;
+            }
+            ts->zs_init = true;
+            ts->format = TAR_FORMAT_GZIP;
+        } else {
+            ts->format = TAR_FORMAT_RAW;
+        }
+    }
+    if (ts->format == TAR_FORMAT_GZIP) {
+        ts->error = tarInflate(ts, p, len);
+    } else {
+        ts->error = tarData(ts, p, len);
+    }
+    return ts->error;
+}
+
+int tarStreamFinish(TarStream_t *ts, long long *entries, long long *bytes) {
+    bool complete;
+
+    if (ts == NULL) {
+        return TAR_STREAM_ERROR;
+    }
+    if (entries != NULL) {
+        *entries = ts->entries;
+    }
+    if (bytes != NULL) {
+        *bytes = ts->bytes;
+    }
+    /* Like tar an archive without end blocks is accepted when it stops on a member boundary.
+     * gzip data must reach its trailer so its CRC was checked */
+    complete = (ts->error == TAR_STREAM_OK && ts->seen_header
+                && (ts->state == TAR_STATE_END || (ts->state == TAR_STATE_HEADER && ts->block_len == 0))
+                && (ts->format != TAR_FORMAT_GZIP || ts->gz_end));
+    if (!complete) {
+        COMMONUTILITIES_ERROR("%s: archive not complete in %s, %lld members extracted\n", __FUNCTION__, ts->out_path, ts->entries);
+        return TAR_STREAM_ERROR;
+    }
+    COMMONUTILITIES_INFO("%s: %lld members, %lld bytes extracted in %s\n", __FUNCTION__, ts->entries, ts->bytes, ts->out_path);
+    return TAR_STREAM_OK;
+}
+
+void tarStreamDestroy(TarStream_t *ts) {
+    if (ts == NULL) {
+        return;
+    }
+    if (ts->fd >= 0) {
+        close(ts->fd);
+    }
+    if (ts->zs_init) {
+        inflateEnd(&ts->zs);
+    }
+    free(ts->zbuf);
+    free(ts->meta);
+    free(ts);
+}
+
+int tarStreamExtractFile(const char *in_file, const char *out_path) {
+    TarStream_t *ts;
+    unsigned char *buf;
+    ssize_t len;
+    int fd;
+    int ret = TAR_STREAM_OK;
+
+    if (in_file == NULL || out_path == NULL) {
+        COMMONUTILITIES_ERROR("%s: parameter is NULL\n", __FUNCTION__);
+        return TAR_STREAM_ERROR;
+    }
+    fd = open(in_file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        COMMONUTILITIES_ERROR("%s: unable to open %s\n", __FUNCTION__, in_file);
+        return TAR_STREAM_ERROR;
+    }
+    ts = tarStreamCreate(out_path);
+    buf = (unsigned char *)malloc(TAR_STREAM_BUF_SIZE);
+    if (ts == NULL || buf == NULL) {
+        ret = TAR_STREAM_ERROR;
+    }
+    while (ret == TAR_STREAM_OK) {
+        len = read(fd, buf, TAR_STREAM_BUF_SIZE);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            ret = (len == 0) ? tarStreamFinish(ts, NULL, NULL) : TAR_STREAM_ERROR;
+            break;
+        }
+        ret = tarStreamWrite(ts, buf, (size_t)len);
+    }
+    free(buf);
+    tarStreamDestroy(ts);
+    close(fd);
+    return ret;
+}
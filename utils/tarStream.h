@@ -0,0 +1,84 @@
+/*
+ * Copyright 2023 Comcast Cable Communications Management, LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef VIDEO_UTILS_TAR_STREAM_H_
+#define VIDEO_UTILS_TAR_STREAM_H_
+
+#include <stddef.h>
+
+/* In process extraction of a tar archive, plain or gzip compressed, fed in pieces of any size.
+ * Data is inflated and members are written to the output directory while it arrives, so the
+ * archive itself is never stored. Regular files, directories, symbolic and hard links are
+ * extracted with GNU long names and pax path, linkpath and size records. Member names which
+ * are absolute or contain ".." and members reached through a symbolic link are refused */
+
+#define TAR_STREAM_OK            0
+#define TAR_STREAM_ERROR        -1  /* broken archive or file system error, extraction stopped */
+#define TAR_STREAM_UNSUPPORTED  -2  /* data is neither gzip nor tar, e.g. bzip2 or xz */
+
+#ifndef TAR_STREAM_BUF_SIZE //This is to provide an option Define custom inflate buffer size using DFLAGS
+#define TAR_STREAM_BUF_SIZE (64 * 1024)
+#endif
+
+#ifndef TAR_STREAM_META_MAX //This is to provide an option Define custom largest pax header or long name using DFLAGS
+#define TAR_STREAM_META_MAX (64 * 1024)
+#endif
+
+typedef struct tarStream TarStream_t;
+
+/** Description: Start extraction of an archive into a directory.
+ *
+ *  @param out_path: Existing directory the members are written to.
+ *  @return TarStream_t pointer, NULL on failure.
+ */
+TarStream_t *tarStreamCreate(const char *out_path);
+
+/** Description: Extract next piece of the archive. Compression is found from the first bytes.
+ *
+ *  @param ts: Stream from tarStreamCreate.
+ *  @param data: Archive bytes in the order of the archive.
+ *  @param len: Length of data.
+ *  @return TAR_STREAM_OK, TAR_STREAM_ERROR or TAR_STREAM_UNSUPPORTED. After an error the stream
+ *          keeps failing.
+ */
+int tarStreamWrite(TarStream_t *ts, const void *data, size_t len);
+
+/** Description: Check the end of the archive was reached and get its totals.
+ *
+ *  @param ts: Stream from tarStreamCreate.
+ *  @param entries: Send back count of extracted members, can be NULL.
+ *  @param bytes: Send back bytes of extracted files, can be NULL.
+ *  @return TAR_STREAM_OK when the whole archive was extracted, TAR_STREAM_ERROR otherwise.
+ */
+int tarStreamFinish(TarStream_t *ts, long long *entries, long long *bytes);
+
+/** Description: Free the stream, a member being written is closed as it is. NULL is allowed.
+ *
+ *  @param ts: Stream from tarStreamCreate.
+ */
+void tarStreamDestroy(TarStream_t *ts);
+
+/** Description: Extract an archive file in process, used by tarExtract.
+ *
+ *  @param in_file: Archive, plain or gzip compressed tar.
+ *  @param out_path: Output directory.
+ *  @return TAR_STREAM_OK, TAR_STREAM_ERROR or TAR_STREAM_UNSUPPORTED.
+ */
+int tarStreamExtractFile(const char *in_file, const char *out_path);
+
+#endif /* VIDEO_UTILS_TAR_STREAM_H_ */